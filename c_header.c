@@ -52,6 +52,11 @@ extern double rtclock() {
 }
 #else
 #include <sys/time.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 extern double rtclock() {
   struct timezone Tzp;
   struct timeval Tp;
@@ -182,3 +187,488 @@ void free_2d_int16_array(short** curr_array)
   free(curr_array);
 }
 
+
+
+void* forma_aligned_malloc(size_t size, int alignment)
+{
+  void* aligned_array = NULL;
+#ifdef _WINDOWS
+  aligned_array = _aligned_malloc(size,alignment);
+#else
+  if( posix_memalign(&aligned_array,alignment,size) != 0 )
+    aligned_array = NULL;
+#endif
+  return aligned_array;
+}
+
+void forma_aligned_free(void* aligned_array)
+{
+#ifdef _WINDOWS
+  _aligned_free(aligned_array);
+#else
+  free(aligned_array);
+#endif
+}
+
+/* Number of elements between the start of successive rows of a buffer with
+   rows of width elements. Rows start on alignment byte boundaries, and the
+   pitch avoids multiples of 1024 bytes which map the same column of
+   successive rows to the same cache sets */
+int forma_row_pitch(int width, int elem_size, int alignment)
+{
+  int a = alignment, b = elem_size, step, pitch;
+  while( b != 0 ){
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  step = alignment / a;
+  pitch = ( width + step - 1 ) / step * step;
+  if( ( pitch * elem_size ) % 1024 == 0 )
+    pitch += step;
+  return pitch;
+}
+
+void** forma_malloc_2d_pitched_array
+(int outer_dim, int inner_dim, int elem_size, int alignment)
+{
+  int pitch = forma_row_pitch(inner_dim,elem_size,alignment);
+  char * base_array =
+    (char*)forma_aligned_malloc((size_t)elem_size*pitch*outer_dim,alignment);
+  int i;
+  void** return_array = (void**)malloc(sizeof(void*)*outer_dim);
+  for( i = 0 ; i < outer_dim ; i++)
+    return_array[i] = &base_array[(size_t)i*pitch*elem_size];
+  return return_array;
+}
+
+void forma_free_2d_pitched_array(void** curr_array)
+{
+  forma_aligned_free(curr_array[0]);
+  free(curr_array);
+}
+
+/* Interleave the pages of a buffer across the NUMA nodes the process can
+   allocate memory on. The pages that lie completely within the buffer are
+   placed when they are first touched, so this has to be called before the
+   buffer is written. It is only a placement hint, failures are ignored */
+void forma_numa_interleave(void* buffer, size_t size)
+{
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+  const int mpol_interleave = 3, mpol_f_mems_allowed = 4;
+  unsigned long nodes[16];
+  unsigned long max_node = sizeof(nodes) * 8;
+  int mode;
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = ( (size_t)buffer + page_size - 1 ) / page_size * page_size;
+  size_t stop = ( (size_t)buffer + size ) / page_size * page_size;
+  if( stop <= start )
+    return;
+  memset(nodes,0,sizeof(nodes));
+  if( syscall
+      (SYS_get_mempolicy,&mode,nodes,max_node,NULL,mpol_f_mems_allowed) != 0 )
+    return;
+  syscall
+    (SYS_mbind,(void*)start,stop-start,mpol_interleave,nodes,max_node,0);
+#endif
+}
+
+
+/* The forma runtime : Parallel regions of kernels generated with
+   --runtime=forma are run by a team of threads from a persistent pool. Every
+   thread of the team runs the region. The iterations of a distributed loop
+   are split into one block per thread, a thread runs chunks of its block and
+   then steals half of the iterations left in the block of another thread.
+   All threads wait for the loop to complete before leaving it */
+
+typedef struct {
+  int lb, ub, step;
+  int loop_id;
+  int grain;
+  int chunk_last;
+} forma_loop;
+
+typedef void (*forma_region_fn)(void* region_data);
+typedef void (*forma_team_fn)(void* team_data, int thread_num);
+typedef void (*forma_thread_pool_hook)
+(forma_team_fn team_fn, void* team_data, int num_threads, void* hook_data);
+
+#ifndef _WINDOWS
+
+/* Iterations of a loop that have not been started, owned by a thread */
+typedef struct {
+  pthread_mutex_t lock;
+  int loop_id;
+  int next, end;
+} forma_range;
+
+typedef struct {
+  int num_threads;
+  forma_range* ranges;
+  pthread_mutex_t barrier_lock;
+  pthread_cond_t barrier_cond;
+  int barrier_count, barrier_generation;
+  forma_region_fn region_fn;
+  void* region_data;
+} forma_team;
+
+static __thread forma_team* forma_curr_team = NULL;
+static __thread int forma_thread_id = 0;
+static __thread int forma_loop_count = 0;
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t start_cond, done_cond;
+  pthread_t* workers;
+  int num_workers, generation, num_running, shutdown;
+  forma_team* team;
+  forma_thread_pool_hook hook;
+  void* hook_data;
+  int hook_threads;
+} forma_pool =
+  { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, NULL, 0, 0, 0, 0, NULL, NULL, NULL, 0 };
+
+/* Held while a region runs on the pool, regions started meanwhile run on
+   the calling thread alone instead of oversubscribing the cores */
+static pthread_mutex_t forma_pool_busy = PTHREAD_MUTEX_INITIALIZER;
+
+static void forma_team_init(forma_team* team, int num_threads)
+{
+  int i;
+  team->num_threads = num_threads;
+  team->ranges = (forma_range*)malloc(sizeof(forma_range)*num_threads);
+  for( i = 0 ; i < num_threads ; i++ ){
+    pthread_mutex_init(&team->ranges[i].lock,NULL);
+    team->ranges[i].loop_id = 0;
+    team->ranges[i].next = team->ranges[i].end = 0;
+  }
+  pthread_mutex_init(&team->barrier_lock,NULL);
+  pthread_cond_init(&team->barrier_cond,NULL);
+  team->barrier_count = team->barrier_generation = 0;
+}
+
+static void forma_team_destroy(forma_team* team)
+{
+  int i;
+  for( i = 0 ; i < team->num_threads ; i++ )
+    pthread_mutex_destroy(&team->ranges[i].lock);
+  free(team->ranges);
+  pthread_mutex_destroy(&team->barrier_lock);
+  pthread_cond_destroy(&team->barrier_cond);
+}
+
+/* Run the region of a team as one of its threads */
+static void forma_run_team_member(void* team_data, int thread_num)
+{
+  forma_team* team = (forma_team*)team_data;
+  forma_team* outer_team = forma_curr_team;
+  int outer_id = forma_thread_id, outer_count = forma_loop_count;
+  forma_curr_team = team;
+  forma_thread_id = thread_num;
+  forma_loop_count = 0;
+  team->region_fn(team->region_data);
+  forma_curr_team = outer_team;
+  forma_thread_id = outer_id;
+  forma_loop_count = outer_count;
+}
+
+static void* forma_worker(void* worker_data)
+{
+  int worker_id = (int)(size_t)worker_data;
+  int seen_generation = 0;
+  pthread_mutex_lock(&forma_pool.lock);
+  while( 1 ){
+    forma_team* team;
+    while( forma_pool.generation == seen_generation && !forma_pool.shutdown )
+      pthread_cond_wait(&forma_pool.start_cond,&forma_pool.lock);
+    if( forma_pool.shutdown )
+      break;
+    seen_generation = forma_pool.generation;
+    team = forma_pool.team;
+    pthread_mutex_unlock(&forma_pool.lock);
+    if( worker_id + 1 < team->num_threads )
+      forma_run_team_member(team,worker_id + 1);
+    pthread_mutex_lock(&forma_pool.lock);
+    if( --forma_pool.num_running == 0 )
+      pthread_cond_signal(&forma_pool.done_cond);
+  }
+  pthread_mutex_unlock(&forma_pool.lock);
+  return NULL;
+}
+
+/* Start the threads of the pool. With num_threads <= 0, the number of
+   threads is read from FORMA_NUM_THREADS, or is the number of cores. Called
+   by the first region if not called before */
+void forma_runtime_init(int num_threads)
+{
+  int i;
+  pthread_mutex_lock(&forma_pool.lock);
+  if( forma_pool.workers != NULL ){
+    pthread_mutex_unlock(&forma_pool.lock);
+    return;
+  }
+  if( num_threads <= 0 && getenv("FORMA_NUM_THREADS") != NULL )
+    num_threads = atoi(getenv("FORMA_NUM_THREADS"));
+  if( num_threads <= 0 )
+    num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if( num_threads <= 0 )
+    num_threads = 1;
+  forma_pool.shutdown = 0;
+  forma_pool.num_workers = num_threads - 1;
+  forma_pool.workers =
+    (pthread_t*)malloc(sizeof(pthread_t)*(forma_pool.num_workers + 1));
+  for( i = 0 ; i < forma_pool.num_workers ; i++ )
+    if( pthread_create
+        (&forma_pool.workers[i],NULL,forma_worker,(void*)(size_t)i) != 0 )
+      break;
+  forma_pool.num_workers = i;
+  pthread_mutex_unlock(&forma_pool.lock);
+}
+
+/* Stop the threads of the pool */
+void forma_runtime_finalize()
+{
+  int i;
+  pthread_mutex_lock(&forma_pool_busy);
+  pthread_mutex_lock(&forma_pool.lock);
+  forma_pool.shutdown = 1;
+  pthread_cond_broadcast(&forma_pool.start_cond);
+  pthread_mutex_unlock(&forma_pool.lock);
+  for( i = 0 ; i < forma_pool.num_workers ; i++ )
+    pthread_join(forma_pool.workers[i],NULL);
+  free(forma_pool.workers);
+  forma_pool.workers = NULL;
+  forma_pool.num_workers = 0;
+  /* Workers started by a later init wait for the next region from
+     generation 0, the team of the last region is gone */
+  forma_pool.generation = 0;
+  forma_pool.team = NULL;
+  pthread_mutex_unlock(&forma_pool_busy);
+}
+
+/* Run the regions on the threads of the application instead of the pool.
+   The hook has to call team_fn(team_data,i) for every i in
+   [0,num_threads) concurrently, since the threads of a team wait for each
+   other, and return once all the calls have returned. A NULL hook restores
+   the pool */
+void forma_set_thread_pool
+(forma_thread_pool_hook hook, int num_threads, void* hook_data)
+{
+  pthread_mutex_lock(&forma_pool_busy);
+  forma_pool.hook = hook;
+  forma_pool.hook_threads = ( num_threads > 0 ? num_threads : 1 );
+  forma_pool.hook_data = hook_data;
+  pthread_mutex_unlock(&forma_pool_busy);
+}
+
+/* Run a parallel region on all the threads of a team */
+void forma_parallel_region(forma_region_fn region_fn, void* region_data)
+{
+  forma_team team;
+  if( forma_curr_team != NULL || pthread_mutex_trylock(&forma_pool_busy) ){
+    forma_team_init(&team,1);
+    team.region_fn = region_fn;
+    team.region_data = region_data;
+    forma_run_team_member(&team,0);
+    forma_team_destroy(&team);
+    return;
+  }
+  if( forma_pool.hook != NULL ){
+    forma_team_init(&team,forma_pool.hook_threads);
+    team.region_fn = region_fn;
+    team.region_data = region_data;
+    forma_pool.hook
+      (forma_run_team_member,&team,team.num_threads,forma_pool.hook_data);
+  }
+  else{
+    forma_runtime_init(0);
+    forma_team_init(&team,forma_pool.num_workers + 1);
+    team.region_fn = region_fn;
+    team.region_data = region_data;
+    pthread_mutex_lock(&forma_pool.lock);
+    forma_pool.team = &team;
+    forma_pool.num_running = forma_pool.num_workers;
+    forma_pool.generation++;
+    pthread_cond_broadcast(&forma_pool.start_cond);
+    pthread_mutex_unlock(&forma_pool.lock);
+    forma_run_team_member(&team,0);
+    pthread_mutex_lock(&forma_pool.lock);
+    while( forma_pool.num_running != 0 )
+      pthread_cond_wait(&forma_pool.done_cond,&forma_pool.lock);
+    pthread_mutex_unlock(&forma_pool.lock);
+  }
+  forma_team_destroy(&team);
+  pthread_mutex_unlock(&forma_pool_busy);
+}
+
+int forma_thread_num()
+{
+  return forma_thread_id;
+}
+
+int forma_num_threads()
+{
+  return ( forma_curr_team != NULL ? forma_curr_team->num_threads : 1 );
+}
+
+void forma_barrier()
+{
+  forma_team* team = forma_curr_team;
+  int generation;
+  if( team == NULL || team->num_threads == 1 )
+    return;
+  pthread_mutex_lock(&team->barrier_lock);
+  generation = team->barrier_generation;
+  if( ++team->barrier_count == team->num_threads ){
+    team->barrier_count = 0;
+    team->barrier_generation++;
+    pthread_cond_broadcast(&team->barrier_cond);
+  }
+  else{
+    while( generation == team->barrier_generation )
+      pthread_cond_wait(&team->barrier_cond,&team->barrier_lock);
+  }
+  pthread_mutex_unlock(&team->barrier_lock);
+}
+
+/* Get the next chunk of iterations of a loop, from the block of the thread
+   or stolen from another. Returns the first iteration of the chunk, or a
+   value past the upper bound once all threads have finished the loop */
+static int forma_loop_next_chunk(forma_loop* loop)
+{
+  forma_team* team = forma_curr_team;
+  int num_threads = ( team != NULL ? team->num_threads : 1 );
+  int first = 0, last = -1, i;
+  while( team != NULL ){
+    forma_range* own_range = &team->ranges[forma_thread_id];
+    pthread_mutex_lock(&own_range->lock);
+    if( own_range->next < own_range->end ){
+      first = own_range->next;
+      last = first + loop->grain - 1;
+      if( last >= own_range->end )
+        last = own_range->end - 1;
+      own_range->next = last + 1;
+    }
+    pthread_mutex_unlock(&own_range->lock);
+    if( last >= first )
+      break;
+
+    /* Steal half of the iterations left to a thread in this loop */
+    for( i = 1 ; i < num_threads && last < first ; i++ ){
+      forma_range* victim =
+        &team->ranges[( forma_thread_id + i ) % num_threads];
+      pthread_mutex_lock(&victim->lock);
+      if( victim->loop_id == loop->loop_id && victim->next < victim->end ){
+        int num_stolen = ( victim->end - victim->next + 1 ) / 2;
+        first = victim->end - num_stolen;
+        last = victim->end - 1;
+        victim->end = first;
+      }
+      pthread_mutex_unlock(&victim->lock);
+    }
+    if( last < first )
+      break;
+    pthread_mutex_lock(&own_range->lock);
+    own_range->next = first;
+    own_range->end = last + 1;
+    pthread_mutex_unlock(&own_range->lock);
+    last = -1;
+  }
+  if( last < first ){
+    forma_barrier();
+    return loop->ub + 1;
+  }
+  loop->chunk_last = loop->lb + last * loop->step;
+  return loop->lb + first * loop->step;
+}
+
+/* Start a loop over lb, lb + step, ... , ub distributed across the team.
+   Returns the first iteration to be run by the thread */
+int forma_loop_begin(forma_loop* loop, int lb, int ub, int step)
+{
+  forma_team* team = forma_curr_team;
+  int num_threads = ( team != NULL ? team->num_threads : 1 );
+  long long num_iters = ( ub < lb ? 0 : ( (long long)ub - lb ) / step + 1 );
+  loop->lb = lb;
+  loop->ub = ub;
+  loop->step = step;
+  loop->loop_id = ++forma_loop_count;
+  loop->grain = (int)( num_iters / ( 8 * num_threads ) );
+  if( loop->grain < 1 )
+    loop->grain = 1;
+  if( team == NULL ){
+    loop->chunk_last = ( num_iters == 0 ? lb - step : ub );
+    return ( num_iters == 0 ? ub + 1 : lb );
+  }
+  else{
+    forma_range* own_range = &team->ranges[forma_thread_id];
+    pthread_mutex_lock(&own_range->lock);
+    own_range->loop_id = loop->loop_id;
+    own_range->next = (int)( num_iters * forma_thread_id / num_threads );
+    own_range->end = (int)( num_iters * ( forma_thread_id + 1 ) / num_threads );
+    pthread_mutex_unlock(&own_range->lock);
+  }
+  return forma_loop_next_chunk(loop);
+}
+
+/* The iteration after iter run by the thread */
+int forma_loop_next(forma_loop* loop, int iter)
+{
+  if( iter < loop->chunk_last )
+    return iter + loop->step;
+  if( forma_curr_team == NULL )
+    return loop->ub + 1;
+  return forma_loop_next_chunk(loop);
+}
+
+#else
+
+/* Regions run on the calling thread */
+void forma_runtime_init(int num_threads)
+{
+}
+
+void forma_runtime_finalize()
+{
+}
+
+void forma_set_thread_pool
+(forma_thread_pool_hook hook, int num_threads, void* hook_data)
+{
+}
+
+void forma_parallel_region(forma_region_fn region_fn, void* region_data)
+{
+  region_fn(region_data);
+}
+
+int forma_thread_num()
+{
+  return 0;
+}
+
+int forma_num_threads()
+{
+  return 1;
+}
+
+void forma_barrier()
+{
+}
+
+int forma_loop_begin(forma_loop* loop, int lb, int ub, int step)
+{
+  loop->lb = lb;
+  loop->ub = ub;
+  loop->step = step;
+  loop->chunk_last = ub;
+  return ( ub < lb ? ub + 1 : lb );
+}
+
+int forma_loop_next(forma_loop* loop, int iter)
+{
+  return ( iter < loop->chunk_last ? iter + loop->step : loop->ub + 1 );
+}
+
+#endif
@@ -0,0 +1,104 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+extern "C"
+void bdy_clamped(float*, int, int, float*);
+
+void ref_output(float * input, int M, int N, float * output)
+{
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ ){
+      int i_index = ( i-2 < 0 ? 0 : i-2 );
+      int j_index = ( j+2 > N-1 ? N-1 : j+2 );
+      output[i*N+j] = input[i_index*N+j_index];
+    }
+}
+
+
+int main() {
+  ///With --specialize-boundaries, images with a single row or column are
+  ///smaller than the footprint of the stencil and use the fully checked
+  ///edges, the others use the one-sided checks
+  int sizes[][2] = { { 1, 1 }, { 1, 5 }, { 5, 1 }, { 2, 2 }, { 12, 10 } };
+  for( int s = 0 ; s < 5 ; s++ ){
+    int M = sizes[s][0];
+    int N = sizes[s][1];
+    float* inp1 = new float[M*N];
+    float* outp = new float[M*N];
+    float* outp_ref = new float[M*N];
+
+    for( int i = 0 ; i < M ; i++ )
+      for( int j = 0 ; j < N ; j++ ){
+        inp1[i*N+j] = (float)rand() / (float)RAND_MAX;
+        outp[i*N+j] = 0.0;
+        outp_ref[i*N+j] = 0.0;
+      }
+
+    bdy_clamped(inp1,M,N,outp);
+    ref_output(inp1,M,N,outp_ref);
+
+    double diff = 0.0;
+    for( int i = 0 ; i < M ; i++ )
+      for( int j = 0 ; j < N ; j++ )
+        diff += fabs(outp_ref[i*N+j] - outp[i*N+j]);
+    printf("Size : %dx%d, Diff : %f\n",M,N,diff);
+    if (diff != 0.0) {
+      printf("Incorrect Result\n");
+      exit(1);
+    }
+    delete[] inp1;
+    delete[] outp;
+    delete[] outp_ref;
+  }
+}
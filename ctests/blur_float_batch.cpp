@@ -0,0 +1,103 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define N 1000
+#define M 1200
+#define NUM_IMAGES 3
+
+extern "C" void blur_float(float *, int, int, float*);
+extern "C" void blur_float_batch(int, float **, int, int, float**);
+
+int main(int argc, char** argv)
+{
+  float* inputs[NUM_IMAGES];
+  float* outputs[NUM_IMAGES];
+  float* output_single = new float[M*N];
+
+  for( int k = 0 ; k < NUM_IMAGES ; k++ ){
+    inputs[k] = new float[M*N];
+    outputs[k] = new float[M*N];
+    for( int i = 0 ; i < M*N ; i++ ){
+      inputs[k][i] = (float)(rand()) / (float)(RAND_MAX-1);
+      outputs[k][i] = 0.0;
+    }
+  }
+
+  blur_float_batch(NUM_IMAGES,inputs,M,N,outputs);
+
+  ///Every image of the batch is the same as the image computed alone
+  for( int k = 0 ; k < NUM_IMAGES ; k++ ){
+    memset(output_single,0,sizeof(float)*M*N);
+    blur_float(inputs[k],M,N,output_single);
+    double diff = 0.0;
+    for( int i = 0 ; i < M*N ; i++ )
+      diff += fabs(output_single[i] - outputs[k][i]);
+    printf("Image : %d, Diff : %e\n",k,diff);
+    if( diff > 1e-5 ){
+      printf("Incorrect Result\n");
+      exit(1);
+    }
+  }
+
+  for( int k = 0 ; k < NUM_IMAGES ; k++ ){
+    delete[] inputs[k];
+    delete[] outputs[k];
+  }
+  delete[] output_single;
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#define N 1000
+#define M 1200
+
+extern "C" void blur_float(float *, int, int, float*);
+extern "C" void forma_runtime_init(int);
+extern "C" void forma_runtime_finalize();
+
+void blur_ref(float (*input)[N], float (*output)[N])
+{
+  float (*by)[N] = (float (*)[N])new float[M*N];
+  for( int i = 1 ; i < M-1 ; i++ )
+    for( int j = 0 ; j < N ; j++ )
+      by[i][j] = (input[i-1][j] + input[i][j] + input[i+1][j])/3.0;
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 1 ; j < N-1 ; j++ )
+      output[i][j] = (by[i][j-1] + by[i][j] + by[i][j+1])/3.0;
+  delete[] by;
+}
+
+/// Run the kernel while the thread pool of the runtime is stopped and
+/// restarted, either explicitly or by the next kernel
+int main(int argc, char** argv)
+{
+  float (*input)[N]  = (float (*)[N])new float[M*N];
+  float (*output)[N]  = (float (*)[N])new float[M*N];
+  float (*output_ref)[N]  = (float (*)[N])new float[M*N];
+
+  for( int run = 0 ; run < 6 ; run++ ){
+    for( int i = 0 ; i < M ; i++ )
+      for( int j = 0 ; j < N ; j++ ){
+        input[i][j] = (float)(rand()) / (float)(RAND_MAX-1);
+        output[i][j] = 0.0;
+        output_ref[i][j] = 0.0;
+      }
+    if( run % 2 == 1 )
+      forma_runtime_init(4);
+
+    blur_float((float*)input,M,N,(float*)output);
+    blur_ref(input,output_ref);
+
+    double diff = 0.0;
+    for( int i = 1 ; i < M-1 ; i++ )
+      for( int j = 1 ; j < N-1 ; j++ )
+        diff += fabs(output_ref[i][j] - output[i][j]);
+    printf("Run %d Diff : %e\n",run,diff);
+    if( diff > 1e-5 ){
+      printf("Incorrect Result\n");
+      exit(1);
+    }
+    forma_runtime_finalize();
+  }
+
+  delete[] input;
+  delete[] output;
+  delete[] output_ref;
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cmath>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define NUM_STEPS 11
+
+void jacobi_gold
+(const float* input, int height, int width, int num_steps, float* output)
+{
+  float* curr = new float[height*width];
+  float* next = new float[height*width];
+  memcpy(curr,input,sizeof(float)*height*width);
+  for( int t = 0 ; t < num_steps ; t++ ){
+    for( int i = 0 ; i < height ; i++ )
+      for( int j = 0 ; j < width ; j++ ){
+        int im = ( i > 0 ? i-1 : 0 ), ip = ( i < height-1 ? i+1 : height-1 );
+        int jm = ( j > 0 ? j-1 : 0 ), jp = ( j < width-1 ? j+1 : width-1 );
+        next[i*width+j] =
+          0.2f * (curr[im*width+j] + curr[ip*width+j] + curr[i*width+j] +
+                  curr[i*width+jm] + curr[i*width+jp]);
+      }
+    float* temp = curr;
+    curr = next;
+    next = temp;
+  }
+  memcpy(output,curr,sizeof(float)*height*width);
+  delete[] curr;
+  delete[] next;
+}
+
+#define absd(a) ( (a) > 0 ? (a) : (-(a)) )
+
+
+extern "C" void jacobi_steps(float* input, int height, int width, int num_steps, float* output);
+
+int main()
+{
+  int width = 1000;
+  int height = 1200;
+
+  float * input = new float[width*height];
+  float * output = new float[width*height];
+  float* output_gold = new float[height*width];
+
+  for( int i = 0 ; i < height ; i++)
+    for( int j = 0 ; j < width ; j++ )
+      input[i*width+j] = (rand()%256)/ 5.0;
+
+  ///Without any step the input is returned, with one step the buffers
+  ///holding the previous instances are never read
+  int num_steps[] = { 0, 1, NUM_STEPS };
+  for( int s = 0 ; s < 3 ; s++ ){
+    memset(output,0,sizeof(float)*height*width);
+    jacobi_steps(input,height,width,num_steps[s],output);
+
+    memset(output_gold,0,sizeof(float)*height*width);
+    jacobi_gold(input,height,width,num_steps[s],output_gold);
+    double max_error = 0.0;
+    double avg_error = 0.0;
+    int err_location_i=-1,err_location_j=-1;
+    for( int i = 0 ; i < height ; i++ )
+      for( int j = 0 ; j < width ; j++ ){
+        double curr_error = absd(output[i*width+j] - output_gold[i*width+j]);
+        if( curr_error > max_error ){
+          max_error = curr_error;
+          err_location_i = i;
+          err_location_j = j;
+        }
+        avg_error += curr_error * curr_error;
+      }
+    avg_error = sqrt(avg_error / (height*width));
+
+    printf("Steps : %d, Max Error : %lf at (%d,%d), Average Error: %lf\n",
+           num_steps[s],max_error,err_location_i,err_location_j,avg_error);
+    if(  avg_error > 1e-5 ) {
+      printf("Incorrect Result\n");
+      exit(1);
+    }
+  }
+  delete[] output_gold;
+  delete[] input;
+  delete[] output;
+  return 0;
+}
@@ -0,0 +1,97 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define N 1000
+#define M 1200
+
+extern "C" void sharpen_int8(unsigned char *, int, int, unsigned char*);
+
+/// Values saturate to [0,255] when compiled with --saturate-int-casts
+unsigned char saturate(int value)
+{
+  return ( value < 0 ? 0 : value > 255 ? 255 : value );
+}
+
+void sharpen_ref(unsigned char (*input)[N], unsigned char (*output)[N])
+{
+  unsigned char (*sharpened)[N] = (unsigned char (*)[N])new unsigned char[M*N];
+  memset((unsigned char*)sharpened,0,sizeof(unsigned char)*M*N);
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 1 ; j < N-1 ; j++ )
+      sharpened[i][j] =
+        saturate(2*input[i][j] -
+                 (input[i][j-1] + 2*input[i][j] + input[i][j+1]) / 4);
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ )
+      output[i][j] =
+        ( sharpened[i][j] > 192 ? sharpened[i][j] :
+          sharpened[i][j] - sharpened[i][j] / 4 );
+  delete[] sharpened;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned char (*input)[N]  = (unsigned char (*)[N])new unsigned char[M*N];
+  unsigned char (*output)[N]  = (unsigned char (*)[N])new unsigned char[M*N];
+  unsigned char (*output_ref)[N]  = (unsigned char (*)[N])new unsigned char[M*N];
+
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ ){
+      input[i][j] = (rand()) % 256;
+      output[i][j] = 0;
+      output_ref[i][j] = 0;
+    }
+
+  sharpen_int8((unsigned char*)input,M,N,(unsigned char*)output);
+  sharpen_ref(input,output_ref);
+
+  double diff = 0.0;
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ )
+      diff += ( output_ref[i][j] > output[i][j] ?
+		output_ref[i][j] - output[i][j] :
+		output[i][j] - output_ref[i][j] );
+
+  printf("Diff : %lf\n",diff);
+  if( diff > 1e-6 ){
+    printf("Incorrect Result\n");
+    exit(1);
+  }
+
+  delete[] input;
+  delete[] output;
+  delete[] output_ref;
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define N 100
+#define M 120
+
+extern "C"
+void soa_blur(float*, float*, float*, int, int, float*, float*, float*);
+
+void soa_blur_ref
+(float (*input)[3][N], float (*output)[3][N])
+{
+  float (*bx)[3][N] = (float (*)[3][N])new float[M*3*N];
+  float (*by)[3][N] = (float (*)[3][N])new float[M*3*N];
+  memset(bx,0,sizeof(float)*M*3*N);
+  memset(by,0,sizeof(float)*M*3*N);
+  for( int i = 1 ; i < M-1 ; i++ )
+    for( int c = 0 ; c < 3 ; c++ )
+      for( int j = 0 ; j < N ; j++ )
+        bx[i][c][j] =
+          (input[i-1][c][j] + input[i][c][j] + input[i+1][c][j]) / 3.0f;
+  for( int i = 0 ; i < M ; i++ )
+    for( int c = 0 ; c < 3 ; c++ )
+      for( int j = 1 ; j < N-1 ; j++ )
+        by[i][c][j] = (bx[i][c][j-1] + bx[i][c][j] + bx[i][c][j+1]) / 3.0f;
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ ){
+      output[i][0][j] =
+        0.25f * by[i][0][j] + 0.5f * by[i][1][j] + 0.25f * by[i][2][j];
+      output[i][1][j] = by[i][1][j];
+      output[i][2][j] = bx[i][2][j];
+    }
+  delete[] bx;
+  delete[] by;
+}
+
+int main(int argc, char** argv)
+{
+  ///Each image is stored as one plane per channel
+  float (*input)[3][N]  = (float (*)[3][N])new float[M*3*N];
+  float (*output)[3][N]  = (float (*)[3][N])new float[M*3*N];
+  float (*output_ref)[3][N]  = (float (*)[3][N])new float[M*3*N];
+  float* input_planes[3];
+  float* output_planes[3];
+  for( int c = 0 ; c < 3 ; c++ ){
+    input_planes[c] = new float[M*N];
+    output_planes[c] = new float[M*N];
+  }
+
+  for( int i = 0 ; i < M ; i++ )
+    for( int c = 0 ; c < 3 ; c++ )
+      for( int j = 0 ; j < N ; j++ ){
+        input[i][c][j] = (float)(rand()) / (float)(RAND_MAX-1);
+        input_planes[c][i*N+j] = input[i][c][j];
+        output_planes[c][i*N+j] = 0.0;
+        output_ref[i][c][j] = 0.0;
+      }
+
+  soa_blur
+    (input_planes[0],input_planes[1],input_planes[2],M,N,
+     output_planes[0],output_planes[1],output_planes[2]);
+  soa_blur_ref(input,output_ref);
+
+  double diff = 0.0;
+  for( int i = 1 ; i < M-1 ; i++ )
+    for( int c = 0 ; c < 3 ; c++ )
+      for( int j = 1 ; j < N-1 ; j++ )
+        diff += fabs(output_ref[i][c][j] - output_planes[c][i*N+j]);
+  printf("Diff : %e\n",diff);
+  if( diff > 1e-5 ){
+    printf("Incorrect Result\n");
+    exit(1);
+  }
+
+  for( int c = 0 ; c < 3 ; c++ ){
+    delete[] input_planes[c];
+    delete[] output_planes[c];
+  }
+  delete[] input;
+  delete[] output;
+  delete[] output_ref;
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+/*
+ *  Copyright 2014 NVIDIA Corporation.  All rights reserved.
+ *
+ *  NOTICE TO USER: The source code, and related code and software
+ *  ("Code"), is copyrighted under U.S. and international laws.
+ *
+ *  NVIDIA Corporation owns the copyright and any patents issued or
+ *  pending for the Code.
+ *
+ *  NVIDIA CORPORATION MAKES NO REPRESENTATION ABOUT THE SUITABILITY
+ *  OF THIS CODE FOR ANY PURPOSE.  IT IS PROVIDED "AS-IS" WITHOUT EXPRESS
+ *  OR IMPLIED WARRANTY OF ANY KIND.  NVIDIA CORPORATION DISCLAIMS ALL
+ *  WARRANTIES WITH REGARD TO THE CODE, INCLUDING NON-INFRINGEMENT, AND
+ *  ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE.  IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ *  WHATSOEVER ARISING OUT OF OR IN ANY WAY RELATED TO THE USE OR
+ *  PERFORMANCE OF THE CODE, INCLUDING, BUT NOT LIMITED TO, INFRINGEMENT,
+ *  LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ *  NEGLIGENCE OR OTHER TORTIOUS ACTION, AND WHETHER OR NOT THE
+ *  POSSIBILITY OF SUCH DAMAGES WERE KNOWN OR MADE KNOWN TO NVIDIA
+ *  CORPORATION.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#define M 11
+#define N 14
+#define NUM_REGIONS 6
+#define UNSET -1.0f
+
+extern "C" void upsample(float*,int,int,float*);
+extern "C" void upsample_roi(float*,int,int,int,int,int,int,float*);
+
+int main(int argc, char** argv)
+{
+  float (*input)[N] = (float (*)[N])new float[M*N];
+  float (*output)[2*N] = (float (*)[2*N])new float[2*M*2*N];
+  float (*output_roi)[2*N] = (float (*)[2*N])new float[2*M*2*N];
+
+  for( int i = 0 ; i < M ; i++ )
+    for( int j = 0 ; j < N ; j++ )
+      input[i][j] = (float)(rand()) / (float)(RAND_MAX-1);
+
+  for( int i = 0 ; i < 2*M ; i++ )
+    for( int j = 0 ; j < 2*N ; j++ )
+      output[i][j] = UNSET;
+
+  upsample((float*)input,M,N,(float*)output);
+
+  ///Regions starting and ending on odd and even points, touching each edge
+  int regions[NUM_REGIONS][4] = {
+    { 3, 8, 5, 12 },
+    { 4, 9, 6, 11 },
+    { 0, 0, 0, 2*N-1 },
+    { 2*M-1, 2*M-1, 2*N-1, 2*N-1 },
+    { 1, 2*M-2, 0, 3 },
+    { 0, 2*M-1, 0, 2*N-1 } };
+
+  for( int r = 0 ; r < NUM_REGIONS ; r++ ){
+    int lb_0 = regions[r][0], ub_0 = regions[r][1];
+    int lb_1 = regions[r][2], ub_1 = regions[r][3];
+    for( int i = 0 ; i < 2*M ; i++ )
+      for( int j = 0 ; j < 2*N ; j++ )
+        output_roi[i][j] = UNSET;
+
+    upsample_roi((float*)input,M,N,lb_0,ub_0,lb_1,ub_1,(float*)output_roi);
+
+    double diff = 0.0;
+    int num_outside = 0;
+    for( int i = 0 ; i < 2*M ; i++ )
+      for( int j = 0 ; j < 2*N ; j++ ){
+        if( i >= lb_0 && i <= ub_0 && j >= lb_1 && j <= ub_1 ){
+          if( output[i][j] != output_roi[i][j] )
+            printf(" Diff at (%d,%d) : %f %f\n",i,j,output[i][j],
+                   output_roi[i][j]);
+          diff += fabs(output[i][j] - output_roi[i][j]);
+        }
+        else if( output_roi[i][j] != UNSET )
+          num_outside++;
+      }
+    printf("Region [%d:%d,%d:%d] : Diff : %e, Points written outside : %d\n",
+           lb_0,ub_0,lb_1,ub_1,diff,num_outside);
+    if( diff > 1e-5 || num_outside != 0 ){
+      printf("Incorrect result\n");
+      exit(1);
+    }
+  }
+  delete[] input;
+  delete[] output;
+  delete[] output_roi;
+  return 0;
+}
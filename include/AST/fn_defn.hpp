@@ -278,6 +278,8 @@ public:
   void pretty_print() const ;
 
   template<typename State> friend class ASTVisitor;
+  friend class StencilCSE;
+  friend class StencilSimplify;
 };
 
 /** Class that holds all the function definitions
@@ -131,28 +131,66 @@ public:
   
   static parametric_exp* copy(const parametric_exp* rhs);
 
+  ///Compute the smallest value of the expression allowed by the constraints
+  ///on the parameters, returns false if it is unbounded
+  static bool get_lower_bound(const parametric_exp* curr_exp, int& lb);
+
+  ///Check if the constraints on the parameters guarantee that the value of
+  ///the expression is a multiple of factor
+  static bool is_multiple_of(const parametric_exp* curr_exp, int factor);
+
   parametric_exp(parametric_exp_type curr_type) : type(curr_type) { }
 
   virtual ~parametric_exp() { }
 };
 
 
+enum param_constraint_type{
+  PC_EQUAL,
+  PC_MULTIPLE,
+  PC_LOWER_BOUND,
+};
+
+
 struct parameter_defn : public ast_node{
 
   const std::string param_id;
 
-  const int value;
+  ///Value the code is specialized for, DEFAULT_RANGE if only known at runtime
+  int value;
+
+  ///The value is known to be a multiple of this factor
+  int multiple_of;
+
+  ///The value is known to be no less than lower_bound
+  bool has_lower_bound;
+  int lower_bound;
   
   parameter_defn(const char* id):
     param_id(id),
-    value(DEFAULT_RANGE)
+    value(DEFAULT_RANGE),
+    multiple_of(1),
+    has_lower_bound(false),
+    lower_bound(0)
   { }
 
   parameter_defn(const char* id, int val):
     param_id(id),
-    value(val)
+    value(val),
+    multiple_of(1),
+    has_lower_bound(false),
+    lower_bound(0)
   { }
 
+  ///Add a constraint on the value of the parameter, returns false if it
+  ///contradicts the constraints added before
+  bool add_constraint(param_constraint_type, int);
+
+  ///Check if any constraint is known on the value of the parameter
+  bool is_constrained() const {
+    return value != DEFAULT_RANGE || multiple_of != 1 || has_lower_bound;
+  }
+
   void print_node(FILE*) const;
   int compute_pretty_print_size() ;
   void pretty_print() const;
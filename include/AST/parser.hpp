@@ -114,6 +114,11 @@ public:
 
   ///Function to start the parsing
   static void parse_input();
+
+  ///Function to set constraints on the values of parameters, of the form
+  ///<ID>=<int>, <ID>%<int>==0 or <ID>>=<int>. They are folded into the
+  ///parametric expressions that use the parameters
+  static void set_param_constraints(const std::deque<std::string>&);
 };
 
 
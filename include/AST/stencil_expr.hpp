@@ -49,6 +49,8 @@ enum operator_type{
   O_GE, ///< '<='
   O_EQ, ///< '=='
   O_NE, ///< '!='
+  O_SHL, ///< '<<', only generated by the compiler
+  O_SHR, ///< '>>', only generated by the compiler
 };
 
 
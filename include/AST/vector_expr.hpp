@@ -307,6 +307,10 @@ private:
   ///Offset to iterator - used only for qualified variables
   int offset;
 
+  ///Upper bound of a for-loop, used to access the last instance of a
+  ///qualified variable computed by a loop with a parametric trip count
+  const parameter_defn* offset_param;
+
 public:
 
   ///Constructor
@@ -315,6 +319,9 @@ public:
   ///Constructor for ID< > 
   vec_id_expr_node(const char*,local_symbols*,int,for_iterator*);
 
+  ///Constructor for ID<param>
+  vec_id_expr_node(const char*,local_symbols*,const parameter_defn*);
+
   ///Constructor used for copying
   vec_id_expr_node(const vec_id_expr_node*);
 
@@ -336,6 +343,11 @@ public:
     return offset;
   }
 
+  ///Return the parameter used as the instance accessed, NULL if not used
+  const parameter_defn* get_offset_param() const {
+    return offset_param;
+  }
+
   ///Return the definition for this id_expr
   inline const std::set<vector_expr_node*>& get_defn() const {
     return defn;
@@ -582,6 +594,8 @@ public:
 
   template <typename State> friend class ASTVisitor;
   friend class ConvertBoundaries;
+  friend class SeparableStencils;
+  friend class InlinePointwise;
 };
 
 
@@ -29,6 +29,7 @@
 #define __VECTOR_STMT_HPP__
 
 #include "AST/vector_expr.hpp"
+#include <climits>
 
 /**Struct to represent a for-loo iterator
  */
@@ -247,6 +248,7 @@ public:
   // void print_simpleC() const;
 
   template <typename State> friend class ASTVisitor;
+  friend class InlinePointwise;
 };
 
 
@@ -283,9 +285,17 @@ public:
     return body;
   }
 
+  ///Used only when the loop is not unrolled, the domain of an iteration is
+  ///computed from the domain of the initial values it reads
+  const domain_node* compute_domain(){
+    for( std::deque<stmt_node*>::iterator it = body->stmt_list.begin() ; it != body->stmt_list.end() ; it++ )
+      (*it)->compute_domain();
+    return NULL;
+  }
+
   int compute_pretty_print_size() ;
   void pretty_print() const;
-  
+
   ~for_stmt_node(){
     delete iter_info;
     for( std::deque<stmt_node*>::iterator it = body->stmt_list.begin() ; it != body->stmt_list.end() ; it++ ){
@@ -383,16 +393,11 @@ public:
       fprintf(stderr,"[ME] : ERROR ! Currently nested for-loops unsupported\n");
       exit(1);
     }
-    range_coeffs curr_range = curr_domain->range_list.front();
-    assert(curr_range.lb->type == P_INT && curr_range.ub->type == P_INT );
-    int curr_range_lb = static_cast<int_expr*>(curr_range.lb)->value;
-    int curr_range_ub = static_cast<int_expr*>(curr_range.ub)->value;
+    int curr_range_lb, curr_range_ub;
+    get_def_range(curr_domain,curr_range_lb,curr_range_ub);
     for( std::deque<std::pair<domain_node*,stmt_node*> >::iterator it = def_exprs.begin() ; it != def_exprs.end() ; it++ ){
-      domain_node* check_domain = it->first;
-      range_coeffs check_range = check_domain->range_list.front();
-      assert(check_range.lb->type == P_INT && check_range.ub->type == P_INT );
-      int check_range_lb = static_cast<int_expr*>(check_range.lb)->value;
-      int check_range_ub = static_cast<int_expr*>(check_range.ub)->value;
+      int check_range_lb, check_range_ub;
+      get_def_range(it->first,check_range_lb,check_range_ub);
       // if( ISIN(curr_range.lb,check_range.lb,check_range.ub) || ISIN(curr_range.ub,check_range.lb,check_range.ub) ){
       if( !(curr_range_lb > check_range_ub || curr_range_ub < check_range_lb) ){
 	fprintf(stderr,"[ME] : ERROR ! Redefinition of symbol %s \n",name.c_str());
@@ -424,12 +429,19 @@ public:
   
   inline stmt_node* check_if_defined(int point) const{
     for( std::deque<std::pair<domain_node*,stmt_node*> >::const_iterator it = def_exprs.begin() ; it != def_exprs.end() ; it++ ){
-      domain_node* check_domain = it->first;
-      range_coeffs check_range = check_domain->range_list.front();
-      assert((check_range.lb->type == P_INT && check_range.ub->type == P_INT ) && ("[ME]: No support for parametric loop bounds of for-loops"));
-      int_expr* lb = static_cast<int_expr*>(check_range.lb);
-      int_expr* ub = static_cast<int_expr*>(check_range.ub);
-      if( ISIN(point,lb->value,ub->value) )
+      int lb, ub;
+      get_def_range(it->first,lb,ub);
+      if( ISIN(point,lb,ub) )
+	return it->second;
+    }
+    return NULL;
+  }
+
+  ///Returns the definition by a for-loop whose upper bound is the parameter
+  inline stmt_node* check_if_defined(const parameter_defn* ub_param) const{
+    for( std::deque<std::pair<domain_node*,stmt_node*> >::const_iterator it = def_exprs.begin() ; it != def_exprs.end() ; it++ ){
+      const parametric_exp* ub = it->first->range_list.front().ub;
+      if( ub->type == P_PARAM && static_cast<const param_expr*>(ub)->param == ub_param )
 	return it->second;
     }
     return NULL;
@@ -438,18 +450,15 @@ public:
   
   inline bool check_if_defined(int lb, int ub, std::set<vector_expr_node*>& defns)const{
     for( std::deque<std::pair<domain_node*,stmt_node*> >::const_iterator it = def_exprs.begin() ; it != def_exprs.end() ; it++ ){
-      domain_node* check_domain = it->first;
-      range_coeffs check_range = check_domain->range_list.front();
-      assert((check_range.lb->type == P_INT && check_range.ub->type == P_INT ) && ("[ME]: No support for parametric loop bounds of for-loops"));
-      int_expr* curr_lb = static_cast<int_expr*>(check_range.lb);
-      int_expr* curr_ub = static_cast<int_expr*>(check_range.ub);
-      if( ISIN(lb,curr_lb->value,curr_ub->value) ){
+      int curr_lb, curr_ub;
+      get_def_range(it->first,curr_lb,curr_ub);
+      if( ISIN(lb,curr_lb,curr_ub) ){
 	defns.insert(it->second);
-	lb = curr_ub->value+1;
+	lb = ( curr_ub < ub ? curr_ub+1 : ub+1 );
       }
-      if( ISIN(ub,curr_lb->value,curr_ub->value) ){
+      if( ISIN(ub,curr_lb,curr_ub) ){
 	defns.insert(it->second);
-	ub = curr_ub->value-1;
+	ub = curr_ub-1;
       }
     }
     return ( lb <= ub ? false : true );
@@ -470,6 +479,22 @@ public:
   int compute_pretty_print_size() { return 0; }
   void pretty_print() const { };
   const domain_node* compute_domain() { return NULL; };
+
+private:
+
+  ///Integer bounds of a definition, the parametric upper bound of a for-loop
+  ///is treated as unbounded
+  static void get_def_range(const domain_node* def_domain, int& lb, int& ub){
+    const range_coeffs& def_range = def_domain->range_list.front();
+    assert((def_range.lb->type == P_INT ) && ("[ME]: No support for parametric lower bounds of for-loops"));
+    lb = static_cast<const int_expr*>(def_range.lb)->value;
+    if( def_range.ub->type == P_INT )
+      ub = static_cast<const int_expr*>(def_range.ub)->value;
+    else{
+      assert((def_range.ub->type == P_PARAM ) && ("[ME]: Upper bound of for-loops has to be an integer or a parameter"));
+      ub = INT_MAX;
+    }
+  }
 };
 
 
@@ -0,0 +1,169 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#ifndef __INLINE_POINTWISE_HPP__
+#define __INLINE_POINTWISE_HPP__
+
+#include <map>
+#include <set>
+#include <string>
+#include "ASTVisitor/visitor.hpp"
+#include "program_opts.hpp"
+
+/** Inlining of pointwise stencil functions into their consumers. A
+    stencil function is pointwise if it reads its vector arguments only
+    at the point being computed, like a conversion or a per-pixel
+    combination of images. An application of such a function that is
+    an argument of a stencil function, either directly or through a
+    statement all of whose uses are such arguments, is not computed
+    into a buffer anymore. The consumer is instead replaced by a new
+    stencil function <consumer>_<param>_<producer> that takes the
+    arguments of the producer in place of the parameter, and where
+    every access of the parameter is replaced by the expression of the
+    producer evaluated at the accessed point. The fields of a producer
+    returning a struct are inlined separately. Boundary conditions of
+    the parameter (other than constant) are applied to the arguments of
+    the producer instead, which is only valid when they have the same
+    domain. Values are converted to the type of the intermediate image
+    where the generated code would have stored them. Statements of the
+    program scheduled with compute=inline are inlined, and those with
+    another compute level are not. Other producers are inlined only if
+    inline_all is set */
+class InlinePointwise : public ASTVisitor<void*> {
+
+private:
+
+  ///Properties of a stencil function as a producer
+  struct producer_info{
+    bool is_pointwise;
+    ///Fields of struct arguments are read
+    bool reads_fields;
+    producer_info() : is_pointwise(false), reads_fields(false) { }
+  };
+
+  ///Key of an inlined function, the consumer, the position of the
+  ///parameter replaced, the producer and the field of the producer
+  ///passed as argument (-1 if none)
+  struct inline_key{
+    const fn_defn_node* consumer;
+    int arg_num;
+    const fn_defn_node* producer;
+    int field;
+    bool operator<(const inline_key&) const;
+  };
+
+  /** Finds the statements that are only used as arguments that can be
+      inlined. Uses within loops are not considered */
+  class UseCollector : public ASTVisitor<void*> {
+
+  private:
+
+    InlinePointwise* inliner;
+
+    ///Nesting depth of loops
+    int loop_depth;
+
+    ///Uses of statements that can be inlined
+    std::set<const vector_expr_node*> inline_uses;
+
+    void visit_vectorfn(vectorfn_defn_node*, void*);
+
+    stmt_node* visit_for_stmt(for_stmt_node*, void*);
+
+    stmt_node* visit_do_stmt(do_stmt_node*, void*);
+
+    vector_expr_node* visit_fnid_expr(fnid_expr_node*, void*);
+
+  public:
+
+    UseCollector(InlinePointwise* curr_inliner) :
+      inliner(curr_inliner), loop_depth(0) { }
+
+  };
+
+  ///Producers not named in the schedule are inlined
+  bool inline_all;
+
+  ///Schedule of the statements of the program
+  const std::map<std::string,stage_schedule>& stage_schedules;
+
+  ///The program being transformed
+  program_node* curr_program;
+
+  ///The domains of the statements of the program have been computed
+  bool domains_computed;
+
+  ///Analysis of the stencil functions used as producers
+  std::map<const fn_defn_node*,producer_info> producers;
+
+  ///Functions created, indexed by what they inline
+  std::map<inline_key,stencilfn_defn_node*> inlined_fns;
+
+  ///Statements whose uses are inlined, they are removed once unused
+  std::set<const stmt_node*> forwarded_stmts;
+
+  ///Check if the schedule allows inlining a statement
+  bool is_inline_stage(const stmt_node*, bool) const;
+
+  ///Returns the properties of a stencil function as a producer
+  const producer_info& get_producer_info(const stencilfn_defn_node*);
+
+  ///Returns the producer applied in an argument, with the field of
+  ///its result that is used
+  fnid_expr_node* get_producer(vector_expr_node*, int&);
+
+  ///Check if an argument of a function application can be inlined,
+  ///the domains of expressions are only known in the program body
+  bool can_inline(fnid_expr_node*, int, fnid_expr_node*, int, bool);
+
+  ///Returns the function inlining a producer into a parameter of a
+  ///consumer, NULL if its name is not available
+  stencilfn_defn_node* get_inlined_fn
+  (const stencilfn_defn_node*, int, const stencilfn_defn_node*, int);
+
+  ///Create the application of the inlined function
+  fnid_expr_node* inline_arg
+  (fnid_expr_node*, int, fnid_expr_node*, stencilfn_defn_node*);
+
+  void visit_vectorfn(vectorfn_defn_node*, void*);
+
+  vector_expr_node* visit_fnid_expr(fnid_expr_node*, void*);
+
+public:
+
+  InlinePointwise
+  (bool all_producers, const std::map<std::string,stage_schedule>& schedules):
+    inline_all(all_producers), stage_schedules(schedules),
+    curr_program(NULL), domains_computed(false) { }
+
+  void visit(program_node*, void*);
+
+  ~InlinePointwise() { }
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#ifndef __SEPARABLE_STENCILS_HPP__
+#define __SEPARABLE_STENCILS_HPP__
+
+#include <map>
+#include <string>
+#include "ASTVisitor/visitor.hpp"
+
+/** Detection and rewriting of separable stencils. A stencil function
+    with a single vector argument whose body is a linear combination
+    of stencil accesses with constant weights is rewritten, when the
+    weights form a rank-1 matrix along one or more dimensions, into a
+    sequence of stencil functions <name>_sep_d<k> that each access the
+    input along fewer dimensions. Every application of the original
+    function (with no boundary condition, or one that treats each
+    dimension independently) is replaced by the composition of these
+    functions, reducing the cost of a KxK stencil from K^2 to 2K
+    operations per point. Only float and double stencils are rewritten,
+    since the intermediate results of integer stencils would be
+    truncated */
+class SeparableStencils{
+
+private:
+
+  ///Offsets of a stencil access, one per dimension
+  typedef std::deque<int> stencil_offset;
+
+  ///Weight of each stencil access in a linear combination
+  typedef std::map<stencil_offset,double> stencil_weights;
+
+  ///Result of analysing a scalar expression as a linear combination
+  ///of stencil accesses
+  struct linear_form{
+    stencil_weights weights;
+    double constant;
+    bool is_valid;
+    linear_form() : constant(0), is_valid(true) { }
+  };
+
+  class Visitor: public ASTVisitor<void*> {
+
+  private:
+
+    vector_expr_node* visit_fnid_expr(fnid_expr_node*, void*);
+
+  public:
+
+    ///The stencil functions that replace every separable function,
+    ///outermost first
+    std::map<const fn_defn_node*,std::deque<stencilfn_defn_node*> > separated_fns;
+
+    Visitor() { };
+
+    ~Visitor() { };
+
+  } visitor;
+
+  ///Vector argument of the stencil function being analysed
+  const vector_defn_node* curr_param;
+
+  ///Linear forms of the local scalars of the stencil function
+  std::map<std::string,linear_form> scalar_forms;
+
+  ///Compute the linear form of a scalar expression
+  linear_form get_linear_form(const expr_node*);
+
+  ///Split the weights into a 1D stencil along dimension dim and the
+  ///remaining stencil, returns false if the weights are not rank-1
+  bool split_weights(const stencil_weights&, int dim, stencil_weights&, stencil_weights&) const;
+
+  ///Create a stencil function computing the weighted sum, scaled by
+  ///the given factor
+  stencilfn_defn_node* create_stencilfn(const std::string&, const stencil_weights&, double);
+
+  ///Analyse a stencil function and create its separated form if possible
+  void separate_stencilfn(stencilfn_defn_node*);
+
+public:
+
+  SeparableStencils() : curr_param(NULL) { }
+
+  void visit(program_node*);
+
+  ~SeparableStencils() { }
+
+};
+
+#endif
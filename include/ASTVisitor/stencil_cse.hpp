@@ -0,0 +1,96 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#ifndef __STENCIL_CSE_HPP__
+#define __STENCIL_CSE_HPP__
+
+#include <map>
+#include <string>
+#include "ASTVisitor/stencil_visitor.hpp"
+
+/** Common subexpression elimination within stencil functions. Every
+    subexpression is given a value number (a string key built from its
+    structure, with local scalars versioned by the number of times they
+    have been redefined). Subexpressions, including stencil loads, that
+    are computed more than once are hoisted into new local scalars
+    __cse_<n>__ defined before their first use, and all later
+    occurences are replaced by a reference to that scalar.  Expressions
+    within the branches of a ternary are only replaced, never hoisted,
+    since they need not be evaluated */
+class StencilCSE : public StencilExprVisitor{
+
+private:
+
+  ///The stencil function being processed
+  stencilfn_defn_node* curr_fn;
+
+  ///Number of occurences of every value number in the current function
+  std::map<std::string,int> num_uses;
+
+  ///Value numbers already computed, and the local scalar holding them
+  std::map<std::string,std::string> available_exprs;
+
+  ///Number of times a local scalar has been (re)defined so far
+  std::map<std::string,int> scalar_versions;
+
+  ///Position in the function body where hoisted statements are inserted
+  int insert_pos;
+
+  ///Depth of nesting within ternary expressions
+  int conditional_depth;
+
+  ///Number of scalars introduced, used to generate unique names
+  int ncse_vars;
+
+  ///Returns true if curr_expr is worth storing in a local scalar
+  bool is_candidate(const expr_node*) const;
+
+  ///Compute the value number of an expression
+  std::string get_key(const expr_node*);
+
+  ///Count the occurences of every candidate subexpression
+  void count_uses(const expr_node*);
+
+  ///Apply the transformation to a single stencil function
+  void visit_stencilfn(stencilfn_defn_node*);
+
+public:
+
+  StencilCSE() :
+    curr_fn(NULL), insert_pos(0), conditional_depth(0), ncse_vars(0) { }
+
+  ~StencilCSE() { }
+
+  ///Overloaded visitor, replaces subexpressions already computed
+  expr_node* visit(expr_node*);
+
+  ///Process all stencil functions in the program
+  void visit(program_node*);
+
+};
+
+#endif
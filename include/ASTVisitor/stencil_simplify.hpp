@@ -0,0 +1,89 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#ifndef __STENCIL_SIMPLIFY_HPP__
+#define __STENCIL_SIMPLIFY_HPP__
+
+#include "ASTVisitor/stencil_visitor.hpp"
+
+/** Algebraic simplification of the expressions within stencil
+    functions. Operations on constants are folded, using the
+    arithmetic of the type the generated code would use. Identities
+    that hold exactly for the type of the expression are applied
+    (x*1, x/1, x-0, -(-x), and x+0, x*0 for integers only). Division
+    of floating point values by a power of two is replaced by a
+    multiplication, and multiplications and divisions of unsigned 8-bit
+    values by powers of two are replaced by shifts. Ternary expressions
+    with a constant condition are replaced by the selected branch */
+class StencilSimplify : public StencilExprVisitor{
+
+private:
+
+  ///Symbol table of the stencil function being processed, used to
+  ///copy sub-expressions
+  const local_symbols* curr_fn_symbols;
+
+  ///Returns a copy of an expression
+  expr_node* copy_expr(const expr_node*);
+
+  ///Returns the negation of a copy of the expression
+  expr_node* negate_expr(const expr_node*);
+
+  ///Fold a binary operation on two constants
+  expr_node* fold_expr_op(const expr_op_node*);
+
+  ///Apply identities to a binary operation with one constant operand
+  expr_node* simplify_expr_op(const expr_op_node*);
+
+  ///Apply the transformation to a single stencil function
+  void visit_stencilfn(stencilfn_defn_node*);
+
+protected:
+
+  expr_node* visit_unary_expr(unary_neg_expr_node*);
+
+  expr_node* visit_math_fn(math_fn_expr_node*);
+
+  expr_node* visit_ternary(ternary_expr_node*);
+
+  expr_node* visit_expr_op(expr_op_node*);
+
+public:
+
+  StencilSimplify() :
+    curr_fn_symbols(NULL) { }
+
+  ~StencilSimplify() { }
+
+  using StencilExprVisitor::visit;
+
+  ///Process all stencil functions in the program
+  void visit(program_node*);
+
+};
+
+#endif
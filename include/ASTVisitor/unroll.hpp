@@ -30,14 +30,50 @@
 
 #include "ASTVisitor/visitor.hpp"
 #include "ASTVisitor/copy_visitor.hpp"
+#include <set>
+#include <map>
+
+/** Collects the vec_id expressions used within an expression
+ */
+class CollectVecIds : public ASTVisitor<int>{
+
+public:
+
+  std::deque<vec_id_expr_node*> vec_ids;
+
+  void collect(const vector_expr_node* curr_expr){
+    visit_vector_expr(const_cast<vector_expr_node*>(curr_expr),0);
+  }
+
+protected:
+
+  vector_expr_node* visit_vec_id_expr(vec_id_expr_node* curr_expr, int){
+    vec_ids.push_back(curr_expr);
+    return NULL;
+  }
+};
+
 
 class LoopUnroll : public ASTVisitor<int>{
 
+public:
+
+  LoopUnroll(bool kr = false) : keep_rolled(kr) { }
+
 private:
 
   std::deque<std::pair<for_stmt_node*,for_stmt_seq*> > replacements;
 
+  ///Keep loops whose iterations only read values of previous iterations
+  bool keep_rolled;
+
+  ///Loops that are not unrolled, and the qualified variables they define
+  std::set<const for_stmt_node*> rolled_loops;
+  std::set<std::string> rolled_names;
+
   void visit_vectorfn(vectorfn_defn_node* curr_fn, int state){
+    if( keep_rolled )
+      find_rolled_loops(curr_fn);
     ASTVisitor::visit_vectorfn(curr_fn,state);
     for( std::deque<std::pair<for_stmt_node*,for_stmt_seq*> >::iterator it = replacements.begin() ; it != replacements.end() ; it++ ){
       for( std::deque<stmt_node*>::iterator jt = it->second->stmt_list.begin() ; jt != it->second->stmt_list.end() ; jt++ ){
@@ -47,12 +83,140 @@ private:
       delete it->second;
     }
     replacements.clear();
+    rolled_loops.clear();
+    rolled_names.clear();
+  }
+
+  ///Check if the body of a loop can be computed by rotating between buffers,
+  ///each iteration can only read instances computed earlier in the same
+  ///iteration, instances of previous iterations and unqualified
+  ///variables. Computes the number of previous iterations read for each
+  ///variable
+  static bool check_rollable_body(const for_stmt_node* curr_loop, std::map<std::string,int>& num_lags){
+    const for_iterator* curr_iterator = curr_loop->get_iterator();
+    if( !curr_iterator->is_positive )
+      return false;
+    const std::deque<stmt_node*>& loop_body = curr_loop->get_body()->stmt_list;
+    for( std::deque<stmt_node*>::const_iterator it = loop_body.begin() ; it != loop_body.end() ; it++ ){
+      if( (*it)->get_type() != VEC_STMT || (*it)->get_access_iterator() != curr_iterator || (*it)->get_offset() != 0 ||
+	  (*it)->get_sub_domain() || (*it)->get_scale_domain() || (*it)->get_dim() == 0 )
+	return false;
+      num_lags[(*it)->get_name_string()] = 0;
+    }
+    std::set<std::string> defined_names;
+    for( std::deque<stmt_node*>::const_iterator it = loop_body.begin() ; it != loop_body.end() ; it++ ){
+      CollectVecIds rhs_ids;
+      rhs_ids.collect((*it)->get_rhs());
+      for( std::deque<vec_id_expr_node*>::iterator jt = rhs_ids.vec_ids.begin() ; jt != rhs_ids.vec_ids.end() ; jt++ ){
+	const vec_id_expr_node* curr_id = *jt;
+	if( curr_id->get_access_iterator() == NULL ){
+	  if( curr_id->get_offset() != DEFAULT_RANGE || curr_id->get_offset_param() )
+	    return false;
+	  continue;
+	}
+	if( curr_id->get_access_iterator() != curr_iterator || num_lags.count(curr_id->get_name_string()) == 0 )
+	  return false;
+	if( curr_id->get_offset() == DEFAULT_RANGE ){
+	  if( defined_names.count(curr_id->get_name_string()) == 0 )
+	    return false;
+	}
+	else if( curr_id->get_offset() <= 0 )
+	  return false;
+	else
+	  num_lags[curr_id->get_name_string()] = MAX(num_lags[curr_id->get_name_string()],curr_id->get_offset());
+      }
+      defined_names.insert((*it)->get_name_string());
+    }
+    return true;
+  }
+
+  ///Find the loops of a function that are kept rolled. The qualified
+  ///variables they define can only be accessed by the loop, before the loop
+  ///for the initial values and after the loop for the last instance
+  void find_rolled_loops(vectorfn_defn_node* curr_fn){
+    const std::deque<stmt_node*>& fn_body = curr_fn->get_body();
+    std::map<const for_stmt_node*,std::map<std::string,int> > candidates;
+    std::map<std::string,int> num_loop_defs;
+    for( std::deque<stmt_node*>::const_iterator it = fn_body.begin() ; it != fn_body.end() ; it++ ){
+      if( (*it)->get_type() != VEC_FORSTMT && (*it)->get_type() != VEC_DOSTMT )
+	continue;
+      const std::deque<stmt_node*>& loop_body = (*it)->get_body()->stmt_list;
+      for( std::deque<stmt_node*>::const_iterator jt = loop_body.begin() ; jt != loop_body.end() ; jt++ )
+	num_loop_defs[(*jt)->get_name_string()]++;
+      std::map<std::string,int> num_lags;
+      if( (*it)->get_type() == VEC_FORSTMT && check_rollable_body(static_cast<const for_stmt_node*>(*it),num_lags) )
+	candidates[static_cast<const for_stmt_node*>(*it)] = num_lags;
+    }
+
+    for( std::map<const for_stmt_node*,std::map<std::string,int> >::iterator it = candidates.begin() ; it != candidates.end() ; it++ ){
+      const range_coeffs& loop_range = it->first->get_iterator()->iter_domain->range_list.front();
+      int lb = static_cast<const int_expr*>(loop_range.lb)->value;
+      bool is_rollable = true;
+      for( std::map<std::string,int>::iterator jt = it->second.begin() ; jt != it->second.end() && is_rollable ; jt++ ){
+	///Not defined by other loops
+	if( num_loop_defs[jt->first] != 1 )
+	  is_rollable = false;
+	///All the initial values read are defined before the loop
+	for( int lag = 1 ; lag <= jt->second && is_rollable ; lag++ ){
+	  bool found_initial = false;
+	  for( std::deque<stmt_node*>::const_iterator kt = fn_body.begin() ; kt != fn_body.end() && *kt != it->first ; kt++ ){
+	    if( (*kt)->get_type() == VEC_STMT && jt->first.compare((*kt)->get_name()) == 0 && (*kt)->get_offset() == lb - lag ){
+	      found_initial = true;
+	      break;
+	    }
+	  }
+	  is_rollable = found_initial;
+	}
+      }
+
+      ///Check the accesses outside the loop
+      for( int stmt_num = 0 ; stmt_num <= (int)fn_body.size() && is_rollable ; stmt_num++ ){
+	CollectVecIds curr_ids;
+	if( stmt_num == (int)fn_body.size() )
+	  curr_ids.collect(curr_fn->get_return_expr());
+	else if( fn_body[stmt_num] == it->first )
+	  continue;
+	else if( fn_body[stmt_num]->get_type() == VEC_STMT )
+	  curr_ids.collect(fn_body[stmt_num]->get_rhs());
+	else{
+	  const std::deque<stmt_node*>& loop_body = fn_body[stmt_num]->get_body()->stmt_list;
+	  for( std::deque<stmt_node*>::const_iterator jt = loop_body.begin() ; jt != loop_body.end() ; jt++ )
+	    curr_ids.collect((*jt)->get_rhs());
+	}
+	for( std::deque<vec_id_expr_node*>::iterator jt = curr_ids.vec_ids.begin() ; jt != curr_ids.vec_ids.end() ; jt++ ){
+	  if( it->second.count((*jt)->get_name_string()) == 0 )
+	    continue;
+	  if( (*jt)->get_access_iterator() != NULL )
+	    is_rollable = false;
+	  else if( (*jt)->get_offset_param() )
+	    is_rollable = ( loop_range.ub->type == P_PARAM && static_cast<const param_expr*>(loop_range.ub)->param == (*jt)->get_offset_param() );
+	  else if( (*jt)->get_offset() >= lb )
+	    is_rollable = ( loop_range.ub->type == P_INT && static_cast<const int_expr*>(loop_range.ub)->value == (*jt)->get_offset() );
+	  if( !is_rollable )
+	    break;
+	}
+      }
+
+      if( is_rollable ){
+	rolled_loops.insert(it->first);
+	for( std::map<std::string,int>::iterator jt = it->second.begin() ; jt != it->second.end() ; jt++ )
+	  rolled_names.insert(jt->first);
+      }
+    }
   }
 
   stmt_node* visit_for_stmt(for_stmt_node* curr_stmt, int state){
     //printf("Found For Stmt\n");
+    if( rolled_loops.count(curr_stmt) )
+      return NULL;
     const std::deque<range_coeffs>& range_list = curr_stmt->get_iterator()->iter_domain->range_list;
     assert((range_list.size() == 1 ) && "[ME] : Error : Currently can handle only loops on single-depth\n");
+    for( std::deque<range_coeffs>::const_iterator it = range_list.begin() ; it != range_list.end() ; it++ ){
+      if( it->ub->type != P_INT ){
+	fprintf(stderr,"[ME] : Error! : for-loop over %s has a parametric bound, it has to be kept rolled (--roll-loops) with iterations that only read values of previous iterations\n",curr_stmt->get_iterator()->name.c_str());
+	exit(1);
+      }
+    }
     replacements.push_back(std::pair<for_stmt_node*,for_stmt_seq*>(curr_stmt,new for_stmt_seq()));
     for( std::deque<range_coeffs>::const_iterator it = range_list.begin() ; it != range_list.end() ; it++ ){
       assert((it->lb->type == P_INT && it->ub->type == P_INT) && ("[ME] : Error : Cant hand parameteric for-loops\n"));
@@ -72,7 +236,10 @@ private:
   }
 
   stmt_node* visit_single_stmt(stmt_node* curr_stmt, int state){
-    if( curr_stmt->get_access_iterator() ){
+    if( rolled_names.count(curr_stmt->get_name_string()) ){
+      return ASTVisitor::visit_single_stmt(curr_stmt,state);
+    }
+    else if( curr_stmt->get_access_iterator() ){
       //printf("Stmt: %p, state : %d\n",curr_stmt,state);
       std::stringstream new_name;
       
@@ -126,7 +293,10 @@ private:
 
   vector_expr_node* visit_vec_id_expr(vec_id_expr_node* curr_expr, int state){
     const for_iterator* curr_access_iterator =  curr_expr->get_access_iterator();
-    if( curr_access_iterator ){
+    if( rolled_names.count(curr_expr->get_name_string()) ){
+      return NULL;
+    }
+    else if( curr_access_iterator ){
       int value = state;
       if( curr_expr->get_offset() != DEFAULT_RANGE ){
     	if( curr_access_iterator->is_positive )
@@ -0,0 +1,124 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#ifndef __VALUE_RANGE_HPP__
+#define __VALUE_RANGE_HPP__
+
+#include <map>
+#include <set>
+#include <string>
+#include "AST/parser.hpp"
+
+/** Interval of values an integer expression can take */
+struct value_range{
+  long long lb;
+  long long ub;
+
+  value_range() :
+    lb(0), ub(0) { }
+
+  value_range(long long l, long long u) :
+    lb(l), ub(u) { }
+
+  inline bool contains(const value_range& inner) const{
+    return lb <= inner.lb && inner.ub <= ub;
+  }
+
+  ///Range of values representable by an integer type in the generated
+  ///code, int8 is unsigned
+  static value_range of_type(basic_data_types);
+};
+
+
+/** Value-range analysis of the integer expressions within stencil
+    functions. For every expression whose value in the generated C code
+    is an integer, two intervals are computed : the raw range of the
+    value computed by the operation (in int, after the usual promotions),
+    and the range after the conversion to the type of the expression,
+    which happens when the value is stored in a temporary of that
+    type. Conversions to int8 and int16 wrap around, or saturate when
+    the analysis is created for saturating conversions. Values of
+    vectors are assumed to be within the range of their element type,
+    which includes the constants used for boundaries */
+class ValueRangeAnalysis{
+
+private:
+
+  ///Saturate conversions to int8 and int16 instead of wrapping
+  bool saturate;
+
+  ///Stencil functions already analyzed
+  std::set<const stencilfn_defn_node*> analyzed_fns;
+
+  ///Raw and converted ranges of the integer expressions analyzed
+  std::map<const expr_node*,std::pair<value_range,value_range> > ranges;
+
+  ///Ranges of the local scalars of the function being analyzed
+  std::map<std::string,value_range> local_ranges;
+
+  ///Compute the ranges of an expression and its sub-expressions,
+  ///returns false if the expression does not have an integer value
+  bool analyze_expr(const expr_node*, value_range&);
+
+  ///Raw range of a binary operation, given the ranges of its operands
+  value_range get_op_range
+  (const expr_op_node*, const value_range&, const value_range&) const;
+
+public:
+
+  ValueRangeAnalysis() :
+    saturate(false) { }
+
+  ~ValueRangeAnalysis() { }
+
+  inline void set_saturate(bool value){
+    saturate = value;
+  }
+
+  inline bool is_saturating() const{
+    return saturate;
+  }
+
+  static bool is_integer_type(basic_data_types);
+
+  ///Range of a value after conversion to an integer type
+  value_range convert(const value_range&, basic_data_types) const;
+
+  ///Analyze the expressions of a stencil function, if not done already
+  void analyze(const stencilfn_defn_node*);
+
+  ///Get the range of an expression after conversion to its type, returns
+  ///false if the expression was not analyzed or is not an integer
+  bool get_range(const expr_node*, value_range&) const;
+
+  ///Get the range of the value computed by an expression before
+  ///conversion to its type
+  bool get_raw_range(const expr_node*, value_range&) const;
+
+};
+
+#endif
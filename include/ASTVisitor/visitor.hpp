@@ -297,7 +297,7 @@ vector_expr_node* ASTVisitor<State>::visit_fnid_expr(fnid_expr_node* expr, State
     if( new_expr ){
       delete it->arg_expr;
       it->arg_expr = new_expr;
-      //new_expr->add_usage(expr);
+      new_expr->add_usage(expr);
     }
   }
   return NULL;
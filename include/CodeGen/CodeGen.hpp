@@ -85,6 +85,13 @@ public:
   (const fnid_expr_node* fn, std::deque<offset_hull>& offsets,
    const domainfn_node* outputIdxInfo, bool considerBdyInfo = false) const;
 
+  /// \brief readsGhostZone Checks if an argument of a stencil application
+  /// reads the points outside its domain from a ghost zone, the boundary
+  /// condition need not be applied to such arguments
+  /// \param arg The argument expression
+  virtual bool readsGhostZone(const vector_expr_node*) const
+  { return false; }
+
   /// Function to apply an offset to a domain to ignore the boundaries
   void ApplyOffset
   (domain_node* loop_domain, const std::deque<offset_hull>& boundary_offsets)
@@ -99,6 +106,12 @@ protected:
   void PrintCStructDefinition
   (stringBuffer& curr_buffer, bool define_cuda_structs = true);
 
+  /// Print the arguments that pass a struct vector as one buffer per field,
+  /// pointer is the pointer type of each argument
+  void PrintCFieldArgs
+  (const data_types& struct_type, const std::string& name,
+   stringBuffer& curr_buffer, const std::string& pointer = "*");
+
   void PrintCParametricDefines(stringBuffer& curr_buffer);
 };
 
@@ -36,8 +36,11 @@
 #include <fstream>
 #include <cmath>
 #include <map>
+#include <set>
+#include <algorithm>
 #include "AST/parser.hpp"
 #include "ASTVisitor/convert_boundaries.hpp"
+#include "ASTVisitor/value_range.hpp"
 #include "program_opts.hpp"
 #include "CodeGen/CodeGen.hpp"
 
@@ -48,11 +51,28 @@ struct c_var_info{
   std::string symbol_name;
   data_types elem_type;
   domain_node* domainEdges;
+  ///When the buffer only holds a window of the outermost dimension of
+  ///expr_domain, the index of the first point held (empty otherwise)
+  std::string window_offset;
+  ///For struct vectors stored as one buffer per field, the buffers in the
+  ///order of the fields of elem_type (empty for arrays of structs)
+  std::deque<c_var_info*> field_vars;
+  ///When the rows of the innermost dimension are padded, the variable holding
+  ///the number of elements between successive rows (empty otherwise)
+  std::string row_pitch;
+  ///When the buffer is padded with a ghost zone, the width of the zone in
+  ///each dimension and the domain without it (empty and NULL otherwise).
+  ///expr_domain includes the ghost zone
+  std::deque<int> ghost_zone;
+  const domain_node* interior_domain;
   c_var_info
   (const std::string& name, const domain_node* ed, const data_types& et):
     expr_domain(ed),
     symbol_name(name),
-    domainEdges(NULL)
+    domainEdges(NULL),
+    window_offset(""),
+    row_pitch(""),
+    interior_domain(NULL)
   {
     elem_type.assign(et);
   }
@@ -156,6 +176,15 @@ typedef std::map<std::string,c_scalar_info> c_scalar_table;
 typedef std::map<std::string,c_scalar_info>::iterator c_scalar_symbol;
 
 
+///Conversion of an integer value held in vector registers to a narrower type
+enum simd_conversion_type{
+  SIMD_CONVERT_NONE, ///< The register already holds the converted value
+  SIMD_CONVERT_WRAP, ///< Keep the low bits, sign-extended for int16
+  SIMD_CONVERT_CLAMP, ///< Saturate to the range of the type
+  SIMD_CONVERT_UNSUPPORTED ///< The register does not hold the exact value
+};
+
+
 ///C-iterator descriptor
 struct c_iterator{
   std::string name;
@@ -177,6 +206,32 @@ struct c_iterator{
   bool is_unit_trip_count() const { return unit_trip_count; }
 };
 
+///Registers that hold the values of a stencil input read by a block of
+///unrolled iterations of the innermost loop, for accesses that differ only in
+///the innermost offset
+struct c_window_group{
+  const c_symbol_info* symbol;
+  domainfn_node* scale_fn;
+  data_types elem_type;
+  int min_offset;
+  int max_offset;
+  std::deque<std::string> registers;
+  ~c_window_group() {
+    delete scale_fn;
+  }
+};
+
+///Variable of the kernel used in the parallel region, which is outlined into a
+///function when the forma runtime is used. Arrays and read-only scalars are
+///copied into the region, other scalars are accessed through their address
+struct c_region_capture{
+  std::string elem_type;
+  std::string name;
+  bool is_array;
+  bool is_restrict;
+  bool by_reference;
+};
+
 
 /** Main class for C-Code-generator  */
 class PrintC  : public CodeGen
@@ -219,6 +274,181 @@ protected:
   bool generate_unroll_code;
   std::deque<int> unroll_factors;
 
+  /// Options that control tiling of loop nests
+  bool generate_tiled_code;
+  std::deque<int> tile_sizes;
+
+  /// Options that control fusion of stencil applications
+  bool fuse_stencils;
+  int fusion_tile_size;
+  int time_tile_steps;
+
+  ///Producers are fused into their consumer if fuse_all_stages is set, unless
+  ///their schedule sets another compute level
+  bool fuse_all_stages;
+
+  ///Statements whose computation is deferred to the tiles of their consumer
+  std::set<const stmt_node*> fused_producers;
+
+  /// Schedules of the stages of the program, indexed by the name of the
+  /// statement ("return" for the return expression). The options set for the
+  /// stage being generated override the global ones, kept in default_*
+  std::map<std::string,stage_schedule> stage_schedules;
+  std::deque<int> default_unroll_factors;
+  std::deque<int> default_tile_sizes;
+  std::string default_simd_isa;
+
+  /// Number of outer loops with more than one iteration that are run by every
+  /// thread before the loop distributed across threads, for the stage being
+  /// generated. parallel_loop_depth is the number used for the current patch,
+  /// which may have fewer loops
+  int parallel_dim;
+  int parallel_loop_depth;
+
+  ///Bounds along the outermost dimension to which the loops of a stencil
+  ///application are restricted, set while generating a fused tile
+  parametric_exp* tile_window_lb;
+  parametric_exp* tile_window_ub;
+
+  /// Options that control reuse of buffers of intermediates
+  bool reuse_buffers;
+
+  /// Intermediates are allocated on buffer_alignment byte boundaries, with
+  /// padded rows, if aligned_buffers is set
+  bool aligned_buffers;
+  int buffer_alignment;
+
+  /// Vector stores of the statements whose values are not reused soon are
+  /// non-temporal if streaming_stores is set. stream_curr_stmt is set while
+  /// the code for such a statement is generated
+  bool streaming_stores;
+  bool stream_curr_stmt;
+  bool emitted_stream_stores;
+
+  /// Intermediates are first touched with the static partition of the loops
+  /// that compute them if numa_first_touch is set. Pages of the statements
+  /// read with a different partition are interleaved across nodes if
+  /// numa_interleave is set, interleave_curr_stmt is set while the code for
+  /// such a statement is generated
+  bool numa_first_touch;
+  bool numa_interleave;
+  bool interleave_curr_stmt;
+
+  /// The stages of the program are OpenMP tasks with dependences between
+  /// them, and their loops are taskloops, if use_omp_tasks is set
+  bool use_omp_tasks;
+
+  /// The parallel region is run by the team of the forma runtime, and the
+  /// distributed loops get their iterations from it, if use_forma_runtime is
+  /// set. The body of the region is generated in region_code, and the
+  /// variables of the kernel it uses are in region_captures
+  bool use_forma_runtime;
+  std::string kernel_name;
+  std::string region_code;
+  std::deque<c_region_capture> region_captures;
+
+  /// The kernel is split into <kernel>_create, <kernel>_run and
+  /// <kernel>_destroy, with the intermediates in a workspace that lives
+  /// across runs, if plan_api is set. workspace_size_code computes the size of
+  /// the workspace and the pitch of its buffers
+  bool plan_api;
+  std::string workspace_size_code;
+
+  /// A batched entry point <kernel>_batch, that computes the program on
+  /// multiple images, is generated if batch_api is set
+  bool batch_api;
+
+  /// The kernel is <kernel>_roi, that computes a region of the output whose
+  /// bounds are its arguments, if roi_api is set. roi_windows are the windows
+  /// of the stencils and scaled expressions needed for the region, roi_window
+  /// is set while generating the patches of one of them. The bodies of vector
+  /// functions called once are computed over the window of the call
+  bool roi_api;
+  std::map<const vector_expr_node*,domain_node*> roi_windows;
+  std::map<const vectorfn_defn_node*,int> roi_vectorfn_calls;
+  std::deque<parameter_defn*> roi_bounds;
+  const domain_node* roi_window;
+
+  /// Conditions on the parameters under which a rolled loop whose result is
+  /// read computes no instance, the kernel rejects them on entry
+  std::deque<std::string> empty_loop_checks;
+
+  /// Intermediates read with a boundary condition are padded with a ghost
+  /// zone if ghost_zones is set. ghost_halos and ghost_bdys are the width of
+  /// the zone of each statement or argument computed into a buffer, and the
+  /// condition it is filled with. ghost_args are the arguments that read
+  /// them without checks. curr_ghost_zone is set while allocating the buffer
+  bool ghost_zones;
+  std::map<const vector_expr_node*,std::deque<int> > ghost_halos;
+  std::map<const vector_expr_node*,const bdy_info*> ghost_bdys;
+  std::set<const vector_expr_node*> ghost_args;
+  const std::deque<int>* curr_ghost_zone;
+  std::deque<domain_node*> ghost_domains;
+
+  /// The edges and corners of stencils are generated with only the checks of
+  /// their side if specialize_bdys is set. patch_sides is the side of the
+  /// patch being generated along each dimension (-1 lower edge, 0 interior, 1
+  /// upper edge), used for the checks if one_sided_checks is set.
+  /// skip_interior_patch is set when only the edges are generated
+  bool specialize_bdys;
+  std::deque<int> patch_sides;
+  bool one_sided_checks;
+  bool skip_interior_patch;
+  void add_region_capture
+  (const std::string& elem_type, const std::string& name, bool is_array,
+   bool is_restrict, bool by_reference);
+
+  ///Buffers allocated by printMalloc that can be reused once dead
+  std::set<c_var_info*> reusable_vars;
+
+  ///Buffers that are no longer live, available for reuse
+  std::deque<c_var_info*> free_vars;
+
+  /// Options that control reuse of loaded values along the innermost loop
+  bool use_sliding_window;
+
+  ///Register windows of the unrolled block being generated
+  std::deque<c_window_group*> window_groups;
+
+  ///Accesses of the current unrolled iteration read from window registers
+  std::map<std::string,std::string> window_registers;
+
+  /// Instruction set used to generate the innermost loops of interior patches
+  /// with vector intrinsics, empty if disabled
+  std::string simd_isa;
+
+  ///Element type of the vector registers used for the patch being generated,
+  ///T_STRUCT if the patch is generated with scalar code
+  basic_data_types simd_type;
+
+  ///Registers holding the values loaded by the vector iteration being
+  ///generated, indexed by the scalar access
+  std::map<std::string,std::string> simd_loads;
+
+  ///Registers holding the values of the local scalars of the stencil function
+  ///within the vector iteration being generated
+  std::map<std::string,std::string> simd_scalars;
+
+  ///For integer stencils, true if the register computed for an expression
+  ///holds its exact value, false if it only holds the value modulo the width
+  ///of the elements of simd_type
+  std::map<const expr_node*,bool> simd_exact;
+
+  ///Same as simd_exact for the local scalars of the stencil function
+  std::map<std::string,bool> simd_scalars_exact;
+
+  ///Ranges of the integer expressions within stencil functions, the
+  ///conversions to int8 and int16 saturate if enabled
+  ValueRangeAnalysis value_ranges;
+
+  /// Options that control the layout of struct vectors, intermediates are
+  /// stored as one buffer per field if soa_structs is set
+  bool soa_structs;
+
+  ///Struct arguments (and "return" for the output) passed to the kernel as one
+  ///buffer per field
+  std::set<std::string> soa_args;
+
   ///Creating unique iterators
   std::string get_new_iterator(stringBuffer*);
   ///Counter for number of iterator variables used (also the current iterator
@@ -259,12 +489,70 @@ protected:
   (const parametric_exp* lb,const parametric_exp* ub, int unroll_factor,
    bool isInnerMost);
 
+  /// \brief is_distributed_loop Check if a loop nested within the loops of
+  /// iters up to outer_end is distributed across threads
+  /// \param outer_end End of the loops enclosing the loop
+  /// \return true if parallel_loop_depth of the enclosing loops have more than
+  /// one iteration
+  bool is_distributed_loop
+  (std::deque<c_iterator*>::const_iterator outer_end) const;
+
+  /// \brief print_omp_loop_pragma Function to print the pragma that
+  /// distributes the next loop across threads
+  /// \param private_vars The iterators of the loop
+  /// \param collapse Number of perfectly nested loops distributed
+  void print_omp_loop_pragma(const std::string& private_vars, int collapse);
+
+  /// \brief print_runtime_loop_header Function to print the header of a loop
+  /// whose iterations are distributed by the forma runtime
+  /// \param iter_var The iterator of the loop
+  /// \param lb Lower bound of the loop
+  /// \param ub Upper bound of the loop
+  /// \param step Increment of the iterator
+  void print_runtime_loop_header
+  (const std::string& iter_var, const std::string& lb, const std::string& ub,
+   int step);
+
   /// \breif printForFooter Function to print the footer of the for loop
   void printForFooter();
 
+  /// \brief printTileHeader Function to print header of a loop that steps
+  /// over tiles of a given size. The iterator is not added to iters
+  /// \param lb Lower bound of the loop
+  /// \param ub upper bound of the loop
+  /// \param tile_size Number of iterations in each tile
+  /// \return Name of the tile iterator
+  std::string printTileHeader
+  (const parametric_exp* lb, const parametric_exp* ub, int tile_size);
+
   /// function to malloc a variable
   virtual c_var_info* printMalloc
   (std::string,data_types,const domain_node*);
+  /// function to print the number of elements of the buffer of a variable,
+  /// including the padding of its rows
+  void print_buffer_size(const c_var_info*, std::stringstream&);
+  /// function to print the number of elements between successive rows of the
+  /// innermost dimension of a buffer, padded or not
+  void print_row_pitch(const c_var_info*, std::stringstream&);
+  /// function to zero a buffer with the static partition of the loops that
+  /// compute it, returns false if it cannot be partitioned at this point
+  bool print_first_touch(const c_var_info*);
+  /// function to zero a buffer before the statement it holds is computed
+  void print_clear_buffer(const c_var_info*);
+  /// function to make the non-temporal stores of a thread visible
+  void print_stream_fence();
+
+  /// function to synchronize all threads of the parallel region
+  void print_barrier();
+  /// function to malloc a struct variable as one buffer per field
+  c_var_info* printSoAMalloc(std::string,data_types,const domain_node*);
+  /// \brief add_field_vars Bind the fields of a struct variable to buffers
+  /// named <symbol_name>_<field> that are allocated elsewhere
+  void add_field_vars(c_var_info* curr_var);
+  /// \brief get_field_var Buffer that holds a field of a struct variable
+  /// \return the variable itself if the variable is an array of structs
+  const c_var_info* get_field_var
+  (const c_var_info* curr_var, const std::string& field_name) const;
   ///Function to initialize the value of a scalar variable
   virtual c_var_info* init_value_var
   (std::string& curr_value, const data_types& curr_data_type){
@@ -317,7 +605,8 @@ protected:
   ( const c_var_info*, const std::deque<std::string>&, std::stringstream& );
   void check_index_value
   (std::string& curr_index, std::string& is_bdy_var,
-   parametric_exp* lb, parametric_exp* ub, const bdy_info* curr_bdy);
+   parametric_exp* lb, parametric_exp* ub, const bdy_info* curr_bdy,
+   bool check_lb = true, bool check_ub = true);
 
 
   ///Simple access to point in a domain
@@ -344,6 +633,18 @@ protected:
    std::stringstream&, const bdy_info* curr_bdy_condn = NULL );
 
 
+  /// \brief print_vector_point Read a point of a vector, gathering the fields
+  /// of struct vectors stored as one buffer per field
+  /// \param curr_var The variable read
+  /// \param field_name Field read, empty to read the whole element
+  /// \param scale_domain Scaling function of the access (can be NULL)
+  /// \param sub_domain Offset of the access (can be NULL)
+  /// \param curr_bdy_condn Boundary condition of stencil accesses
+  void print_vector_point
+  (const c_var_info* curr_var, const std::string& field_name,
+   const domainfn_node* scale_domain, const domain_node* sub_domain,
+   std::stringstream& curr_stream, const bdy_info* curr_bdy_condn = NULL);
+
   ///Access an extrapolated point on the LHS
   void print_extrapolate_point
   (const c_var_info*, const domainfn_node*, std::stringstream& );
@@ -405,6 +706,15 @@ protected:
   std::string print_expr_op(const expr_op_node*, c_symbol_table&,
                             bool handle_bdys = false);
 
+  /// \brief print_int_conversion Clamp the value of an expression stored to
+  /// int8 or int16 when conversions saturate and the value might not be
+  /// within the range of the type
+  /// \param is_raw Use the range of the value computed by the expression,
+  /// before its conversion to the type of the expression
+  std::string print_int_conversion
+  (const expr_node*, const std::string& value, basic_data_types to_type,
+   bool is_raw);
+
   /// \brief print_stencil_op_helper Helper function to print stencil operations
   /// \param curr_symbol The symbol
   /// \param scale_fn Scaling function to be used
@@ -487,6 +797,147 @@ protected:
    c_symbol_info* output_symbol, domain_node* loop_domain,
    bool is_bdy, bool unroll_loops, std::deque<int>& curr_unroll_factors);
 
+  /// \brief print_patch_tiled Function to print code for each patch that
+  /// iterates over tiles of the patch, with the tiles distributed across
+  /// threads. Each tile is generated using print_patch_untiled
+  /// \param curr_fn the function expression being handled, is a stencil
+  /// function application
+  /// \param input_exprs List of symbols that corr. to arguments of stencil fn
+  /// \param output_symbol the buffer to which the result is to be written
+  /// \param loop_domain the domain for the current patch
+  /// \param is_bdy Boolean to specify if this is a boundary patch
+  /// \param curr_unroll_factors Unroll factors used in kernel
+  /// \param unroll_loops Boolean to generate unrolled code
+  void print_patch_tiled
+  (const fnid_expr_node* curr_fn, std::deque<c_symbol_info*>& input_exprs,
+   c_symbol_info* output_symbol, domain_node* loop_domain,
+   bool is_bdy, bool unroll_loops, std::deque<int>& curr_unroll_factors);
+
+  /// \brief init_window_groups Find the groups of stencil accesses that
+  /// differ only in the innermost offset, and allocate registers for them
+  /// \param curr_fn the function expression being handled, is a stencil
+  /// function application
+  /// \param input_exprs List of symbols that corr. to arguments of stencil fn
+  /// \param ndims Loop dimensionality
+  /// \param block_size Number of unrolled iterations of the innermost loop
+  /// that share the registers
+  void init_window_groups
+  (const fnid_expr_node* curr_fn, std::deque<c_symbol_info*>& input_exprs,
+   int ndims, int block_size);
+
+  /// \brief collect_stencil_ops Collect all stencil operations in an
+  /// expression of a stencil function
+  void collect_stencil_ops
+  (const expr_node* curr_expr, std::deque<const stencil_op_node*>& ops);
+
+  /// \brief print_window_access Print the access of a window group at an
+  /// offset along the innermost dimension, w.r.t. the current iterators
+  std::string print_window_access(const c_window_group*, int offset);
+
+  /// \brief print_window_loads Load the registers of all window groups for
+  /// a block of unrolled iterations of the innermost loop
+  void print_window_loads();
+
+  /// \brief set_window_registers Map the accesses of an unrolled iteration
+  /// of the innermost loop to the window registers
+  /// \param iteration The unrolled iteration within the block
+  void set_window_registers(int iteration);
+
+  /// \brief clear_window_groups Release the window groups of a block
+  void clear_window_groups();
+
+  /// \brief get_simd_width Number of elements of a type held by a vector
+  /// register of the instruction set used
+  int get_simd_width(basic_data_types) const;
+
+  /// \brief get_simd_vector_type C type of the vector registers of simd_type
+  std::string get_simd_vector_type() const;
+
+  /// \brief get_simd_intrinsic Name of the intrinsic that applies an
+  /// operation to vector registers of simd_type
+  std::string get_simd_intrinsic(const std::string& op) const;
+  std::string get_simd_intrinsic
+  (const std::string& op, basic_data_types elem_type) const;
+
+  /// \brief check_simd_stencil Check if the stencil function application can
+  /// be computed using vector registers along the innermost loop. Sets
+  /// simd_type if that is the case
+  /// \param curr_fn the stencil function application expression
+  /// \param input_exprs List of symbols that corr. to arguments of stencil fn
+  /// \param output_symbol the symbol for the buffer to write to
+  bool check_simd_stencil
+  (const fnid_expr_node* curr_fn, std::deque<c_symbol_info*>& input_exprs,
+   const c_symbol_info* output_symbol);
+
+  /// \brief check_simd_expr Check if all operations of an expression within
+  /// the stencil function are supported on vector registers of simd_type
+  bool check_simd_expr(const expr_node*, c_symbol_table&);
+
+  /// \brief check_simd_int_expr Same as check_simd_expr for integer
+  /// stencils, records in simd_exact whether the value computed is exact
+  bool check_simd_int_expr(const expr_node*, c_symbol_table&);
+
+  /// \brief get_simd_int_conversion Operation needed on vector registers of
+  /// simd_type to convert a value to an integer type
+  /// \param curr_range Range of the value before conversion
+  /// \param is_exact Whether the register holds the exact value, updated for
+  /// the converted value
+  simd_conversion_type get_simd_int_conversion
+  (const value_range& curr_range, basic_data_types to_type, bool& is_exact);
+
+  /// \brief print_simd_int_conversion Generate the conversion of a register
+  /// holding the value of an expression to an integer type
+  std::string print_simd_int_conversion
+  (const expr_node*, const std::string& curr_register,
+   basic_data_types to_type, bool is_raw);
+
+  /// \brief print_simd_load Generate the load of consecutive elements of
+  /// a type into a register of simd_type, widening them if needed
+  std::string print_simd_load
+  (const std::string& curr_access, basic_data_types elem_type);
+
+  /// \brief print_simd_store Generate the store of a register of simd_type
+  /// to consecutive elements of a type, narrowing them if needed
+  void print_simd_store
+  (const std::string& curr_access, const std::string& curr_register,
+   basic_data_types elem_type);
+
+  /// \brief new_simd_register Declare a vector register initialized to a value
+  std::string new_simd_register(const std::string& value);
+
+  /// \brief print_simd_expr Generate the computation of an expression within
+  /// the stencil function for a vector of consecutive points along the
+  /// innermost loop, returns the register that holds the result
+  std::string print_simd_expr(const expr_node*, c_symbol_table&);
+
+  /// \brief print_simd_ternary Generate a ternary expression as a blend of
+  /// the two values based on the comparison
+  std::string print_simd_ternary(const ternary_expr_node*, c_symbol_table&);
+
+  /// \brief print_simd_stencilfn_body Generate the body of a stencil function
+  /// for a vector of consecutive points along the innermost loop
+  /// \param curr_fn the stencil function application expression
+  /// \param input_exprs List of symbols that corr. to arguments of stencil fn
+  /// \param output_symbol the symbol for the buffer to write to
+  void print_simd_stencilfn_body
+  (const fnid_expr_node* curr_fn, std::deque<c_symbol_info*>& input_exprs,
+   c_symbol_info* output_symbol);
+
+  /// \brief init_stage_schedules Set the schedules of the stages, and keep
+  /// the global options they override
+  /// \param command_opts The options of the compiler
+  void init_stage_schedules(const program_options& command_opts);
+
+  /// \brief set_stage_schedule Set the options used to generate a stage
+  /// \param stage_name Name of the stage, the global options are used for
+  /// stages without a schedule
+  void set_stage_schedule(const std::string& stage_name);
+
+  /// \brief get_stage_schedule Find the schedule of a stage
+  /// \param stage_name Name of the stage
+  /// \return the schedule, NULL if the stage has none
+  const stage_schedule* get_stage_schedule(const std::string& stage_name) const;
+
   /// \brief getCurrUnrollFactors Setup the unroll factors to use in the code
   /// generation
   /// \param ndims Dimensionality of the loop to be generated
@@ -582,6 +1033,48 @@ protected:
   void print_fnid_expr
   (const fnid_expr_node* curr_fn, c_symbol_table& fn_bindings);
 
+  /// \brief check_fusible_stencil Check if a function application is a
+  /// stencil whose code can be generated one tile at a time
+  /// \param curr_fn the function application
+  /// \return true if the application can be part of a fused loop nest
+  bool check_fusible_stencil(const fnid_expr_node* curr_fn) const;
+
+  /// \brief check_fusible_producer Check if the value computed by a statement
+  /// is read only by a stencil application that it can be fused into
+  /// \param curr_stmt the statement
+  /// \return true if the statement is to be computed within its consumer
+  bool check_fusible_producer(const stmt_node* curr_stmt) const;
+
+  /// \brief is_fused_stage Check if a statement of the program is to be
+  /// computed within the tiles of its consumer
+  /// \param curr_stmt the statement
+  /// \return true if the statement is fused into its consumer
+  bool is_fused_stage(const stmt_node* curr_stmt) const;
+
+  /// \brief get_fused_steps Number of successive stencil applications that
+  /// are computed within a tile when curr_stmt is computed, including itself
+  /// \param curr_stmt Statement whose rhs is a stencil application
+  /// \return 1 + the largest number of steps of the fused producers read
+  int get_fused_steps(const stmt_node* curr_stmt) const;
+
+  /// \brief collect_fused_stages Find the producers fused into a stencil
+  /// application, along with the halo of each along the outermost dimension
+  /// \param curr_fn the stencil function application
+  /// \param halo The halo of curr_fn, relative to the tile of the consumer
+  /// \param stages List of producers, ordered such that each producer appears
+  /// before its consumer
+  /// \param stage_halos The halo of each producer
+  void collect_fused_stages
+  (const fnid_expr_node* curr_fn, const offset_hull& halo,
+   std::deque<const stmt_node*>& stages, std::deque<offset_hull>& stage_halos);
+
+  /// \brief print_fused_stencils Generate a tiled loop nest that computes a
+  /// stencil application along with all the producers fused into it
+  /// \param curr_fn the stencil function application
+  /// \param fn_bindings Current symbol table
+  void print_fused_stencils
+  (const fnid_expr_node* curr_fn, c_symbol_table& fn_bindings);
+
 
   ///Methods used to precompute values of vector expressions
   void print_vector_expr(const vector_expr_node*,c_symbol_table&);
@@ -592,6 +1085,92 @@ protected:
   void print_vec_id_expr(const vec_id_expr_node*,c_symbol_table&);
   void print_stmt(const stmt_node*,c_symbol_table&,bool);
 
+  /// \brief print_rolled_loop Generate a for-loop that was not unrolled,
+  /// rotating between buffers for the instances of its variables
+  /// \param curr_loop The loop
+  /// \param fn_body The statements of the function containing the loop,
+  /// used to find the initial values it reads
+  /// \param fn_bindings Current symbol table
+  void print_rolled_loop
+  (const for_stmt_node* curr_loop, const std::deque<stmt_node*>& fn_body,
+   c_symbol_table& fn_bindings);
+
+  /// \brief collect_vec_id_defns Find the definitions of all vectors read by
+  /// a vector expression
+  /// \param curr_expr The expression being analyzed
+  /// \param defns The set to which the definitions are added
+  void collect_vec_id_defns
+  (const vector_expr_node* curr_expr,
+   std::set<const vector_expr_node*>& defns) const;
+
+  /// \brief compute_streamed_stmts Reuse analysis over the statements of a
+  /// vector function body
+  /// \param fn_body The statements of the function
+  /// \param return_expr The return expression of the function
+  /// \param streamed_stmts The set to which the statements that are not read
+  /// by the next statement computed are added
+  void compute_streamed_stmts
+  (const std::deque<stmt_node*>& fn_body, const vector_expr_node* return_expr,
+   std::set<const stmt_node*>& streamed_stmts) const;
+
+  /// \brief print_window_buffers Print the allocation, or the release, of
+  /// the windows of fused producers
+  /// \param slot_names The variables of the windows
+  /// \param slot_mallocs The statements that allocate the windows
+  /// \param allocate Print the allocation if true, the release otherwise
+  void print_window_buffers
+  (const std::deque<std::string>& slot_names,
+   const std::deque<std::string>& slot_mallocs, bool allocate);
+
+  /// \brief collect_task_inputs Find the variables computed by earlier tasks
+  /// that are read by an expression
+  /// \param curr_expr The expression
+  /// \param task_vars The variables of the statements computed by tasks
+  /// \param task_inputs The set to which the variables read are added
+  void collect_task_inputs
+  (const vector_expr_node* curr_expr,
+   const std::map<const stmt_node*,c_var_info*>& task_vars,
+   std::set<c_var_info*>& task_inputs) const;
+
+  /// \brief print_task_depend_item Print the list items of a depend clause
+  /// for a variable
+  void print_task_depend_item
+  (const c_var_info* curr_var, bool& first,
+   std::stringstream& curr_stream) const;
+
+  /// \brief print_stage_task Print the code of a stage as an OpenMP task
+  /// \param stage_expr The expression computed by the stage
+  /// \param stage_var The variable written by the stage
+  /// \param task_vars The variables of the statements computed by tasks
+  /// \param stage_buffer The code of the stage
+  void print_stage_task
+  (const vector_expr_node* stage_expr, const c_var_info* stage_var,
+   const std::map<const stmt_node*,c_var_info*>& task_vars,
+   stringBuffer* stage_buffer);
+
+  /// \brief compute_interleaved_stmts Find the statements of a vector
+  /// function body that are read by a statement over a range of the
+  /// outermost dimension that is not a shift of their own
+  /// \param fn_body The statements of the function
+  /// \param return_expr The return expression of the function
+  /// \param interleaved_stmts The set to which such statements are added
+  void compute_interleaved_stmts
+  (const std::deque<stmt_node*>& fn_body, const vector_expr_node* return_expr,
+   std::set<const stmt_node*>& interleaved_stmts) const;
+
+  /// \brief compute_last_uses Liveness analysis over the statements of a
+  /// vector function body
+  /// \param fn_body The statements of the function
+  /// \param return_expr The return expression of the function
+  /// \param last_use For each statement, the index of the last statement
+  /// whose computation reads it, or fn_body.size() if read by the return
+  /// expression
+  /// \return false if the body contains statements that cannot be analyzed
+  bool compute_last_uses
+  (const std::deque<stmt_node*>& fn_body,
+   const vector_expr_node* return_expr,
+   std::map<const stmt_node*,int>& last_use) const;
+
   /// \brief print_vectorfn_body_helper Function that implements the main parts
   /// of printing a vector function body
   /// \param curr_fn the function whose body is being printed
@@ -602,6 +1181,106 @@ protected:
   (const vectorfn_defn_node* curr_fn, c_symbol_table& fn_bindings,
    bool is_inlined);
 
+  /// \brief add_kernel_captures Add the arguments, parameters and outputs of
+  /// the kernel to the variables used by the parallel region
+  void add_kernel_captures
+  (const program_node* curr_program, const std::string& output_var);
+
+  /// \brief print_region_call Print the call that runs the parallel region
+  /// on the team of the forma runtime
+  void print_region_call();
+
+  /// \brief print_region_function Print the function the parallel region is
+  /// outlined into
+  void print_region_function(FILE* outfile);
+
+  /// \brief print_plan_functions Print the context of the kernel and the
+  /// functions that create, run and destroy it
+  /// \param outfile The generated file
+  /// \param input_args The input arguments of the kernel
+  /// \param param_args The parameters of the kernel
+  /// \param output_args The output buffers of the kernel
+  /// \param param_check_code Code checking the parameter constraints
+  void print_plan_functions
+  (FILE* outfile, const std::string& input_args, const std::string& param_args,
+   const std::string& output_args, const std::string& param_check_code);
+
+  /// \brief add_roi_demands Add the points of the statements read by an
+  /// expression that are needed to compute it over a window. Windows of
+  /// the stencils and scaled expressions within it are added to roi_windows
+  /// \param curr_expr The expression
+  /// \param curr_window The window, deleted or added to roi_windows, NULL if
+  /// the whole expression is computed
+  /// \param demands The points needed of each statement and vector function
+  /// parameter, NULL if all of them
+  void add_roi_demands
+  (const vector_expr_node* curr_expr, domain_node* curr_window,
+   std::map<const vector_expr_node*,domain_node*>& demands);
+
+  /// \brief add_body_roi_demands Windows of the statements of a function
+  /// body from the points needed by their consumers, in reverse order. Prints
+  /// the bounds of each window
+  /// \param fn_body The statements of the body
+  /// \param demands The points needed of each statement and parameter
+  void add_body_roi_demands
+  (const std::deque<stmt_node*>& fn_body,
+   std::map<const vector_expr_node*,domain_node*>& demands);
+
+  /// \brief count_vectorfn_calls Count the calls of each vector function
+  /// within an expression, and within the bodies of the functions it calls
+  /// \param curr_expr The expression or statement being analyzed
+  /// \param num_calls The number of calls of each vector function
+  void count_vectorfn_calls
+  (const vector_expr_node* curr_expr,
+   std::map<const vectorfn_defn_node*,int>& num_calls) const;
+
+  /// \brief compute_roi_windows Bounds inference from the region of the
+  /// output back to the statements of the program. Prints the bounds of the
+  /// window of each statement and adds it to roi_windows
+  /// \param program_fn The body of the program
+  void compute_roi_windows(const vectorfn_defn_node* program_fn);
+
+  /// \brief collect_ghost_uses Find the arguments of the stencils within an
+  /// expression that read a statement or an expression with a boundary
+  /// condition
+  /// \param curr_expr The expression
+  /// \param ghost_uses The arguments and the parameter they are bound to, for
+  /// every statement or argument expression
+  void collect_ghost_uses
+  (const vector_expr_node* curr_expr,
+   std::map<const vector_expr_node*,
+   std::deque<std::pair<const arg_info*,const vector_defn_node*> > >&
+   ghost_uses) const;
+
+  /// \brief compute_ghost_zones Find the statements and arguments of a
+  /// function body that are padded with a ghost zone, and the width of the
+  /// zone
+  /// \param fn_body The statements of the function
+  /// \param return_expr The return expression of the function
+  void compute_ghost_zones
+  (const std::deque<stmt_node*>& fn_body,
+   const vector_expr_node* return_expr);
+
+  /// \brief print_ghost_zone_fill Fill the ghost zone of a buffer after it is
+  /// computed, with the values the boundary condition gives
+  /// \param curr_var The padded buffer
+  /// \param curr_bdy The boundary condition
+  void print_ghost_zone_fill
+  (const c_var_info* curr_var, const bdy_info* curr_bdy);
+
+  bool readsGhostZone(const vector_expr_node* arg) const;
+
+  /// \brief print_batch_function Print the batched entry point
+  /// \param outfile The generated file
+  /// \param batch_args Types and names of the arguments of the batched kernel
+  /// \param image_call The statement that computes the image __image__
+  /// \param param_names The parameters of the kernel
+  /// \param image_size Number of points of an output image
+  void print_batch_function
+  (FILE* outfile, const std::deque<std::pair<std::string,std::string> >&
+   batch_args, const std::string& image_call, const std::string& param_names,
+   const std::string& image_size);
+
   virtual void print_program_body
   (const program_node*, c_symbol_table&,std::string&);
 
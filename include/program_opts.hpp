@@ -30,8 +30,32 @@
 
 #include <cstdio>
 #include <deque>
+#include <map>
 #include <string>
 
+///Where the values of a stage of the program are computed
+enum stage_compute_level{
+  COMPUTE_DEFAULT, ///As chosen by the global options
+  COMPUTE_ROOT,    ///Into a buffer that holds the whole stage
+  COMPUTE_INLINE,  ///Recomputed within the stencils that read it
+  COMPUTE_TILE     ///Within each tile of the stencil that reads it
+};
+
+///Schedule of a stage of the program, a statement of the program body or
+///its return expression. Options that are not set keep their global value
+struct stage_schedule{
+  std::deque<int> tile_sizes;
+  std::deque<int> unroll_factors;
+  ///Number of outer loops run by every thread before the distributed loop,
+  ///-1 if not set
+  int parallel_dim;
+  ///Instruction set for the vector loops, "none" to disable them, empty if
+  ///not set
+  std::string simd_isa;
+  stage_compute_level compute_level;
+  stage_schedule() :
+    parallel_dim(-1), simd_isa(""), compute_level(COMPUTE_DEFAULT) { }
+};
 
 struct program_options{
   /// input file
@@ -41,6 +65,10 @@ struct program_options{
   bool unroll_loops;
   bool forward_exprs;
   bool inline_vectorfn;
+  bool stencil_cse;
+  bool separable_stencils;
+  bool inline_pointwise;
+  bool simplify_stencils;
 
   /// Pretty print
   bool pretty_print;
@@ -52,6 +80,8 @@ struct program_options{
   bool use_single_malloc;
   bool generate_unroll_code;
   std::deque<int> unroll_factors;
+  std::deque<std::string> param_constraints;
+  std::map<std::string,stage_schedule> stage_schedules;
 
   /// Dot code-generation
   bool print_dot;
@@ -62,6 +92,30 @@ struct program_options{
   bool generate_affine;
   bool use_openmp;
   bool use_icc_pragmas;
+  bool fuse_stencils;
+  int fusion_tile_size;
+  int time_tile_steps;
+  bool generate_tiled_code;
+  std::deque<int> tile_sizes;
+  bool reuse_buffers;
+  bool roll_loops;
+  bool sliding_window;
+  std::string simd_isa;
+  bool soa_structs;
+  std::deque<std::string> soa_args;
+  bool saturate_int_casts;
+  bool aligned_buffers;
+  int buffer_alignment;
+  bool streaming_stores;
+  bool numa_first_touch;
+  bool numa_interleave;
+  bool omp_tasks;
+  std::string runtime;
+  bool plan_api;
+  bool batch_api;
+  bool roi_api;
+  bool ghost_zones;
+  bool specialize_bdys;
   std::string c_output_file;
 
   /// Cuda code generation options
@@ -80,6 +134,10 @@ struct program_options{
     unroll_loops(true),
     forward_exprs(false),
     inline_vectorfn(false),
+    stencil_cse(false),
+    separable_stencils(false),
+    inline_pointwise(false),
+    simplify_stencils(false),
 
     pretty_print(false),
 
@@ -96,6 +154,28 @@ struct program_options{
     generate_affine(false),
     use_openmp(true),
     use_icc_pragmas(false),
+    fuse_stencils(false),
+    fusion_tile_size(32),
+    time_tile_steps(0),
+    generate_tiled_code(false),
+    reuse_buffers(false),
+    roll_loops(false),
+    sliding_window(false),
+    simd_isa(""),
+    soa_structs(false),
+    saturate_int_casts(false),
+    aligned_buffers(false),
+    buffer_alignment(64),
+    streaming_stores(false),
+    numa_first_touch(false),
+    numa_interleave(false),
+    omp_tasks(false),
+    runtime("openmp"),
+    plan_api(false),
+    batch_api(false),
+    roi_api(false),
+    ghost_zones(false),
+    specialize_bdys(false),
     c_output_file(""),
 
     print_cuda(false),
@@ -108,6 +188,8 @@ struct program_options{
   {  }
   ~program_options(){  }
   void parse_options(int,char**);
+  void parse_schedule(const char*);
+  bool has_compute_level(stage_compute_level) const;
 };
 
 #endif
@@ -65,6 +65,12 @@ string get_op_string(operator_type op){
   case O_NE:
     op_string << "!=" ;
     break;
+  case O_SHL:
+    op_string << "<<" ;
+    break;
+  case O_SHR:
+    op_string << ">>" ;
+    break;
   default:
     ;
   }
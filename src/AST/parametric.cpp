@@ -27,6 +27,7 @@
 //****************************************************************************//
 #include "AST/parametric.hpp"
 #include <cassert>
+#include <algorithm>
 
 using namespace std;
 
@@ -397,6 +398,9 @@ parametric_exp* param_expr::ceil(int val){
   if( val == 1 ){
     return this;
   }
+  else if( is_multiple_of(this,val) ){
+    return divide(val);
+  }
   else{
     return new binary_expr(this,new int_expr(val),P_CEIL);
   }
@@ -419,6 +423,9 @@ parametric_exp* binary_expr::ceil(int val){
   if( val == 1 ){
     return this;
   }
+  else if( is_multiple_of(this,val) ){
+    return divide(val);
+  }
   else{
     return new binary_expr(this,new int_expr(val), P_DIVIDE);
   }
@@ -457,10 +464,19 @@ parametric_exp* param_expr::max(parametric_exp* rhs, bool no_copy)
       delete rhs;
     return this;
   }
+  else if( rhs->type == P_INT ){
+    parametric_exp* return_exp = max(static_cast<int_expr*>(rhs)->value);
+    if( no_copy )
+      delete rhs;
+    return return_exp;
+  }
   return new binary_expr(this,(no_copy ? rhs : copy(rhs) ),P_MAX);
 }
 
 parametric_exp* param_expr::max(int val){
+  int lb;
+  if( get_lower_bound(this,lb) && lb >= val )
+    return this;
   return new binary_expr(this,new int_expr(val),P_MAX);
 }
 
@@ -487,7 +503,11 @@ parametric_exp* binary_expr::max(parametric_exp* rhs, bool no_copy)
 
 parametric_exp* binary_expr::max(int val){
   parametric_exp* return_exp = NULL;
-  if( rhs_expr->type == P_INT ){
+  int lb;
+  if( get_lower_bound(this,lb) && lb >= val ){
+    return_exp = this;
+  }
+  else if( rhs_expr->type == P_INT ){
     if( type == P_MAX ){
       rhs_expr->max(val);
       return_exp = this;
@@ -659,3 +679,173 @@ bool parametric_exp::is_equal(const parametric_exp* lhs, const parametric_exp* r
     return false; 
   }
 }
+
+
+///Greatest common divisor of a and a positive b
+static int get_gcd(int a, int b)
+{
+  a = ( a < 0 ? -a : a );
+  while( b != 0 ){
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+
+bool parametric_exp::get_lower_bound(const parametric_exp* curr_exp, int& lb)
+{
+  switch(curr_exp->type){
+  case P_INT:
+    lb = static_cast<const int_expr*>(curr_exp)->value;
+    return true;
+  case P_PARAM: {
+    const parameter_defn* curr_param =
+      static_cast<const param_expr*>(curr_exp)->param;
+    if( curr_param->value != DEFAULT_RANGE ){
+      lb = curr_param->value;
+      return true;
+    }
+    lb = curr_param->lower_bound;
+    return curr_param->has_lower_bound;
+  }
+  case P_ADD: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    int lhs_lb, rhs_lb;
+    if( !get_lower_bound(curr_binary->lhs_expr,lhs_lb) ||
+        !get_lower_bound(curr_binary->rhs_expr,rhs_lb) )
+      return false;
+    lb = lhs_lb + rhs_lb;
+    return true;
+  }
+  case P_SUBTRACT: {
+    ///Only the upper bound of constants is known
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    int lhs_lb;
+    if( curr_binary->rhs_expr->type != P_INT ||
+        !get_lower_bound(curr_binary->lhs_expr,lhs_lb) )
+      return false;
+    lb = lhs_lb - static_cast<const int_expr*>(curr_binary->rhs_expr)->value;
+    return true;
+  }
+  case P_MULTIPLY: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    const parametric_exp* factor_exp = curr_binary->lhs_expr;
+    const parametric_exp* other_exp = curr_binary->rhs_expr;
+    if( factor_exp->type != P_INT )
+      std::swap(factor_exp,other_exp);
+    int other_lb;
+    if( factor_exp->type != P_INT ||
+        static_cast<const int_expr*>(factor_exp)->value < 0 ||
+        !get_lower_bound(other_exp,other_lb) )
+      return false;
+    lb = static_cast<const int_expr*>(factor_exp)->value * other_lb;
+    return true;
+  }
+  case P_DIVIDE:
+  case P_CEIL: {
+    ///Both are non-decreasing in the numerator for a positive denominator
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    int lhs_lb;
+    if( curr_binary->rhs_expr->type != P_INT ||
+        static_cast<const int_expr*>(curr_binary->rhs_expr)->value <= 0 ||
+        !get_lower_bound(curr_binary->lhs_expr,lhs_lb) || lhs_lb < 0 )
+      return false;
+    int denominator = static_cast<const int_expr*>(curr_binary->rhs_expr)->value;
+    lb = ( curr_exp->type == P_DIVIDE ? lhs_lb / denominator : CEIL(lhs_lb,denominator) );
+    return true;
+  }
+  case P_MAX: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    int lhs_lb, rhs_lb;
+    bool lhs_bounded = get_lower_bound(curr_binary->lhs_expr,lhs_lb);
+    bool rhs_bounded = get_lower_bound(curr_binary->rhs_expr,rhs_lb);
+    if( lhs_bounded && rhs_bounded )
+      lb = MAX(lhs_lb,rhs_lb);
+    else
+      lb = ( lhs_bounded ? lhs_lb : rhs_lb );
+    return lhs_bounded || rhs_bounded;
+  }
+  case P_MIN: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    int lhs_lb, rhs_lb;
+    if( !get_lower_bound(curr_binary->lhs_expr,lhs_lb) ||
+        !get_lower_bound(curr_binary->rhs_expr,rhs_lb) )
+      return false;
+    lb = MIN(lhs_lb,rhs_lb);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+
+bool parametric_exp::is_multiple_of(const parametric_exp* curr_exp, int factor)
+{
+  if( factor == 1 )
+    return true;
+  switch(curr_exp->type){
+  case P_INT:
+    return static_cast<const int_expr*>(curr_exp)->value % factor == 0;
+  case P_PARAM: {
+    const parameter_defn* curr_param =
+      static_cast<const param_expr*>(curr_exp)->param;
+    if( curr_param->value != DEFAULT_RANGE )
+      return curr_param->value % factor == 0;
+    return curr_param->multiple_of % factor == 0;
+  }
+  case P_ADD:
+  case P_SUBTRACT:
+  case P_MAX:
+  case P_MIN: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    return is_multiple_of(curr_binary->lhs_expr,factor) &&
+      is_multiple_of(curr_binary->rhs_expr,factor);
+  }
+  case P_MULTIPLY: {
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    const parametric_exp* factor_exp = curr_binary->lhs_expr;
+    const parametric_exp* other_exp = curr_binary->rhs_expr;
+    if( factor_exp->type != P_INT )
+      std::swap(factor_exp,other_exp);
+    if( factor_exp->type != P_INT )
+      return false;
+    ///The remaining part of the factor has to divide the other operand
+    int common_factor =
+      get_gcd(static_cast<const int_expr*>(factor_exp)->value,factor);
+    return is_multiple_of(other_exp,factor / common_factor);
+  }
+  default:
+    return false;
+  }
+}
+
+
+bool parameter_defn::add_constraint(param_constraint_type constraint, int val)
+{
+  switch(constraint){
+  case PC_EQUAL:
+    if( ( value != DEFAULT_RANGE && value != val ) || val % multiple_of != 0 ||
+        ( has_lower_bound && val < lower_bound ) )
+      return false;
+    value = val;
+    return true;
+  case PC_MULTIPLE: {
+    if( val <= 0 || ( value != DEFAULT_RANGE && value % val != 0 ) )
+      return false;
+    multiple_of = ( multiple_of / get_gcd(multiple_of,val) ) * val;
+    return true;
+  }
+  case PC_LOWER_BOUND:
+    if( value != DEFAULT_RANGE && value < val )
+      return false;
+    lower_bound = ( has_lower_bound ? MAX(lower_bound,val) : val );
+    has_lower_bound = true;
+    return true;
+  default:
+    assert(0);
+    return false;
+  }
+}
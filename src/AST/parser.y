@@ -50,6 +50,16 @@
   std::deque<for_iterator*> curr_iterator_stack;
   //param_table* curr_parameters = new param_table();
 
+  ///Constraints on the values of parameters specified on the command line
+  struct param_constraint{
+    std::string param_id;
+    param_constraint_type type;
+    int value;
+    bool is_used;
+  };
+  std::deque<param_constraint> param_constraints;
+  void add_param_defn(char* id, parameter_defn* new_defn);
+
 %}
 
 %union{
@@ -447,36 +457,16 @@ PARAMETER parameterlist ';'
 
 parameterlist:
 parameterlist ',' ID {
-  int not_new_param = global_params->add_symbol($3,new parameter_defn($3));
-  if( not_new_param ){
-    fprintf(stderr,"[ME] : Error! Duplicate parameter defn :%d.%d-%d.%d \n",yylloc.first_line, yylloc.first_column,yylloc.last_line, yylloc.last_column);
-    exit(1);
-  }
-  free($3);
+  add_param_defn($3,new parameter_defn($3));
 }
 | parameterlist ',' ID '=' INT {
-  int not_new_param = global_params->add_symbol($3,new parameter_defn($3,$5));
-  if( not_new_param ){
-    fprintf(stderr,"[ME] : Error! Duplicate parameter defn :%d.%d-%d.%d \n",yylloc.first_line, yylloc.first_column,yylloc.last_line, yylloc.last_column);
-    exit(1);
-  }
-  free($3);
+  add_param_defn($3,new parameter_defn($3,$5));
   }
 | ID {
-  int not_new_param = global_params->add_symbol($1,new parameter_defn($1));
-  if( not_new_param ){
-    fprintf(stderr,"[ME] : Error! Duplicate parameter defn :%d.%d-%d.%d \n",yylloc.first_line, yylloc.first_column,yylloc.last_line, yylloc.last_column);
-    exit(1);
-  }
-  free($1);
+  add_param_defn($1,new parameter_defn($1));
   }
 | ID '=' INT {
-  int not_new_param = global_params->add_symbol($1,new parameter_defn($1,$3));
-  if( not_new_param ){
-    fprintf(stderr,"[ME] : Error! Duplicate parameter defn :%d.%d-%d.%d \n",yylloc.first_line, yylloc.first_column,yylloc.last_line, yylloc.last_column);
-    exit(1);
-  }
-  free($1);
+  add_param_defn($1,new parameter_defn($1,$3));
   }
 
 
@@ -679,6 +669,21 @@ ID '=' vectorexpr ';'{
   $$ = new for_stmt_node(curr_iterator,$8);
   free($2);
 }
+| FOR ID '=' INT DOTDOT ID {
+  parameter_defn* ub_param = global_params->find_symbol($6);
+  if( ub_param == 0 ){
+    fprintf(stderr,"[ME]: ERROR! Unknown parameter :%s used as bound of iterator %s\n",$6,$2);
+    exit(1);
+  }
+  for_iterator* new_iterator = new for_iterator($2,new domain_node(new int_expr($4),new param_expr(ub_param)),true);
+  curr_iterator_stack.push_back(new_iterator);
+  free($6);
+}  forstmtseq ENDFOR {
+  for_iterator * curr_iterator = curr_iterator_stack.back();
+  curr_iterator_stack.pop_back();
+  $$ = new for_stmt_node(curr_iterator,$8);
+  free($2);
+}
 | DO ID '=' INT DOTDOT INT {
   for_iterator* new_iterator;
   if( $4 <= $6 )
@@ -787,8 +792,13 @@ ID {
     }    
   }
   if( it == curr_iterator_stack.rend() ){
-    fprintf(stderr,"[ME] : ERROR : Using undefined iterator %s in %s<%s>\n",$3,$1,$3);
-    exit(1);
+    ///Outside the loop, the parametric upper bound of a loop refers to its last instance
+    parameter_defn* ub_param = global_params->find_symbol($3);
+    if( ub_param == 0 ){
+      fprintf(stderr,"[ME] : ERROR : Using undefined iterator %s in %s<%s>\n",$3,$1,$3);
+      exit(1);
+    }
+    $$ = new vec_id_expr_node($1,curr_local_symbols,ub_param);
   }
   free($1);
   free($3);
@@ -1038,7 +1048,11 @@ paramexpr '+' paramexpr {
     fprintf(stderr,"[ME]: ERROR! Unknown parameter :%s at %d.%d-%d.%d\n",$1, yylloc.first_line, yylloc.first_column, yylloc.last_line, yylloc.last_column);
     exit(1);
   }
-  $$ = new param_expr(curr_defn);
+  ///Parameters specialized to a value are replaced by the value
+  if( curr_defn->value != DEFAULT_RANGE )
+    $$ = new int_expr(curr_defn->value);
+  else
+    $$ = new param_expr(curr_defn);
   free($1);
   }
 
@@ -1058,9 +1072,69 @@ void parser::parse_input()
   do{
     yyparse();
   }while(!feof(yyin));
+  for( std::deque<param_constraint>::iterator it = param_constraints.begin() ;
+       it != param_constraints.end() ; it++ )
+    if( !it->is_used ){
+      fprintf(stderr,"[ME] : Error! Constraint on unknown parameter %s\n",it->param_id.c_str());
+      exit(1);
+    }
   printf("Done Parsing\n");
 }
 
+void parser::set_param_constraints(const std::deque<std::string>& constraints)
+{
+  for( std::deque<std::string>::const_iterator it = constraints.begin() ; it != constraints.end() ; it++ ){
+    param_constraint new_constraint;
+    size_t id_end = it->find_first_of("=%>");
+    std::string constraint_op, constraint_value;
+    if( id_end != std::string::npos ){
+      size_t value_start = it->find_first_of("0123456789-",id_end);
+      constraint_op = it->substr(id_end,value_start-id_end);
+      if( value_start != std::string::npos )
+        constraint_value = it->substr(value_start);
+    }
+    char* value_end = NULL;
+    new_constraint.param_id = it->substr(0,id_end);
+    new_constraint.value = strtol(constraint_value.c_str(),&value_end,10);
+    new_constraint.is_used = false;
+    if( constraint_op.compare("=") == 0 )
+      new_constraint.type = PC_EQUAL;
+    else if( constraint_op.compare("%") == 0 && std::string(value_end).compare("==0") == 0 ){
+      new_constraint.type = PC_MULTIPLE;
+      value_end += 3;
+    }
+    else if( constraint_op.compare(">=") == 0 )
+      new_constraint.type = PC_LOWER_BOUND;
+    else
+      value_end = NULL;
+    if( new_constraint.param_id.empty() || constraint_value.empty() || value_end == NULL || *value_end != '\0' ||
+        ( new_constraint.type != PC_LOWER_BOUND && new_constraint.value <= 0 ) ){
+      fprintf(stderr,"[ME] : Error! Invalid parameter constraint %s\n",it->c_str());
+      exit(1);
+    }
+    param_constraints.push_back(new_constraint);
+  }
+}
+
+void add_param_defn(char* id, parameter_defn* new_defn)
+{
+  int not_new_param = global_params->add_symbol(id,new_defn);
+  if( not_new_param ){
+    fprintf(stderr,"[ME] : Error! Duplicate parameter defn :%d.%d-%d.%d \n",yylloc.first_line, yylloc.first_column,yylloc.last_line, yylloc.last_column);
+    exit(1);
+  }
+  for( std::deque<param_constraint>::iterator it = param_constraints.begin() ; it != param_constraints.end() ; it++ ){
+    if( it->param_id.compare(id) != 0 )
+      continue;
+    if( !new_defn->add_constraint(it->type,it->value) ){
+      fprintf(stderr,"[ME] : Error! Constraints on parameter %s are inconsistent\n",id);
+      exit(1);
+    }
+    it->is_used = true;
+  }
+  free(id);
+}
+
 void yyerror(const char* s){
   if (yylloc.first_line) {
     printf("%d.%d-%d.%d: ", yylloc.first_line, yylloc.first_column,
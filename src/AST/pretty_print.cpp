@@ -443,6 +443,8 @@ int vec_id_expr_node::compute_pretty_print_size()
   }
   else if( offset != DEFAULT_RANGE)
     pretty_print_size += NUM_STRING_SIZE(offset) + 2; ///'<'<INT'>'
+  else if( offset_param )
+    pretty_print_size += offset_param->param_id.size() + 2; ///'<'<ID>'>'
   if( field_num != -1 ){
     assert(base_elem_type.type ==T_STRUCT && base_elem_type.struct_info != NULL );
     pretty_print_size += 1 + base_elem_type.struct_info->fields[field_num].field_name.size();
@@ -479,6 +481,11 @@ void vec_id_expr_node::pretty_print() const
     PrettyPrinter::instance()->print(PPTokenString(curr_num.str()),curr_num.str().size());
     PrettyPrinter::instance()->print(PPTokenString(">"),1);
   }
+  else if( offset_param ){
+    PrettyPrinter::instance()->print(PPTokenString("<"),1);
+    PrettyPrinter::instance()->print(PPTokenString(offset_param->param_id),offset_param->param_id.size());
+    PrettyPrinter::instance()->print(PPTokenString(">"),1);
+  }
   if( field_num != -1 ){
     int field_print_size = base_elem_type.struct_info->fields[field_num].field_name.size();
     PrettyPrinter::instance()->print(PPTokenBreak(0,0),1+field_print_size);
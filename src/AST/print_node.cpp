@@ -107,6 +107,12 @@ void expr_op_node::print_node(FILE* outfile) const
   case O_EXP:
     fprintf(outfile,"^");
     break;
+  case O_SHL:
+    fprintf(outfile,"<<");
+    break;
+  case O_SHR:
+    fprintf(outfile,">>");
+    break;
   // case O_MATHFN:
   //   fprintf(outfile,"(");
   //   break;
@@ -70,7 +70,8 @@ string vector_expr_node::get_field_name() const
 
 
 vec_id_expr_node::vec_id_expr_node(const  char* id_name , local_symbols* curr_vector_defs ) :
-  access_iterator(NULL)
+  access_iterator(NULL),
+  offset_param(NULL)
 {
   vector_expr_node* curr_defn = curr_vector_defs->find_local_symbol(id_name);
   if( dynamic_cast<multi_stmt_node*>(curr_defn) ){
@@ -89,7 +90,8 @@ vec_id_expr_node::vec_id_expr_node(const  char* id_name , local_symbols* curr_ve
 }
 
 vec_id_expr_node::vec_id_expr_node(const char* id_name, local_symbols* curr_vector_defs, int curr_offset, for_iterator* used_iterator) :
-  access_iterator(used_iterator)
+  access_iterator(used_iterator),
+  offset_param(NULL)
 {
   multi_stmt_node* curr_symbol = dynamic_cast<multi_stmt_node*>(curr_vector_defs->find_local_symbol(id_name));
   if( curr_symbol == NULL ){
@@ -126,16 +128,31 @@ vec_id_expr_node::vec_id_expr_node(const char* id_name, local_symbols* curr_vect
     }
     else{
       ///If no offset is used, then all instances of the qualified variables have to be defined previously.
-      assert(used_iterator->iter_domain->range_list.front().lb->type == P_INT && used_iterator->iter_domain->range_list.front().ub->type == P_INT );
-      int lb = static_cast<int_expr*>(used_iterator->iter_domain->range_list.front().lb)->value;
-      int ub = static_cast<int_expr*>(used_iterator->iter_domain->range_list.front().ub)->value;
-      bool all_defined = curr_symbol->check_if_defined(lb, ub , defn );
-      if( !all_defined ){
-	fprintf(stderr,"[ME] : Error ! %s is not defined at all points in range %d..%d\n",id_name,lb,ub);
-	exit(1);
+      assert(used_iterator->iter_domain->range_list.front().lb->type == P_INT );
+      const parametric_exp* iter_ub = used_iterator->iter_domain->range_list.front().ub;
+      if( iter_ub->type == P_PARAM ){
+	///With a parametric upper bound, the instances have to be defined earlier within the same loop
+	const parameter_defn* ub_param = static_cast<const param_expr*>(iter_ub)->param;
+	stmt_node* curr_defn = curr_symbol->check_if_defined(ub_param);
+	if( curr_defn == NULL || curr_defn->get_access_iterator() != used_iterator ){
+	  fprintf(stderr,"[ME] : Error ! %s is not defined at all points in range of %s<%s>\n",id_name,id_name,used_iterator->name.c_str());
+	  exit(1);
+	}
+	defn.insert(curr_defn);
+	curr_defn->add_usage(this);
       }
-      for( set<vector_expr_node*>::iterator it = defn.begin() ; it != defn.end() ; it++ ){
-      	(*it)->add_usage(this);
+      else{
+	assert(iter_ub->type == P_INT);
+	int lb = static_cast<int_expr*>(used_iterator->iter_domain->range_list.front().lb)->value;
+	int ub = static_cast<const int_expr*>(iter_ub)->value;
+	bool all_defined = curr_symbol->check_if_defined(lb, ub , defn );
+	if( !all_defined ){
+	  fprintf(stderr,"[ME] : Error ! %s is not defined at all points in range %d..%d\n",id_name,lb,ub);
+	  exit(1);
+	}
+	for( set<vector_expr_node*>::iterator it = defn.begin() ; it != defn.end() ; it++ ){
+	  (*it)->add_usage(this);
+	}
       }
     }
   }
@@ -157,6 +174,31 @@ vec_id_expr_node::vec_id_expr_node(const char* id_name, local_symbols* curr_vect
   offset = curr_offset;
 }
 
+vec_id_expr_node::vec_id_expr_node(const char* id_name, local_symbols* curr_vector_defs, const parameter_defn* ub_param) :
+  access_iterator(NULL),
+  offset_param(ub_param)
+{
+  multi_stmt_node* curr_symbol = dynamic_cast<multi_stmt_node*>(curr_vector_defs->find_local_symbol(id_name));
+  if( curr_symbol == NULL ){
+    fprintf(stderr,"[ME] : ERROR ! Undefined symbol : %s\n",id_name);
+    exit(1);
+  }
+  ///The last instance computed by a for-loop with a parametric upper bound
+  stmt_node* curr_defn = curr_symbol->check_if_defined(ub_param);
+  if( curr_defn == NULL ){
+    fprintf(stderr,"[ME] : Error ! %s<%s> is not defined\n",id_name,ub_param->param_id.c_str());
+    exit(1);
+  }
+  defn.insert(curr_defn);
+  curr_defn->add_usage(this);
+  ndims = curr_defn->get_dim();
+  elem_type.assign(curr_defn->get_data_type());
+  base_elem_type.assign(elem_type);
+  expr_type = VEC_ID;
+  name.assign(id_name);
+  offset = DEFAULT_RANGE;
+}
+
 vec_id_expr_node::vec_id_expr_node(const vec_id_expr_node* orig_expr) :
   access_iterator(NULL)
 {
@@ -167,6 +209,7 @@ vec_id_expr_node::vec_id_expr_node(const vec_id_expr_node* orig_expr) :
   expr_type = VEC_ID;
   access_iterator = orig_expr->get_access_iterator();
   offset = orig_expr->get_offset();
+  offset_param = orig_expr->get_offset_param();
   if( orig_expr->get_sub_domain() != NULL )
     sub_domain = new domain_node(orig_expr->get_sub_domain());
   for( set<vector_expr_node*>::const_iterator it = orig_expr->defn.begin() ; it != orig_expr->defn.end() ; it++ ){
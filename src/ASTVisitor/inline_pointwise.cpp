@@ -0,0 +1,918 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <sstream>
+#include "AST/parser.hpp"
+#include "ASTVisitor/copy_visitor.hpp"
+#include "ASTVisitor/copy_stencil_expr.hpp"
+#include "ASTVisitor/inline_pointwise.hpp"
+
+using namespace std;
+
+///Maximum size of the expression of a pointwise stencil function,
+///with its local scalars substituted, for it to be inlined
+#define MAX_INLINE_SIZE 64
+
+
+///Returns the type of the value the generated code computes for an
+///expression. Accesses are not stored in temporaries, so a cast on
+///them only takes effect when the value is stored, and negations are
+///evaluated with the C promotion rules
+static basic_data_types get_value_type(const expr_node* curr_expr)
+{
+  switch(curr_expr->get_s_type()){
+  case S_STENCILOP:
+  case S_ARRAYACCESS:
+    if( curr_expr->get_base_type().type == T_STRUCT &&
+        curr_expr->get_access_field() != -1 )
+      return curr_expr->get_base_type().struct_info->
+        fields[curr_expr->get_access_field()].field_type;
+    return curr_expr->get_base_type().type;
+  case S_UNARYNEG: {
+    basic_data_types base_type = get_value_type
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr());
+    return ( base_type == T_INT8 || base_type == T_INT16 ? T_INT :
+             base_type );
+  }
+  default:
+    return curr_expr->get_data_type().type;
+  }
+}
+
+
+///Convert the value of an expression to the given type, as done when
+///it is stored. StencilSimplify keeps the addition since the type of
+///the result differs from the type of the expression
+static expr_node* convert_value
+(expr_node* curr_expr, basic_data_types to_type)
+{
+  if( get_value_type(curr_expr) == to_type &&
+      curr_expr->get_data_type().type == to_type )
+    return curr_expr;
+  expr_node* ret_expr =
+    new expr_op_node(curr_expr,new value_node<int>(0),O_PLUS);
+  ret_expr->cast_to_type(to_type);
+  return ret_expr;
+}
+
+
+///Returns true if the expression is an access of the parameter
+static bool is_param_access
+(const expr_node* curr_expr, const vector_defn_node* param)
+{
+  if( curr_expr->get_s_type() == S_STENCILOP )
+    return static_cast<const stencil_op_node*>(curr_expr)->get_var() ==
+      param;
+  if( curr_expr->get_s_type() == S_ARRAYACCESS )
+    return static_cast<const array_access_node*>(curr_expr)->get_var() ==
+      param;
+  return false;
+}
+
+
+///Check that the vector arguments are only accessed at the current
+///point, and add the size of the expression, with the local scalars
+///substituted, to size
+static bool check_pointwise_expr
+(const expr_node* curr_expr, const map<string,int>& local_sizes, int& size,
+ bool& reads_fields)
+{
+  size++;
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+    return true;
+  case S_ID: {
+    map<string,int>::const_iterator curr_local = local_sizes.find
+      (static_cast<const id_expr_node*>(curr_expr)->get_name());
+    if( curr_local == local_sizes.end() )
+      return false;
+    size += curr_local->second - 1;
+    return true;
+  }
+  case S_UNARYNEG:
+    return check_pointwise_expr
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),
+       local_sizes,size,reads_fields);
+  case S_MATHFN: {
+    const deque<expr_node*>& fn_args =
+      static_cast<const math_fn_expr_node*>(curr_expr)->get_args();
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ;
+         it != fn_args.end() ; it++ )
+      if( !check_pointwise_expr(*it,local_sizes,size,reads_fields) )
+        return false;
+    return true;
+  }
+  case S_TERNARY: {
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    return check_pointwise_expr
+      (curr_ternary->get_bool_expr(),local_sizes,size,reads_fields) &&
+      check_pointwise_expr
+      (curr_ternary->get_true_expr(),local_sizes,size,reads_fields) &&
+      check_pointwise_expr
+      (curr_ternary->get_false_expr(),local_sizes,size,reads_fields);
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    return check_pointwise_expr
+      (curr_op->get_lhs_expr(),local_sizes,size,reads_fields) &&
+      check_pointwise_expr
+      (curr_op->get_rhs_expr(),local_sizes,size,reads_fields);
+  }
+  case S_STENCILOP: {
+    const stencil_op_node* curr_access =
+      static_cast<const stencil_op_node*>(curr_expr);
+    if( curr_access->get_base_type().type == T_STRUCT ){
+      if( curr_access->get_access_field() == -1 )
+        return false;
+      reads_fields = true;
+    }
+    const deque<scale_coeffs>& scale_fn =
+      curr_access->get_scale_fn()->scale_fn;
+    for( deque<scale_coeffs>::const_iterator it = scale_fn.begin() ;
+         it != scale_fn.end() ; it++ )
+      if( it->offset != 0 || it->scale != 1 )
+        return false;
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+
+///Check the accesses of a parameter of the consumer, a struct
+///parameter must be accessed one field at a time
+static bool check_param_accesses
+(const expr_node* curr_expr, const vector_defn_node* param,
+ bool& has_array_access)
+{
+  bool is_struct = ( param->get_data_type().type == T_STRUCT );
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+  case S_ID:
+    return true;
+  case S_UNARYNEG:
+    return check_param_accesses
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),
+       param,has_array_access);
+  case S_MATHFN: {
+    const deque<expr_node*>& fn_args =
+      static_cast<const math_fn_expr_node*>(curr_expr)->get_args();
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ;
+         it != fn_args.end() ; it++ )
+      if( !check_param_accesses(*it,param,has_array_access) )
+        return false;
+    return true;
+  }
+  case S_TERNARY: {
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    return
+      check_param_accesses
+      (curr_ternary->get_bool_expr(),param,has_array_access) &&
+      check_param_accesses
+      (curr_ternary->get_true_expr(),param,has_array_access) &&
+      check_param_accesses
+      (curr_ternary->get_false_expr(),param,has_array_access);
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    return
+      check_param_accesses(curr_op->get_lhs_expr(),param,has_array_access) &&
+      check_param_accesses(curr_op->get_rhs_expr(),param,has_array_access);
+  }
+  case S_STRUCT: {
+    const deque<expr_node*>& field_exprs =
+      static_cast<const pt_struct_node*>(curr_expr)->get_field_exprs();
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ;
+         it != field_exprs.end() ; it++ )
+      if( !check_param_accesses(*it,param,has_array_access) )
+        return false;
+    return true;
+  }
+  case S_STENCILOP:
+    return !is_param_access(curr_expr,param) || !is_struct ||
+      curr_expr->get_access_field() != -1;
+  case S_ARRAYACCESS: {
+    if( is_param_access(curr_expr,param) ){
+      if( is_struct )
+        return false;
+      has_array_access = true;
+    }
+    const deque<expr_node*>& index_exprs =
+      static_cast<const array_access_node*>(curr_expr)->get_index_exprs();
+    for( deque<expr_node*>::const_iterator it = index_exprs.begin() ;
+         it != index_exprs.end() ; it++ )
+      if( !check_param_accesses(*it,param,has_array_access) )
+        return false;
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+
+///Returns true if the two domains are the same
+static bool is_same_domain(const domain_node* lhs, const domain_node* rhs)
+{
+  if( lhs->get_dim() != rhs->get_dim() )
+    return false;
+  deque<range_coeffs>::const_iterator jt = rhs->range_list.begin();
+  for( deque<range_coeffs>::const_iterator it = lhs->range_list.begin() ;
+       it != lhs->range_list.end() ; it++, jt++ )
+    if( !parametric_exp::is_equal(it->lb,jt->lb) ||
+        !parametric_exp::is_equal(it->ub,jt->ub) )
+      return false;
+  return true;
+}
+
+
+/** Copy of the expression of a pointwise producer, evaluated at the
+    point of an access by the consumer. The local scalars of the
+    producer are substituted by their definition */
+class CopyProducerExpr : public CopyStencilExpr{
+
+private:
+
+  ///Names of the parameters of the producer in the inlined function
+  const map<string,string>& param_names;
+
+  ///Definitions of the local scalars of the producer
+  map<string,const expr_node*> local_defns;
+
+  ///The access of the consumer being replaced
+  const expr_node* consumer_access;
+
+  ///Copier used for the indices of direct accesses of the consumer
+  CopyStencilExpr* index_copier;
+
+public:
+
+  CopyProducerExpr
+  (const local_symbols* curr_fn_args,
+   const map<string,string>& curr_param_names,
+   const stencilfn_defn_node* producer_fn,
+   CopyStencilExpr* curr_index_copier) :
+    CopyStencilExpr(curr_fn_args),
+    param_names(curr_param_names),
+    consumer_access(NULL),
+    index_copier(curr_index_copier)
+  {
+    const deque<pt_stmt_node*>& fn_body = producer_fn->get_body();
+    for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+         it != fn_body.end() ; it++ )
+      local_defns[(*it)->get_lhs()] = (*it)->get_rhs();
+  }
+
+  void set_access(const expr_node* curr_access){
+    consumer_access = curr_access;
+  }
+
+  using CopyStencilExpr::copy;
+
+  expr_node* copy(const expr_node* curr_expr){
+    if( curr_expr->get_s_type() == S_ID ){
+      map<string,const expr_node*>::const_iterator curr_defn =
+        local_defns.find
+        (static_cast<const id_expr_node*>(curr_expr)->get_name());
+      assert(curr_defn != local_defns.end());
+      return copy(curr_defn->second);
+    }
+    if( curr_expr->get_s_type() != S_STENCILOP )
+      return CopyStencilExpr::copy(curr_expr);
+
+    const stencil_op_node* curr_access =
+      static_cast<const stencil_op_node*>(curr_expr);
+    const string& new_name =
+      param_names.find(curr_access->get_name())->second;
+    expr_node* ret_expr;
+    if( curr_access->get_var()->get_dim() == 0 )
+      ret_expr = new stencil_op_node
+        (new_name.c_str(),CopyStencilExpr::copy(curr_access->get_scale_fn()),
+         fn_args);
+    else if( consumer_access->get_s_type() == S_STENCILOP )
+      ret_expr = new stencil_op_node
+        (new_name.c_str(),
+         CopyStencilExpr::copy
+         (static_cast<const stencil_op_node*>(consumer_access)->
+          get_scale_fn()),
+         fn_args);
+    else{
+      const deque<expr_node*>& index_exprs =
+        static_cast<const array_access_node*>(consumer_access)->
+        get_index_exprs();
+      deque<expr_node*>::const_iterator it = index_exprs.begin();
+      array_access_node* new_access =
+        new array_access_node(index_copier->copy(*it));
+      for( it++ ; it != index_exprs.end() ; it++ )
+        new_access->add_index(index_copier->copy(*it));
+      new_access->set_name(new_name.c_str(),fn_args);
+      ret_expr = new_access;
+    }
+    if( curr_access->get_base_type().type == T_STRUCT &&
+        curr_access->get_access_field() != -1 )
+      ret_expr->add_access_field(curr_access->get_field_name().c_str());
+    ret_expr->cast_to_type(curr_access->get_data_type().type);
+    return ret_expr;
+  }
+
+};
+
+
+/** Copy of the expressions of the consumer into the inlined function,
+    where the accesses of the inlined parameter are replaced by the
+    expression of the producer */
+class CopyConsumerExpr : public CopyStencilExpr{
+
+private:
+
+  ///Local scalars of the inlined function
+  local_scalar_symbols* local_scalars;
+
+  ///The parameter replaced
+  const vector_defn_node* inlined_param;
+
+  ///Field of the producer passed as argument
+  int arg_field;
+
+  const stencilfn_defn_node* producer_fn;
+
+  CopyProducerExpr producer_copier;
+
+  ///Returns the expression of the producer at the point accessed
+  expr_node* inline_access(const expr_node* curr_access){
+    int field =
+      ( arg_field != -1 ? arg_field : curr_access->get_access_field() );
+    const expr_node* producer_expr = producer_fn->get_return_expr();
+    basic_data_types value_type;
+    if( field != -1 ){
+      value_type =
+        producer_fn->get_data_type().struct_info->fields[field].field_type;
+      producer_expr = static_cast<const pt_struct_node*>(producer_expr)->
+        get_field_exprs()[field];
+    }
+    else
+      value_type = producer_fn->get_data_type().type;
+    producer_copier.set_access(curr_access);
+    return convert_value(producer_copier.copy(producer_expr),value_type);
+  }
+
+public:
+
+  CopyConsumerExpr
+  (const local_symbols* curr_fn_args, local_scalar_symbols* curr_local_scalars,
+   const vector_defn_node* curr_param, int curr_field,
+   const stencilfn_defn_node* curr_producer,
+   const map<string,string>& param_names) :
+    CopyStencilExpr(curr_fn_args),
+    local_scalars(curr_local_scalars),
+    inlined_param(curr_param),
+    arg_field(curr_field),
+    producer_fn(curr_producer),
+    producer_copier(curr_fn_args,param_names,curr_producer,this)
+  { }
+
+  using CopyStencilExpr::copy;
+
+  expr_node* copy(const expr_node* curr_expr){
+    if( curr_expr->get_s_type() == S_ID ){
+      expr_node* ret_expr = new id_expr_node
+        (static_cast<const id_expr_node*>(curr_expr)->get_name().c_str(),
+         local_scalars);
+      ret_expr->cast_to_type(curr_expr->get_data_type().type);
+      return ret_expr;
+    }
+    if( is_param_access(curr_expr,inlined_param) )
+      return inline_access(curr_expr);
+    return CopyStencilExpr::copy(curr_expr);
+  }
+
+  ///Copy an expression whose value is stored in the output, a replaced
+  ///access keeps the type it had. Local scalars are not converted
+  ///since the generated code uses their value as is
+  expr_node* copy_stored(const expr_node* curr_expr){
+    expr_node* ret_expr = copy(curr_expr);
+    if( is_param_access(curr_expr,inlined_param) )
+      ret_expr = convert_value(ret_expr,curr_expr->get_data_type().type);
+    return ret_expr;
+  }
+
+};
+
+
+bool InlinePointwise::inline_key::operator<(const inline_key& rhs) const
+{
+  if( consumer != rhs.consumer )
+    return consumer < rhs.consumer;
+  if( arg_num != rhs.arg_num )
+    return arg_num < rhs.arg_num;
+  if( producer != rhs.producer )
+    return producer < rhs.producer;
+  return field < rhs.field;
+}
+
+
+const InlinePointwise::producer_info& InlinePointwise::get_producer_info
+(const stencilfn_defn_node* curr_fn)
+{
+  map<const fn_defn_node*,producer_info>::iterator curr_info =
+    producers.find(curr_fn);
+  if( curr_info != producers.end() )
+    return curr_info->second;
+  producer_info& new_info = producers[curr_fn];
+  if( curr_fn->get_return_dim() == 0 )
+    return new_info;
+
+  ///Local scalars that are redefined are not substituted
+  map<string,int> local_sizes;
+  bool reads_fields = false;
+  const deque<pt_stmt_node*>& fn_body = curr_fn->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    int curr_size = 0;
+    if( local_sizes.count((*it)->get_lhs()) ||
+        !check_pointwise_expr
+        ((*it)->get_rhs(),local_sizes,curr_size,reads_fields) )
+      return new_info;
+    local_sizes[(*it)->get_lhs()] = curr_size;
+  }
+  int fn_size = 0;
+  const expr_node* ret_expr = curr_fn->get_return_expr();
+  if( ret_expr->get_s_type() == S_STRUCT ){
+    const deque<expr_node*>& field_exprs =
+      static_cast<const pt_struct_node*>(ret_expr)->get_field_exprs();
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ;
+         it != field_exprs.end() ; it++ )
+      if( !check_pointwise_expr(*it,local_sizes,fn_size,reads_fields) )
+        return new_info;
+  }
+  else if( !check_pointwise_expr(ret_expr,local_sizes,fn_size,reads_fields) )
+    return new_info;
+  new_info.is_pointwise = ( fn_size <= MAX_INLINE_SIZE );
+  new_info.reads_fields = reads_fields;
+  return new_info;
+}
+
+
+fnid_expr_node* InlinePointwise::get_producer
+(vector_expr_node* curr_arg, int& field)
+{
+  field = ( curr_arg->get_base_type().type == T_STRUCT ?
+            curr_arg->get_access_field() : -1 );
+  if( curr_arg->get_sub_domain() )
+    return NULL;
+  fnid_expr_node* producer = NULL;
+  if( curr_arg->get_type() == VEC_FN )
+    producer = static_cast<fnid_expr_node*>(curr_arg);
+  else if( curr_arg->get_type() == VEC_ID ){
+    ///Statements defined in loops or with an offset on the left hand
+    ///side are not forwarded
+    vec_id_expr_node* curr_id = static_cast<vec_id_expr_node*>(curr_arg);
+    if( curr_id->get_access_iterator() || curr_id->get_offset_param() ||
+        curr_id->get_defn().size() != 1 )
+      return NULL;
+    stmt_node* curr_defn =
+      dynamic_cast<stmt_node*>(*(curr_id->get_defn().begin()));
+    if( !curr_defn || curr_defn->get_type() != VEC_STMT ||
+        curr_defn->get_access_iterator() ||
+        curr_defn->get_sub_domain() || curr_defn->get_scale_domain() ||
+        curr_defn->rhs->get_type() != VEC_FN ||
+        curr_defn->rhs->get_sub_domain() )
+      return NULL;
+    producer = static_cast<fnid_expr_node*>(curr_defn->rhs);
+  }
+  if( producer && field == -1 && producer->get_base_type().type == T_STRUCT )
+    field = producer->get_access_field();
+  return producer;
+}
+
+
+bool InlinePointwise::can_inline
+(fnid_expr_node* consumer, int arg_num, fnid_expr_node* producer, int field,
+ bool in_program)
+{
+  const stencilfn_defn_node* consumer_fn =
+    dynamic_cast<const stencilfn_defn_node*>(consumer->get_defn());
+  const stencilfn_defn_node* producer_fn =
+    dynamic_cast<const stencilfn_defn_node*>(producer->get_defn());
+  if( !consumer_fn || !producer_fn || producer->get_sub_domain() )
+    return false;
+  const producer_info& curr_info = get_producer_info(producer_fn);
+  if( !curr_info.is_pointwise )
+    return false;
+
+  ///A constant boundary condition would have to be applied to the
+  ///value of the producer
+  const arg_info& curr_arg = consumer->get_args()[arg_num];
+  if( curr_arg.bdy_condn->type == B_CONSTANT )
+    return false;
+
+  ///The parameter must have the type of the values produced
+  const vector_defn_node* param = consumer_fn->get_args()[arg_num];
+  const data_types& param_type = param->get_data_type();
+  const expr_node* producer_expr = producer_fn->get_return_expr();
+  if( param->get_dim() == 0 )
+    return false;
+  if( field != -1 ){
+    if( producer_expr->get_s_type() != S_STRUCT ||
+        param_type.type == T_STRUCT ||
+        producer_fn->get_data_type().struct_info->fields[field].field_type !=
+        param_type.type )
+      return false;
+  }
+  else if( param_type.type == T_STRUCT ){
+    if( producer_expr->get_s_type() != S_STRUCT ||
+        !data_types::is_same_type(param_type,producer_fn->get_data_type()) )
+      return false;
+  }
+  else if( producer_fn->get_data_type().type != param_type.type )
+    return false;
+
+  ///Direct accesses of the parameter are replaced by direct accesses
+  ///of the arguments of the producer, which do not support fields
+  bool has_array_access = false;
+  const deque<pt_stmt_node*>& fn_body = consumer_fn->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ )
+    if( !check_param_accesses((*it)->get_rhs(),param,has_array_access) )
+      return false;
+  if( !check_param_accesses
+      (consumer_fn->get_return_expr(),param,has_array_access) ||
+      ( has_array_access && curr_info.reads_fields ) )
+    return false;
+
+  ///The boundary condition of the parameter is applied to every
+  ///argument of the producer, which must then have the same domain
+  const deque<arg_info>& producer_args = producer->get_args();
+  const deque<vector_defn_node*>& producer_params = producer_fn->get_args();
+  int num_images = 0;
+  deque<vector_defn_node*>::const_iterator kt = producer_params.begin();
+  for( deque<arg_info>::const_iterator it = producer_args.begin() ;
+       it != producer_args.end() ; it++, kt++ ){
+    if( it->arg_expr->get_sub_domain() )
+      return false;
+    if( (*kt)->get_dim() != 0 )
+      num_images++;
+  }
+  if( curr_arg.bdy_condn->type != B_NONE && num_images > 1 ){
+    if( !in_program )
+      return false;
+    if( !domains_computed ){
+      curr_program->compute_domain();
+      domains_computed = true;
+    }
+    producer->compute_domain();
+    const domain_node* first_domain = NULL;
+    kt = producer_params.begin();
+    for( deque<arg_info>::const_iterator it = producer_args.begin() ;
+         it != producer_args.end() ; it++, kt++ ){
+      if( (*kt)->get_dim() == 0 )
+        continue;
+      if( first_domain == NULL )
+        first_domain = it->arg_expr->get_expr_domain();
+      else if( !is_same_domain(first_domain,it->arg_expr->get_expr_domain()) )
+        return false;
+    }
+  }
+  return true;
+}
+
+
+stencilfn_defn_node* InlinePointwise::get_inlined_fn
+(const stencilfn_defn_node* consumer_fn, int arg_num,
+ const stencilfn_defn_node* producer_fn, int field)
+{
+  inline_key curr_key = { consumer_fn, arg_num, producer_fn, field };
+  map<inline_key,stencilfn_defn_node*>::iterator curr_fn =
+    inlined_fns.find(curr_key);
+  if( curr_fn != inlined_fns.end() )
+    return curr_fn->second;
+
+  const deque<vector_defn_node*>& consumer_params = consumer_fn->get_args();
+  const vector_defn_node* inlined_param = consumer_params[arg_num];
+  stringstream fn_name;
+  fn_name << consumer_fn->get_name() << "_" << inlined_param->get_name()
+          << "_" << producer_fn->get_name();
+  if( field != -1 )
+    fn_name << "_" << producer_fn->get_data_type().struct_info->
+      fields[field].field_name;
+  if( fn_defs->find_symbol(fn_name.str().c_str()) )
+    return NULL;
+
+  ///Parameters of the producer are renamed if they conflict with the
+  ///names used in the consumer
+  set<string> used_names;
+  for( deque<vector_defn_node*>::const_iterator it = consumer_params.begin() ;
+       it != consumer_params.end() ; it++ )
+    if( *it != inlined_param )
+      used_names.insert((*it)->get_name());
+  const deque<pt_stmt_node*>& fn_body = consumer_fn->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ )
+    used_names.insert((*it)->get_lhs());
+
+  local_symbols* fn_symbols = new local_symbols();
+  map<string,string> param_names;
+  for( deque<vector_defn_node*>::const_iterator it = consumer_params.begin() ;
+       it != consumer_params.end() ; it++ ){
+    if( *it != inlined_param ){
+      fn_symbols->add_local_symbol
+        ((*it)->get_name().c_str(),
+         new vector_defn_node
+         (&(*it)->get_data_type(),(*it)->get_dim(),(*it)->get_name().c_str()));
+      continue;
+    }
+    const deque<vector_defn_node*>& producer_params = producer_fn->get_args();
+    for( deque<vector_defn_node*>::const_iterator jt =
+           producer_params.begin() ;
+         jt != producer_params.end() ; jt++ ){
+      string new_name = (*jt)->get_name();
+      if( used_names.count(new_name) ){
+        string base_name = inlined_param->get_name() + "_" + new_name;
+        new_name = base_name;
+        for( int suffix = 1 ; used_names.count(new_name) ; suffix++ ){
+          stringstream curr_name;
+          curr_name << base_name << "_" << suffix;
+          new_name = curr_name.str();
+        }
+      }
+      used_names.insert(new_name);
+      param_names[(*jt)->get_name()] = new_name;
+      fn_symbols->add_local_symbol
+        (new_name.c_str(),
+         new vector_defn_node
+         (&(*jt)->get_data_type(),(*jt)->get_dim(),new_name.c_str()));
+    }
+  }
+
+  local_scalar_symbols* fn_scalars = new local_scalar_symbols();
+  stencilfn_defn_node* new_fn = new stencilfn_defn_node(fn_symbols,fn_scalars);
+  new_fn->set_name(fn_name.str().c_str());
+  CopyConsumerExpr expr_copier
+    (fn_symbols,fn_scalars,inlined_param,field,producer_fn,param_names);
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    expr_node* new_rhs = expr_copier.copy((*it)->get_rhs());
+    new_fn->add_stmt
+      (new pt_stmt_node((*it)->get_lhs().c_str(),new_rhs,fn_symbols));
+    fn_scalars->add_local_scalar((*it)->get_lhs().c_str(),new_rhs);
+  }
+  const expr_node* ret_expr = consumer_fn->get_return_expr();
+  if( ret_expr->get_s_type() == S_STRUCT ){
+    const pt_struct_node* ret_struct =
+      static_cast<const pt_struct_node*>(ret_expr);
+    const deque<expr_node*>& field_exprs = ret_struct->get_field_exprs();
+    pt_struct_node* new_struct = NULL;
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ;
+         it != field_exprs.end() ; it++ ){
+      if( new_struct == NULL )
+        new_struct = new pt_struct_node(expr_copier.copy_stored(*it));
+      else
+        new_struct->add_field(expr_copier.copy_stored(*it));
+    }
+    new_struct->find_struct_definition(ret_struct->get_struct_name().c_str());
+    new_fn->add_ret_expr(new_struct);
+  }
+  else
+    new_fn->add_ret_expr(expr_copier.copy_stored(ret_expr));
+  fn_defs->add_fn_def(new_fn);
+  inlined_fns[curr_key] = new_fn;
+  return new_fn;
+}
+
+
+fnid_expr_node* InlinePointwise::inline_arg
+(fnid_expr_node* consumer, int arg_num, fnid_expr_node* producer,
+ stencilfn_defn_node* inlined_fn)
+{
+  ///The producer is moved if it is the argument, and copied if it is
+  ///the right hand side of a statement
+  arg_info& inlined_arg = consumer->args[arg_num];
+  bool is_forwarded = ( inlined_arg.arg_expr != producer );
+  const deque<vector_defn_node*>& producer_params =
+    producer->get_defn()->get_args();
+  CopyVectorExpr copier;
+
+  fnid_expr_node* new_expr = new fnid_expr_node();
+  for( deque<arg_info>::iterator it = consumer->args.begin() ;
+       it != consumer->args.end() ; it++ ){
+    if( it->arg_expr != inlined_arg.arg_expr ){
+      it->arg_expr->remove_usage(consumer);
+      new_expr->add_arg(it->arg_expr,it->bdy_condn);
+      continue;
+    }
+    deque<vector_defn_node*>::const_iterator kt = producer_params.begin();
+    for( deque<arg_info>::iterator jt = producer->args.begin() ;
+         jt != producer->args.end() ; jt++, kt++ ){
+      vector_expr_node* new_arg;
+      bdy_info* new_bdy;
+      if( is_forwarded ){
+        new_arg = copier.copy(jt->arg_expr);
+        new_bdy = copier.copy(jt->bdy_condn);
+      }
+      else{
+        new_arg = jt->arg_expr;
+        new_arg->remove_usage(producer);
+        new_bdy = jt->bdy_condn;
+      }
+      if( (*kt)->get_dim() != 0 && inlined_arg.bdy_condn->type != B_NONE ){
+        delete new_bdy;
+        new_bdy = copier.copy(inlined_arg.bdy_condn);
+      }
+      new_expr->add_arg(new_arg,new_bdy);
+    }
+    if( !is_forwarded )
+      producer->args.clear();
+  }
+  delete inlined_arg.arg_expr;
+  delete inlined_arg.bdy_condn;
+  consumer->args.clear();
+
+  new_expr->find_definition(inlined_fn->get_name());
+  if( consumer->get_sub_domain() )
+    new_expr->set_domain(new domain_node(consumer->get_sub_domain()));
+  if( consumer->get_base_type().type == T_STRUCT &&
+      consumer->get_access_field() != -1 )
+    new_expr->add_access_field(consumer->get_field_name().c_str());
+  return new_expr;
+}
+
+
+bool InlinePointwise::is_inline_stage
+(const stmt_node* curr_stmt, bool in_program) const
+{
+  map<string,stage_schedule>::const_iterator curr_schedule =
+    stage_schedules.find(curr_stmt->get_name_string());
+  if( !in_program || curr_schedule == stage_schedules.end() ||
+      curr_schedule->second.compute_level == COMPUTE_DEFAULT )
+    return inline_all;
+  return curr_schedule->second.compute_level == COMPUTE_INLINE;
+}
+
+
+vector_expr_node* InlinePointwise::visit_fnid_expr
+(fnid_expr_node* curr_expr, void* state)
+{
+  ASTVisitor<void*>::visit_fnid_expr(curr_expr,state);
+
+  ///Every argument inlined creates a new application, the intermediate
+  ///ones are deleted
+  fnid_expr_node* consumer = curr_expr;
+  bool in_program = ( curr_fn == curr_program->get_body() );
+  for( int arg_num = 0 ; arg_num < (int)consumer->args.size() ; arg_num++ ){
+    vector_expr_node* curr_arg = consumer->args[arg_num].arg_expr;
+    int field;
+    fnid_expr_node* producer = get_producer(curr_arg,field);
+    if( producer == NULL ||
+        ( curr_arg->get_type() == VEC_FN && !inline_all ) )
+      continue;
+    if( curr_arg->get_type() == VEC_ID ){
+      stmt_node* curr_defn = static_cast<stmt_node*>
+        (*(static_cast<vec_id_expr_node*>(curr_arg)->get_defn().begin()));
+      if( !forwarded_stmts.count(curr_defn) )
+        continue;
+    }
+    if( !can_inline(consumer,arg_num,producer,field,in_program) )
+      continue;
+    stencilfn_defn_node* inlined_fn =
+      get_inlined_fn(static_cast<stencilfn_defn_node*>(consumer->get_defn()),
+                     arg_num,
+                     static_cast<stencilfn_defn_node*>(producer->get_defn()),
+                     field);
+    if( inlined_fn == NULL )
+      continue;
+    int num_producer_args = (int)producer->args.size();
+    fnid_expr_node* new_expr =
+      inline_arg(consumer,arg_num,producer,inlined_fn);
+    if( consumer != curr_expr )
+      delete consumer;
+    consumer = new_expr;
+    arg_num += num_producer_args - 1;
+  }
+  return ( consumer != curr_expr ? consumer : NULL );
+}
+
+
+void InlinePointwise::visit_vectorfn
+(vectorfn_defn_node* curr_vectorfn, void* state)
+{
+  ASTVisitor<void*>::visit_vectorfn(curr_vectorfn,state);
+
+  ///Remove the statements that are not used anymore, the last ones
+  ///first since they may use the previous ones
+  deque<stmt_node*> fn_body = curr_vectorfn->get_body();
+  for( deque<stmt_node*>::reverse_iterator it = fn_body.rbegin() ;
+       it != fn_body.rend() ; it++ ){
+    if( forwarded_stmts.count(*it) && (*it)->get_usage().empty() ){
+      forwarded_stmts.erase(*it);
+      remove_statement(*it);
+    }
+  }
+}
+
+
+void InlinePointwise::UseCollector::visit_vectorfn
+(vectorfn_defn_node* curr_vectorfn, void* state)
+{
+  inline_uses.clear();
+  ASTVisitor<void*>::visit_vectorfn(curr_vectorfn,state);
+  const deque<stmt_node*>& fn_body = curr_vectorfn->get_body();
+  bool in_program = ( curr_vectorfn == inliner->curr_program->get_body() );
+  for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    const deque<vector_expr_node*>& curr_uses = (*it)->get_usage();
+    if( (*it)->get_type() != VEC_STMT || curr_uses.empty() )
+      continue;
+    bool all_inlined = true;
+    for( deque<vector_expr_node*>::const_iterator jt = curr_uses.begin() ;
+         jt != curr_uses.end() && all_inlined ; jt++ )
+      all_inlined = ( inline_uses.count(*jt) != 0 );
+    if( all_inlined && inliner->is_inline_stage(*it,in_program) )
+      inliner->forwarded_stmts.insert(*it);
+    else if( !all_inlined && in_program ){
+      map<string,stage_schedule>::const_iterator curr_schedule =
+        inliner->stage_schedules.find((*it)->get_name_string());
+      if( curr_schedule != inliner->stage_schedules.end() &&
+          curr_schedule->second.compute_level == COMPUTE_INLINE )
+        fprintf(stderr,"[MW] : Warning : Stage %s cannot be computed inline,"
+                " it is computed into a buffer\n",(*it)->get_name());
+    }
+  }
+}
+
+
+stmt_node* InlinePointwise::UseCollector::visit_for_stmt
+(for_stmt_node* curr_stmt, void* state)
+{
+  loop_depth++;
+  ASTVisitor<void*>::visit_for_stmt(curr_stmt,state);
+  loop_depth--;
+  return NULL;
+}
+
+
+stmt_node* InlinePointwise::UseCollector::visit_do_stmt
+(do_stmt_node* curr_stmt, void* state)
+{
+  loop_depth++;
+  ASTVisitor<void*>::visit_do_stmt(curr_stmt,state);
+  loop_depth--;
+  return NULL;
+}
+
+
+vector_expr_node* InlinePointwise::UseCollector::visit_fnid_expr
+(fnid_expr_node* curr_expr, void* state)
+{
+  ASTVisitor<void*>::visit_fnid_expr(curr_expr,state);
+  if( loop_depth != 0 )
+    return NULL;
+  bool in_program = ( curr_fn == inliner->curr_program->get_body() );
+  const deque<arg_info>& curr_args = curr_expr->get_args();
+  for( int arg_num = 0 ; arg_num < (int)curr_args.size() ; arg_num++ ){
+    if( curr_args[arg_num].arg_expr->get_type() != VEC_ID )
+      continue;
+    int field;
+    fnid_expr_node* producer =
+      inliner->get_producer(curr_args[arg_num].arg_expr,field);
+    if( producer &&
+        inliner->can_inline(curr_expr,arg_num,producer,field,in_program) )
+      inline_uses.insert(curr_args[arg_num].arg_expr);
+  }
+  return NULL;
+}
+
+
+void InlinePointwise::visit(program_node* curr_prog, void* state)
+{
+  curr_program = curr_prog;
+  UseCollector collect_uses(this);
+  collect_uses.visit(curr_program,state);
+  ASTVisitor<void*>::visit(curr_program,state);
+}
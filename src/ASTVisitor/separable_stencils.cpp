@@ -0,0 +1,482 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <cmath>
+#include <sstream>
+#include "AST/parser.hpp"
+#include "ASTVisitor/separable_stencils.hpp"
+
+using namespace std;
+
+///Relative tolerance used when comparing weights
+#define WEIGHT_TOLERANCE 1e-9
+
+///Returns true if the value is an integer (within tolerance)
+static bool is_integer_value(double value)
+{
+  return fabs(value) < 1e9 && fabs(value - floor(value + 0.5)) <= WEIGHT_TOLERANCE * MAX(1.0,fabs(value));
+}
+
+
+///Create a value node of the given type, integral values are
+///generated as integers so that they are printed exactly
+static expr_node* create_weight(double value, basic_data_types elem_type)
+{
+  if( is_integer_value(value) )
+    return new value_node<int>((int)floor(value + 0.5));
+  if( elem_type == T_FLOAT )
+    return new value_node<float>((float)value);
+  return new value_node<double>(value);
+}
+
+
+SeparableStencils::linear_form SeparableStencils::get_linear_form(const expr_node* curr_expr)
+{
+  linear_form ret_form;
+  basic_data_types param_type = curr_param->get_data_type().type;
+
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+    switch(curr_expr->get_data_type().type){
+    case T_INT:
+      ret_form.constant = static_cast<const value_node<int>*>(curr_expr)->get_value();
+      break;
+    case T_FLOAT:
+      ret_form.constant = static_cast<const value_node<float>*>(curr_expr)->get_value();
+      break;
+    case T_DOUBLE:
+      ret_form.constant = static_cast<const value_node<double>*>(curr_expr)->get_value();
+      break;
+    default:
+      ret_form.is_valid = false;
+    }
+    return ret_form;
+  case S_STENCILOP: {
+    const stencil_op_node* curr_access = static_cast<const stencil_op_node*>(curr_expr);
+    if( curr_access->get_var() != curr_param ){
+      ret_form.is_valid = false;
+      return ret_form;
+    }
+    stencil_offset curr_offset;
+    const deque<scale_coeffs>& scale_fn = curr_access->get_scale_fn()->scale_fn;
+    for( deque<scale_coeffs>::const_iterator it = scale_fn.begin() ; it != scale_fn.end() ; it++ ){
+      if( it->scale != 1 ){
+	ret_form.is_valid = false;
+	return ret_form;
+      }
+      curr_offset.push_back(it->offset);
+    }
+    ret_form.weights[curr_offset] = 1.0;
+    break;
+  }
+  case S_ID: {
+    map<string,linear_form>::iterator it = scalar_forms.find(static_cast<const id_expr_node*>(curr_expr)->get_name());
+    if( it == scalar_forms.end() ){
+      ret_form.is_valid = false;
+      return ret_form;
+    }
+    ret_form = it->second;
+    break;
+  }
+  case S_UNARYNEG: {
+    ret_form = get_linear_form(static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr());
+    ret_form.constant = -ret_form.constant;
+    for( stencil_weights::iterator it = ret_form.weights.begin() ; it != ret_form.weights.end() ; it++ )
+      it->second = -it->second;
+    break;
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    linear_form lhs_form = get_linear_form(curr_op->get_lhs_expr());
+    linear_form rhs_form = get_linear_form(curr_op->get_rhs_expr());
+    if( !lhs_form.is_valid || !rhs_form.is_valid ){
+      ret_form.is_valid = false;
+      return ret_form;
+    }
+
+    ///Constant sub-expressions are folded, using integer arithmetic
+    ///where the generated code would
+    if( lhs_form.weights.empty() && rhs_form.weights.empty() ){
+      bool is_int = curr_expr->get_data_type().type == T_INT;
+      double lhs_value = lhs_form.constant, rhs_value = rhs_form.constant;
+      switch(curr_op->get_op()){
+      case O_PLUS:
+	ret_form.constant = lhs_value + rhs_value;
+	break;
+      case O_MINUS:
+	ret_form.constant = lhs_value - rhs_value;
+	break;
+      case O_MULT:
+	ret_form.constant = lhs_value * rhs_value;
+	break;
+      case O_DIV:
+	if( rhs_value == 0 )
+	  ret_form.is_valid = false;
+	else if( is_int )
+	  ret_form.constant = (int)lhs_value / (int)rhs_value;
+	else
+	  ret_form.constant = lhs_value / rhs_value;
+	break;
+      default:
+	ret_form.is_valid = false;
+      }
+      return ret_form;
+    }
+
+    switch(curr_op->get_op()){
+    case O_PLUS:
+    case O_MINUS: {
+      double sign = ( curr_op->get_op() == O_PLUS ? 1.0 : -1.0 );
+      ret_form = lhs_form;
+      ret_form.constant += sign * rhs_form.constant;
+      for( stencil_weights::iterator it = rhs_form.weights.begin() ; it != rhs_form.weights.end() ; it++ )
+	ret_form.weights[it->first] += sign * it->second;
+      break;
+    }
+    case O_MULT:
+    case O_DIV: {
+      double factor;
+      if( curr_op->get_op() == O_DIV ){
+	if( !rhs_form.weights.empty() || rhs_form.constant == 0 ){
+	  ret_form.is_valid = false;
+	  return ret_form;
+	}
+	ret_form = lhs_form;
+	factor = 1.0 / rhs_form.constant;
+      }
+      else if( lhs_form.weights.empty() ){
+	ret_form = rhs_form;
+	factor = lhs_form.constant;
+      }
+      else if( rhs_form.weights.empty() ){
+	ret_form = lhs_form;
+	factor = rhs_form.constant;
+      }
+      else{
+	ret_form.is_valid = false;
+	return ret_form;
+      }
+      ret_form.constant *= factor;
+      for( stencil_weights::iterator it = ret_form.weights.begin() ; it != ret_form.weights.end() ; it++ )
+	it->second *= factor;
+      break;
+    }
+    default:
+      ret_form.is_valid = false;
+      return ret_form;
+    }
+    break;
+  }
+  default:
+    ret_form.is_valid = false;
+    return ret_form;
+  }
+
+  ///Every sub-expression that depends on the input must be evaluated
+  ///in the type of the input, otherwise splitting changes the rounding
+  if( ret_form.is_valid && !ret_form.weights.empty() && curr_expr->get_data_type().type != param_type )
+    ret_form.is_valid = false;
+  return ret_form;
+}
+
+
+bool SeparableStencils::split_weights(const stencil_weights& weights, int dim, stencil_weights& outer_weights, stencil_weights& inner_weights) const
+{
+  ///Use the largest weight as pivot
+  stencil_weights::const_iterator pivot = weights.begin();
+  for( stencil_weights::const_iterator it = weights.begin() ; it != weights.end() ; it++ )
+    if( fabs(it->second) > fabs(pivot->second) )
+      pivot = it;
+  if( pivot == weights.end() || pivot->second == 0 )
+    return false;
+  double max_weight = fabs(pivot->second);
+  int pivot_row = pivot->first[dim];
+  stencil_offset pivot_col = pivot->first;
+  pivot_col[dim] = 0;
+
+  ///The weights are viewed as a matrix, with rows indexed by the
+  ///offset along dim and columns by the offsets along other dims
+  map<int,double> row_weights;
+  outer_weights.clear();
+  inner_weights.clear();
+  for( stencil_weights::const_iterator it = weights.begin() ; it != weights.end() ; it++ ){
+    stencil_offset curr_col = it->first;
+    curr_col[dim] = 0;
+    if( curr_col == pivot_col )
+      row_weights[it->first[dim]] = it->second;
+    if( it->first[dim] == pivot_row )
+      inner_weights[curr_col] = it->second / pivot->second;
+  }
+
+  ///Check that weights[row,col] == row_weights[row] * inner_weights[col]
+  int num_entries = 0;
+  for( map<int,double>::iterator it = row_weights.begin() ; it != row_weights.end() ; it++ ){
+    for( stencil_weights::iterator jt = inner_weights.begin() ; jt != inner_weights.end() ; jt++ ){
+      stencil_offset curr_offset = jt->first;
+      curr_offset[dim] = it->first;
+      stencil_weights::const_iterator kt = weights.find(curr_offset);
+      double curr_weight = ( kt == weights.end() ? 0.0 : kt->second );
+      if( kt != weights.end() )
+	num_entries++;
+      if( fabs(curr_weight - it->second * jt->second) > WEIGHT_TOLERANCE * max_weight )
+	return false;
+    }
+  }
+  ///All non-zero weights must be covered by the product
+  if( num_entries != (int)weights.size() )
+    return false;
+
+  stencil_offset outer_offset(pivot->first.size(),0);
+  for( map<int,double>::iterator it = row_weights.begin() ; it != row_weights.end() ; it++ ){
+    outer_offset[dim] = it->first;
+    outer_weights[outer_offset] = it->second;
+  }
+  return true;
+}
+
+
+stencilfn_defn_node* SeparableStencils::create_stencilfn(const string& fn_name, const stencil_weights& weights, double scale)
+{
+  const string& param_name = curr_param->get_name();
+  basic_data_types param_type = curr_param->get_data_type().type;
+
+  local_symbols* fn_symbols = new local_symbols();
+  vector_defn_node* new_param = new vector_defn_node(&curr_param->get_data_type(),curr_param->get_dim(),param_name.c_str());
+  fn_symbols->add_local_symbol(param_name.c_str(),new_param);
+  stencilfn_defn_node* new_fn = new stencilfn_defn_node(fn_symbols,new local_scalar_symbols());
+  new_fn->set_name(fn_name.c_str());
+
+  ///Positive weights are added first, so that the expression only
+  ///starts with a negation if all weights are negative
+  expr_node* sum_expr = NULL;
+  for( int negative = 0 ; negative < 2 ; negative++ ){
+    for( stencil_weights::const_iterator it = weights.begin() ; it != weights.end() ; it++ ){
+      if( ( it->second < 0 ) != ( negative == 1 ) )
+	continue;
+      domainfn_node* curr_scale_fn = new domainfn_node();
+      for( stencil_offset::const_iterator jt = it->first.begin() ; jt != it->first.end() ; jt++ )
+	curr_scale_fn->add_scale_coeffs(*jt);
+      expr_node* curr_term = new stencil_op_node(param_name.c_str(),curr_scale_fn,fn_symbols);
+      double abs_weight = fabs(it->second);
+      if( !is_integer_value(abs_weight) || floor(abs_weight + 0.5) != 1 )
+	curr_term = new expr_op_node(create_weight(abs_weight,param_type),curr_term,O_MULT);
+      if( sum_expr == NULL )
+	sum_expr = ( negative ? new unary_neg_expr_node(curr_term) : curr_term );
+      else
+	sum_expr = new expr_op_node(sum_expr,curr_term,( negative ? O_MINUS : O_PLUS ));
+    }
+  }
+
+  ///Apply the scale factor, as a division by an integer if possible
+  if( fabs(scale + 1.0) <= WEIGHT_TOLERANCE )
+    sum_expr = new unary_neg_expr_node(sum_expr);
+  else if( fabs(scale - 1.0) > WEIGHT_TOLERANCE ){
+    if( is_integer_value(1.0 / scale) )
+      sum_expr = new expr_op_node(sum_expr,create_weight(1.0 / scale,param_type),O_DIV);
+    else
+      sum_expr = new expr_op_node(sum_expr,create_weight(scale,param_type),O_MULT);
+  }
+  new_fn->add_ret_expr(sum_expr);
+  fn_defs->add_fn_def(new_fn);
+  return new_fn;
+}
+
+
+void SeparableStencils::separate_stencilfn(stencilfn_defn_node* curr_fn)
+{
+  const deque<vector_defn_node*>& fn_args = curr_fn->get_args();
+  if( fn_args.size() != 1 )
+    return;
+  curr_param = fn_args.front();
+  basic_data_types param_type = curr_param->get_data_type().type;
+  int ndims = curr_param->get_dim();
+  if( ndims < 2 || curr_param->get_direct_access() ||
+      ( param_type != T_FLOAT && param_type != T_DOUBLE ) ||
+      curr_fn->get_data_type().type != param_type )
+    return;
+
+  ///Compute the weight of every stencil access
+  scalar_forms.clear();
+  const deque<pt_stmt_node*>& fn_body = curr_fn->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ; it != fn_body.end() ; it++ ){
+    linear_form curr_form = get_linear_form((*it)->get_rhs());
+    if( !curr_form.is_valid )
+      return;
+    scalar_forms[(*it)->get_lhs()] = curr_form;
+  }
+  linear_form ret_form = get_linear_form(curr_fn->get_return_expr());
+  if( !ret_form.is_valid || ret_form.constant != 0 )
+    return;
+  stencil_weights fn_weights;
+  for( stencil_weights::iterator it = ret_form.weights.begin() ; it != ret_form.weights.end() ; it++ )
+    if( it->second != 0 )
+      fn_weights.insert(*it);
+
+  ///Peel off one dimension at a time while the remaining weights
+  ///are rank-1
+  deque<stencil_weights> stage_weights;
+  deque<int> stage_dims;
+  stencil_weights remaining_weights = fn_weights;
+  for( int dim = 0 ; dim < ndims ; dim++ ){
+    stencil_weights outer_weights, inner_weights;
+    if( split_weights(remaining_weights,dim,outer_weights,inner_weights) &&
+	outer_weights.size() > 1 && inner_weights.size() > 1 ){
+      stage_weights.push_back(outer_weights);
+      stage_dims.push_back(dim);
+      remaining_weights = inner_weights;
+    }
+  }
+  if( stage_weights.empty() )
+    return;
+  stage_weights.push_back(remaining_weights);
+  stage_dims.push_back(-1);
+
+  ///Only rewrite if it reduces the number of operations
+  size_t num_terms = 0;
+  for( deque<stencil_weights>::iterator it = stage_weights.begin() ; it != stage_weights.end() ; it++ )
+    num_terms += it->size();
+  if( num_terms >= fn_weights.size() )
+    return;
+
+  ///Normalize the weights of every stage to small integers where
+  ///possible, the common scale factor is applied by the last stage
+  double scale = 1.0;
+  for( deque<stencil_weights>::iterator it = stage_weights.begin() ; it != stage_weights.end() ; it++ ){
+    double min_weight = 0;
+    int num_negative = 0;
+    for( stencil_weights::iterator jt = it->begin() ; jt != it->end() ; jt++ ){
+      if( min_weight == 0 || fabs(jt->second) < min_weight )
+	min_weight = fabs(jt->second);
+      if( jt->second < 0 )
+	num_negative++;
+    }
+    if( 2 * num_negative > (int)it->size() )
+      min_weight = -min_weight;
+    bool all_integers = true;
+    for( stencil_weights::iterator jt = it->begin() ; jt != it->end() ; jt++ )
+      all_integers = all_integers && is_integer_value(jt->second / min_weight);
+    if( !all_integers )
+      continue;
+    for( stencil_weights::iterator jt = it->begin() ; jt != it->end() ; jt++ )
+      jt->second = floor(jt->second / min_weight + 0.5);
+    scale *= min_weight;
+  }
+  ///Move a negative scale factor into a stage with as many negative
+  ///as positive weights
+  for( deque<stencil_weights>::iterator it = stage_weights.begin() ; it != stage_weights.end() && scale < 0 ; it++ ){
+    int num_negative = 0;
+    for( stencil_weights::iterator jt = it->begin() ; jt != it->end() ; jt++ )
+      if( jt->second < 0 )
+	num_negative++;
+    if( 2 * num_negative == (int)it->size() ){
+      for( stencil_weights::iterator jt = it->begin() ; jt != it->end() ; jt++ )
+	jt->second = -jt->second;
+      scale = -scale;
+    }
+  }
+
+  ///Check that the names of the new functions are not in use
+  deque<string> stage_names;
+  for( deque<int>::iterator it = stage_dims.begin() ; it != stage_dims.end() ; it++ ){
+    int curr_dim = *it;
+    if( curr_dim == -1 ){
+      ///The remaining stage is named after its dimension if it is 1D
+      const stencil_weights& last_weights = stage_weights.back();
+      for( int dim = 0 ; dim < ndims && curr_dim != -2 ; dim++ ){
+	for( stencil_weights::const_iterator jt = last_weights.begin() ; jt != last_weights.end() ; jt++ ){
+	  if( jt->first[dim] != 0 ){
+	    curr_dim = ( curr_dim == -1 ? dim : -2 );
+	    break;
+	  }
+	}
+      }
+    }
+    stringstream curr_name;
+    curr_name << curr_fn->get_name() << "_sep_";
+    if( curr_dim >= 0 )
+      curr_name << "d" << curr_dim;
+    else
+      curr_name << "r";
+    if( fn_defs->find_symbol(curr_name.str().c_str()) )
+      return;
+    stage_names.push_back(curr_name.str());
+  }
+
+  deque<stencilfn_defn_node*>& new_fns = visitor.separated_fns[curr_fn];
+  deque<string>::iterator jt = stage_names.begin();
+  for( deque<stencil_weights>::iterator it = stage_weights.begin() ; it != stage_weights.end() ; it++, jt++ ){
+    new_fns.push_back(create_stencilfn(*jt,*it,( it == stage_weights.begin() ? scale : 1.0 )));
+  }
+}
+
+
+vector_expr_node* SeparableStencils::Visitor::visit_fnid_expr(fnid_expr_node* curr_expr, void* state)
+{
+  ASTVisitor<void*>::visit_fnid_expr(curr_expr,state);
+
+  map<const fn_defn_node*,deque<stencilfn_defn_node*> >::iterator curr_fns = separated_fns.find(curr_expr->get_defn());
+  if( curr_fns == separated_fns.end() || curr_expr->get_sub_domain() )
+    return NULL;
+
+  ///Boundary conditions other than constant are applied to each
+  ///dimension independently, and so are not affected by splitting
+  arg_info& curr_arg = curr_expr->args.front();
+  if( curr_arg.bdy_condn->type == B_CONSTANT && curr_arg.bdy_condn->value != 0 )
+    return NULL;
+
+  vector_expr_node* curr_input = curr_arg.arg_expr;
+  bdy_info* curr_bdy = curr_arg.bdy_condn;
+  bdy_info orig_bdy = *curr_bdy;
+  curr_input->remove_usage(curr_expr);
+  curr_expr->args.clear();
+
+  ///Apply the stages starting with the innermost
+  for( deque<stencilfn_defn_node*>::reverse_iterator it = curr_fns->second.rbegin() ; it != curr_fns->second.rend() ; it++ ){
+    fnid_expr_node* new_expr = new fnid_expr_node();
+    new_expr->add_arg(curr_input,curr_bdy);
+    new_expr->find_definition((*it)->get_name());
+    curr_input = new_expr;
+    curr_bdy = new bdy_info(orig_bdy.type,orig_bdy.value);
+  }
+  delete curr_bdy;
+  return curr_input;
+}
+
+
+void SeparableStencils::visit(program_node* curr_program)
+{
+  deque<pair<string,fn_defn_node*> > curr_fns;
+  for( deque<pair<string,fn_defn_node*> >::const_iterator it = fn_defs->begin() ; it != fn_defs->end() ; it++ )
+    curr_fns.push_back(*it);
+  for( deque<pair<string,fn_defn_node*> >::iterator it = curr_fns.begin() ; it != curr_fns.end() ; it++ ){
+    stencilfn_defn_node* curr_fn = dynamic_cast<stencilfn_defn_node*>(it->second);
+    if( curr_fn )
+      separate_stencilfn(curr_fn);
+  }
+  if( !visitor.separated_fns.empty() )
+    visitor.visit(curr_program,NULL);
+}
@@ -0,0 +1,267 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <sstream>
+#include <iomanip>
+#include "AST/parser.hpp"
+#include "ASTVisitor/stencil_cse.hpp"
+#include "ASTVisitor/copy_stencil_expr.hpp"
+
+using namespace std;
+
+bool StencilCSE::is_candidate(const expr_node* curr_expr) const
+{
+  if( curr_expr->get_data_type().type == T_STRUCT )
+    return false;
+  switch(curr_expr->get_s_type()){
+  case S_UNARYNEG:
+    return
+      static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr()->get_s_type() != S_VALUE;
+  case S_STENCILOP:
+    return
+      static_cast<const stencil_op_node*>(curr_expr)->get_var()->get_dim() != 0;
+  case S_MATHFN:
+  case S_TERNARY:
+  case S_BINARYOP:
+  case S_ARRAYACCESS:
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+string StencilCSE::get_key(const expr_node* curr_expr)
+{
+  stringstream curr_key;
+  curr_key << curr_expr->get_data_type().type << ":" ;
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+    switch(curr_expr->get_data_type().type){
+    case T_FLOAT:
+      curr_key << setprecision(9) << static_cast<const value_node<float>*>(curr_expr)->get_value();
+      break;
+    case T_DOUBLE:
+      curr_key << setprecision(17) << static_cast<const value_node<double>*>(curr_expr)->get_value();
+      break;
+    case T_INT:
+      curr_key << static_cast<const value_node<int>*>(curr_expr)->get_value();
+      break;
+    case T_INT8:
+      curr_key << (int)static_cast<const value_node<unsigned char>*>(curr_expr)->get_value();
+      break;
+    case T_INT16:
+      curr_key << static_cast<const value_node<short>*>(curr_expr)->get_value();
+      break;
+    default:
+      assert((0) && ("[ME]: Error! Value of unknown data type"));
+    }
+    break;
+  case S_UNARYNEG:
+    curr_key << "-(" << get_key(static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr()) << ")";
+    break;
+  case S_ID:{
+    const string& id_name = static_cast<const id_expr_node*>(curr_expr)->get_name();
+    map<string,int>::const_iterator curr_version = scalar_versions.find(id_name);
+    curr_key << id_name << "#" << ( curr_version == scalar_versions.end() ? 0 : curr_version->second );
+  }
+    break;
+  case S_MATHFN:{
+    const math_fn_expr_node* curr_mathfn = static_cast<const math_fn_expr_node*>(curr_expr);
+    curr_key << curr_mathfn->get_name() << "(" ;
+    const deque<expr_node*>& fn_args = curr_mathfn->get_args();
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ; it != fn_args.end() ; it++ )
+      curr_key << get_key(*it) << ",";
+    curr_key << ")";
+  }
+    break;
+  case S_TERNARY:{
+    const ternary_expr_node* curr_ternary = static_cast<const ternary_expr_node*>(curr_expr);
+    curr_key << "(" << get_key(curr_ternary->get_bool_expr()) << "?" <<
+      get_key(curr_ternary->get_true_expr()) << ":" <<
+      get_key(curr_ternary->get_false_expr()) << ")";
+  }
+    break;
+  case S_BINARYOP:{
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    curr_key << "(" << get_key(curr_op->get_lhs_expr()) << get_op_string(curr_op->get_op()) << get_key(curr_op->get_rhs_expr()) << ")";
+  }
+    break;
+  case S_STENCILOP:{
+    const stencil_op_node* curr_stencil_op = static_cast<const stencil_op_node*>(curr_expr);
+    curr_key << curr_stencil_op->get_name() << "@[" ;
+    const deque<scale_coeffs>& scale_fn = curr_stencil_op->get_scale_fn()->scale_fn;
+    for( deque<scale_coeffs>::const_iterator it = scale_fn.begin() ; it != scale_fn.end() ; it++ )
+      curr_key << it->offset << "/" << it->scale << ",";
+    curr_key << "]." << curr_stencil_op->get_access_field();
+  }
+    break;
+  case S_STRUCT:{
+    const deque<expr_node*>& field_exprs = static_cast<const pt_struct_node*>(curr_expr)->get_field_exprs();
+    curr_key << "{" ;
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ; it != field_exprs.end() ; it++ )
+      curr_key << get_key(*it) << ",";
+    curr_key << "}";
+  }
+    break;
+  case S_ARRAYACCESS:{
+    const array_access_node* curr_access = static_cast<const array_access_node*>(curr_expr);
+    curr_key << curr_access->get_name() << "[" ;
+    const deque<expr_node*>& index_exprs = curr_access->get_index_exprs();
+    for( deque<expr_node*>::const_iterator it = index_exprs.begin() ; it != index_exprs.end() ; it++ )
+      curr_key << get_key(*it) << ",";
+    curr_key << "]";
+  }
+    break;
+  default:
+    assert(0);
+  }
+  return curr_key.str();
+}
+
+
+void StencilCSE::count_uses(const expr_node* curr_expr)
+{
+  if( is_candidate(curr_expr) )
+    num_uses[get_key(curr_expr)]++;
+  switch(curr_expr->get_s_type()){
+  case S_UNARYNEG:
+    count_uses(static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr());
+    break;
+  case S_MATHFN:{
+    const deque<expr_node*>& fn_args = static_cast<const math_fn_expr_node*>(curr_expr)->get_args();
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ; it != fn_args.end() ; it++ )
+      count_uses(*it);
+  }
+    break;
+  case S_TERNARY:{
+    const ternary_expr_node* curr_ternary = static_cast<const ternary_expr_node*>(curr_expr);
+    count_uses(curr_ternary->get_bool_expr());
+    count_uses(curr_ternary->get_true_expr());
+    count_uses(curr_ternary->get_false_expr());
+  }
+    break;
+  case S_BINARYOP:
+    count_uses(static_cast<const expr_op_node*>(curr_expr)->get_lhs_expr());
+    count_uses(static_cast<const expr_op_node*>(curr_expr)->get_rhs_expr());
+    break;
+  case S_STRUCT:{
+    const deque<expr_node*>& field_exprs = static_cast<const pt_struct_node*>(curr_expr)->get_field_exprs();
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ; it != field_exprs.end() ; it++ )
+      count_uses(*it);
+  }
+    break;
+  case S_ARRAYACCESS:{
+    const deque<expr_node*>& index_exprs = static_cast<const array_access_node*>(curr_expr)->get_index_exprs();
+    for( deque<expr_node*>::const_iterator it = index_exprs.begin() ; it != index_exprs.end() ; it++ )
+      count_uses(*it);
+  }
+    break;
+  default:
+    break;
+  }
+}
+
+
+expr_node* StencilCSE::visit(expr_node* curr_expr)
+{
+  if( !is_candidate(curr_expr) )
+    return StencilExprVisitor::visit(curr_expr);
+
+  string curr_key = get_key(curr_expr);
+  map<string,string>::iterator curr_avail = available_exprs.find(curr_key);
+  if( curr_avail != available_exprs.end() )
+    return new id_expr_node(curr_avail->second.c_str(),curr_fn->local_scalars);
+
+  ///Eliminate common subexpressions within the current expression first
+  bool is_conditional = ( curr_expr->get_s_type() == S_TERNARY );
+  if( is_conditional )
+    conditional_depth++;
+  StencilExprVisitor::visit(curr_expr);
+  if( is_conditional )
+    conditional_depth--;
+
+  if( num_uses[curr_key] < 2 || conditional_depth > 0 )
+    return NULL;
+
+  ///Hoist the expression into a new local scalar
+  stringstream new_name;
+  new_name << "__cse_" << ncse_vars++ << "__";
+  CopyStencilExpr copier(curr_fn->get_fn_symbols());
+  expr_node* hoisted_expr = copier.copy(curr_expr);
+  curr_fn->local_scalars->add_local_scalar(new_name.str().c_str(),hoisted_expr);
+  curr_fn->fn_body.insert
+    (curr_fn->fn_body.begin()+insert_pos,
+     new pt_stmt_node(new_name.str().c_str(),hoisted_expr));
+  insert_pos++;
+  available_exprs.insert(make_pair(curr_key,new_name.str()));
+  return new id_expr_node(new_name.str().c_str(),curr_fn->local_scalars);
+}
+
+
+void StencilCSE::visit_stencilfn(stencilfn_defn_node* curr_stencil_fn)
+{
+  curr_fn = curr_stencil_fn;
+  deque<pt_stmt_node*>& fn_body = curr_fn->fn_body;
+
+  ///Count the occurences of each value number
+  num_uses.clear();
+  scalar_versions.clear();
+  for( deque<pt_stmt_node*>::iterator it = fn_body.begin() ; it != fn_body.end() ; it++ ){
+    count_uses((*it)->get_rhs());
+    scalar_versions[(*it)->get_lhs()]++;
+  }
+  count_uses(curr_fn->return_expr);
+
+  ///Replay the function body, hoisting repeated subexpressions
+  available_exprs.clear();
+  scalar_versions.clear();
+  for( int i = 0 ; i < (int)fn_body.size() ; i++ ){
+    insert_pos = i;
+    pt_stmt_node* curr_stmt = fn_body[i];
+    visit_stmt(curr_stmt);
+    i = insert_pos;
+    scalar_versions[curr_stmt->get_lhs()]++;
+  }
+  insert_pos = fn_body.size();
+  expr_node* new_return_expr = visit(curr_fn->return_expr);
+  if( new_return_expr ){
+    delete curr_fn->return_expr;
+    curr_fn->return_expr = new_return_expr;
+  }
+  curr_fn = NULL;
+}
+
+
+void StencilCSE::visit(program_node*)
+{
+  for( deque<pair<string,fn_defn_node*> >::const_iterator it = fn_defs->begin() ; it != fn_defs->end() ; it++ ){
+    stencilfn_defn_node* curr_stencil_fn = dynamic_cast<stencilfn_defn_node*>(it->second);
+    if( curr_stencil_fn )
+      visit_stencilfn(curr_stencil_fn);
+  }
+}
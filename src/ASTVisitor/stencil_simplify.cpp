@@ -0,0 +1,384 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <cmath>
+#include <climits>
+#include "AST/parser.hpp"
+#include "ASTVisitor/stencil_simplify.hpp"
+#include "ASTVisitor/copy_stencil_expr.hpp"
+
+using namespace std;
+
+///Returns true if curr_expr is a literal of a basic type, and sets its value
+static bool get_constant(const expr_node* curr_expr, double& value)
+{
+  if( curr_expr->get_s_type() != S_VALUE )
+    return false;
+  ///Literals that have been cast are not folded
+  switch(curr_expr->get_data_type().type){
+  case T_INT: {
+    const value_node<int>* curr_value = dynamic_cast<const value_node<int>*>(curr_expr);
+    if( curr_value )
+      value = curr_value->get_value();
+    return curr_value != NULL;
+  }
+  case T_FLOAT: {
+    const value_node<float>* curr_value = dynamic_cast<const value_node<float>*>(curr_expr);
+    if( curr_value )
+      value = curr_value->get_value();
+    return curr_value != NULL;
+  }
+  case T_DOUBLE: {
+    const value_node<double>* curr_value = dynamic_cast<const value_node<double>*>(curr_expr);
+    if( curr_value )
+      value = curr_value->get_value();
+    return curr_value != NULL;
+  }
+  default:
+    return false;
+  }
+}
+
+
+///Create a literal of the given type
+static expr_node* create_value(basic_data_types value_type, double value)
+{
+  switch(value_type){
+  case T_INT:
+    return new value_node<int>((int)value);
+  case T_FLOAT:
+    return new value_node<float>((float)value);
+  case T_DOUBLE:
+    return new value_node<double>(value);
+  default:
+    assert(0);
+    return NULL;
+  }
+}
+
+
+///Type in which a binary operation between the two types is evaluated,
+///same rules as the constructor of expr_op_node
+static basic_data_types get_promoted_type(basic_data_types lhs_type, basic_data_types rhs_type)
+{
+  if( lhs_type == T_DOUBLE || rhs_type == T_DOUBLE )
+    return T_DOUBLE;
+  else if( lhs_type == T_FLOAT || rhs_type == T_FLOAT )
+    return T_FLOAT;
+  return T_INT;
+}
+
+
+///Convert a value computed in one type to the type of the expression
+///holding it, returns false if the conversion is not well defined
+static bool convert_value(double& value, basic_data_types from_type, basic_data_types to_type)
+{
+  if( std::isnan(value) || std::isinf(value) )
+    return false;
+  switch(to_type){
+  case T_INT:
+    if( from_type != T_INT ){
+      if( value <= (double)INT_MIN - 1.0 || value >= (double)INT_MAX + 1.0 )
+	return false;
+      value = (double)(int)value;
+    }
+    return true;
+  case T_FLOAT:
+    value = (float)value;
+    return !std::isinf(value);
+  case T_DOUBLE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+///Evaluate a binary operation in type T
+template<typename T>
+static bool compute_op(operator_type op, T lhs_value, T rhs_value, double& result)
+{
+  switch(op){
+  case O_PLUS:
+    result = (T)(lhs_value + rhs_value);
+    break;
+  case O_MINUS:
+    result = (T)(lhs_value - rhs_value);
+    break;
+  case O_MULT:
+    result = (T)(lhs_value * rhs_value);
+    break;
+  case O_DIV:
+    if( rhs_value == 0 )
+      return false;
+    result = (T)(lhs_value / rhs_value);
+    break;
+  case O_LT:
+    result = lhs_value < rhs_value;
+    break;
+  case O_GT:
+    result = lhs_value > rhs_value;
+    break;
+  case O_LE:
+    result = lhs_value <= rhs_value;
+    break;
+  case O_GE:
+    result = lhs_value >= rhs_value;
+    break;
+  case O_EQ:
+    result = lhs_value == rhs_value;
+    break;
+  case O_NE:
+    result = lhs_value != rhs_value;
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+
+///Returns k if value == 2^k, k > 0, and -1 otherwise
+static int get_log2(double value)
+{
+  int exponent;
+  if( value < 2 || frexp(value,&exponent) != 0.5 )
+    return -1;
+  return exponent - 1;
+}
+
+
+expr_node* StencilSimplify::copy_expr(const expr_node* curr_expr)
+{
+  CopyStencilExpr copy_visitor(curr_fn_symbols);
+  return copy_visitor.copy(curr_expr);
+}
+
+
+expr_node* StencilSimplify::negate_expr(const expr_node* curr_expr)
+{
+  if( curr_expr->get_s_type() == S_UNARYNEG ){
+    const expr_node* base_expr = static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr();
+    if( base_expr->get_data_type().type == curr_expr->get_data_type().type )
+      return copy_expr(base_expr);
+  }
+  return new unary_neg_expr_node(copy_expr(curr_expr));
+}
+
+
+expr_node* StencilSimplify::fold_expr_op(const expr_op_node* curr_expr)
+{
+  double lhs_value, rhs_value, result;
+  get_constant(curr_expr->get_lhs_expr(),lhs_value);
+  get_constant(curr_expr->get_rhs_expr(),rhs_value);
+  basic_data_types eval_type =
+    get_promoted_type(curr_expr->get_lhs_expr()->get_data_type().type,curr_expr->get_rhs_expr()->get_data_type().type);
+  basic_data_types result_type = curr_expr->get_data_type().type;
+
+  bool is_valid;
+  switch(eval_type){
+  case T_INT:
+    is_valid = compute_op<long long>(curr_expr->get_op(),(long long)lhs_value,(long long)rhs_value,result) &&
+      result >= INT_MIN && result <= INT_MAX;
+    break;
+  case T_FLOAT:
+    is_valid = compute_op<float>(curr_expr->get_op(),(float)lhs_value,(float)rhs_value,result);
+    break;
+  default:
+    is_valid = compute_op<double>(curr_expr->get_op(),lhs_value,rhs_value,result);
+  }
+  if( is_relation_op(curr_expr->get_op()) )
+    eval_type = T_INT;
+  if( !is_valid || !convert_value(result,eval_type,result_type) )
+    return NULL;
+  return create_value(result_type,result);
+}
+
+
+expr_node* StencilSimplify::simplify_expr_op(const expr_op_node* curr_expr)
+{
+  const expr_node* lhs_expr = curr_expr->get_lhs_expr();
+  const expr_node* rhs_expr = curr_expr->get_rhs_expr();
+  double value;
+  bool is_rhs_constant = get_constant(rhs_expr,value);
+  if( !is_rhs_constant && !get_constant(lhs_expr,value) )
+    return NULL;
+  const expr_node* var_expr = ( is_rhs_constant ? lhs_expr : rhs_expr );
+  basic_data_types var_type = var_expr->get_data_type().type;
+  basic_data_types result_type = curr_expr->get_data_type().type;
+
+  ///Skip expressions that are cast, and those whose type differs
+  ///from the type of the non-constant operand, since removing the
+  ///operation would change the type of the result
+  if( result_type != get_promoted_type(lhs_expr->get_data_type().type,rhs_expr->get_data_type().type) )
+    return NULL;
+  bool is_int = ( result_type == T_INT );
+  bool same_type = ( var_type == result_type ) &&
+    ( result_type == T_INT || result_type == T_FLOAT || result_type == T_DOUBLE );
+
+  switch(curr_expr->get_op()){
+  case O_PLUS:
+    ///x + 0 is not x for floating point values when x is -0
+    if( value == 0 && is_int && same_type )
+      return copy_expr(var_expr);
+    break;
+  case O_MINUS:
+    if( value == 0 && same_type ){
+      if( is_rhs_constant )
+	return copy_expr(var_expr);
+      else if( is_int )
+	return negate_expr(var_expr);
+    }
+    break;
+  case O_MULT:
+    if( same_type ){
+      if( value == 1 )
+	return copy_expr(var_expr);
+      if( value == -1 )
+	return negate_expr(var_expr);
+      ///x * 0 is not 0 for floating point values when x is inf or nan
+      if( value == 0 && is_int )
+	return create_value(T_INT,0);
+    }
+    ///Shifts are only used for unsigned values, for signed values they
+    ///do not match the semantics of the multiplication/division
+    if( is_int && var_type == T_INT8 && get_log2(value) > 0 )
+      return new expr_op_node(copy_expr(var_expr),new value_node<int>(get_log2(value)),O_SHL);
+    break;
+  case O_DIV:
+    if( !is_rhs_constant )
+      break;
+    if( same_type ){
+      if( value == 1 )
+	return copy_expr(var_expr);
+      if( value == -1 )
+	return negate_expr(var_expr);
+      ///Division by a power of two is exactly a multiplication by its reciprocal
+      if( !is_int && get_log2(fabs(value)) > 0 && get_log2(fabs(value)) < 126 )
+	return new expr_op_node(copy_expr(var_expr),create_value(result_type,1.0/value),O_MULT);
+    }
+    if( is_int && var_type == T_INT8 && get_log2(value) > 0 )
+      return new expr_op_node(copy_expr(var_expr),new value_node<int>(get_log2(value)),O_SHR);
+    break;
+  default:
+    ;
+  }
+  return NULL;
+}
+
+
+expr_node* StencilSimplify::visit_expr_op(expr_op_node* curr_expr)
+{
+  StencilExprVisitor::visit_expr_op(curr_expr);
+  double value;
+  if( get_constant(curr_expr->get_lhs_expr(),value) && get_constant(curr_expr->get_rhs_expr(),value) )
+    return fold_expr_op(curr_expr);
+  return simplify_expr_op(curr_expr);
+}
+
+
+expr_node* StencilSimplify::visit_unary_expr(unary_neg_expr_node* curr_expr)
+{
+  StencilExprVisitor::visit_unary_expr(curr_expr);
+  const expr_node* base_expr = curr_expr->get_base_expr();
+  basic_data_types result_type = curr_expr->get_data_type().type;
+  if( base_expr->get_data_type().type != result_type )
+    return NULL;
+  double value;
+  if( get_constant(base_expr,value) ){
+    if( result_type == T_INT && value == INT_MIN )
+      return NULL;
+    return create_value(result_type,-value);
+  }
+  if( base_expr->get_s_type() == S_UNARYNEG )
+    return negate_expr(base_expr);
+  return NULL;
+}
+
+
+expr_node* StencilSimplify::visit_math_fn(math_fn_expr_node* curr_expr)
+{
+  StencilExprVisitor::visit_math_fn(curr_expr);
+  const deque<expr_node*>& fn_args = curr_expr->get_args();
+  double value;
+  if( fn_args.size() != 1 || !get_constant(fn_args.front(),value) )
+    return NULL;
+
+  ///Only functions whose result is exactly defined are evaluated
+  const string& fn_name = curr_expr->get_name();
+  if( fn_name.compare("sqrt") == 0 )
+    value = sqrt(value);
+  else if( fn_name.compare("fabs") == 0 )
+    value = fabs(value);
+  else if( fn_name.compare("floor") == 0 )
+    value = floor(value);
+  else if( fn_name.compare("ceil") == 0 )
+    value = ceil(value);
+  else
+    return NULL;
+  basic_data_types result_type = curr_expr->get_data_type().type;
+  if( !convert_value(value,T_DOUBLE,result_type) )
+    return NULL;
+  return create_value(result_type,value);
+}
+
+
+expr_node* StencilSimplify::visit_ternary(ternary_expr_node* curr_expr)
+{
+  StencilExprVisitor::visit_ternary(curr_expr);
+  double value;
+  if( !get_constant(curr_expr->get_bool_expr(),value) )
+    return NULL;
+  const expr_node* selected_expr =
+    ( value != 0 ? curr_expr->get_true_expr() : curr_expr->get_false_expr() );
+  if( selected_expr->get_data_type().type != curr_expr->get_data_type().type )
+    return NULL;
+  return copy_expr(selected_expr);
+}
+
+
+void StencilSimplify::visit_stencilfn(stencilfn_defn_node* curr_fn)
+{
+  curr_fn_symbols = curr_fn->get_fn_symbols();
+  for( deque<pt_stmt_node*>::iterator it = curr_fn->fn_body.begin() ; it != curr_fn->fn_body.end() ; it++ )
+    visit_stmt(*it);
+  expr_node* new_return_expr = visit(curr_fn->return_expr);
+  if( new_return_expr ){
+    delete curr_fn->return_expr;
+    curr_fn->return_expr = new_return_expr;
+  }
+}
+
+
+void StencilSimplify::visit(program_node*)
+{
+  for( deque<pair<string,fn_defn_node*> >::const_iterator it = fn_defs->begin() ; it != fn_defs->end() ; it++ ){
+    stencilfn_defn_node* curr_stencil_fn = dynamic_cast<stencilfn_defn_node*>(it->second);
+    if( curr_stencil_fn )
+      visit_stencilfn(curr_stencil_fn);
+  }
+}
@@ -0,0 +1,328 @@
+//****************************************************************************//
+//* Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.             *//
+//*                                                                          *//
+//* Redistribution and use in source and binary forms, with or without       *//
+//* modification, are permitted provided that the following conditions       *//
+//* are met:                                                                 *//
+//*  * Redistributions of source code must retain the above copyright        *//
+//*    notice, this list of conditions and the following disclaimer.         *//
+//*  * Redistributions in binary form must reproduce the above copyright     *//
+//*    notice, this list of conditions and the following disclaimer in the   *//
+//*    documentation and/or other materials provided with the distribution.  *//
+//*  * Neither the name of NVIDIA CORPORATION nor the names of its           *//
+//*    contributors may be used to endorse or promote products derived       *//
+//*    from this software without specific prior written permission.         *//
+//*                                                                          *//
+//* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY     *//
+//* EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        *//
+//* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR       *//
+//* PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR        *//
+//* CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,    *//
+//* EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,      *//
+//* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR       *//
+//* PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY      *//
+//* OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT             *//
+//* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
+//* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
+//****************************************************************************//
+#include <algorithm>
+#include <climits>
+#include "ASTVisitor/value_range.hpp"
+
+using namespace std;
+
+///-----------------------------------------------------------------------------
+value_range value_range::of_type(basic_data_types elem_type)
+{
+  switch(elem_type){
+  case T_INT8:
+    return value_range(0,UCHAR_MAX);
+  case T_INT16:
+    return value_range(SHRT_MIN,SHRT_MAX);
+  case T_INT:
+    return value_range(INT_MIN,INT_MAX);
+  default:
+    assert(0 && "[ME] : Range requested for a non-integer type");
+  }
+  return value_range();
+}
+
+
+///-----------------------------------------------------------------------------
+bool ValueRangeAnalysis::is_integer_type(basic_data_types elem_type)
+{
+  return elem_type == T_INT || elem_type == T_INT16 || elem_type == T_INT8;
+}
+
+
+///Operations are evaluated in int, results that overflow it can be any int
+static value_range get_int_range(long long lb, long long ub)
+{
+  value_range int_range = value_range::of_type(T_INT);
+  value_range curr_range(lb,ub);
+  if( !int_range.contains(curr_range) )
+    return int_range;
+  return curr_range;
+}
+
+
+///Returns true if the range contains a single value
+static bool get_constant(const value_range& curr_range, long long& value)
+{
+  value = curr_range.lb;
+  return curr_range.lb == curr_range.ub;
+}
+
+
+///-----------------------------------------------------------------------------
+value_range ValueRangeAnalysis::convert
+(const value_range& curr_range, basic_data_types elem_type) const
+{
+  value_range type_range = value_range::of_type(elem_type);
+  if( type_range.contains(curr_range) )
+    return curr_range;
+  if( !saturate || elem_type == T_INT )
+    return type_range;
+  return value_range
+    (min(max(curr_range.lb,type_range.lb),type_range.ub),
+     min(max(curr_range.ub,type_range.lb),type_range.ub));
+}
+
+
+///-----------------------------------------------------------------------------
+value_range ValueRangeAnalysis::get_op_range
+(const expr_op_node* curr_expr, const value_range& lhs_range,
+ const value_range& rhs_range) const
+{
+  long long shift;
+  switch(curr_expr->get_op()){
+  case O_PLUS:
+    return get_int_range
+      (lhs_range.lb + rhs_range.lb, lhs_range.ub + rhs_range.ub);
+  case O_MINUS:
+    return get_int_range
+      (lhs_range.lb - rhs_range.ub, lhs_range.ub - rhs_range.lb);
+  case O_MULT:
+  case O_DIV: {
+    ///Division truncates towards zero, and is monotonic in each operand
+    ///when the divisor does not change sign, the extremes are at the corners
+    if( curr_expr->get_op() == O_DIV && rhs_range.lb <= 0 &&
+        rhs_range.ub >= 0 )
+      return value_range::of_type(T_INT);
+    long long corners[4];
+    int ncorners = 0;
+    for( int i = 0 ; i < 2 ; i++ )
+      for( int j = 0 ; j < 2 ; j++ ){
+        long long lhs_value = ( i ? lhs_range.ub : lhs_range.lb );
+        long long rhs_value = ( j ? rhs_range.ub : rhs_range.lb );
+        corners[ncorners++] =
+          ( curr_expr->get_op() == O_MULT ? lhs_value * rhs_value :
+            lhs_value / rhs_value );
+      }
+    return get_int_range
+      (*min_element(corners,corners+4), *max_element(corners,corners+4));
+  }
+  case O_SHL:
+    if( get_constant(rhs_range,shift) && shift >= 0 && shift < 31 &&
+        lhs_range.lb >= 0 )
+      return get_int_range(lhs_range.lb << shift, lhs_range.ub << shift);
+    return value_range::of_type(T_INT);
+  case O_SHR:
+    ///Right shift of negative values is arithmetic in the generated code
+    if( get_constant(rhs_range,shift) && shift >= 0 && shift < 32 )
+      return value_range(lhs_range.lb >> shift, lhs_range.ub >> shift);
+    return value_range::of_type(T_INT);
+  default:
+    if( is_relation_op(curr_expr->get_op()) )
+      return value_range(0,1);
+    return value_range::of_type(T_INT);
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+bool ValueRangeAnalysis::analyze_expr
+(const expr_node* curr_expr, value_range& curr_range)
+{
+  basic_data_types elem_type = curr_expr->get_data_type().type;
+  value_range raw_range;
+  bool is_integer = false;
+
+  switch(curr_expr->get_s_type()){
+  case S_VALUE: {
+    const value_node<int>* curr_value =
+      dynamic_cast<const value_node<int>*>(curr_expr);
+    if( curr_value && is_integer_type(elem_type) ){
+      raw_range = value_range(curr_value->get_value(),curr_value->get_value());
+      curr_range = raw_range;
+      is_integer = true;
+    }
+    break;
+  }
+  case S_ID: {
+    map<string,value_range>::const_iterator curr_local =
+      local_ranges.find
+      (static_cast<const id_expr_node*>(curr_expr)->get_name());
+    if( curr_local != local_ranges.end() ){
+      raw_range = curr_local->second;
+      is_integer = true;
+    }
+    else if( is_integer_type(elem_type) ){
+      raw_range = value_range::of_type(elem_type);
+      is_integer = true;
+    }
+    curr_range = raw_range;
+    break;
+  }
+  case S_UNARYNEG: {
+    ///Printed inline, there is no conversion to the type of the expression
+    value_range base_range;
+    if( analyze_expr
+        (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),
+         base_range) ){
+      raw_range = get_int_range(-base_range.ub,-base_range.lb);
+      curr_range = raw_range;
+      is_integer = true;
+    }
+    break;
+  }
+  case S_MATHFN: {
+    const deque<expr_node*>& fn_args =
+      static_cast<const math_fn_expr_node*>(curr_expr)->get_args();
+    value_range arg_range;
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ;
+         it != fn_args.end() ; it++ )
+      analyze_expr(*it,arg_range);
+    if( is_integer_type(elem_type) ){
+      raw_range = value_range::of_type(T_INT);
+      curr_range = convert(raw_range,elem_type);
+      is_integer = true;
+    }
+    break;
+  }
+  case S_TERNARY: {
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    value_range cond_range, true_range, false_range;
+    analyze_expr(curr_ternary->get_bool_expr(),cond_range);
+    bool true_integer = analyze_expr(curr_ternary->get_true_expr(),true_range);
+    bool false_integer =
+      analyze_expr(curr_ternary->get_false_expr(),false_range);
+    if( is_integer_type(elem_type) ){
+      if( true_integer && false_integer )
+        raw_range = value_range
+          (min(true_range.lb,false_range.lb),
+           max(true_range.ub,false_range.ub));
+      else
+        raw_range = value_range::of_type(T_INT);
+      curr_range = convert(raw_range,elem_type);
+      is_integer = true;
+    }
+    break;
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    value_range lhs_range, rhs_range;
+    bool lhs_integer = analyze_expr(curr_op->get_lhs_expr(),lhs_range);
+    bool rhs_integer = analyze_expr(curr_op->get_rhs_expr(),rhs_range);
+    if( is_relation_op(curr_op->get_op()) )
+      raw_range = value_range(0,1);
+    else if( lhs_integer && rhs_integer )
+      raw_range = get_op_range(curr_op,lhs_range,rhs_range);
+    else
+      raw_range = value_range::of_type(T_INT);
+    if( is_integer_type(elem_type) ){
+      curr_range = convert(raw_range,elem_type);
+      is_integer = true;
+    }
+    break;
+  }
+  case S_STENCILOP:
+  case S_ARRAYACCESS: {
+    if( curr_expr->get_s_type() == S_ARRAYACCESS ){
+      const deque<expr_node*>& index_exprs =
+        static_cast<const array_access_node*>(curr_expr)->get_index_exprs();
+      value_range index_range;
+      for( deque<expr_node*>::const_iterator it = index_exprs.begin() ;
+           it != index_exprs.end() ; it++ )
+        analyze_expr(*it,index_range);
+    }
+    ///Casts of vectors do not convert the value loaded
+    const data_types& base_type = curr_expr->get_base_type();
+    basic_data_types stored_type = base_type.type;
+    if( stored_type == T_STRUCT && curr_expr->get_access_field() != -1 )
+      stored_type =
+        base_type.struct_info->fields[curr_expr->get_access_field()].field_type;
+    if( is_integer_type(stored_type) ){
+      raw_range = value_range::of_type(stored_type);
+      curr_range = raw_range;
+      is_integer = true;
+    }
+    break;
+  }
+  case S_STRUCT: {
+    const deque<expr_node*>& field_exprs =
+      static_cast<const pt_struct_node*>(curr_expr)->get_field_exprs();
+    value_range field_range;
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ;
+         it != field_exprs.end() ; it++ )
+      analyze_expr(*it,field_range);
+    break;
+  }
+  default:
+    break;
+  }
+
+  if( is_integer )
+    ranges[curr_expr] = make_pair(raw_range,curr_range);
+  return is_integer;
+}
+
+
+///-----------------------------------------------------------------------------
+void ValueRangeAnalysis::analyze(const stencilfn_defn_node* curr_fn)
+{
+  if( analyzed_fns.find(curr_fn) != analyzed_fns.end() )
+    return;
+  analyzed_fns.insert(curr_fn);
+
+  local_ranges.clear();
+  const deque<pt_stmt_node*>& fn_body = curr_fn->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    value_range curr_range;
+    if( analyze_expr((*it)->get_rhs(),curr_range) )
+      local_ranges[(*it)->get_lhs()] = curr_range;
+    else
+      local_ranges.erase((*it)->get_lhs());
+  }
+  value_range return_range;
+  analyze_expr(curr_fn->get_return_expr(),return_range);
+  local_ranges.clear();
+}
+
+
+///-----------------------------------------------------------------------------
+bool ValueRangeAnalysis::get_range
+(const expr_node* curr_expr, value_range& curr_range) const
+{
+  map<const expr_node*,pair<value_range,value_range> >::const_iterator it =
+    ranges.find(curr_expr);
+  if( it == ranges.end() )
+    return false;
+  curr_range = it->second.second;
+  return true;
+}
+
+
+///-----------------------------------------------------------------------------
+bool ValueRangeAnalysis::get_raw_range
+(const expr_node* curr_expr, value_range& curr_range) const
+{
+  map<const expr_node*,pair<value_range,value_range> >::const_iterator it =
+    ranges.find(curr_expr);
+  if( it == ranges.end() )
+    return false;
+  curr_range = it->second.first;
+  return true;
+}
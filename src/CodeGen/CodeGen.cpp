@@ -27,6 +27,7 @@
 //****************************************************************************//
 #include "CodeGen/CodeGen.hpp"
 #include "AST/parser.hpp"
+#include <algorithm>
 
 using namespace std;
 
@@ -43,34 +44,117 @@ void CodeGen::PrintCHeader
   header_buffer.buffer << "extern \"C\" {\n";
   header_buffer.buffer << "#endif\n";
 
-  /// Function signature : void <kernel name>( <inputs arguments>, <parameters>,
-  /// <output buffer>);
-  header_buffer.buffer << "void ";
-  header_buffer.buffer << opts.kernel_name << "(";
-  /// <input arguments>
+  /// <input arguments>, struct arguments passed per field are split into one
+  /// argument per field
+  stringBuffer input_args, batch_input_args;
   for( deque<vector_defn_node*>::const_iterator I = curr_args.begin() ,
          E = curr_args.end();
        I != E ; I++ ){
-    header_buffer.buffer << get_string((*I)->get_data_type());
-    header_buffer.buffer << ( (*I)->get_dim() == 0 ? " " : "* ") ;
-    header_buffer.buffer << (*I)->get_name() << ", ";
+    if( find(opts.soa_args.begin(),opts.soa_args.end(),(*I)->get_name()) !=
+        opts.soa_args.end() ){
+      PrintCFieldArgs((*I)->get_data_type(),(*I)->get_name(),input_args);
+      input_args.buffer << ", ";
+      PrintCFieldArgs
+        ((*I)->get_data_type(),(*I)->get_name(),batch_input_args,"**");
+      batch_input_args.buffer << ", ";
+      continue;
+    }
+    input_args.buffer << get_string((*I)->get_data_type());
+    input_args.buffer << ( (*I)->get_dim() == 0 ? " " : "* ") ;
+    input_args.buffer << (*I)->get_name() << ", ";
+    batch_input_args.buffer << get_string((*I)->get_data_type());
+    batch_input_args.buffer << ( (*I)->get_dim() == 0 ? " " : "** ") ;
+    batch_input_args.buffer << (*I)->get_name() << ", ";
   }
 
   /// parameters
+  stringBuffer param_args;
   for( deque<pair<string,parameter_defn*> >::const_iterator
          I = global_params->begin(), E = global_params->end() ; I != E ; I++ )
-    header_buffer.buffer << "int " << I->first << ", ";
+    param_args.buffer << "int " << I->first << ", ";
 
   /// buffer for the output
-  header_buffer.buffer <<
-    get_string(program_fn->get_return_expr()->get_data_type());
-  header_buffer.buffer << "* output);\n";
+  stringBuffer output_args, batch_output_args;
+  if( find(opts.soa_args.begin(),opts.soa_args.end(),string("return")) !=
+      opts.soa_args.end() ){
+    PrintCFieldArgs
+      (program_fn->get_return_expr()->get_data_type(),"output",output_args);
+    PrintCFieldArgs
+      (program_fn->get_return_expr()->get_data_type(),"output",
+       batch_output_args,"**");
+  }
+  else{
+    output_args.buffer <<
+      get_string(program_fn->get_return_expr()->get_data_type());
+    output_args.buffer << "* output";
+    batch_output_args.buffer <<
+      get_string(program_fn->get_return_expr()->get_data_type());
+    batch_output_args.buffer << "** output";
+  }
+
+  /// Function signature : void <kernel name>( <inputs arguments>, <parameters>,
+  /// <output buffer>);
+  header_buffer.buffer << "void ";
+  header_buffer.buffer << opts.kernel_name << "(" << input_args.buffer.str() <<
+    param_args.buffer.str() << output_args.buffer.str() << ");\n";
+
+  /// Entry points that keep the intermediates in a workspace owned by a
+  /// context across calls : <kernel name>_create(<parameters>),
+  /// <kernel name>_run(<context>, <input arguments>, <output buffer>) and
+  /// <kernel name>_destroy(<context>)
+  if( opts.plan_api ){
+    string context_type = "struct " + opts.kernel_name + "_context";
+    string create_args = param_args.buffer.str();
+    if( create_args.empty() )
+      create_args = "void";
+    else
+      create_args.erase(create_args.size()-2);
+    header_buffer.buffer << context_type << ";\n";
+    header_buffer.buffer << context_type << "* " << opts.kernel_name <<
+      "_create(" << create_args << ");\n";
+    header_buffer.buffer << "void " << opts.kernel_name << "_run(" <<
+      context_type << "* ctx, " << input_args.buffer.str() <<
+      output_args.buffer.str() << ");\n";
+    header_buffer.buffer << "void " << opts.kernel_name << "_destroy(" <<
+      context_type << "* ctx);\n";
+  }
+
+  /// Batched entry point : void <kernel name>_batch(<number of images>,
+  /// <inputs arguments>, <parameters>, <output buffers>), with one pointer per
+  /// image for every array argument
+  if( opts.batch_api )
+    header_buffer.buffer << "void " << opts.kernel_name <<
+      "_batch(int num_images, " << batch_input_args.buffer.str() <<
+      param_args.buffer.str() << batch_output_args.buffer.str() << ");\n";
+
+  /// Region of interest entry point : void <kernel name>_roi(<inputs
+  /// arguments>, <parameters>, <bounds of the region>, <output buffer>), with
+  /// the lower and upper bound of each dimension, outermost first
+  if( opts.roi_api ){
+    header_buffer.buffer << "void " << opts.kernel_name << "_roi(" <<
+      input_args.buffer.str() << param_args.buffer.str();
+    for( int i = 0 ; i < program_fn->get_return_expr()->get_dim() ; i++ )
+      header_buffer.buffer << "int roi_lb_" << i << ", int roi_ub_" << i <<
+        ", ";
+    header_buffer.buffer << output_args.buffer.str() << ");\n";
+  }
 
   /// Size of the output
   header_buffer.buffer << "///Size of the output : ";
   PrintCDomainSize(program_fn->get_expr_domain(),header_buffer.buffer);
   header_buffer.buffer <<"\n";
 
+  /// The pool of the forma runtime is created on the first parallel region,
+  /// or by the application, that can also run teams on its own threads
+  if( opts.runtime.compare("forma") == 0 ){
+    header_buffer.buffer << "void forma_runtime_init(int num_threads);\n";
+    header_buffer.buffer << "void forma_runtime_finalize();\n";
+    header_buffer.buffer << "void forma_set_thread_pool\n"
+      "(void (*hook)(void (*team_fn)(void* team_data, int thread_num),\n"
+      "              void* team_data, int num_threads, void* hook_data),\n"
+      " int num_threads, void* hook_data);\n";
+  }
+
   header_buffer.buffer << "#ifdef __cplusplus\n";
   header_buffer.buffer<< "}\n";
   header_buffer.buffer << "#endif\n";
@@ -82,6 +166,24 @@ void CodeGen::PrintCHeader
 }
 
 
+///-----------------------------------------------------------------------------
+void CodeGen::PrintCFieldArgs
+(const data_types& struct_type, const string& name, stringBuffer& curr_buffer,
+ const string& pointer)
+{
+  const deque<defined_fields>& fields = struct_type.struct_info->fields;
+  for( deque<defined_fields>::const_iterator it = fields.begin() ;
+       it != fields.end() ; it++ ){
+    data_types field_data_type;
+    field_data_type.assign(it->field_type);
+    if( it != fields.begin() )
+      curr_buffer.buffer << ", ";
+    curr_buffer.buffer << get_string(field_data_type) << pointer << " " <<
+      name << "_" << it->field_name;
+  }
+}
+
+
 ///-----------------------------------------------------------------------------
 void CodeGen::PrintCStructDefinition
 (stringBuffer& curr_buffer, bool define_cuda_structs)
@@ -286,6 +388,12 @@ void CodeGen::computeOffsets
       if( considerBdyInfo && fnArgsIt->bdy_condn->type != B_NONE )
         continue;
 
+      /// Points outside the domain of arguments read from a ghost zone are
+      /// valid, they dont limit the interior
+      if( fnArgsIt->bdy_condn->type != B_NONE &&
+          readsGhostZone(fnArgsIt->arg_expr) )
+        continue;
+
       // Run over the stencil access information
       auto stencilAccessInfo = (*fnParamsIt)->get_access_info();
       assert(stencilAccessInfo.size() == numDims && "Mismatched stencil info");
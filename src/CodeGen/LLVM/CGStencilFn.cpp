@@ -370,6 +370,12 @@ Value *CGStencilFn::generateBinaryOp(const expr_op_node *expr) {
     retValue = ( useFloatOp ? builder.CreateFCmp(CmpInst::FCMP_ONE,lhsValue,rhsValue)
 		 : builder.CreateICmp(CmpInst::ICMP_NE,lhsValue,rhsValue) );
     break;
+  case O_SHL:
+    retValue = builder.CreateShl(lhsValue, rhsValue);
+    break;
+  case O_SHR:
+    retValue = builder.CreateAShr(lhsValue, rhsValue);
+    break;
   default:
     llvm_unreachable("Unhandled binary operator");
   }  
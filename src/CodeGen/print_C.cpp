@@ -25,6 +25,8 @@
 //* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE    *//
 //* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
 //****************************************************************************//
+#include <cstdlib>
+#include <iomanip>
 #include "CodeGen/print_C.hpp"
 
 using namespace std;
@@ -60,6 +62,41 @@ PrintC::PrintC
   host_allocate = new stringBuffer();
 
   use_single_malloc = false;
+
+  generate_tiled_code = false;
+  generate_unroll_code = false;
+  reuse_buffers = false;
+  use_sliding_window = false;
+  simd_type = T_STRUCT;
+  soa_structs = false;
+  aligned_buffers = false;
+  buffer_alignment = 64;
+  streaming_stores = false;
+  stream_curr_stmt = false;
+  emitted_stream_stores = false;
+  numa_first_touch = false;
+  numa_interleave = false;
+  interleave_curr_stmt = false;
+  use_omp_tasks = false;
+  use_forma_runtime = false;
+  plan_api = false;
+  batch_api = false;
+  roi_api = false;
+  roi_window = NULL;
+  ghost_zones = false;
+  curr_ghost_zone = NULL;
+  specialize_bdys = false;
+  one_sided_checks = false;
+  skip_interior_patch = false;
+
+  fuse_stencils = false;
+  fuse_all_stages = false;
+  parallel_dim = 0;
+  parallel_loop_depth = 0;
+  fusion_tile_size = 1;
+  time_tile_steps = 0;
+  tile_window_lb = NULL;
+  tile_window_ub = NULL;
 }
 
 ///-----------------------------------------------------------------------------
@@ -70,6 +107,16 @@ PrintC::~PrintC()
        it++)
     delete (*it);
 
+  for( map<const vector_expr_node*,domain_node*>::iterator it =
+         roi_windows.begin() ; it != roi_windows.end() ; it++ )
+    delete it->second;
+  for( deque<parameter_defn*>::iterator it = roi_bounds.begin() ;
+       it != roi_bounds.end() ; it++ )
+    delete (*it);
+  for( deque<domain_node*>::iterator it = ghost_domains.begin() ;
+       it != ghost_domains.end() ; it++ )
+    delete (*it);
+
   delete output_buffer;
   delete deallocate_buffer;
   delete host_allocate;
@@ -129,21 +176,12 @@ c_iterator* PrintC::printForHeader
     new c_iterator
     (new_var, parametric_exp::copy(lb), parametric_exp::copy(ub));
 
+  bool addpragma = false;
   if( generate_omp_pragmas && !new_iter->is_unit_trip_count() ){
-    bool addpragma = true;
-    for( deque<c_iterator*>::const_iterator itersIter = iters.begin(),
-           itersEnd = iters.end() ; itersIter != itersEnd ; itersIter++){
-      if( !((*itersIter)->is_unit_trip_count()) ){
-        addpragma = false;
-        break;
-      }
-    }
+    addpragma = is_distributed_loop(iters.end());
 
-    if( addpragma ){
-      output_buffer->buffer << "#pragma omp for schedule(static) private(" <<
-        new_var << ")" ;
-      output_buffer->newline();
-    }
+    if( addpragma && !use_forma_runtime )
+      print_omp_loop_pragma(new_var,1);
   }
 
   if( generate_icc_pragmas && isInnerMost && unroll_factor == 1 ){
@@ -158,18 +196,28 @@ c_iterator* PrintC::printForHeader
     output_buffer->buffer << "#endif";
     output_buffer->newline();
   }
-  output_buffer->indent();
-  output_buffer->buffer << "for (" << new_var << " = ";
-  PrintCParametricExpr(lb,output_buffer->buffer);
-  output_buffer-> buffer << "; " << new_var;
-  output_buffer->buffer << " <= ";
-  PrintCParametricExpr(ub,output_buffer->buffer);
-  output_buffer->buffer << " - " << unroll_factor -1 << "; " << new_var;
-  if (unroll_factor != 1)
-    output_buffer->buffer << "+= " << unroll_factor;
-  else
-    output_buffer->buffer << "++";
-  output_buffer->buffer << ")";
+  if( addpragma && use_forma_runtime ){
+    stringstream lb_stream, ub_stream;
+    PrintCParametricExpr(lb,lb_stream);
+    PrintCParametricExpr(ub,ub_stream);
+    ub_stream << " - " << unroll_factor - 1;
+    print_runtime_loop_header
+      (new_var,lb_stream.str(),ub_stream.str(),unroll_factor);
+  }
+  else{
+    output_buffer->indent();
+    output_buffer->buffer << "for (" << new_var << " = ";
+    PrintCParametricExpr(lb,output_buffer->buffer);
+    output_buffer-> buffer << "; " << new_var;
+    output_buffer->buffer << " <= ";
+    PrintCParametricExpr(ub,output_buffer->buffer);
+    output_buffer->buffer << " - " << unroll_factor -1 << "; " << new_var;
+    if (unroll_factor != 1)
+      output_buffer->buffer << "+= " << unroll_factor;
+    else
+      output_buffer->buffer << "++";
+    output_buffer->buffer << ")";
+  }
 
   output_buffer->buffer << "{";
   output_buffer->newline();
@@ -179,6 +227,60 @@ c_iterator* PrintC::printForHeader
 }
 
 
+///-----------------------------------------------------------------------------
+/// Check if a loop within the loops of iters up to outer_end is distributed
+/// across the threads. That is the outermost loop with more than one
+/// iteration, or an inner one for stages whose outer loops are run by every
+/// thread
+bool PrintC::is_distributed_loop
+(deque<c_iterator*>::const_iterator outer_end) const
+{
+  int num_outer = 0;
+  for( deque<c_iterator*>::const_iterator itersIter = iters.begin() ;
+       itersIter != outer_end ; itersIter++ )
+    if( !((*itersIter)->is_unit_trip_count()) )
+      num_outer++;
+  return num_outer == parallel_loop_depth;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Distribute the iterations of the next loop across the threads. With tasks,
+/// the thread that runs a stage generates a task per chunk of iterations and
+/// waits for them at the end of the loop
+void PrintC::print_omp_loop_pragma(const string& private_vars, int collapse)
+{
+  if( use_omp_tasks )
+    output_buffer->buffer << "#pragma omp taskloop";
+  else
+    output_buffer->buffer << "#pragma omp for schedule(static)";
+  if( collapse > 1 )
+    output_buffer->buffer << " collapse(" << collapse << ")";
+  output_buffer->buffer << " private(" << private_vars << ")";
+  output_buffer->newline();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Print the header of a loop whose iterations are distributed across the
+/// team by the forma runtime. A thread gets the chunks of iterations it runs
+/// from the runtime, which returns a value past the upper bound once all the
+/// threads have completed the loop
+void PrintC::print_runtime_loop_header
+(const string& iter_var, const string& lb, const string& ub, int step)
+{
+  string loop_var = iter_var + "loop__";
+  output_buffer->indent();
+  output_buffer->buffer << "forma_loop " << loop_var << ";";
+  output_buffer->newline();
+  output_buffer->indent();
+  output_buffer->buffer << "for (" << iter_var << " = forma_loop_begin(&" <<
+    loop_var << "," << lb << "," << ub << "," << step << "); " << iter_var <<
+    " <= " << ub << "; " << iter_var << " = forma_loop_next(&" << loop_var <<
+    "," << iter_var << "))";
+}
+
+
 ///-----------------------------------------------------------------------------
 /// Print the footer of the for loop
 void PrintC::printForFooter()
@@ -193,6 +295,60 @@ void PrintC::printForFooter()
 }
 
 
+///-----------------------------------------------------------------------------
+/// Print the header of a loop that steps over tiles
+string PrintC::printTileHeader
+(const parametric_exp* lb, const parametric_exp* ub, int tile_size)
+{
+  string tile_var = get_new_iterator(output_buffer);
+
+  bool addpragma = false;
+  if( generate_omp_pragmas ){
+    addpragma = is_distributed_loop(iters.end());
+    if( addpragma && !use_forma_runtime )
+      print_omp_loop_pragma(tile_var,1);
+  }
+
+  if( addpragma && use_forma_runtime ){
+    stringstream lb_stream, ub_stream;
+    PrintCParametricExpr(lb,lb_stream);
+    PrintCParametricExpr(ub,ub_stream);
+    print_runtime_loop_header
+      (tile_var,lb_stream.str(),ub_stream.str(),tile_size);
+    output_buffer->buffer << "{";
+  }
+  else{
+    output_buffer->indent();
+    output_buffer->buffer << "for (" << tile_var << " = ";
+    PrintCParametricExpr(lb,output_buffer->buffer);
+    output_buffer->buffer << "; " << tile_var << " <= ";
+    PrintCParametricExpr(ub,output_buffer->buffer);
+    output_buffer->buffer << "; " << tile_var << " += " << tile_size << "){";
+  }
+  output_buffer->newline();
+  output_buffer->increaseIndent();
+
+  return tile_var;
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::add_region_capture
+(const string& elem_type, const string& name, bool is_array, bool is_restrict,
+ bool by_reference)
+{
+  if( !use_forma_runtime )
+    return;
+  c_region_capture new_capture;
+  new_capture.elem_type = elem_type;
+  new_capture.name = name;
+  new_capture.is_array = is_array;
+  new_capture.is_restrict = is_restrict;
+  new_capture.by_reference = by_reference;
+  region_captures.push_back(new_capture);
+}
+
+
 ///-----------------------------------------------------------------------------
 void PrintC::print_pointer(int ndim, stringstream& curr_stream)
 {
@@ -206,9 +362,98 @@ c_var_info* PrintC::printMalloc
 (string lhs,data_types elem_type, const domain_node* expr_domain)
 {
   string elem_type_string = get_string(elem_type);
+  ///Buffers with a ghost zone are allocated over the domain extended by the
+  ///zone, the points of the domain are at the same index as without it
+  const domain_node* interior_domain = NULL;
+  if( curr_ghost_zone &&
+      (int)curr_ghost_zone->size() == expr_domain->get_dim() ){
+    interior_domain = expr_domain;
+    domain_node* padded_domain = new domain_node(expr_domain);
+    deque<int>::const_iterator jt = curr_ghost_zone->begin();
+    for( deque<range_coeffs>::iterator it = padded_domain->range_list.begin() ;
+         it != padded_domain->range_list.end() ; it++, jt++ ){
+      it->lb = it->lb->add(-(*jt));
+      it->ub = it->ub->add(*jt);
+    }
+    ghost_domains.push_back(padded_domain);
+    expr_domain = padded_domain;
+  }
   c_var_info* new_var = new c_var_info(lhs,expr_domain,elem_type);
+  if( interior_domain ){
+    new_var->ghost_zone = *curr_ghost_zone;
+    new_var->interior_domain = interior_domain;
+  }
+  curr_ghost_zone = NULL;
   def_vars.push_back(new_var);
+  bool is_affine_array =
+    generate_affine && expr_domain->get_dim() > 1 &&
+    expr_domain->get_dim() <= supported_affine_dim;
+  if( reuse_buffers && expr_domain->get_dim() != 0 ){
+    ///Check for a dead buffer of the same type and size
+    stringstream size_stream;
+    PrintCDomainSize(expr_domain,size_stream);
+    for( deque<c_var_info*>::iterator it = free_vars.begin() ;
+         it != free_vars.end() ; it++ ){
+      if( get_string((*it)->elem_type).compare(elem_type_string) != 0 )
+        continue;
+      stringstream free_size_stream;
+      PrintCDomainSize((*it)->expr_domain,free_size_stream);
+      if( free_size_stream.str().compare(size_stream.str()) != 0 )
+        continue;
+      host_allocate->indent();
+      host_allocate->buffer << elem_type_string << " * " << lhs << " = " <<
+        (*it)->symbol_name << ";";
+      host_allocate->newline();
+      add_region_capture(elem_type_string,lhs,true,false,false);
+      new_var->row_pitch = (*it)->row_pitch;
+      ///Threads can still be reading the dead intermediate in loops that dont
+      ///end with a barrier, wait for them before the buffer is overwritten
+      print_barrier();
+      ///The buffer holds values of the dead intermediate, clear it before it
+      ///is written to
+      if( init_zero && !( numa_first_touch && print_first_touch(new_var) ) )
+        print_clear_buffer(new_var);
+      free_vars.erase(it);
+      reusable_vars.insert(new_var);
+      return new_var;
+    }
+    reusable_vars.insert(new_var);
+  }
   if(expr_domain->get_dim() != 0 ){
+    ///With aligned buffers, rows of the innermost dimension are padded to the
+    ///pitch computed at runtime
+    string row_pitch = "";
+    if( aligned_buffers && expr_domain->get_dim() > 1 ){
+      row_pitch = lhs + "pitch__";
+      stringBuffer* pitch_buffer =
+        ( use_single_malloc ? host_allocate_size : host_allocate );
+      pitch_buffer->indent();
+      pitch_buffer->buffer << "int " << row_pitch << " = forma_row_pitch(";
+      const range_coeffs& inner_range = expr_domain->range_list.back();
+      parametric_exp* inner_size = parametric_exp::copy(inner_range.ub);
+      inner_size = inner_size->subtract(inner_range.lb);
+      inner_size = inner_size->add(1);
+      PrintCParametricExpr(inner_size,pitch_buffer->buffer);
+      delete inner_size;
+      pitch_buffer->buffer << ",sizeof(" << elem_type_string << ")," <<
+        buffer_alignment << ");";
+      pitch_buffer->newline();
+      add_region_capture("int",row_pitch,false,false,false);
+      if( !is_affine_array )
+        new_var->row_pitch = row_pitch;
+    }
+    stringstream size_stream;
+    if( row_pitch.compare("") != 0 ){
+      c_var_info pitched_var(lhs,expr_domain,elem_type);
+      pitched_var.row_pitch = row_pitch;
+      print_buffer_size(&pitched_var,size_stream);
+    }
+    else
+      PrintCDomainSize(expr_domain,size_stream);
+    int offset_alignment = ( aligned_buffers ? buffer_alignment : 16 );
+    if( !is_affine_array )
+      add_region_capture(elem_type_string,lhs,true,false,false);
+
     if( use_single_malloc ){
       static int malloc_num = 0;
       stringstream malloc_size_var;
@@ -216,14 +461,13 @@ c_var_info* PrintC::printMalloc
 
       host_allocate_size->indent();
       host_allocate_size->buffer << "int " << malloc_size_var.str() <<
-        " = sizeof(" << elem_type_string << ")*";
-      PrintCDomainSize(expr_domain,host_allocate_size->buffer);
-      host_allocate_size->buffer << ";";
+        " = sizeof(" << elem_type_string << ")*" << size_stream.str() << ";";
       host_allocate_size->newline();
 
       host_allocate_size->indent();
       host_allocate_size->buffer << malloc_size_var.str() <<
-        " = FORMA_CEIL(" << malloc_size_var.str() << ",16)*16;";
+        " = FORMA_CEIL(" << malloc_size_var.str() << "," << offset_alignment <<
+        ")*" << offset_alignment << ";";
       host_allocate_size->newline();
 
       host_allocate_size->indent();
@@ -241,14 +485,13 @@ c_var_info* PrintC::printMalloc
       malloc_offset_var << "__malloc_" << malloc_num << "_offset__";
       host_allocate->indent();
       host_allocate->buffer << "int " << malloc_offset_var.str() <<
-        " = sizeof(" << elem_type_string << ")*";
-      PrintCDomainSize(expr_domain,host_allocate->buffer);
-      host_allocate->buffer << ";";
+        " = sizeof(" << elem_type_string << ")*" << size_stream.str() << ";";
       host_allocate->newline();
 
       host_allocate->indent();
       host_allocate->buffer << malloc_offset_var.str() <<
-        " = FORMA_CEIL(" << malloc_offset_var.str() << ",16)*16;";
+        " = FORMA_CEIL(" << malloc_offset_var.str() << "," <<
+        offset_alignment << ")*" << offset_alignment << ";";
       host_allocate->newline();
 
       host_allocate->indent();
@@ -257,10 +500,27 @@ c_var_info* PrintC::printMalloc
       host_allocate->newline();
 
       malloc_num++;
+
+      if( interleave_curr_stmt ){
+        host_allocate->indent();
+        host_allocate->buffer << "forma_numa_interleave(" << lhs <<
+          ",sizeof(" << elem_type_string << ")*" << size_stream.str() << ");";
+        host_allocate->newline();
+      }
+      ///The global buffer is not cleared when it is first touched per buffer
+      if( init_zero && numa_first_touch && !print_first_touch(new_var) ){
+        host_allocate->indent();
+        host_allocate->buffer << "memset(" << lhs << ",0,sizeof(" <<
+          elem_type_string << ")*" << size_stream.str() << ");";
+        host_allocate->newline();
+      }
+      ///With the plan API, the workspace is only cleared when it is created,
+      ///buffers that can be reused hold values of the previous run
+      else if( init_zero && !numa_first_touch && plan_api && reuse_buffers )
+        print_clear_buffer(new_var);
     }
     else{
-      if( generate_affine && expr_domain->get_dim() > 1 &&
-          expr_domain->get_dim() <= supported_affine_dim  ){
+      if( is_affine_array ){
         host_allocate->indent();
         host_allocate->buffer << elem_type_string << " ";
         print_pointer(expr_domain->get_dim(),host_allocate->buffer);
@@ -268,8 +528,11 @@ c_var_info* PrintC::printMalloc
 
         host_allocate->buffer << "(" << elem_type_string ;
         print_pointer(expr_domain->get_dim(),host_allocate->buffer);
-        host_allocate->buffer << ")malloc_" << expr_domain->get_dim() <<
-          "d_" <<  get_forma_string(elem_type) << "_array(";
+        if( aligned_buffers )
+          host_allocate->buffer << ")forma_malloc_2d_pitched_array(";
+        else
+          host_allocate->buffer << ")malloc_" << expr_domain->get_dim() <<
+            "d_" <<  get_forma_string(elem_type) << "_array(";
         const deque<range_coeffs>& domain_size = expr_domain->get_domain();
         for( deque<range_coeffs>::const_iterator it = domain_size.begin() ;
              it != domain_size.end() ; it++ ){
@@ -281,9 +544,28 @@ c_var_info* PrintC::printMalloc
             host_allocate->buffer << "," ;
           delete curr_size;
         }
+        if( aligned_buffers )
+          host_allocate->buffer << ",sizeof(" << elem_type_string << ")," <<
+            buffer_alignment;
         host_allocate->buffer << ");" ;
         host_allocate->newline();
       }
+      else if( aligned_buffers ){
+        host_allocate->indent();
+        host_allocate->buffer << elem_type_string << " * " << lhs << " = " ;
+        host_allocate->buffer << "(" << elem_type_string << "*)";
+#ifndef _WINDOWS_
+        host_allocate->buffer << "__builtin_assume_aligned(";
+#endif
+        host_allocate->buffer << "forma_aligned_malloc(sizeof(" <<
+          elem_type_string << ")*" << size_stream.str() << "," <<
+          buffer_alignment << ")";
+#ifndef _WINDOWS_
+        host_allocate->buffer << "," << buffer_alignment << ")";
+#endif
+        host_allocate->buffer << ";" ;
+        host_allocate->newline();
+      }
       else{
         host_allocate->indent();
         host_allocate->buffer << elem_type_string << " * " << lhs << " = " ;
@@ -293,12 +575,20 @@ c_var_info* PrintC::printMalloc
         host_allocate->buffer << ");" ;
         host_allocate->newline();
       }
-      if( init_zero ){
+      if( interleave_curr_stmt && !is_affine_array ){
         host_allocate->indent();
-        host_allocate->buffer << "memset(" << lhs << ",0,sizeof("
+        host_allocate->buffer << "forma_numa_interleave(" << lhs <<
+          ",sizeof(" << elem_type_string << ")*" << size_stream.str() << ");";
+        host_allocate->newline();
+      }
+      ///With first touch placement, the buffer is cleared by the threads that
+      ///compute it
+      if( init_zero && !( numa_first_touch && print_first_touch(new_var) ) ){
+        host_allocate->indent();
+        host_allocate->buffer << "memset(" << lhs <<
+          ( is_affine_array && aligned_buffers ? "[0]" : "" ) << ",0,sizeof("
                               << elem_type_string << ")*" ;
-        PrintCDomainSize(expr_domain,host_allocate->buffer);
-        host_allocate->buffer << ");";
+        host_allocate->buffer << size_stream.str() << ");";
         host_allocate->newline();
       }
     }
@@ -307,15 +597,20 @@ c_var_info* PrintC::printMalloc
     host_allocate->indent();
     host_allocate->buffer << elem_type_string << " " << lhs << ";" ;
     host_allocate->newline();
+    add_region_capture(elem_type_string,lhs,false,false,true);
   }
 
   deallocate_buffer->indent();
   if( expr_domain->get_dim() != 0 ){
     if( !use_single_malloc ){
-      if( generate_affine && expr_domain->get_dim() > 1 &&
-          expr_domain->get_dim() <= supported_affine_dim )
+      if( is_affine_array && aligned_buffers )
+        deallocate_buffer->buffer << "forma_free_2d_pitched_array((void**)" <<
+          lhs << ");";
+      else if( is_affine_array )
         deallocate_buffer->buffer << "free_" << expr_domain->get_dim() <<
           "d_" << get_forma_string(elem_type) << "_array("  << lhs << ");";
+      else if( aligned_buffers )
+        deallocate_buffer->buffer << "forma_aligned_free(" << lhs << ");";
       else
         deallocate_buffer->buffer << "free(" << lhs << ");";
     }
@@ -324,6 +619,223 @@ c_var_info* PrintC::printMalloc
   }
 }
 
+
+///-----------------------------------------------------------------------------
+/// Clear a buffer in the parallel region, before the statement it is
+/// allocated for is computed
+void PrintC::print_clear_buffer(const c_var_info* curr_var)
+{
+  if( use_forma_runtime ){
+    output_buffer->indent();
+    output_buffer->buffer << "if( forma_thread_num() == 0 )";
+    output_buffer->newline();
+    output_buffer->increaseIndent();
+  }
+  else if( generate_omp_pragmas && !use_omp_tasks ){
+    output_buffer->buffer << "#pragma omp single";
+    output_buffer->newline();
+  }
+  output_buffer->indent();
+  output_buffer->buffer << "memset(" << curr_var->symbol_name <<
+    ",0,sizeof(" << get_string(curr_var->elem_type) << ")*";
+  print_buffer_size(curr_var,output_buffer->buffer);
+  output_buffer->buffer << ");";
+  output_buffer->newline();
+  if( use_forma_runtime ){
+    output_buffer->decreaseIndent();
+    output_buffer->indent();
+    output_buffer->buffer << "forma_barrier();";
+    output_buffer->newline();
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Order the non-temporal stores of the thread before its later stores
+void PrintC::print_stream_fence()
+{
+  output_buffer->indent();
+  output_buffer->buffer << "_mm_sfence();";
+  output_buffer->newline();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Synchronize the threads of the parallel region. With tasks, the stages are
+/// run by a single thread that waits for the tasks of every stage
+void PrintC::print_barrier()
+{
+  if( use_forma_runtime ){
+    output_buffer->indent();
+    output_buffer->buffer << "forma_barrier();";
+    output_buffer->newline();
+  }
+  else if( generate_omp_pragmas && !use_omp_tasks ){
+    output_buffer->buffer << "#pragma omp barrier";
+    output_buffer->newline();
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_buffer_size
+(const c_var_info* curr_var, stringstream& curr_stream)
+{
+  if( curr_var->row_pitch.compare("") == 0 ){
+    PrintCDomainSize(curr_var->expr_domain,curr_stream);
+    return;
+  }
+  ///Rows of the innermost dimension are row_pitch elements apart
+  const deque<range_coeffs>& range_list = curr_var->expr_domain->range_list;
+  curr_stream << "(" << curr_var->row_pitch;
+  for( deque<range_coeffs>::const_iterator it = range_list.begin() ;
+       it != range_list.end() - 1 ; it++ ){
+    curr_stream << "*" ;
+    parametric_exp* curr_size = parametric_exp::copy(it->ub);
+    curr_size = curr_size->subtract(it->lb);
+    curr_size = curr_size->add(1);
+    PrintCParametricExpr(curr_size,curr_stream);
+    delete curr_size;
+  }
+  curr_stream << ")";
+}
+
+///-----------------------------------------------------------------------------
+void PrintC::print_row_pitch
+(const c_var_info* curr_var, stringstream& curr_stream)
+{
+  if( curr_var->row_pitch.compare("") != 0 ){
+    curr_stream << curr_var->row_pitch;
+    return;
+  }
+  ///Rows of dense buffers are the size of the innermost dimension apart
+  const range_coeffs& inner_range = curr_var->expr_domain->range_list.back();
+  parametric_exp* inner_size = parametric_exp::copy(inner_range.ub);
+  inner_size = inner_size->subtract(inner_range.lb);
+  inner_size = inner_size->add(1);
+  PrintCParametricExpr(inner_size,curr_stream);
+  delete inner_size;
+}
+
+///-----------------------------------------------------------------------------
+/// Zero a buffer a row of the outermost dimension at a time, with the static
+/// partition of the loops that compute it. The pages of a row are allocated on
+/// the NUMA node of the thread that computes it
+bool PrintC::print_first_touch(const c_var_info* curr_var)
+{
+  if( !generate_omp_pragmas )
+    return false;
+  for( deque<c_iterator*>::const_iterator it = iters.begin() ;
+       it != iters.end() ; it++ )
+    if( !(*it)->is_unit_trip_count() )
+      return false;
+
+  const deque<range_coeffs>& range_list = curr_var->expr_domain->range_list;
+  stringstream row_size;
+  string separator = "";
+  row_size << "(";
+  for( deque<range_coeffs>::const_iterator it = range_list.begin() + 1 ;
+       it != range_list.end() ; it++ ){
+    row_size << separator;
+    if( it == range_list.end() - 1 && curr_var->row_pitch.compare("") != 0 )
+      row_size << curr_var->row_pitch;
+    else{
+      parametric_exp* curr_size = parametric_exp::copy(it->ub);
+      curr_size = curr_size->subtract(it->lb);
+      curr_size = curr_size->add(1);
+      PrintCParametricExpr(curr_size,row_size);
+      delete curr_size;
+    }
+    separator = "*";
+  }
+  if( separator.empty() )
+    row_size << "1";
+  row_size << ")";
+
+  const range_coeffs& outer_range = range_list.front();
+  string iter_var = get_new_iterator(output_buffer);
+  if( use_forma_runtime ){
+    stringstream lb_stream, ub_stream;
+    PrintCParametricExpr(outer_range.lb,lb_stream);
+    PrintCParametricExpr(outer_range.ub,ub_stream);
+    print_runtime_loop_header(iter_var,lb_stream.str(),ub_stream.str(),1);
+  }
+  else{
+    output_buffer->buffer << "#pragma omp for schedule(static) private(" <<
+      iter_var << ")" ;
+    output_buffer->newline();
+    output_buffer->indent();
+    output_buffer->buffer << "for (" << iter_var << " = ";
+    PrintCParametricExpr(outer_range.lb,output_buffer->buffer);
+    output_buffer->buffer << "; " << iter_var << " <= ";
+    PrintCParametricExpr(outer_range.ub,output_buffer->buffer);
+    output_buffer->buffer << "; " << iter_var << "++)";
+  }
+  output_buffer->newline();
+  output_buffer->increaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << "memset(&" << curr_var->symbol_name <<
+    "[(size_t)(" << iter_var << "-(";
+  PrintCParametricExpr(outer_range.lb,output_buffer->buffer);
+  output_buffer->buffer << "))*" << row_size.str() << "],0,sizeof(" <<
+    get_string(curr_var->elem_type) << ")*" << row_size.str() << ");";
+  output_buffer->newline();
+  output_buffer->decreaseIndent();
+  return true;
+}
+
+
+///-----------------------------------------------------------------------------
+c_var_info* PrintC::printSoAMalloc
+(string lhs, data_types elem_type, const domain_node* expr_domain)
+{
+  c_var_info* new_var = new c_var_info(lhs,expr_domain,elem_type);
+  def_vars.push_back(new_var);
+  const deque<defined_fields>& fields = elem_type.struct_info->fields;
+  for( deque<defined_fields>::const_iterator it = fields.begin() ;
+       it != fields.end() ; it++ ){
+    data_types field_type;
+    field_type.assign(it->field_type);
+    new_var->field_vars.push_back
+      (printMalloc(lhs + "_" + it->field_name,field_type,expr_domain));
+  }
+  return new_var;
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::add_field_vars(c_var_info* curr_var)
+{
+  const deque<defined_fields>& fields = curr_var->elem_type.struct_info->fields;
+  for( deque<defined_fields>::const_iterator it = fields.begin() ;
+       it != fields.end() ; it++ ){
+    data_types field_type;
+    field_type.assign(it->field_type);
+    c_var_info* field_var =
+      new c_var_info
+      (curr_var->symbol_name + "_" + it->field_name,curr_var->expr_domain,
+       field_type);
+    def_vars.push_back(field_var);
+    curr_var->field_vars.push_back(field_var);
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+const c_var_info* PrintC::get_field_var
+(const c_var_info* curr_var, const string& field_name) const
+{
+  if( curr_var->field_vars.empty() || field_name.compare("") == 0 )
+    return curr_var;
+  const deque<defined_fields>& fields = curr_var->elem_type.struct_info->fields;
+  for( int i = 0 ; i < (int)fields.size() ; i++ )
+    if( fields[i].field_name.compare(field_name) == 0 )
+      return curr_var->field_vars[i];
+  assert(0 && "Accessing an unknown field of a struct vector");
+  return curr_var;
+}
+
+
 ///-----------------------------------------------------------------------------
 c_symbol_info* PrintC::FindDefnSymbol
 (const vector_expr_node* curr_expr, c_symbol_table& fn_bindings) const
@@ -395,10 +907,57 @@ int PrintC::print_domain_loops_header
 
 
 ///-----------------------------------------------------------------------------
+/// Remap an index that is outside the bounds as specified by the boundary
+/// condition. When only one of the bounds is checked, the index is remapped
+/// with a single expression without branches
 void PrintC::check_index_value
 (string& curr_index, string& is_bdy_var, parametric_exp* curr_lb,
- parametric_exp* curr_ub, const bdy_info* curr_bdy)
+ parametric_exp* curr_ub, const bdy_info* curr_bdy, bool check_lb,
+ bool check_ub)
 {
+  if( !check_lb || !check_ub ){
+    assert(check_lb || check_ub);
+    stringstream bound_stream, size_stream;
+    PrintCParametricExpr(check_lb ? curr_lb : curr_ub,bound_stream);
+    size_stream << "(";
+    PrintCParametricExpr(curr_ub,size_stream);
+    size_stream << " - ";
+    PrintCParametricExpr(curr_lb,size_stream);
+    size_stream << " + 1)";
+    const string& bound = bound_stream.str();
+    const char* bound_fn = ( check_lb ? "FORMA_MAX(" : "FORMA_MIN(" );
+    stringstream fix_stream;
+    switch(curr_bdy->type){
+    case B_CONSTANT:
+      fix_stream << is_bdy_var << " |= ( " << curr_index <<
+        ( check_lb ? " < " : " > " ) << bound << " );";
+      break;
+    case B_WRAP:
+      fix_stream << curr_index << " = ( " << curr_index <<
+        ( check_lb ? " < " : " > " ) << bound << " ? " << curr_index <<
+        ( check_lb ? " + " : " - " ) << size_stream.str() << " : " <<
+        curr_index << " );";
+      break;
+    case B_EXTEND:
+    case B_CLAMPED:
+      fix_stream << curr_index << " = " << bound_fn << curr_index << "," <<
+        bound << ");";
+      break;
+    case B_MIRROR:
+      ///Points within the bounds are closer to it than their reflection
+      fix_stream << curr_index << " = " << bound_fn << curr_index << ",2*(" <<
+        bound << ") - " << curr_index << ");";
+      break;
+    case B_NONE:
+    default:
+      return;
+    }
+    output_buffer->indent();
+    output_buffer->buffer << fix_stream.str();
+    output_buffer->newline();
+    return;
+  }
+
   stringstream lb_fix, ub_fix;
 
   switch(curr_bdy->type){
@@ -491,13 +1050,43 @@ void PrintC::print_array_access
       curr_stream << "[" << (*it) << "]";
   }
   else{
-    deque<string>::const_reverse_iterator it = access_exp.rbegin() ;
+    ///Buffers that hold a window of the outermost dimension are indexed
+    ///relative to the start of the window, buffers with a ghost zone relative
+    ///to the start of the zone
+    deque<string> window_access_exp;
+    if( curr_var->window_offset.compare("") != 0 ){
+      window_access_exp = access_exp;
+      window_access_exp.front() =
+        "(" + access_exp.front() + ")-(" + curr_var->window_offset + ")";
+    }
+    else if( !curr_var->ghost_zone.empty() ){
+      window_access_exp = access_exp;
+      for( int i = 0 ; i < (int)access_exp.size() ; i++ ){
+        if( curr_var->ghost_zone[i] == 0 )
+          continue;
+        stringstream ghost_stream;
+        ghost_stream << "(" << access_exp[i] << ")+" <<
+          curr_var->ghost_zone[i];
+        window_access_exp[i] = ghost_stream.str();
+      }
+    }
+    const deque<string>& curr_access_exp =
+      ( curr_var->window_offset.compare("") != 0 ||
+        !curr_var->ghost_zone.empty() ? window_access_exp : access_exp );
+    deque<string>::const_reverse_iterator it = curr_access_exp.rbegin() ;
     curr_stream << "[" << (*it);
     it++;
     for( deque<range_coeffs>::const_reverse_iterator jt =
            curr_var->expr_domain->range_list.rbegin() ;
-         it != access_exp.rend() ; it++,jt++ ){
+         it != curr_access_exp.rend() ; it++,jt++ ){
       curr_stream << "+" ;
+      ///Rows of the innermost dimension of padded buffers are row_pitch
+      ///elements apart
+      if( jt == curr_var->expr_domain->range_list.rbegin() &&
+          curr_var->row_pitch.compare("") != 0 ){
+        curr_stream << curr_var->row_pitch << "*" << "(" << (*it) ;
+        continue;
+      }
       parametric_exp* curr_size = parametric_exp::copy(jt->ub);
       curr_size = curr_size->subtract(jt->lb);
       curr_size = curr_size->add(1);
@@ -601,8 +1190,12 @@ void PrintC::print_stencil_point
       is_bdy_var = "";
     }
 
+    ///The boundary of buffers with a ghost zone is that of the domain
+    const domain_node* bounds_domain =
+      ( curr_var->interior_domain ? curr_var->interior_domain :
+        curr_var->expr_domain );
     deque<range_coeffs>::const_iterator jt =
-      curr_var->expr_domain->range_list.begin();
+      bounds_domain->range_list.begin();
     for(deque<scale_coeffs>::const_iterator it = scale_domain->scale_fn.begin();
          it != scale_domain->scale_fn.end() ; it++,dim++,jt++ ){
       stringstream curr_index_stream;
@@ -612,8 +1205,11 @@ void PrintC::print_stencil_point
       if( it->offset != 0 )
         curr_index_stream << "+(" << it->offset << ")";
 
+      ///Edges of a specialized patch only check the bound of their side
+      bool check_lb = ( !one_sided_checks || patch_sides[dim] < 0 );
+      bool check_ub = ( !one_sided_checks || patch_sides[dim] > 0 );
       string curr_index;
-      if( curr_bdy_condn ){
+      if( curr_bdy_condn && ( check_lb || check_ub ) ){
         assert(curr_bdy_condn &&
                "Checking Boundary conditions when bdy condn is not specified");
         curr_index  = get_new_temp_var(int_type,output_buffer);
@@ -621,7 +1217,9 @@ void PrintC::print_stencil_point
         output_buffer->buffer << curr_index << " = "
                              << curr_index_stream.str() << ";";
         output_buffer->newline();
-        check_index_value(curr_index,is_bdy_var,jt->lb,jt->ub,curr_bdy_condn);
+        check_index_value
+          (curr_index,is_bdy_var,jt->lb,jt->ub,curr_bdy_condn,check_lb,
+           check_ub);
       }
       else{
         curr_index = curr_index_stream.str();
@@ -676,7 +1274,8 @@ void PrintC::print_stencil_point
     deque<range_coeffs>::const_iterator BoundsIter;
     BoundsIter = sub_domain->range_list.begin();
     deque<range_coeffs>::const_iterator SizeIter =
-      curr_var->expr_domain->range_list.begin();
+      ( curr_var->interior_domain ? curr_var->interior_domain :
+        curr_var->expr_domain )->range_list.begin();
 
     for( ; ScaleFactorIter != scale_domain->scale_fn.end() ;
          ScaleFactorIter++, OffsetIter++, SizeIter++,dim++ ){
@@ -688,8 +1287,10 @@ void PrintC::print_stencil_point
       if( ScaleFactorIter->offset != 0 )
         curr_index_stream << "+(" << ScaleFactorIter->offset <<")";
 
+      bool check_lb = ( !one_sided_checks || patch_sides[dim] < 0 );
+      bool check_ub = ( !one_sided_checks || patch_sides[dim] > 0 );
       string curr_index;
-      if( curr_bdy_condn ){
+      if( curr_bdy_condn && ( check_lb || check_ub ) ){
         parametric_exp* curr_lb =
           ( BoundsIter->lb && BoundsIter->lb->is_default() ?
             SizeIter->lb : BoundsIter->lb);
@@ -702,7 +1303,9 @@ void PrintC::print_stencil_point
         output_buffer->buffer << curr_index << " = "
                              << curr_index_stream.str() << ";";
         output_buffer->newline();
-        check_index_value(curr_index,is_bdy_var,curr_lb,curr_ub,curr_bdy_condn);
+        check_index_value
+          (curr_index,is_bdy_var,curr_lb,curr_ub,curr_bdy_condn,check_lb,
+           check_ub);
       }
       else{
         curr_index = curr_index_stream.str();
@@ -861,6 +1464,52 @@ void PrintC::print_extrapolate_point
 }
 
 
+///-----------------------------------------------------------------------------
+void PrintC::print_vector_point
+(const c_var_info* curr_var, const string& field_name,
+ const domainfn_node* scale_domain, const domain_node* sub_domain,
+ stringstream& curr_stream, const bdy_info* curr_bdy_condn)
+{
+  ///Struct vectors stored per field are read from the buffer of the field, or
+  ///gathered into a struct when read as a whole
+  bool gather_fields =
+    !curr_var->field_vars.empty() && field_name.compare("") == 0;
+  deque<const c_var_info*> point_vars;
+  if( gather_fields ){
+    point_vars.insert
+      (point_vars.end(),curr_var->field_vars.begin(),
+       curr_var->field_vars.end());
+    curr_stream << "((" << get_string(curr_var->elem_type) << "){";
+  }
+  else
+    point_vars.push_back(get_field_var(curr_var,field_name));
+
+  for( deque<const c_var_info*>::iterator it = point_vars.begin() ;
+       it != point_vars.end() ; it++ ){
+    if( it != point_vars.begin() )
+      curr_stream << ",";
+    if( scale_domain ){
+      if( sub_domain )
+        print_stencil_point
+          (*it,scale_domain,sub_domain,curr_stream,curr_bdy_condn);
+      else
+        print_stencil_point(*it,scale_domain,curr_stream,curr_bdy_condn);
+    }
+    else{
+      if( sub_domain )
+        print_domain_point(*it,curr_stream,sub_domain);
+      else
+        print_domain_point(*it,curr_stream);
+    }
+  }
+
+  if( gather_fields )
+    curr_stream << "})";
+  else if( curr_var->field_vars.empty() && field_name.compare("") != 0 )
+    curr_stream << "." << field_name;
+}
+
+
 ///-----------------------------------------------------------------------------
 void PrintC::print_assignment_stmt
 (const c_symbol_info* curr_symbol, std::string& rhs_expr,
@@ -868,6 +1517,26 @@ void PrintC::print_assignment_stmt
 {
   const c_var_info* curr_var = curr_symbol->var;
   assert(curr_var->expr_domain);
+  ///Whole structs are written to struct vectors stored per field one field at
+  ///a time
+  if( !curr_var->field_vars.empty() &&
+      curr_symbol->field_name.compare("") == 0 ){
+    const deque<defined_fields>& fields =
+      curr_var->elem_type.struct_info->fields;
+    for( deque<defined_fields>::const_iterator it = fields.begin() ;
+         it != fields.end() ; it++ ){
+      c_symbol_info field_symbol
+        (curr_symbol->var,curr_symbol->scale_domain,
+         curr_symbol->offset_domain,it->field_name);
+      string field_expr = "(" + rhs_expr + ")." + it->field_name;
+      if( it != fields.begin() )
+        curr_stream << " ";
+      print_assignment_stmt(&field_symbol,field_expr,curr_stream);
+    }
+    return;
+  }
+  if( curr_symbol->field_name.compare("") != 0 )
+    curr_var = get_field_var(curr_var,curr_symbol->field_name);
   if( curr_var->expr_domain->get_dim() != 0 ){
     if( curr_symbol->offset_domain ){
       print_domain_point(curr_var,curr_stream,curr_symbol->offset_domain);
@@ -889,7 +1558,7 @@ void PrintC::print_assignment_stmt
   else{
     curr_stream << "*(" << curr_var->symbol_name << ")";
   }
-  if( curr_symbol->field_name.compare("") != 0 )
+  if( curr_symbol->field_name.compare("") != 0 && curr_var == curr_symbol->var )
     curr_stream << "." << curr_symbol->field_name ;
 
   curr_stream << " = " << rhs_expr << ";";
@@ -919,7 +1588,10 @@ void PrintC::init_rhs
       field_name.compare("") != 0 ){
     string rhs_var = get_new_var();
     c_var_info* new_var =
-      printMalloc(rhs_var,curr_expr->get_data_type(),expr_domain);
+      ( soa_structs && curr_expr->get_data_type().type == T_STRUCT &&
+        expr_domain->get_dim() != 0 ?
+        printSoAMalloc(rhs_var,curr_expr->get_data_type(),expr_domain) :
+        printMalloc(rhs_var,curr_expr->get_data_type(),expr_domain) );
     domain_node* sub_domain = NULL;
     if( offset_domain )
       sub_domain = new domain_node(offset_domain);
@@ -956,58 +1628,28 @@ void PrintC::print_rhs_var
         if( sub_domain ){
           curr_sub_domain->compute_intersection(sub_domain);
         }
-        if( scale_domain ){
-          print_stencil_point
-            (defn_symbol->var,scale_domain,curr_sub_domain,curr_stream,NULL);
-        }
-        else{
-          print_domain_point(defn_symbol->var,curr_stream,curr_sub_domain);
-        }
+        print_vector_point
+          (defn_symbol->var,"",scale_domain,curr_sub_domain,curr_stream);
         delete curr_sub_domain;
         return ;
       }
       else{
-        if( scale_domain ){
-          if( sub_domain ){
-            print_stencil_point
-              (defn_symbol->var,scale_domain,sub_domain,curr_stream,NULL);
-          }
-          else{
-            print_stencil_point(defn_symbol->var,scale_domain,curr_stream,NULL);
-          }
-        }
-        else{
-          if( sub_domain )
-            print_domain_point(defn_symbol->var,curr_stream,sub_domain);
-          else
-            print_domain_point(defn_symbol->var,curr_stream);
-        }
+        print_vector_point
+          (defn_symbol->var,"",scale_domain,sub_domain,curr_stream);
       }
     }
   }
   else{
     const c_symbol_info* curr_symbol = fn_bindings.GetSymbolInfo(curr_expr);
-    if( scale_domain ){
-      if( sub_domain ){
-        print_stencil_point
-          (curr_symbol->var,scale_domain,sub_domain,curr_stream,NULL);
-      }
-      else{
-        print_stencil_point(curr_symbol->var,scale_domain,curr_stream,NULL);
-      }
-    }
-    else{
-      if( sub_domain )
-        print_domain_point(curr_symbol->var,curr_stream,sub_domain);
-      else
-        print_domain_point(curr_symbol->var,curr_stream);
-    }
+    string field_name = "";
     if( curr_expr->get_base_type().type == T_STRUCT &&
         curr_expr->get_access_field() != -1 ){
-      curr_stream << "." <<
+      field_name =
         curr_expr->get_base_type().
         struct_info->fields[curr_expr->get_access_field()].field_name;
     }
+    print_vector_point
+      (curr_symbol->var,field_name,scale_domain,sub_domain,curr_stream);
     fn_bindings.RemoveSymbol(curr_expr);
   }
 }
@@ -1034,7 +1676,10 @@ string PrintC::print_mathfn_expr
   else{
     string lhs_var=get_new_temp_var(curr_mathfn->get_data_type(),output_buffer);
     output_buffer->indent();
-    output_buffer->buffer << lhs_var << " = " << curr_stream.str() << ";";
+    output_buffer->buffer << lhs_var << " = " <<
+      print_int_conversion
+      (curr_mathfn,curr_stream.str(),curr_mathfn->get_data_type().type,true) <<
+      ";";
     output_buffer->newline();
     return lhs_var;
   }
@@ -1067,7 +1712,10 @@ string PrintC::print_ternary_exp
     output_buffer->increaseIndent();
     curr_stream.str("");
     curr_stream << output_var << " = " <<
-      print_expr(curr_expr->get_true_expr(),fn_bindings,handle_bdys) << ";" ;
+      print_int_conversion
+      (curr_expr->get_true_expr(),
+       print_expr(curr_expr->get_true_expr(),fn_bindings,handle_bdys),
+       curr_expr->get_data_type().type,false) << ";" ;
     output_buffer->indent();
     output_buffer->buffer << curr_stream.str();
     output_buffer->newline();
@@ -1082,7 +1730,10 @@ string PrintC::print_ternary_exp
     output_buffer->increaseIndent();
     curr_stream.str("");
     curr_stream << output_var << " = " <<
-      print_expr(curr_expr->get_false_expr(),fn_bindings,handle_bdys) << ";" ;
+      print_int_conversion
+      (curr_expr->get_false_expr(),
+       print_expr(curr_expr->get_false_expr(),fn_bindings,handle_bdys),
+       curr_expr->get_data_type().type,false) << ";" ;
     output_buffer->indent();
     output_buffer->buffer << curr_stream.str();
     output_buffer->newline();
@@ -1112,13 +1763,40 @@ string PrintC::print_expr_op
   else{
     string lhs_var = get_new_temp_var(curr_expr->get_data_type(),output_buffer);
     output_buffer->indent();
-    output_buffer->buffer << lhs_var << " = " << curr_stream.str() << ";" ;
+    output_buffer->buffer << lhs_var << " = " <<
+      print_int_conversion
+      (curr_expr,curr_stream.str(),curr_expr->get_data_type().type,true) <<
+      ";" ;
     output_buffer->newline();
     return lhs_var;
   }
 }
 
 
+///-----------------------------------------------------------------------------
+string PrintC::print_int_conversion
+(const expr_node* curr_expr, const string& value, basic_data_types to_type,
+ bool is_raw)
+{
+  if( !value_ranges.is_saturating() ||
+      ( to_type != T_INT8 && to_type != T_INT16 ) )
+    return value;
+  ///Affine code has no temporaries, values are not converted by the
+  ///expressions and the ranges computed do not apply
+  value_range curr_range;
+  bool is_known = !generate_affine &&
+    ( is_raw ? value_ranges.get_raw_range(curr_expr,curr_range) :
+      value_ranges.get_range(curr_expr,curr_range) );
+  value_range type_range = value_range::of_type(to_type);
+  if( is_known && type_range.contains(curr_range) )
+    return value;
+  stringstream curr_stream;
+  curr_stream << "FORMA_MIN(FORMA_MAX(" << value << "," << type_range.lb <<
+    ")," << type_range.ub << ")";
+  return curr_stream.str();
+}
+
+
 ///-----------------------------------------------------------------------------
 /// Helper function to print stencil operations
 string PrintC::print_stencil_op_helper
@@ -1126,27 +1804,26 @@ string PrintC::print_stencil_op_helper
  const data_types& base_data_type, int field_num, bool handle_bdys)
 {
   stringstream curr_stream;
-  if ( curr_symbol->var->expr_domain == NULL ||
-       curr_symbol->var->expr_domain->get_dim() == 0 )
-    curr_stream << curr_symbol->var->symbol_name;
-  else if( curr_symbol->offset_domain )
-    print_stencil_point
-      (curr_symbol->var,scale_fn,curr_symbol->offset_domain,curr_stream,
-       ( handle_bdys ? curr_symbol->bdy_condn : NULL ) );
-  else
-    print_stencil_point
-      (curr_symbol->var,scale_fn,curr_stream,
-       ( handle_bdys ? curr_symbol->bdy_condn : NULL ) );
-
+  string field_name = "";
   if( base_data_type.type == T_STRUCT ){
     if( field_num != -1 ){
       assert
         (base_data_type.struct_info != NULL &&
          field_num < (int)(base_data_type.struct_info->fields.size())  );
-      curr_stream << "." <<
-        base_data_type.struct_info->fields[field_num].field_name;
+      field_name = base_data_type.struct_info->fields[field_num].field_name;
     }
   }
+
+  if ( curr_symbol->var->expr_domain == NULL ||
+       curr_symbol->var->expr_domain->get_dim() == 0 ){
+    curr_stream << curr_symbol->var->symbol_name;
+    if( field_name.compare("") != 0 )
+      curr_stream << "." << field_name;
+  }
+  else
+    print_vector_point
+      (curr_symbol->var,field_name,scale_fn,curr_symbol->offset_domain,
+       curr_stream,( handle_bdys ? curr_symbol->bdy_condn : NULL ) );
   return curr_stream.str();
 }
 
@@ -1159,10 +1836,17 @@ string PrintC::print_stencil_op
   const vector_expr_node* curr_var = curr_expr->get_var();
 
   const c_symbol_info* curr_var_symbol = fn_bindings.GetSymbolInfo(curr_var);
-  return
+  string curr_access =
     print_stencil_op_helper
     (curr_var_symbol,curr_expr->get_scale_fn(),curr_expr->get_base_type(),
      curr_expr->get_access_field(),handle_bdys);
+  if( !window_registers.empty() ){
+    map<string,string>::const_iterator curr_register =
+      window_registers.find(curr_access);
+    if( curr_register != window_registers.end() )
+      return curr_register->second;
+  }
+  return curr_access;
 }
 
 
@@ -1173,18 +1857,36 @@ string PrintC::print_value_expr(const expr_node* curr_expr)
   switch (curr_expr->get_data_type().type) {
   case T_DOUBLE: {
     double val = static_cast<const value_node<double>*>(curr_expr)->get_value();
+    ///Use more digits if the fixed notation does not represent the
+    ///value exactly, e.g. for constants computed by the compiler
+    stringstream val_stream;
+    val_stream.setf(ios::fixed);
+    val_stream << val;
+    if( strtod(val_stream.str().c_str(),NULL) != val ){
+      val_stream.str("");
+      val_stream.unsetf(ios::fixed);
+      val_stream << setprecision(17) << val;
+    }
     if( val < 0.0 )
-      curr_stream << "(" << val << ")";
+      curr_stream << "(" << val_stream.str() << ")";
     else
-      curr_stream << val ;
+      curr_stream << val_stream.str() ;
   }
     break;
   case T_FLOAT: {
     float val = static_cast<const value_node<float>*>(curr_expr)->get_value();
+    stringstream val_stream;
+    val_stream.setf(ios::fixed);
+    val_stream << val;
+    if( strtof(val_stream.str().c_str(),NULL) != val ){
+      val_stream.str("");
+      val_stream.unsetf(ios::fixed);
+      val_stream << setprecision(9) << val;
+    }
     if( val < 0.0 )
-      curr_stream << "(" << val  <<"f)" ;
+      curr_stream << "(" << val_stream.str()  <<"f)" ;
     else
-      curr_stream << val << "f" ;
+      curr_stream << val_stream.str() << "f" ;
   }
     break;
   case T_INT: {
@@ -1221,7 +1923,6 @@ string PrintC::print_array_expr
   const vector_defn_node* curr_var = curr_expr->get_var();
 
   const c_symbol_info* curr_var_symbol = fn_bindings.GetSymbolInfo(curr_var);
-  curr_stream << curr_var_symbol->var->symbol_name;
 
   deque<string> curr_indices;
   const deque<expr_node*>& index_exprs = curr_expr->get_index_exprs();
@@ -1230,10 +1931,24 @@ string PrintC::print_array_expr
     string index = print_expr(*it, fn_bindings, handle_bdys);
     curr_indices.push_back(index);
   }
-  print_array_access(curr_var_symbol->var,curr_indices,curr_stream);
-  return curr_stream.str();
-}
-
+  const deque<c_var_info*>& field_vars = curr_var_symbol->var->field_vars;
+  if( field_vars.empty() ){
+    curr_stream << curr_var_symbol->var->symbol_name;
+    print_array_access(curr_var_symbol->var,curr_indices,curr_stream);
+  }
+  else{
+    curr_stream << "((" << get_string(curr_var_symbol->var->elem_type) << "){";
+    for( deque<c_var_info*>::const_iterator it = field_vars.begin() ;
+         it != field_vars.end() ; it++ ){
+      curr_stream << ( it == field_vars.begin() ? "" : "," ) <<
+        (*it)->symbol_name;
+      print_array_access(*it,curr_indices,curr_stream);
+    }
+    curr_stream << "})";
+  }
+  return curr_stream.str();
+}
+
 
 ///-----------------------------------------------------------------------------
 string PrintC::print_expr
@@ -1312,6 +2027,7 @@ void PrintC::print_stencil_fn
 (const stencilfn_defn_node* curr_stencil_fn,
  c_symbol_table& fn_bindings, deque<string>& return_vals, bool handle_bdys)
 {
+  value_ranges.analyze(curr_stencil_fn);
   const deque<pt_stmt_node*> fn_body = curr_stencil_fn->get_body();
   for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
        it != fn_body.end() ; it++ ){
@@ -1358,7 +2074,16 @@ void PrintC::init_arg_info
   domain_node* sub_domain = NULL;
   if( curr_argument->get_dim() != 0 ){
     /// Evaluate the current argument expression
+    map<const vector_expr_node*,deque<int> >::const_iterator ghost_iter =
+      ghost_halos.find(curr_argument);
+    if( ghost_iter != ghost_halos.end() )
+      curr_ghost_zone = &ghost_iter->second;
     init_rhs(curr_argument,arg_expr_domain,output_buffer->buffer,fn_bindings);
+    curr_ghost_zone = NULL;
+    if( ghost_iter != ghost_halos.end() )
+      print_ghost_zone_fill
+        (fn_bindings.GetSymbolInfo(curr_argument)->var,
+         ghost_bdys[curr_argument]);
 
     if( !fn_bindings.IsPresent(curr_argument) ){
       /// For vec_id expressions, there is no symbol, track back to the symbol
@@ -1443,10 +2168,12 @@ bool PrintC::init_fn_args
          it_end = curr_args.end() ; it_begin != it_end ; it_begin++, jt++){
     vector_expr_node* curr_argument = it_begin->arg_expr;
 
-    /// By default do what is done for untiled code
+    /// By default do what is done for untiled code. Arguments read from a
+    /// ghost zone are accessed without checks
     init_arg_info
-      (it_begin->arg_expr,it_begin->bdy_condn,*jt,fn_bindings,
-       arg_symbols,arg_domains);
+      (it_begin->arg_expr,
+       ( readsGhostZone(it_begin->arg_expr) ? NULL : it_begin->bdy_condn ),
+       *jt,fn_bindings,arg_symbols,arg_domains);
   }
   return false;
 }
@@ -1497,17 +2224,49 @@ void PrintC::print_unrolled_code_body
     int num_unroll_generated = 0;
     c_iterator* curr_iterator = iters[iters.size() - num_loop_dims + loop_dim];
     std::string orig_iterator_name = curr_iterator->name;
+
+    /// Unrolled iterations of the innermost loop are computed a vector
+    /// register at a time
+    if( simd_type != T_STRUCT && loop_dim == num_loop_dims - 1 &&
+        curr_unroll_factors[loop_dim] >= get_simd_width(simd_type) ){
+      int simd_width = get_simd_width(simd_type);
+      for( ; num_unroll_generated < curr_unroll_factors[loop_dim] ;
+           num_unroll_generated += simd_width ){
+        std::stringstream next_iterator;
+        next_iterator << "(" << orig_iterator_name << "+" <<
+          num_unroll_generated << ")";
+        curr_iterator->name = next_iterator.str();
+        print_simd_stencilfn_body(curr_fn, input_exprs, output_symbol);
+      }
+      curr_iterator->name = orig_iterator_name;
+      return;
+    }
+
+    /// Values read by more than one unrolled iteration of the innermost loop
+    /// are loaded once for the whole block
+    bool use_window =
+      use_sliding_window && !is_bdy && !output_symbol->scale_domain &&
+      loop_dim == num_loop_dims - 1 && curr_unroll_factors[loop_dim] > 1;
+    if( use_window ){
+      init_window_groups
+        (curr_fn, input_exprs, num_loop_dims, curr_unroll_factors[loop_dim]);
+      print_window_loads();
+    }
     do {
       std::stringstream next_iterator;
       next_iterator << "(" << orig_iterator_name << "+" <<
         num_unroll_generated << ")";
       curr_iterator->name = next_iterator.str();
+      if( use_window )
+        set_window_registers(num_unroll_generated);
       PrintC::print_unrolled_code_body
         (loop_dim+1, num_loop_dims, curr_unroll_factors, curr_fn, input_exprs,
          output_symbol, is_bdy);
       num_unroll_generated++;
     } while(num_unroll_generated < curr_unroll_factors[loop_dim]);
     curr_iterator->name = orig_iterator_name;
+    if( use_window )
+      clear_window_groups();
   }
   else {
     print_stencilfn_body(curr_fn, input_exprs, output_symbol, is_bdy);
@@ -1581,21 +2340,30 @@ void PrintC::print_unrolled_code
       output_buffer->buffer << "}";
       output_buffer->newline();
 
-      /// Generate remainder code if unroll factor > 1
-      if (curr_unroll_factor > 1){
+      /// Generate remainder code if unroll factor > 1, unless the constraints
+      /// on the parameters make the trip count a multiple of the factor
+      parametric_exp* trip_count =
+        parametric_exp::copy(range_list[curr_dim].ub);
+      trip_count = trip_count->subtract(range_list[curr_dim].lb);
+      trip_count = trip_count->add(1);
+      bool exact_trip_count =
+        parametric_exp::is_multiple_of(trip_count, curr_unroll_factor);
+      delete trip_count;
+      if (curr_unroll_factor > 1 && !exact_trip_count){
         bool addpragma = false;
-        if (generate_omp_pragmas && !iterator->is_unit_trip_count()) {
-          addpragma = true;
-          for(deque<c_iterator*>::const_iterator itersIter = iters.begin();
-                *itersIter != iterator; itersIter++){
-            if( !((*itersIter)->is_unit_trip_count()) ){
-              addpragma = false;
-              break;
-            }
-          }
+        if (generate_omp_pragmas && !use_omp_tasks &&
+            !iterator->is_unit_trip_count()) {
+          addpragma = is_distributed_loop(iters.end() - 1);
         }
 
-        if (addpragma) {
+        if (addpragma && use_forma_runtime) {
+          output_buffer->indent();
+          output_buffer->buffer <<
+            "if (forma_thread_num() == forma_num_threads() - 1) {";
+          output_buffer->newline();
+          output_buffer->increaseIndent();
+        }
+        else if (addpragma) {
           output_buffer->buffer << "#ifdef _OPENMP";
           output_buffer->newline();
           output_buffer->indent();
@@ -1634,7 +2402,16 @@ void PrintC::print_unrolled_code
         print_remainder_loop_footer();
         curr_unroll_factors[curr_dim] = curr_unroll_factor;
 
-        if (addpragma) {
+        if (addpragma && use_forma_runtime) {
+          output_buffer->decreaseIndent();
+          output_buffer->indent();
+          output_buffer->buffer << "}";
+          output_buffer->newline();
+          output_buffer->indent();
+          output_buffer->buffer << "forma_barrier();";
+          output_buffer->newline();
+        }
+        else if (addpragma) {
           output_buffer->decreaseIndent();
           output_buffer->buffer << "#ifdef _OPENMP";
           output_buffer->newline();
@@ -1690,12 +2467,393 @@ void PrintC::print_patch_untiled
 }
 
 
+///-----------------------------------------------------------------------------
+/// Generate tiled code for each patch. The tile loops are distributed across
+/// threads, and the points within each tile are generated as an untiled patch
+void PrintC::print_patch_tiled
+(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
+ c_symbol_info* output_symbol, domain_node* loop_domain,
+ bool is_bdy, bool unrolled_code, deque<int>& curr_unroll_factors) {
+  const deque<range_coeffs>& range_list = loop_domain->range_list;
+  int ndims = loop_domain->get_dim();
+
+  /// Tile sizes are specified from the innermost dimension. Dimensions with a
+  /// single iteration are not tiled
+  deque<int> curr_tile_sizes(ndims, 0);
+  deque<string> tile_vars(ndims, "");
+  int num_tiled = 0;
+  for( int curr_dim = 0 ; curr_dim < ndims ; curr_dim++ ){
+    int i = ndims - 1 - curr_dim;
+    if( i < (int)tile_sizes.size() && tile_sizes[i] > 1 &&
+        !parametric_exp::is_equal
+        (range_list[curr_dim].lb,range_list[curr_dim].ub) ){
+      curr_tile_sizes[curr_dim] = tile_sizes[i];
+      tile_vars[curr_dim] = get_new_iterator(output_buffer);
+      num_tiled++;
+    }
+  }
+  if( num_tiled == 0 ){
+    print_patch_untiled
+      (curr_fn, input_exprs, output_symbol, loop_domain, is_bdy,
+       unrolled_code, curr_unroll_factors);
+    return;
+  }
+
+  /// The tile loops are perfectly nested, so all of them are distributed
+  /// across threads. A stage scheduled to run its outer loops on every
+  /// thread distributes only the inner tile loops
+  bool addpragma = false;
+  int first_distributed = 0;
+  if( generate_omp_pragmas ){
+    int num_outer = 0;
+    for( deque<c_iterator*>::const_iterator itersIter = iters.begin(),
+           itersEnd = iters.end() ; itersIter != itersEnd ; itersIter++)
+      if( !((*itersIter)->is_unit_trip_count()) )
+        num_outer++;
+    addpragma = ( num_outer <= parallel_loop_depth );
+    first_distributed = MIN(parallel_loop_depth - num_outer, num_tiled - 1);
+  }
+
+  /// Print the tile loops, and compute the domain of the points in a tile
+  domain_node* tile_domain = new domain_node(loop_domain);
+  deque<parameter_defn*> tile_params;
+  int tile_num = 0;
+  for( int i = 0 ; i < ndims ; i++ ){
+    if( curr_tile_sizes[i] == 0 )
+      continue;
+    if( addpragma && !use_forma_runtime && tile_num == first_distributed ){
+      stringstream private_vars;
+      bool first = true;
+      for( int j = i ; j < ndims ; j++ ){
+        if( curr_tile_sizes[j] == 0 )
+          continue;
+        private_vars << ( first ? "" : "," ) << tile_vars[j];
+        first = false;
+      }
+      print_omp_loop_pragma(private_vars.str(),num_tiled - first_distributed);
+    }
+    /// With the forma runtime only the outermost tile loop is distributed
+    if( addpragma && use_forma_runtime && tile_num == first_distributed ){
+      stringstream lb_stream, ub_stream;
+      PrintCParametricExpr(range_list[i].lb,lb_stream);
+      PrintCParametricExpr(range_list[i].ub,ub_stream);
+      print_runtime_loop_header
+        (tile_vars[i],lb_stream.str(),ub_stream.str(),curr_tile_sizes[i]);
+      output_buffer->buffer << "{";
+    }
+    else{
+      output_buffer->indent();
+      output_buffer->buffer << "for (" << tile_vars[i] << " = ";
+      PrintCParametricExpr(range_list[i].lb,output_buffer->buffer);
+      output_buffer->buffer << "; " << tile_vars[i] << " <= ";
+      PrintCParametricExpr(range_list[i].ub,output_buffer->buffer);
+      output_buffer->buffer << "; " << tile_vars[i] << " += " <<
+        curr_tile_sizes[i] << "){";
+    }
+    tile_num++;
+    output_buffer->newline();
+    output_buffer->increaseIndent();
+
+    parameter_defn* tile_param = new parameter_defn(tile_vars[i].c_str());
+    tile_params.push_back(tile_param);
+    parametric_exp* tile_lb = new param_expr(tile_param);
+    parametric_exp* tile_ub = new param_expr(tile_param);
+    tile_ub = tile_ub->add(curr_tile_sizes[i]-1);
+    range_coeffs& tile_range = tile_domain->range_list[i];
+    tile_range.lb = tile_range.lb->max(tile_lb);
+    tile_range.ub = tile_range.ub->min(tile_ub);
+    delete tile_lb;
+    delete tile_ub;
+  }
+
+  /// Points within a tile are computed by the thread that owns the tile
+  bool orig_omp_pragmas = generate_omp_pragmas;
+  generate_omp_pragmas = false;
+  print_patch_untiled
+    (curr_fn, input_exprs, output_symbol, tile_domain, is_bdy,
+     unrolled_code, curr_unroll_factors);
+  generate_omp_pragmas = orig_omp_pragmas;
+
+  for( int i = 0 ; i < num_tiled ; i++ ){
+    output_buffer->decreaseIndent();
+    output_buffer->indent();
+    output_buffer->buffer << "}";
+    output_buffer->newline();
+  }
+  delete tile_domain;
+  for( deque<parameter_defn*>::iterator it = tile_params.begin() ;
+       it != tile_params.end() ; it++ )
+    delete *it;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Collect the stencil operations within an expression of a stencil function
+void PrintC::collect_stencil_ops
+(const expr_node* curr_expr, deque<const stencil_op_node*>& ops)
+{
+  switch(curr_expr->get_s_type()){
+  case S_STENCILOP:
+    ops.push_back(static_cast<const stencil_op_node*>(curr_expr));
+    break;
+  case S_UNARYNEG:
+    collect_stencil_ops
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),ops);
+    break;
+  case S_MATHFN:{
+    const deque<expr_node*>& fn_args =
+      static_cast<const math_fn_expr_node*>(curr_expr)->get_args();
+    for( deque<expr_node*>::const_iterator it = fn_args.begin() ;
+         it != fn_args.end() ; it++ )
+      collect_stencil_ops(*it,ops);
+  }
+    break;
+  case S_TERNARY:{
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    collect_stencil_ops(curr_ternary->get_bool_expr(),ops);
+    collect_stencil_ops(curr_ternary->get_true_expr(),ops);
+    collect_stencil_ops(curr_ternary->get_false_expr(),ops);
+  }
+    break;
+  case S_BINARYOP:
+    collect_stencil_ops
+      (static_cast<const expr_op_node*>(curr_expr)->get_lhs_expr(),ops);
+    collect_stencil_ops
+      (static_cast<const expr_op_node*>(curr_expr)->get_rhs_expr(),ops);
+    break;
+  case S_STRUCT:{
+    const deque<expr_node*>& field_exprs =
+      static_cast<const pt_struct_node*>(curr_expr)->get_field_exprs();
+    for( deque<expr_node*>::const_iterator it = field_exprs.begin() ;
+         it != field_exprs.end() ; it++ )
+      collect_stencil_ops(*it,ops);
+  }
+    break;
+  case S_ARRAYACCESS:{
+    const deque<expr_node*>& index_exprs =
+      static_cast<const array_access_node*>(curr_expr)->get_index_exprs();
+    for( deque<expr_node*>::const_iterator it = index_exprs.begin() ;
+         it != index_exprs.end() ; it++ )
+      collect_stencil_ops(*it,ops);
+  }
+    break;
+  default:
+    break;
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Group the stencil accesses of a stencil function application that differ
+/// only in the offset along the innermost dimension. Groups with more than one
+/// offset get a register for every point read by a block of unrolled
+/// iterations
+void PrintC::init_window_groups
+(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs, int ndims,
+ int block_size)
+{
+  const stencilfn_defn_node* curr_stencil =
+    dynamic_cast<const stencilfn_defn_node*>(curr_fn->get_defn());
+  assert(curr_stencil && "Wrong function type while printing stencil body");
+
+  deque<const stencil_op_node*> stencil_ops;
+  const deque<pt_stmt_node*>& fn_body = curr_stencil->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ )
+    collect_stencil_ops((*it)->get_rhs(),stencil_ops);
+  collect_stencil_ops(curr_stencil->get_return_expr(),stencil_ops);
+
+  const deque<vector_defn_node*>& fn_params = curr_stencil->get_args();
+  deque<c_window_group*> curr_groups;
+  for( deque<const stencil_op_node*>::iterator it = stencil_ops.begin() ;
+       it != stencil_ops.end() ; it++ ){
+    const deque<scale_coeffs>& scale_fn = (*it)->get_scale_fn()->scale_fn;
+    if( (*it)->get_base_type().type == T_STRUCT ||
+        (int)scale_fn.size() != ndims || scale_fn.back().scale != 1 )
+      continue;
+    const c_symbol_info* curr_symbol = NULL;
+    for( int i = 0 ; i < (int)fn_params.size() ; i++ )
+      if( fn_params[i] == (*it)->get_var() )
+        curr_symbol = input_exprs[i];
+    if( !curr_symbol || !curr_symbol->var->expr_domain ||
+        curr_symbol->var->expr_domain->get_dim() != ndims )
+      continue;
+
+    int curr_offset = scale_fn.back().offset;
+    c_window_group* curr_group = NULL;
+    for( deque<c_window_group*>::iterator jt = curr_groups.begin() ;
+         jt != curr_groups.end() && !curr_group ; jt++ ){
+      if( (*jt)->symbol != curr_symbol )
+        continue;
+      const deque<scale_coeffs>& group_fn = (*jt)->scale_fn->scale_fn;
+      bool is_same = true;
+      for( int i = 0 ; i < ndims-1 ; i++ )
+        if( group_fn[i].offset != scale_fn[i].offset ||
+            group_fn[i].scale != scale_fn[i].scale )
+          is_same = false;
+      if( is_same )
+        curr_group = *jt;
+    }
+    if( curr_group ){
+      curr_group->min_offset = MIN(curr_group->min_offset,curr_offset);
+      curr_group->max_offset = MAX(curr_group->max_offset,curr_offset);
+    }
+    else{
+      curr_group = new c_window_group;
+      curr_group->symbol = curr_symbol;
+      curr_group->scale_fn = new domainfn_node();
+      for( int i = 0 ; i < ndims ; i++ )
+        curr_group->scale_fn->add_scale_coeffs
+          (i == ndims-1 ? 0 : scale_fn[i].offset, scale_fn[i].scale);
+      curr_group->elem_type = (*it)->get_base_type();
+      curr_group->min_offset = curr_offset;
+      curr_group->max_offset = curr_offset;
+      curr_groups.push_back(curr_group);
+    }
+  }
+
+  for( deque<c_window_group*>::iterator it = curr_groups.begin() ;
+       it != curr_groups.end() ; it++ ){
+    if( (*it)->min_offset == (*it)->max_offset ){
+      delete *it;
+      continue;
+    }
+    for( int i = (*it)->min_offset ; i < (*it)->max_offset + block_size ; i++ )
+      (*it)->registers.push_back
+        (get_new_temp_var((*it)->elem_type,output_buffer));
+    window_groups.push_back(*it);
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+string PrintC::print_window_access(const c_window_group* curr_group, int offset)
+{
+  domainfn_node curr_scale_fn;
+  const deque<scale_coeffs>& scale_fn = curr_group->scale_fn->scale_fn;
+  for( deque<scale_coeffs>::const_iterator it = scale_fn.begin() ;
+       it != scale_fn.end() ; it++ )
+    curr_scale_fn.add_scale_coeffs(it->offset,it->scale);
+  curr_scale_fn.scale_fn.back().offset = offset;
+  return
+    print_stencil_op_helper
+    (curr_group->symbol,&curr_scale_fn,curr_group->elem_type,-1,false);
+}
+
+
+///-----------------------------------------------------------------------------
+/// Load all values of the windows used by a block of unrolled iterations of
+/// the innermost loop
+void PrintC::print_window_loads()
+{
+  for( deque<c_window_group*>::iterator it = window_groups.begin() ;
+       it != window_groups.end() ; it++ ){
+    for( int i = 0 ; i < (int)(*it)->registers.size() ; i++ ){
+      output_buffer->indent();
+      output_buffer->buffer << (*it)->registers[i] << " = " <<
+        print_window_access(*it,(*it)->min_offset+i) << ";";
+      output_buffer->newline();
+    }
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Map the accesses of an unrolled iteration of the innermost loop to the
+/// registers of the window
+void PrintC::set_window_registers(int iteration)
+{
+  window_registers.clear();
+  for( deque<c_window_group*>::iterator it = window_groups.begin() ;
+       it != window_groups.end() ; it++ ){
+    for( int i = (*it)->min_offset ; i <= (*it)->max_offset ; i++ )
+      window_registers[print_window_access(*it,i)] =
+        (*it)->registers[iteration + i - (*it)->min_offset];
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::clear_window_groups()
+{
+  for( deque<c_window_group*>::iterator it = window_groups.begin() ;
+       it != window_groups.end() ; it++ )
+    delete *it;
+  window_groups.clear();
+  window_registers.clear();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Keep the schedules of the stages, and the global options they override
+void PrintC::init_stage_schedules(const program_options& command_opts)
+{
+  stage_schedules = command_opts.stage_schedules;
+  default_unroll_factors = unroll_factors;
+  default_tile_sizes = tile_sizes;
+  default_simd_isa = simd_isa;
+}
+
+
+///-----------------------------------------------------------------------------
+const stage_schedule* PrintC::get_stage_schedule(const string& stage_name) const
+{
+  map<string,stage_schedule>::const_iterator curr_schedule =
+    stage_schedules.find(stage_name);
+  if( curr_schedule == stage_schedules.end() )
+    return NULL;
+  return &curr_schedule->second;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Set the options used to generate a stage, those not set by its schedule
+/// are the global ones. Polyhedral affine code does not use vector intrinsics
+void PrintC::set_stage_schedule(const string& stage_name)
+{
+  unroll_factors = default_unroll_factors;
+  tile_sizes = default_tile_sizes;
+  simd_isa = default_simd_isa;
+  parallel_dim = 0;
+  const stage_schedule* curr_schedule = get_stage_schedule(stage_name);
+  if( curr_schedule ){
+    if( !curr_schedule->unroll_factors.empty() )
+      unroll_factors = curr_schedule->unroll_factors;
+    if( !curr_schedule->tile_sizes.empty() )
+      tile_sizes = curr_schedule->tile_sizes;
+    if( curr_schedule->simd_isa.compare("none") == 0 )
+      simd_isa = "";
+    else if( curr_schedule->simd_isa.compare("") != 0 && !generate_affine )
+      simd_isa = curr_schedule->simd_isa;
+    if( curr_schedule->parallel_dim != -1 )
+      parallel_dim = curr_schedule->parallel_dim;
+  }
+  generate_unroll_code = !unroll_factors.empty();
+  generate_tiled_code = !tile_sizes.empty();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Check if a statement of the program is computed within the tiles of its
+/// consumer, as set by its schedule or for all stages
+bool PrintC::is_fused_stage(const stmt_node* curr_stmt) const
+{
+  const stage_schedule* curr_schedule =
+    get_stage_schedule(curr_stmt->get_name_string());
+  if( curr_schedule == NULL ||
+      curr_schedule->compute_level == COMPUTE_DEFAULT )
+    return fuse_all_stages;
+  return curr_schedule->compute_level == COMPUTE_TILE;
+}
+
+
 ///-----------------------------------------------------------------------------
 void PrintC::getCurrUnrollFactors(int ndims, deque<int>& curr_unroll_factors) {
   int num_loops = curr_unroll_factors.size();
   assert
     (num_loops == ndims && "Mismatch in loop dimension and num unroll factors");
-  for (int i = 0 ; i < unroll_factors.size(); i++ ) {
+  for (int i = 0 ; i < unroll_factors.size() && i < num_loops; i++ ) {
     curr_unroll_factors[num_loops - 1 - i] = unroll_factors[i];
   }
 }
@@ -1721,11 +2879,13 @@ void PrintC::printPatches
         parametric_exp::copy(inner_domain->range_list[dim].lb);
       ub = ub->subtract(1);
       loop_domain->add_range(lb,ub);
+      patch_sides.push_back(-1);
       /// Recursive call to compute patches in this range
       printPatches
         (curr_argument,input_exprs,output_symbol,loop_domain,
          outer_domain,inner_domain,dim+1,ndims,true);
       loop_domain->range_list.pop_back();
+      patch_sides.pop_back();
       delete lb;
       delete ub;
     }
@@ -1735,10 +2895,12 @@ void PrintC::printPatches
     parametric_exp* inner_ub =
       parametric_exp::copy(inner_domain->range_list[dim].ub);
     loop_domain->add_range(inner_lb,inner_ub);
+    patch_sides.push_back(0);
     printPatches
       (curr_argument,input_exprs,output_symbol,loop_domain,
        outer_domain,inner_domain,dim+1,ndims,isBdy);
     loop_domain->range_list.pop_back();
+    patch_sides.pop_back();
     delete inner_lb;
     delete inner_ub;
     /// Check if the outer domains outer edge is same as inner domains outer
@@ -1751,10 +2913,12 @@ void PrintC::printPatches
       parametric_exp* ub =
         parametric_exp::copy(outer_domain->range_list[dim].ub);
       loop_domain->add_range(lb,ub);
+      patch_sides.push_back(1);
       printPatches
         (curr_argument,input_exprs,output_symbol,loop_domain,
          outer_domain,inner_domain,dim+1,ndims,true);
       loop_domain->range_list.pop_back();
+      patch_sides.pop_back();
       delete lb;
       delete ub;
     }
@@ -1762,12 +2926,75 @@ void PrintC::printPatches
   else{
     /// End of recursion, actually generate code for whatever we have in loop
     /// domain
+    if( !isBdy && skip_interior_patch )
+      return;
     deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
     if (generate_unroll_code)
       getCurrUnrollFactors(loop_domain->get_dim(), curr_unroll_factors);
-    print_patch_untiled
-      (curr_argument, input_exprs, output_symbol, loop_domain, isBdy,
-       generate_unroll_code, curr_unroll_factors);
+    /// In the interior the innermost loop steps over whole vector registers,
+    /// the remainder loop computes the left over points with scalar code
+    bool use_simd =
+      !isBdy && check_simd_stencil(curr_argument,input_exprs,output_symbol);
+    if( use_simd )
+      curr_unroll_factors.back() *= get_simd_width(simd_type);
+    domain_node* patch_domain = loop_domain;
+    if( tile_window_lb ){
+      /// Within a fused tile, restrict the outermost dimension to the window
+      patch_domain = new domain_node(loop_domain);
+      range_coeffs& outer_range = patch_domain->range_list.front();
+      outer_range.lb = outer_range.lb->max(tile_window_lb);
+      outer_range.ub = outer_range.ub->min(tile_window_ub);
+    }
+    if( roi_window ){
+      if( patch_domain == loop_domain )
+        patch_domain = new domain_node(loop_domain);
+      deque<range_coeffs>::const_iterator window_range =
+        roi_window->range_list.begin();
+      for( deque<range_coeffs>::iterator it = patch_domain->range_list.begin();
+           it != patch_domain->range_list.end() ; it++, window_range++ ){
+        it->lb = it->lb->max(window_range->lb);
+        it->ub = it->ub->min(window_range->ub);
+      }
+    }
+    if( skip_interior_patch ){
+      /// The edges of images smaller than the stencil extend past the other
+      /// side of the domain, points where edges overlap are computed twice
+      if( patch_domain == loop_domain )
+        patch_domain = new domain_node(loop_domain);
+      deque<range_coeffs>::const_iterator outer_range =
+        outer_domain->range_list.begin();
+      for( deque<range_coeffs>::iterator it = patch_domain->range_list.begin();
+           it != patch_domain->range_list.end() ; it++, outer_range++ ){
+        it->lb = it->lb->max(outer_range->lb);
+        it->ub = it->ub->min(outer_range->ub);
+      }
+    }
+    /// A patch with fewer loops than the outer loops the stage runs on every
+    /// thread distributes its innermost loop
+    domain_node* patch_loop_domain =
+      compute_loop_domain(patch_domain, output_symbol->scale_domain);
+    int num_loops = 0;
+    for( deque<range_coeffs>::const_iterator it =
+           patch_loop_domain->range_list.begin() ;
+         it != patch_loop_domain->range_list.end() ; it++ )
+      if( !parametric_exp::is_equal(it->lb,it->ub) )
+        num_loops++;
+    parallel_loop_depth = MAX(0, MIN(parallel_dim, num_loops - 1));
+    delete patch_loop_domain;
+    if( generate_tiled_code && !output_symbol->scale_domain ){
+      print_patch_tiled
+        (curr_argument, input_exprs, output_symbol, patch_domain, isBdy,
+         generate_unroll_code || use_simd, curr_unroll_factors);
+    }
+    else{
+      print_patch_untiled
+        (curr_argument, input_exprs, output_symbol, patch_domain, isBdy,
+         generate_unroll_code || use_simd, curr_unroll_factors);
+    }
+    parallel_loop_depth = 0;
+    simd_type = T_STRUCT;
+    if( patch_domain != loop_domain )
+      delete patch_domain;
   }
 }
 
@@ -1802,10 +3029,17 @@ void PrintC::print_stencilfn_body
     assert
       (elem_type.struct_info &&
        elem_type.struct_info->fields.size()==stencil_return_exprs.size());
+    const pt_struct_node* return_expr =
+      dynamic_cast<const pt_struct_node*>(curr_stencil->get_return_expr());
     for( int i =0 ; i < (int)stencil_return_exprs.size() ; i++ ){
       output_buffer->indent();
       output_symbol->field_name =
         elem_type.struct_info->fields[i].field_name;
+      if( return_expr )
+        stencil_return_exprs[i] =
+          print_int_conversion
+          (return_expr->get_field_exprs()[i],stencil_return_exprs[i],
+           elem_type.struct_info->fields[i].field_type,false);
       print_assignment_stmt
         (output_symbol,stencil_return_exprs[i],output_buffer->buffer);
       output_buffer->newline();
@@ -1813,6 +3047,20 @@ void PrintC::print_stencilfn_body
   }
   else{
     assert(stencil_return_exprs.size() == 1 );
+    ///The value is converted to the type of the output when stored
+    basic_data_types output_type = output_symbol->var->elem_type.type;
+    if( output_type == T_STRUCT ){
+      const deque<defined_fields>& output_fields =
+        output_symbol->var->elem_type.struct_info->fields;
+      for( deque<defined_fields>::const_iterator it = output_fields.begin() ;
+           it != output_fields.end() ; it++ )
+        if( it->field_name.compare(output_symbol->field_name) == 0 )
+          output_type = it->field_type;
+    }
+    stencil_return_exprs[0] =
+      print_int_conversion
+      (curr_stencil->get_return_expr(),stencil_return_exprs[0],output_type,
+       false);
     output_buffer->indent();
     print_assignment_stmt
       (output_symbol,stencil_return_exprs[0],output_buffer->buffer);
@@ -1825,564 +3073,3403 @@ void PrintC::print_stencilfn_body
 
 
 ///-----------------------------------------------------------------------------
-/// Function to generate the body of the vector function
-void PrintC::print_vectorfn_body
-(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
- deque<const domain_node*>& arg_domains, c_symbol_info* curr_output_symbol)
+/// Number of elements of a type held by a vector register
+int PrintC::get_simd_width(basic_data_types elem_type) const
 {
-  fn_defn_node* fn_defn = curr_fn->get_defn();
-  assert
-    (dynamic_cast<vectorfn_defn_node*>(fn_defn) &&
-     "Calling generator of vector fn body for non-vector function");
-  vectorfn_defn_node* curr_vector_fn= static_cast<vectorfn_defn_node*>(fn_defn);
-  const deque<vector_defn_node*> fn_params = curr_vector_fn->get_args();
-  assert
-    (input_exprs.size() == fn_params.size()
-     && "Number of input symbols doesnt match number of vector fn params");
-  /// Add the input exprs to the symbol table of the vector fn body
-  c_symbol_table new_fn_bindings;
-  deque<vector_defn_node*>::const_iterator fn_params_iter = fn_params.begin();
-  for( deque<c_symbol_info*>::iterator symbol_iter = input_exprs.begin(),
-         symbol_end = input_exprs.end() ; symbol_iter != symbol_end ;
-       symbol_iter++, fn_params_iter++){
-    new_fn_bindings.symbol_table.insert
-      (make_pair(*fn_params_iter,*symbol_iter));
+  int register_bytes = 16;
+  if( simd_isa.compare("avx2") == 0 )
+    register_bytes = 32;
+  else if( simd_isa.compare("avx512") == 0 )
+    register_bytes = 64;
+  switch(elem_type){
+  case T_DOUBLE:
+    return register_bytes / 8;
+  case T_FLOAT:
+  case T_INT:
+    return register_bytes / 4;
+  case T_INT16:
+    return register_bytes / 2;
+  case T_INT8:
+    return register_bytes;
+  default:
+    assert(0 && "[ME] : Within Code-generator : No vector registers for type");
   }
+  return 1;
+}
 
-  ///Need to recompute the domain of expressions within the vector
-  ///function based ont he domain of the arguments
-  curr_vector_fn->compute_domain(arg_domains);
-  new_fn_bindings.AddSymbol
-    (static_cast<const vectorfn_defn_node*>(fn_defn)->get_return_expr(),
-     curr_output_symbol->var, curr_output_symbol->scale_domain,
-     curr_output_symbol->offset_domain, curr_output_symbol->field_name);
-  print_vectorfn_body_helper(curr_vector_fn,new_fn_bindings,true);
 
-  /// Remove the input_exprs from the symbol table, they are deallocated later
-  fn_params_iter = fn_params.begin();
-  for(deque<vector_defn_node*>::const_iterator fn_params_end= fn_params.end();
-      fn_params_iter != fn_params_end ; fn_params_iter++ ){
-    map<const vector_expr_node*,c_symbol_info*>::iterator var =
-      new_fn_bindings.symbol_table.find(*fn_params_iter);
-    new_fn_bindings.symbol_table.erase(*fn_params_iter);
-  }
+///-----------------------------------------------------------------------------
+string PrintC::get_simd_vector_type() const
+{
+  stringstream curr_stream;
+  if( simd_isa.compare("avx2") == 0 )
+    curr_stream << "__m256";
+  else if( simd_isa.compare("avx512") == 0 )
+    curr_stream << "__m512";
+  else
+    curr_stream << "__m128";
+  if( simd_type == T_DOUBLE )
+    curr_stream << "d";
+  else if( simd_type != T_FLOAT )
+    curr_stream << "i";
+  return curr_stream.str();
 }
 
 
-
 ///-----------------------------------------------------------------------------
-/// Generate code for function applications
-void PrintC::print_fn_body
-(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
- deque<const domain_node*>& arg_domains, c_symbol_info* curr_output_symbol)
+string PrintC::get_simd_intrinsic(const string& op) const
 {
-  fn_defn_node* fn_defn = curr_fn->get_defn();
+  return get_simd_intrinsic(op,simd_type);
+}
 
-  if( dynamic_cast<const stencilfn_defn_node*>(fn_defn) ){
 
-    ////Stencil fns are inlined by default.
-    stencilfn_defn_node* curr_stencil =
-      dynamic_cast<stencilfn_defn_node*>(fn_defn);
+///-----------------------------------------------------------------------------
+string PrintC::get_simd_intrinsic
+(const string& op, basic_data_types elem_type) const
+{
+  stringstream curr_stream;
+  if( simd_isa.compare("avx2") == 0 )
+    curr_stream << "_mm256_";
+  else if( simd_isa.compare("avx512") == 0 )
+    curr_stream << "_mm512_";
+  else
+    curr_stream << "_mm_";
+  curr_stream << op << "_";
+  switch(elem_type){
+  case T_DOUBLE:
+    curr_stream << "pd";
+    break;
+  case T_FLOAT:
+    curr_stream << "ps";
+    break;
+  case T_INT:
+    curr_stream << "epi32";
+    break;
+  case T_INT16:
+    curr_stream << "epi16";
+    break;
+  case T_INT8:
+    curr_stream << "epi8";
+    break;
+  default:
+    /// Bitwise operations on whole registers
+    if( simd_isa.compare("avx2") == 0 )
+      curr_stream << "si256";
+    else if( simd_isa.compare("avx512") == 0 )
+      curr_stream << "si512";
+    else
+      curr_stream << "si128";
+    break;
+  }
+  return curr_stream.str();
+}
 
-    ///The domain of the stencil, the function compute_domain sets the domain of
-    ///all parameters to those in arg_domains
-    const domain_node* stencil_domain =
-      curr_stencil->compute_domain(arg_domains);
 
-    /// Compute the interior of the loop domain
-    deque<offset_hull> interior_offset;
-    computeOffsets(curr_fn,interior_offset,curr_output_symbol->scale_domain);
-    domain_node* interior_loop_domain = new domain_node(stencil_domain);
-    ApplyOffset(interior_loop_domain,interior_offset);
+///-----------------------------------------------------------------------------
+/// The vector code has to compute exactly what the scalar code computes. For
+/// float and double the operations have to be performed in simd_type
+bool PrintC::check_simd_expr
+(const expr_node* curr_expr, c_symbol_table& fn_bindings)
+{
+  basic_data_types expr_type = curr_expr->get_data_type().type;
 
-    /// Compute the exterior of the loop domain
-    deque<offset_hull> exterior_offset;
-    computeOffsets
-      (curr_fn,exterior_offset,curr_output_symbol->scale_domain,true);
-    domain_node* exterior_loop_domain = new domain_node(stencil_domain);
-    ApplyOffset(exterior_loop_domain,exterior_offset);
+  /// Constants are converted to simd_type as done by the C promotion rules
+  if( curr_expr->get_s_type() == S_VALUE )
+    return expr_type >= simd_type;
+  if( expr_type != simd_type )
+    return false;
 
-    domain_node* loop_domain = new domain_node();
-    printPatches
-      (curr_fn,input_exprs,curr_output_symbol,loop_domain,exterior_loop_domain,
-       interior_loop_domain, 0, stencil_domain->get_dim(), false);
-    delete loop_domain;
-    delete exterior_loop_domain;
-    delete interior_loop_domain;
-  }
-  else{
-    print_vectorfn_body(curr_fn,input_exprs,arg_domains,curr_output_symbol);
+  switch(curr_expr->get_s_type()){
+  case S_ID:
+    return true;
+  case S_UNARYNEG:
+    return check_simd_expr
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),
+       fn_bindings);
+  case S_MATHFN: {
+    const math_fn_expr_node* curr_mathfn =
+      static_cast<const math_fn_expr_node*>(curr_expr);
+    return
+      curr_mathfn->get_name().compare("sqrt") == 0 &&
+      curr_mathfn->get_args().size() == 1 &&
+      check_simd_expr(curr_mathfn->get_args().front(),fn_bindings);
+  }
+  case S_TERNARY: {
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    if( curr_ternary->get_bool_expr()->get_s_type() != S_BINARYOP )
+      return false;
+    const expr_op_node* curr_cond =
+      static_cast<const expr_op_node*>(curr_ternary->get_bool_expr());
+    if( !is_relation_op(curr_cond->get_op()) )
+      return false;
+    return
+      check_simd_expr(curr_cond->get_lhs_expr(),fn_bindings) &&
+      check_simd_expr(curr_cond->get_rhs_expr(),fn_bindings) &&
+      check_simd_expr(curr_ternary->get_true_expr(),fn_bindings) &&
+      check_simd_expr(curr_ternary->get_false_expr(),fn_bindings);
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    switch(curr_op->get_op()){
+    case O_PLUS:
+    case O_MINUS:
+    case O_MULT:
+    case O_DIV:
+      break;
+    default:
+      return false;
+    }
+    return
+      check_simd_expr(curr_op->get_lhs_expr(),fn_bindings) &&
+      check_simd_expr(curr_op->get_rhs_expr(),fn_bindings);
+  }
+  case S_STENCILOP: {
+    const stencil_op_node* curr_stencil_op =
+      static_cast<const stencil_op_node*>(curr_expr);
+    const c_symbol_info* curr_symbol =
+      fn_bindings.GetSymbolInfo(curr_stencil_op->get_var());
+    /// Scalars are broadcast to all elements
+    if( curr_symbol->var->expr_domain == NULL ||
+        curr_symbol->var->expr_domain->get_dim() == 0 )
+      return true;
+    /// Vectors are loaded from consecutive points along the innermost
+    /// dimension
+    const domainfn_node* scale_fn = curr_stencil_op->get_scale_fn();
+    return
+      curr_symbol->field_name.compare("") == 0 &&
+      curr_symbol->var->elem_type.type == simd_type &&
+      curr_stencil_op->get_base_type().type == simd_type &&
+      scale_fn->scale_fn.back().scale == 1;
+  }
+  default:
+    return false;
   }
 }
 
 
+///Width in bits of an integer type
+static int get_int_bits(basic_data_types elem_type)
+{
+  switch(elem_type){
+  case T_INT8:
+    return 8;
+  case T_INT16:
+    return 16;
+  default:
+    return 32;
+  }
+}
 
-///-----------------------------------------------------------------------------
-/// Generate code for a function application expressions
-void PrintC::print_fnid_expr
-(const fnid_expr_node* curr_fn,c_symbol_table& fn_bindings){
-  deque<c_symbol_info*> arg_symbols;
-  deque<const domain_node*> arg_domains;
-
-  /// Initialize the arguments
-  bool is_tiled =
-    init_fn_args(curr_fn,fn_bindings,arg_symbols,arg_domains);
 
-  /// Generate code for the function body
-  c_symbol_info* output_symbol = fn_bindings.GetSymbolInfo(curr_fn);
-  print_fn_body(curr_fn,arg_symbols,arg_domains,output_symbol);
-  for( deque<const domain_node*>::iterator it = arg_domains.begin() ;
-       it != arg_domains.end() ; it++ )
-    delete (*it);
-  arg_domains.clear();
-  deleteArgSymbols(arg_symbols);
+///Returns the exponent if the expression is a positive power of 2 constant
+static int get_log2_constant
+(const ValueRangeAnalysis& value_ranges, const expr_node* curr_expr)
+{
+  value_range curr_range;
+  if( curr_expr->get_s_type() != S_VALUE ||
+      !value_ranges.get_range(curr_expr,curr_range) ||
+      curr_range.lb != curr_range.ub || curr_range.lb <= 0 ||
+      ( curr_range.lb & ( curr_range.lb - 1 ) ) != 0 )
+    return -1;
+  int exponent = 0;
+  while( ( 1LL << exponent ) < curr_range.lb )
+    exponent++;
+  return exponent;
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_domainfn_expr
-(const vec_domainfn_node* curr_domainfn, c_symbol_table& fn_bindings)
+/// Integer values are computed in the elements of simd_type, which can be
+/// wider than the types of the vectors read and written. The elements hold
+/// either the exact value computed by the scalar code, or only its low bits
+/// when the value can overflow them. Additions, subtractions,
+/// multiplications and left shifts give the right low bits in both cases,
+/// while comparisons, divisions by powers of 2, right shifts, saturating
+/// conversions and the narrowing of the stored values need exact values
+bool PrintC::check_simd_int_expr
+(const expr_node* curr_expr, c_symbol_table& fn_bindings)
 {
-  ///Get the output symbol to be used for the RHS
-  const c_symbol_info* curr_output_symbol =
-    fn_bindings.GetSymbolInfo(curr_domainfn);
-  const domain_node* expr_domain = curr_output_symbol->var->expr_domain;
+  value_range raw_range;
+  if( !value_ranges.get_raw_range(curr_expr,raw_range) )
+    return false;
+  value_range lane_range = value_range::of_type(simd_type);
+  bool is_exact = false;
 
-  ///Precompute the base expression
-  const vector_expr_node* base_expr = curr_domainfn->get_base_expr();
-  init_rhs
-    (base_expr,curr_domainfn->get_expr_domain(),
-     output_buffer->buffer,fn_bindings);
-  c_symbol_info* base_symbol = FindDefnSymbol(base_expr,fn_bindings);
-  assert(base_symbol != NULL &&
-         "Couldnt find symbol for base of domainfn expr");
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+    is_exact = lane_range.contains(raw_range);
+    break;
+  case S_ID: {
+    map<string,bool>::const_iterator curr_scalar =
+      simd_scalars_exact.find
+      (static_cast<const id_expr_node*>(curr_expr)->get_name());
+    if( curr_scalar == simd_scalars_exact.end() )
+      return false;
+    is_exact = curr_scalar->second;
+    break;
+  }
+  case S_UNARYNEG: {
+    const expr_node* base_expr =
+      static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr();
+    if( !check_simd_int_expr(base_expr,fn_bindings) )
+      return false;
+    is_exact = simd_exact[base_expr] && lane_range.contains(raw_range);
+    break;
+  }
+  case S_STENCILOP: {
+    const stencil_op_node* curr_stencil_op =
+      static_cast<const stencil_op_node*>(curr_expr);
+    const c_symbol_info* curr_symbol =
+      fn_bindings.GetSymbolInfo(curr_stencil_op->get_var());
+    basic_data_types stored_type = curr_stencil_op->get_base_type().type;
+    if( !ValueRangeAnalysis::is_integer_type(stored_type) )
+      return false;
+    /// Scalars are broadcast to all elements
+    if( curr_symbol->var->expr_domain == NULL ||
+        curr_symbol->var->expr_domain->get_dim() == 0 ){
+      is_exact = lane_range.contains(value_range::of_type(stored_type));
+      break;
+    }
+    /// Vectors are loaded from consecutive points along the innermost
+    /// dimension, and widened to simd_type
+    if( curr_symbol->field_name.compare("") != 0 ||
+        curr_symbol->var->elem_type.type != stored_type ||
+        get_int_bits(stored_type) > get_int_bits(simd_type) ||
+        curr_stencil_op->get_scale_fn()->scale_fn.back().scale != 1 )
+      return false;
+    is_exact = true;
+    break;
+  }
+  case S_TERNARY: {
+    const ternary_expr_node* curr_ternary =
+      static_cast<const ternary_expr_node*>(curr_expr);
+    if( curr_ternary->get_bool_expr()->get_s_type() != S_BINARYOP )
+      return false;
+    const expr_op_node* curr_cond =
+      static_cast<const expr_op_node*>(curr_ternary->get_bool_expr());
+    if( !is_relation_op(curr_cond->get_op()) ||
+        !check_simd_int_expr(curr_cond->get_lhs_expr(),fn_bindings) ||
+        !check_simd_int_expr(curr_cond->get_rhs_expr(),fn_bindings) ||
+        !simd_exact[curr_cond->get_lhs_expr()] ||
+        !simd_exact[curr_cond->get_rhs_expr()] ||
+        !check_simd_int_expr(curr_ternary->get_true_expr(),fn_bindings) ||
+        !check_simd_int_expr(curr_ternary->get_false_expr(),fn_bindings) )
+      return false;
+    is_exact =
+      simd_exact[curr_ternary->get_true_expr()] &&
+      simd_exact[curr_ternary->get_false_expr()];
+    break;
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    const expr_node* lhs_expr = curr_op->get_lhs_expr();
+    const expr_node* rhs_expr = curr_op->get_rhs_expr();
+    if( !check_simd_int_expr(lhs_expr,fn_bindings) ||
+        !check_simd_int_expr(rhs_expr,fn_bindings) )
+      return false;
+    bool operands_exact = simd_exact[lhs_expr] && simd_exact[rhs_expr];
+    value_range shift_range;
+    value_ranges.get_range(rhs_expr,shift_range);
+    switch(curr_op->get_op()){
+    case O_PLUS:
+    case O_MINUS:
+      is_exact = operands_exact && lane_range.contains(raw_range);
+      break;
+    case O_MULT:
+      if( simd_type == T_INT8 )
+        return false;
+      is_exact = operands_exact && lane_range.contains(raw_range);
+      break;
+    case O_SHL:
+      if( simd_type == T_INT8 || shift_range.lb != shift_range.ub ||
+          shift_range.lb < 0 || shift_range.lb > 31 )
+        return false;
+      is_exact = simd_exact[lhs_expr] && lane_range.contains(raw_range);
+      break;
+    case O_SHR:
+      if( simd_type == T_INT8 || shift_range.lb != shift_range.ub ||
+          shift_range.lb < 0 || shift_range.lb > 31 || !simd_exact[lhs_expr] )
+        return false;
+      is_exact = true;
+      break;
+    case O_DIV:
+      /// Only divisions by powers of 2, computed with shifts
+      if( simd_type == T_INT8 ||
+          get_log2_constant(value_ranges,rhs_expr) < 0 ||
+          !simd_exact[lhs_expr] )
+        return false;
+      is_exact = true;
+      break;
+    default:
+      return false;
+    }
+    break;
+  }
+  default:
+    return false;
+  }
 
-  const domainfn_node* scale_domain = curr_domainfn->get_scale_fn();
+  /// Results of operations are stored in temporaries of the type of the
+  /// expression
+  if( curr_expr->get_s_type() == S_TERNARY ||
+      curr_expr->get_s_type() == S_BINARYOP ){
+    if( get_simd_int_conversion
+        (raw_range,curr_expr->get_data_type().type,is_exact) ==
+        SIMD_CONVERT_UNSUPPORTED )
+      return false;
+  }
+  simd_exact[curr_expr] = is_exact;
+  return true;
+}
 
-  //Compute the loop domain
-  domain_node* loop_domain = new domain_node(curr_domainfn->get_expr_domain());
-  // printf("Loop Domain Before : ");
-  // loop_domain->print_node(stdout);
-  // printf("\n");
-  // printf("Scale Domain : ");
-  // scale_domain->print_node(stdout);
-  // printf("\n");
-  // printf("Expr Domain : ");
-  // curr_domainfn->get_expr_domain()->print_node(stdout);
-  // printf("\n");
-  deque<range_coeffs>::iterator it = loop_domain->range_list.begin();
-  deque<scale_coeffs>::const_iterator jt = scale_domain->scale_fn.begin();
-  for( ; it != loop_domain->range_list.end() ; it++,jt++ ){
-    it->lb = it->lb->add(-MIN(0,FLOOR(jt->offset,jt->scale)));
-    it->ub = it->ub->subtract(MAX(0,FLOOR(jt->offset,jt->scale)));
+
+///-----------------------------------------------------------------------------
+simd_conversion_type PrintC::get_simd_int_conversion
+(const value_range& curr_range, basic_data_types to_type, bool& is_exact)
+{
+  if( value_range::of_type(to_type).contains(curr_range) || to_type == T_INT )
+    return SIMD_CONVERT_NONE;
+  if( value_ranges.is_saturating() ){
+    if( !is_exact )
+      return SIMD_CONVERT_UNSUPPORTED;
+    return SIMD_CONVERT_CLAMP;
   }
-  // printf("Loop Domain : ");
-  // loop_domain->print_node(stdout);
-  // printf("\n");
+  /// Wrapping around to a type at least as wide as the elements does not
+  /// change their bits
+  if( get_int_bits(to_type) >= get_int_bits(simd_type) )
+    return SIMD_CONVERT_NONE;
+  is_exact = true;
+  return SIMD_CONVERT_WRAP;
+}
 
-  ///Print the surrounding loops, iterate through points of the result domain in
-  ///this case
-  deque<c_symbol_info*> input_exprs;
-  input_exprs.push_back(base_symbol);
-  deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
-  print_domain_loops_header
-    (loop_domain, input_exprs, curr_output_symbol->var,
-     curr_output_symbol->scale_domain, curr_unroll_factors);
 
-  ///Print the LHS reference
-  output_buffer->indent();
-  stringstream rhs_stream;
-  print_rhs_var
-    (base_expr,rhs_stream,fn_bindings,curr_domainfn->get_sub_domain(),
-     scale_domain);
-  string rhs_string = rhs_stream.str();
-  print_assignment_stmt(curr_output_symbol,rhs_string,output_buffer->buffer);
-  output_buffer->newline();
+///-----------------------------------------------------------------------------
+bool PrintC::check_simd_stencil
+(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
+ const c_symbol_info* output_symbol)
+{
+  if( simd_isa.compare("") == 0 )
+    return false;
+  const stencilfn_defn_node* curr_stencil =
+    dynamic_cast<const stencilfn_defn_node*>(curr_fn->get_defn());
+  if( !curr_stencil || output_symbol->scale_domain ||
+      output_symbol->field_name.compare("") != 0 ||
+      output_symbol->var->expr_domain->get_dim() == 0 )
+    return false;
+  basic_data_types elem_type = output_symbol->var->elem_type.type;
+  bool is_integer = ValueRangeAnalysis::is_integer_type(elem_type);
+  if( elem_type != T_FLOAT && elem_type != T_DOUBLE && !is_integer )
+    return false;
+  basic_data_types fn_type = curr_fn->get_data_type().type;
+  if( is_integer ? !ValueRangeAnalysis::is_integer_type(fn_type) :
+      fn_type != elem_type )
+    return false;
 
-  ///Finish the loop
-  print_domain_loops_footer(loop_domain, curr_unroll_factors);
+  c_symbol_table fn_bindings;
+  const deque<vector_defn_node*>& fn_params = curr_stencil->get_args();
+  deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+  for( deque<c_symbol_info*>::iterator symbol_iter = input_exprs.begin(),
+         symbol_end = input_exprs.end() ; symbol_iter != symbol_end ;
+       symbol_iter++, param_iter++)
+    fn_bindings.symbol_table.insert(make_pair(*param_iter,*symbol_iter));
 
-  delete loop_domain;
+  const deque<pt_stmt_node*>& fn_body = curr_stencil->get_body();
+  const expr_node* return_expr = curr_stencil->get_return_expr();
+  bool is_supported = false;
+  if( !is_integer ){
+    simd_type = elem_type;
+    is_supported = check_simd_expr(return_expr,fn_bindings);
+    for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+         it != fn_body.end() && is_supported ; it++ )
+      is_supported = check_simd_expr((*it)->get_rhs(),fn_bindings);
+  }
+  else{
+    /// Integer stencils use the narrowest elements that give the same result
+    /// as the scalar code, up to int
+    value_ranges.analyze(curr_stencil);
+    simd_type = elem_type;
+    while( true ){
+      simd_exact.clear();
+      simd_scalars_exact.clear();
+      is_supported = true;
+      for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+           it != fn_body.end() && is_supported ; it++ ){
+        is_supported = check_simd_int_expr((*it)->get_rhs(),fn_bindings);
+        simd_scalars_exact[(*it)->get_lhs()] =
+          is_supported && simd_exact[(*it)->get_rhs()];
+      }
+      is_supported =
+        is_supported && check_simd_int_expr(return_expr,fn_bindings);
+      if( is_supported ){
+        /// The value is converted to the type of the output, and has to be
+        /// exact to be narrowed
+        value_range return_range;
+        value_ranges.get_range(return_expr,return_range);
+        bool is_exact = simd_exact[return_expr];
+        is_supported =
+          get_simd_int_conversion(return_range,elem_type,is_exact) !=
+          SIMD_CONVERT_UNSUPPORTED && ( is_exact || simd_type == elem_type );
+      }
+      if( is_supported || simd_type == T_INT )
+        break;
+      simd_type = ( simd_type == T_INT8 ? T_INT16 : T_INT );
+    }
+  }
+  if( !is_supported )
+    simd_type = T_STRUCT;
+
+  /// The symbols are owned by the caller
+  fn_bindings.symbol_table.clear();
+  return is_supported;
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_make_struct
-(const make_struct_node* curr_struct_node, c_symbol_table& fn_bindings)
+string PrintC::new_simd_register(const string& value)
 {
-  const c_symbol_info* curr_output_symbol =
-    fn_bindings.GetSymbolInfo(curr_struct_node);
-  const deque<vector_expr_node*>& field_inputs =
-    curr_struct_node->get_field_inputs();
+  stringstream var_name_stream;
+  var_name_stream << "__temp_" << ntemp_variables++ << "__" ;
+  output_buffer->indent();
+  output_buffer->buffer << get_simd_vector_type() << " " <<
+    var_name_stream.str() << " = " << value << ";";
+  output_buffer->newline();
+  return var_name_stream.str();
+}
 
-  int field_num = 0;
-  for( deque<vector_expr_node*>::const_iterator it = field_inputs.begin() ;
-       it != field_inputs.end() ; it++, field_num++ ){
-    assert(curr_output_symbol->field_name.compare("") == 0 &&
-           curr_struct_node->get_base_type().type == T_STRUCT &&
-           curr_struct_node->get_base_type().struct_info);
 
-    ///Set the output variable of the RHS variable, with the same information as
-    ///the LHS, but updated field_num
-    fn_bindings.AddSymbol
-      (*it,curr_output_symbol->var, curr_output_symbol->scale_domain,
-       curr_output_symbol->offset_domain,
-       curr_struct_node->get_base_type().
-       struct_info->fields[field_num].field_name);
-    print_vector_expr(*it,fn_bindings);
-    fn_bindings.RemoveSymbol(*it);
+///-----------------------------------------------------------------------------
+string PrintC::print_simd_int_conversion
+(const expr_node* curr_expr, const string& curr_register,
+ basic_data_types to_type, bool is_raw)
+{
+  value_range curr_range;
+  if( is_raw )
+    value_ranges.get_raw_range(curr_expr,curr_range);
+  else
+    value_ranges.get_range(curr_expr,curr_range);
+  /// Exactness was verified when checking the stencil
+  bool is_exact = true;
+  stringstream curr_stream;
+  switch(get_simd_int_conversion(curr_range,to_type,is_exact)){
+  case SIMD_CONVERT_WRAP:
+    if( to_type == T_INT8 ){
+      curr_stream << get_simd_intrinsic("and",T_STRUCT) << "(" <<
+        curr_register << "," << get_simd_intrinsic("set1") << "(0xFF))";
+    }
+    else{
+      curr_stream << get_simd_intrinsic("srai") << "(" <<
+        get_simd_intrinsic("slli") << "(" << curr_register << ",16),16)";
+    }
+    break;
+  case SIMD_CONVERT_CLAMP: {
+    value_range type_range = value_range::of_type(to_type);
+    curr_stream << get_simd_intrinsic("max") << "(" <<
+      get_simd_intrinsic("min") << "(" << curr_register << "," <<
+      get_simd_intrinsic("set1") << "(" << type_range.ub << "))," <<
+      get_simd_intrinsic("set1") << "(" << type_range.lb << "))";
+    break;
   }
-
+  default:
+    return curr_register;
+  }
+  return new_simd_register(curr_stream.str());
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_compose_expr
-(const compose_expr_node* curr_compose_expr, c_symbol_table& fn_bindings)
+string PrintC::print_simd_load(const string& curr_access, basic_data_types elem_type)
 {
-  const c_symbol_info* curr_output_symbol =
-    fn_bindings.GetSymbolInfo(curr_compose_expr);
-  const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
-    curr_compose_expr->get_expr_list();
-
-  for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
-         expr_list.begin() ; it != expr_list.end() ; it++ ){
-    const vector_expr_node* curr_expr = it->second;
-    ///if the rhs expression is a scalar, craete a loop to iterate throught the
-    ///specified domain
-    if( curr_expr->get_dim() == 0 ){
-      const domain_node* curr_domain =
-        dynamic_cast<const domain_node*>(it->first);
-      assert(curr_domain);
-      c_symbol_info* curr_expr_symbol = FindDefnSymbol(curr_expr,fn_bindings);
+  stringstream curr_stream;
+  if( simd_type == T_FLOAT || simd_type == T_DOUBLE )
+    curr_stream << get_simd_intrinsic("loadu") << "(&" << curr_access << ")";
+  else if( elem_type == simd_type ){
+    if( simd_isa.compare("avx512") == 0 )
+      curr_stream << "_mm512_loadu_si512((const void*)&" << curr_access << ")";
+    else if( simd_isa.compare("avx2") == 0 )
+      curr_stream << "_mm256_loadu_si256((const __m256i*)&" << curr_access <<
+        ")";
+    else
+      curr_stream << "_mm_loadu_si128((const __m128i*)&" << curr_access << ")";
+  }
+  else{
+    /// Narrower elements fill the low part of a register, and are widened
+    int load_bytes =
+      get_simd_width(simd_type) * get_int_bits(elem_type) / 8;
+    curr_stream << get_simd_intrinsic
+      ( elem_type == T_INT8 ? "cvtepu8" : "cvtepi16" ) << "(";
+    switch(load_bytes){
+    case 4:
+      curr_stream << "_mm_loadu_si32((const void*)&";
+      break;
+    case 8:
+      curr_stream << "_mm_loadl_epi64((const __m128i*)&";
+      break;
+    case 16:
+      curr_stream << "_mm_loadu_si128((const __m128i*)&";
+      break;
+    default:
+      curr_stream << "_mm256_loadu_si256((const __m256i*)&";
+      break;
+    }
+    curr_stream << curr_access << "))";
+  }
+  return new_simd_register(curr_stream.str());
+}
 
-      deque<c_symbol_info*> input_exprs;
-      input_exprs.push_back(curr_expr_symbol);
-      deque<int> curr_unroll_factors(curr_domain->get_dim(), 1);
-      print_domain_loops_header
-        (curr_domain, input_exprs, curr_output_symbol->var,
-         curr_output_symbol->scale_domain, curr_unroll_factors);
 
-      output_buffer->indent();
-      string rhs_string;
-      if( it->second->get_type() == VEC_SCALAR )
-        rhs_string =
-          print_value_expr(static_cast<const expr_node*>(it->second));
+///-----------------------------------------------------------------------------
+void PrintC::print_simd_store
+(const string& curr_access, const string& curr_register,
+ basic_data_types elem_type)
+{
+  ///The unaligned store of the value, and the non-temporal store with its
+  ///required alignment if there is one for the width of the store
+  string store_fn, stream_fn, store_value = curr_register;
+  int store_bytes = get_simd_width(T_INT8);
+  if( simd_type == T_FLOAT || simd_type == T_DOUBLE ){
+    store_fn = get_simd_intrinsic("storeu") + "(&";
+    stream_fn = get_simd_intrinsic("stream") + "(&";
+  }
+  else if( elem_type == simd_type ){
+    if( simd_isa.compare("avx512") == 0 ){
+      store_fn = "_mm512_storeu_si512((void*)&";
+      stream_fn = "_mm512_stream_si512((__m512i*)&";
+    }
+    else if( simd_isa.compare("avx2") == 0 ){
+      store_fn = "_mm256_storeu_si256((__m256i*)&";
+      stream_fn = "_mm256_stream_si256((__m256i*)&";
+    }
+    else{
+      store_fn = "_mm_storeu_si128((__m128i*)&";
+      stream_fn = "_mm_stream_si128((__m128i*)&";
+    }
+  }
+  else{
+    /// The exact values are within the range of elem_type, truncating or
+    /// saturating them to it gives the same result
+    stringstream packed_stream;
+    if( simd_isa.compare("avx512") == 0 ){
+      packed_stream << "_mm512_cvtepi" << get_int_bits(simd_type) << "_epi" <<
+        get_int_bits(elem_type) << "(" << curr_register << ")";
+    }
+    else{
+      stringstream lo_stream, hi_stream;
+      if( simd_isa.compare("avx2") == 0 ){
+        lo_stream << "_mm256_castsi256_si128(" << curr_register << ")";
+        hi_stream << "_mm256_extracti128_si256(" << curr_register << ",1)";
+      }
       else{
-        assert
-          (it->second->get_type() == VEC_ID &&
-           "Scalar expression is not a number or an ID");
-        rhs_string = curr_expr_symbol->var->symbol_name;
+        lo_stream << curr_register;
+        hi_stream << curr_register;
+      }
+      if( simd_type == T_INT16 ){
+        packed_stream << "_mm_packus_epi16(" << lo_stream.str() << "," <<
+          hi_stream.str() << ")";
+      }
+      else if( elem_type == T_INT16 ){
+        packed_stream << "_mm_packs_epi32(" << lo_stream.str() << "," <<
+          hi_stream.str() << ")";
+      }
+      else{
+        string packed_words =
+          "_mm_packs_epi32(" + lo_stream.str() + "," + hi_stream.str() + ")";
+        packed_stream << "_mm_packus_epi16(" << packed_words << "," <<
+          packed_words << ")";
       }
-      print_assignment_stmt
-        (curr_output_symbol,rhs_string,output_buffer->buffer);
-      output_buffer->newline();
-      print_domain_loops_footer(curr_domain, curr_unroll_factors);
     }
-    else{
-      ///The the output symbol already has a scale domain, cant carry forward
-      ///the symbol, compute the expression here
-      if( curr_output_symbol->scale_domain ){
+    store_value = packed_stream.str();
+    store_bytes =
+      get_simd_width(simd_type) * get_int_bits(elem_type) / 8;
+    switch(store_bytes){
+    case 4:
+      store_fn = "_mm_storeu_si32((void*)&";
+      break;
+    case 8:
+      store_fn = "_mm_storel_epi64((__m128i*)&";
+      break;
+    case 16:
+      store_fn = "_mm_storeu_si128((__m128i*)&";
+      stream_fn = "_mm_stream_si128((__m128i*)&";
+      break;
+    default:
+      store_fn = "_mm256_storeu_si256((__m256i*)&";
+      stream_fn = "_mm256_stream_si256((__m256i*)&";
+      break;
+    }
+  }
 
-        ///Precompute the RHS expression and set the scale or offset domain
-        ///appropriately
-        if( dynamic_cast<const domainfn_node*>(it->first))
-          init_rhs
-            (it->second,it->second->get_expr_domain(),output_buffer->buffer,
-             fn_bindings,static_cast<const domainfn_node*>(it->first),NULL);
-        else
-          init_rhs
-            (it->second,it->second->get_expr_domain(),output_buffer->buffer,
-             fn_bindings,NULL,static_cast<const domain_node*>(it->first));
+  if( !stream_curr_stmt || stream_fn.compare("") == 0 ){
+    output_buffer->indent();
+    output_buffer->buffer << store_fn << curr_access << "," << store_value <<
+      ");";
+    output_buffer->newline();
+    return;
+  }
 
-        ///The loop domain is the domain of the RHS
+  ///Non-temporal stores need aligned addresses, the alignment is the same
+  ///for all vector iterations of a row
+  emitted_stream_stores = true;
+  output_buffer->indent();
+  output_buffer->buffer << "if( ((size_t)&" << curr_access << " & " <<
+    store_bytes - 1 << ") == 0 )";
+  output_buffer->newline();
+  output_buffer->increaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << stream_fn << curr_access << "," << store_value <<
+    ");";
+  output_buffer->newline();
+  output_buffer->decreaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << "else";
+  output_buffer->newline();
+  output_buffer->increaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << store_fn << curr_access << "," << store_value <<
+    ");";
+  output_buffer->newline();
+  output_buffer->decreaseIndent();
+}
+
+
+///-----------------------------------------------------------------------------
+string PrintC::print_simd_expr
+(const expr_node* curr_expr, c_symbol_table& fn_bindings)
+{
+  bool is_integer = ValueRangeAnalysis::is_integer_type(simd_type);
+  string scalar_type;
+  switch(simd_type){
+  case T_INT16:
+    scalar_type = "short";
+    break;
+  case T_INT8:
+    scalar_type = "char";
+    break;
+  default:
+    data_types elem_type;
+    elem_type.assign(simd_type);
+    scalar_type = get_string(elem_type);
+  }
+
+  stringstream curr_stream;
+  switch(curr_expr->get_s_type()){
+  case S_VALUE:
+    curr_stream << get_simd_intrinsic("set1") << "((" << scalar_type << ")" <<
+      print_value_expr(curr_expr) << ")";
+    return curr_stream.str();
+  case S_ID: {
+    map<string,string>::const_iterator curr_scalar =
+      simd_scalars.find
+      (static_cast<const id_expr_node*>(curr_expr)->get_name());
+    assert(curr_scalar != simd_scalars.end() && "Undefined scalar symbol used");
+    return curr_scalar->second;
+  }
+  case S_UNARYNEG: {
+    /// Subtract from negative zero to get the sign of zeros right
+    string base_register =
+      print_simd_expr
+      (static_cast<const unary_neg_expr_node*>(curr_expr)->get_base_expr(),
+       fn_bindings);
+    curr_stream << get_simd_intrinsic("sub") << "(" <<
+      get_simd_intrinsic("set1") << "(" <<
+      ( simd_type == T_FLOAT ? "-0.0f" : simd_type == T_DOUBLE ? "-0.0" : "0" )
+                << ")," << base_register << ")";
+    return new_simd_register(curr_stream.str());
+  }
+  case S_MATHFN: {
+    string arg_register =
+      print_simd_expr
+      (static_cast<const math_fn_expr_node*>(curr_expr)->get_args().front(),
+       fn_bindings);
+    curr_stream << get_simd_intrinsic("sqrt") << "(" << arg_register << ")";
+    return new_simd_register(curr_stream.str());
+  }
+  case S_TERNARY: {
+    string result_register =
+      print_simd_ternary
+      (static_cast<const ternary_expr_node*>(curr_expr),fn_bindings);
+    if( is_integer )
+      result_register =
+        print_simd_int_conversion
+        (curr_expr,result_register,curr_expr->get_data_type().type,true);
+    return result_register;
+  }
+  case S_BINARYOP: {
+    const expr_op_node* curr_op = static_cast<const expr_op_node*>(curr_expr);
+    string lhs_register = print_simd_expr(curr_op->get_lhs_expr(),fn_bindings);
+    operator_type op = curr_op->get_op();
+    if( is_integer && ( op == O_DIV || op == O_SHL || op == O_SHR ) ){
+      /// Shifts by a constant, divisions by a power of 2 round towards zero
+      /// by adding 2^shift-1 to negative values before shifting
+      value_range lhs_range, shift_range;
+      value_ranges.get_range(curr_op->get_lhs_expr(),lhs_range);
+      value_ranges.get_range(curr_op->get_rhs_expr(),shift_range);
+      int shift =
+        ( op == O_DIV ?
+          get_log2_constant(value_ranges,curr_op->get_rhs_expr()) :
+          (int)shift_range.lb );
+      if( op == O_SHL )
+        curr_stream << get_simd_intrinsic("slli");
+      else if( lhs_range.lb >= 0 )
+        curr_stream << get_simd_intrinsic("srli");
+      else if( op == O_SHR )
+        curr_stream << get_simd_intrinsic("srai");
+      else{
+        stringstream bias_stream;
+        int bits = get_int_bits(simd_type);
+        bias_stream << get_simd_intrinsic("srli") << "(" <<
+          get_simd_intrinsic("srai") << "(" << lhs_register << "," <<
+          bits - 1 << ")," << bits - shift << ")";
+        string bias_register = new_simd_register(bias_stream.str());
+        bias_stream.str("");
+        bias_stream << get_simd_intrinsic("add") << "(" << lhs_register <<
+          "," << bias_register << ")";
+        lhs_register = new_simd_register(bias_stream.str());
+        curr_stream << get_simd_intrinsic("srai");
+      }
+      curr_stream << "(" << lhs_register << "," << shift << ")";
+    }
+    else{
+      string rhs_register =
+        print_simd_expr(curr_op->get_rhs_expr(),fn_bindings);
+      string op_name;
+      switch(op){
+      case O_PLUS:
+        op_name = "add";
+        break;
+      case O_MINUS:
+        op_name = "sub";
+        break;
+      case O_MULT:
+        op_name = ( is_integer ? "mullo" : "mul" );
+        break;
+      case O_DIV:
+        op_name = "div";
+        break;
+      default:
+        assert
+          (0 && "[ME] : Within Code-generator : Unsupported vector operation");
+      }
+      curr_stream << get_simd_intrinsic(op_name) << "(" << lhs_register <<
+        "," << rhs_register << ")";
+    }
+    string result_register = new_simd_register(curr_stream.str());
+    if( is_integer )
+      result_register =
+        print_simd_int_conversion
+        (curr_expr,result_register,curr_expr->get_data_type().type,true);
+    return result_register;
+  }
+  case S_STENCILOP: {
+    const stencil_op_node* curr_stencil_op =
+      static_cast<const stencil_op_node*>(curr_expr);
+    const c_symbol_info* curr_symbol =
+      fn_bindings.GetSymbolInfo(curr_stencil_op->get_var());
+    string curr_access =
+      print_stencil_op_helper
+      (curr_symbol,curr_stencil_op->get_scale_fn(),
+       curr_stencil_op->get_base_type(),curr_stencil_op->get_access_field(),
+       false);
+    if( curr_symbol->var->expr_domain == NULL ||
+        curr_symbol->var->expr_domain->get_dim() == 0 ){
+      curr_stream << get_simd_intrinsic("set1") << "((" << scalar_type << ")" <<
+        curr_access << ")";
+      return curr_stream.str();
+    }
+
+    /// Each point is loaded once per vector iteration
+    map<string,string>::const_iterator curr_load =
+      simd_loads.find(curr_access);
+    if( curr_load != simd_loads.end() )
+      return curr_load->second;
+    string load_register =
+      print_simd_load(curr_access,curr_stencil_op->get_base_type().type);
+    simd_loads.insert(make_pair(curr_access,load_register));
+    return load_register;
+  }
+  default:
+    assert(0 && "[ME] : Within Code-generator : Unsupported vector expression");
+  }
+  return "";
+}
+
+
+///-----------------------------------------------------------------------------
+/// Both values are computed for all elements, and the comparison selects
+/// between them. Integer comparisons other than AVX-512 only provide signed
+/// greater than and equal to, the others are computed by swapping the
+/// operands or the values selected. Unsigned int8 elements are compared after
+/// flipping their sign bit
+string PrintC::print_simd_ternary
+(const ternary_expr_node* curr_expr, c_symbol_table& fn_bindings)
+{
+  const expr_op_node* curr_cond =
+    static_cast<const expr_op_node*>(curr_expr->get_bool_expr());
+  string lhs_register = print_simd_expr(curr_cond->get_lhs_expr(),fn_bindings);
+  string rhs_register = print_simd_expr(curr_cond->get_rhs_expr(),fn_bindings);
+  string true_register =
+    print_simd_expr(curr_expr->get_true_expr(),fn_bindings);
+  string false_register =
+    print_simd_expr(curr_expr->get_false_expr(),fn_bindings);
+
+  bool is_avx512 = ( simd_isa.compare("avx512") == 0 );
+  bool is_int = ValueRangeAnalysis::is_integer_type(simd_type);
+  stringstream cond_stream;
+  if( is_avx512 || ( !is_int && simd_isa.compare("avx2") == 0 ) ){
+    string predicate;
+    switch(curr_cond->get_op()){
+    case O_LT:
+      predicate = ( is_int ? "_MM_CMPINT_LT" : "_CMP_LT_OQ" );
+      break;
+    case O_GT:
+      predicate = ( is_int ? "_MM_CMPINT_NLE" : "_CMP_GT_OQ" );
+      break;
+    case O_LE:
+      predicate = ( is_int ? "_MM_CMPINT_LE" : "_CMP_LE_OQ" );
+      break;
+    case O_GE:
+      predicate = ( is_int ? "_MM_CMPINT_NLT" : "_CMP_GE_OQ" );
+      break;
+    case O_EQ:
+      predicate = ( is_int ? "_MM_CMPINT_EQ" : "_CMP_EQ_OQ" );
+      break;
+    default:
+      predicate = ( is_int ? "_MM_CMPINT_NE" : "_CMP_NEQ_UQ" );
+      break;
+    }
+    cond_stream <<
+      ( simd_type == T_INT8 ? "_mm512_cmp_epu8" : get_simd_intrinsic("cmp") ) <<
+      ( is_avx512 ? "_mask" : "" ) << "(" << lhs_register << "," <<
+      rhs_register << "," << predicate << ")";
+  }
+  else if( !is_int ){
+    string cmp_name;
+    switch(curr_cond->get_op()){
+    case O_LT:
+      cmp_name = "cmplt";
+      break;
+    case O_GT:
+      cmp_name = "cmpgt";
+      break;
+    case O_LE:
+      cmp_name = "cmple";
+      break;
+    case O_GE:
+      cmp_name = "cmpge";
+      break;
+    case O_EQ:
+      cmp_name = "cmpeq";
+      break;
+    default:
+      cmp_name = "cmpneq";
+      break;
+    }
+    cond_stream << get_simd_intrinsic(cmp_name) << "(" << lhs_register << ","
+                << rhs_register << ")";
+  }
+  else{
+    operator_type curr_op = curr_cond->get_op();
+    if( curr_op == O_LE || curr_op == O_GE || curr_op == O_NE )
+      swap(true_register,false_register);
+    if( curr_op == O_LT || curr_op == O_GE )
+      swap(lhs_register,rhs_register);
+    bool is_equality = ( curr_op == O_EQ || curr_op == O_NE );
+    if( simd_type == T_INT8 && !is_equality ){
+      stringstream flip_stream;
+      flip_stream << get_simd_intrinsic("xor",T_STRUCT) << "(" <<
+        lhs_register << "," << get_simd_intrinsic("set1") << "((char)0x80))";
+      lhs_register = new_simd_register(flip_stream.str());
+      flip_stream.str("");
+      flip_stream << get_simd_intrinsic("xor",T_STRUCT) << "(" <<
+        rhs_register << "," << get_simd_intrinsic("set1") << "((char)0x80))";
+      rhs_register = new_simd_register(flip_stream.str());
+    }
+    cond_stream <<
+      get_simd_intrinsic( is_equality ? "cmpeq" : "cmpgt" ) << "(" <<
+      lhs_register << "," << rhs_register << ")";
+  }
+
+  stringstream curr_stream;
+  if( is_avx512 ){
+    curr_stream << get_simd_intrinsic("mask_blend") << "(" <<
+      cond_stream.str() << "," << false_register << "," << true_register << ")";
+  }
+  else{
+    /// The comparison sets all bits of the selected elements
+    curr_stream << get_simd_intrinsic("blendv",( is_int ? T_INT8 : simd_type ))
+                << "(" << false_register << "," <<
+      true_register << "," << cond_stream.str() << ")";
+  }
+  return new_simd_register(curr_stream.str());
+}
+
+
+///-----------------------------------------------------------------------------
+/// function to print the stencil function body for a vector of points
+void PrintC::print_simd_stencilfn_body
+( const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
+  c_symbol_info* output_symbol)
+{
+  const stencilfn_defn_node* curr_stencil =
+    static_cast<const stencilfn_defn_node*>(curr_fn->get_defn());
+  const deque<vector_defn_node*>& fn_params = curr_stencil->get_args();
+  c_symbol_table fn_bindings;
+  deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+  for( deque<c_symbol_info*>::iterator symbol_iter = input_exprs.begin(),
+         symbol_end = input_exprs.end() ; symbol_iter != symbol_end ;
+       symbol_iter++, param_iter++)
+    fn_bindings.symbol_table.insert(make_pair(*param_iter,*symbol_iter));
+
+  const deque<pt_stmt_node*>& fn_body = curr_stencil->get_body();
+  for( deque<pt_stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    string curr_register = print_simd_expr((*it)->get_rhs(),fn_bindings);
+    simd_scalars[(*it)->get_lhs()] = curr_register;
+  }
+  string result_register =
+    print_simd_expr(curr_stencil->get_return_expr(),fn_bindings);
+  basic_data_types output_type = output_symbol->var->elem_type.type;
+  if( ValueRangeAnalysis::is_integer_type(output_type) )
+    result_register =
+      print_simd_int_conversion
+      (curr_stencil->get_return_expr(),result_register,output_type,false);
+
+  stringstream output_stream;
+  if( output_symbol->offset_domain )
+    print_domain_point
+      (output_symbol->var,output_stream,output_symbol->offset_domain);
+  else
+    print_domain_point(output_symbol->var,output_stream);
+  print_simd_store(output_stream.str(),result_register,output_type);
+
+  simd_loads.clear();
+  simd_scalars.clear();
+  /// Not de-allocating the symbols since they need to be reused.
+  fn_bindings.symbol_table.clear();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Function to generate the body of the vector function
+void PrintC::print_vectorfn_body
+(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
+ deque<const domain_node*>& arg_domains, c_symbol_info* curr_output_symbol)
+{
+  fn_defn_node* fn_defn = curr_fn->get_defn();
+  assert
+    (dynamic_cast<vectorfn_defn_node*>(fn_defn) &&
+     "Calling generator of vector fn body for non-vector function");
+  vectorfn_defn_node* curr_vector_fn= static_cast<vectorfn_defn_node*>(fn_defn);
+  const deque<vector_defn_node*> fn_params = curr_vector_fn->get_args();
+  assert
+    (input_exprs.size() == fn_params.size()
+     && "Number of input symbols doesnt match number of vector fn params");
+  /// Add the input exprs to the symbol table of the vector fn body
+  c_symbol_table new_fn_bindings;
+  deque<vector_defn_node*>::const_iterator fn_params_iter = fn_params.begin();
+  for( deque<c_symbol_info*>::iterator symbol_iter = input_exprs.begin(),
+         symbol_end = input_exprs.end() ; symbol_iter != symbol_end ;
+       symbol_iter++, fn_params_iter++){
+    new_fn_bindings.symbol_table.insert
+      (make_pair(*fn_params_iter,*symbol_iter));
+  }
+
+  ///Need to recompute the domain of expressions within the vector
+  ///function based ont he domain of the arguments
+  curr_vector_fn->compute_domain(arg_domains);
+  new_fn_bindings.AddSymbol
+    (static_cast<const vectorfn_defn_node*>(fn_defn)->get_return_expr(),
+     curr_output_symbol->var, curr_output_symbol->scale_domain,
+     curr_output_symbol->offset_domain, curr_output_symbol->field_name);
+  print_vectorfn_body_helper(curr_vector_fn,new_fn_bindings,true);
+
+  /// Remove the input_exprs from the symbol table, they are deallocated later
+  fn_params_iter = fn_params.begin();
+  for(deque<vector_defn_node*>::const_iterator fn_params_end= fn_params.end();
+      fn_params_iter != fn_params_end ; fn_params_iter++ ){
+    map<const vector_expr_node*,c_symbol_info*>::iterator var =
+      new_fn_bindings.symbol_table.find(*fn_params_iter);
+    new_fn_bindings.symbol_table.erase(*fn_params_iter);
+  }
+}
+
+
+
+///-----------------------------------------------------------------------------
+/// Generate code for function applications
+void PrintC::print_fn_body
+(const fnid_expr_node* curr_fn, deque<c_symbol_info*>& input_exprs,
+ deque<const domain_node*>& arg_domains, c_symbol_info* curr_output_symbol)
+{
+  fn_defn_node* fn_defn = curr_fn->get_defn();
+
+  if( dynamic_cast<const stencilfn_defn_node*>(fn_defn) ){
+
+    ////Stencil fns are inlined by default.
+    stencilfn_defn_node* curr_stencil =
+      dynamic_cast<stencilfn_defn_node*>(fn_defn);
+
+    ///The domain of the stencil, the function compute_domain sets the domain of
+    ///all parameters to those in arg_domains
+    const domain_node* stencil_domain =
+      curr_stencil->compute_domain(arg_domains);
+
+    /// Compute the interior of the loop domain
+    deque<offset_hull> interior_offset;
+    computeOffsets(curr_fn,interior_offset,curr_output_symbol->scale_domain);
+    domain_node* interior_loop_domain = new domain_node(stencil_domain);
+    ApplyOffset(interior_loop_domain,interior_offset);
+
+    /// Compute the exterior of the loop domain
+    deque<offset_hull> exterior_offset;
+    computeOffsets
+      (curr_fn,exterior_offset,curr_output_symbol->scale_domain,true);
+    domain_node* exterior_loop_domain = new domain_node(stencil_domain);
+    ApplyOffset(exterior_loop_domain,exterior_offset);
+
+    /// Only the window needed for the region of interest is computed
+    map<const vector_expr_node*,domain_node*>::const_iterator curr_window =
+      roi_windows.find(curr_fn);
+    if( curr_window != roi_windows.end() )
+      roi_window = curr_window->second;
+
+    /// The edges are specialized when the interior is not empty along any
+    /// dimension that has them, points of an edge are then within the bound
+    /// of the other side. Otherwise the edges are generated with all checks
+    /// and restricted to the domain, there are no points in the interior
+    stringstream guard_stream;
+    for( int i = 0 ; i < stencil_domain->get_dim() && specialize_bdys ; i++ ){
+      const range_coeffs& exterior_range = exterior_loop_domain->range_list[i];
+      const range_coeffs& interior_range = interior_loop_domain->range_list[i];
+      if( parametric_exp::is_equal(exterior_range.lb,interior_range.lb) &&
+          parametric_exp::is_equal(exterior_range.ub,interior_range.ub) )
+        continue;
+      guard_stream << ( guard_stream.str().empty() ? "" : " && " ) << "(";
+      PrintCParametricExpr(interior_range.lb,guard_stream);
+      guard_stream << ") <= (";
+      PrintCParametricExpr(interior_range.ub,guard_stream);
+      guard_stream << ") + 1";
+    }
+    bool orig_one_sided_checks = one_sided_checks;
+    bool orig_skip_interior_patch = skip_interior_patch;
+    one_sided_checks = !guard_stream.str().empty();
+    skip_interior_patch = false;
+    if( one_sided_checks ){
+      output_buffer->indent();
+      output_buffer->buffer << "if( " << guard_stream.str() << " ){";
+      output_buffer->newline();
+      output_buffer->increaseIndent();
+    }
+
+    domain_node* loop_domain = new domain_node();
+    printPatches
+      (curr_fn,input_exprs,curr_output_symbol,loop_domain,exterior_loop_domain,
+       interior_loop_domain, 0, stencil_domain->get_dim(), false);
+    one_sided_checks = false;
+
+    if( !guard_stream.str().empty() ){
+      output_buffer->decreaseIndent();
+      output_buffer->indent();
+      output_buffer->buffer << "}";
+      output_buffer->newline();
+      output_buffer->indent();
+      output_buffer->buffer << "else{";
+      output_buffer->newline();
+      output_buffer->increaseIndent();
+      skip_interior_patch = true;
+      printPatches
+        (curr_fn,input_exprs,curr_output_symbol,loop_domain,
+         exterior_loop_domain,interior_loop_domain,0,stencil_domain->get_dim(),
+         false);
+      output_buffer->decreaseIndent();
+      output_buffer->indent();
+      output_buffer->buffer << "}";
+      output_buffer->newline();
+    }
+    one_sided_checks = orig_one_sided_checks;
+    skip_interior_patch = orig_skip_interior_patch;
+    roi_window = NULL;
+    delete loop_domain;
+    delete exterior_loop_domain;
+    delete interior_loop_domain;
+  }
+  else{
+    print_vectorfn_body(curr_fn,input_exprs,arg_domains,curr_output_symbol);
+  }
+}
+
+
+
+///-----------------------------------------------------------------------------
+/// Generate code for a function application expressions
+void PrintC::print_fnid_expr
+(const fnid_expr_node* curr_fn,c_symbol_table& fn_bindings){
+  /// Stencils that read fused producers are generated a tile at a time
+  if( fuse_stencils && tile_window_lb == NULL ){
+    const deque<arg_info>& curr_args = curr_fn->get_args();
+    for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+         it != curr_args.end() ; it++ ){
+      if( it->arg_expr->get_type() != VEC_ID )
+        continue;
+      const set<vector_expr_node*>& curr_defn_set =
+        static_cast<const vec_id_expr_node*>(it->arg_expr)->get_defn();
+      if( curr_defn_set.size() == 1 &&
+          fused_producers.count
+          (dynamic_cast<const stmt_node*>(*curr_defn_set.begin())) ){
+        print_fused_stencils(curr_fn,fn_bindings);
+        return;
+      }
+    }
+  }
+
+  deque<c_symbol_info*> arg_symbols;
+  deque<const domain_node*> arg_domains;
+
+  /// Initialize the arguments
+  bool is_tiled =
+    init_fn_args(curr_fn,fn_bindings,arg_symbols,arg_domains);
+
+  /// Generate code for the function body
+  c_symbol_info* output_symbol = fn_bindings.GetSymbolInfo(curr_fn);
+  print_fn_body(curr_fn,arg_symbols,arg_domains,output_symbol);
+  for( deque<const domain_node*>::iterator it = arg_domains.begin() ;
+       it != arg_domains.end() ; it++ )
+    delete (*it);
+  arg_domains.clear();
+  deleteArgSymbols(arg_symbols);
+}
+
+
+///-----------------------------------------------------------------------------
+/// Check if the function application is a stencil that can be computed a tile
+/// at a time. All vector arguments must be references to computed values
+bool PrintC::check_fusible_stencil(const fnid_expr_node* curr_fn) const
+{
+  if( !dynamic_cast<const stencilfn_defn_node*>(curr_fn->get_defn()) ||
+      curr_fn->get_dim() == 0 || curr_fn->get_sub_domain() )
+    return false;
+  const deque<arg_info>& curr_args = curr_fn->get_args();
+  for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+       it != curr_args.end() ; it++ ){
+    if( it->arg_expr->get_dim() != 0 && it->arg_expr->get_type() != VEC_ID )
+      return false;
+  }
+  return true;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Check if the value computed by the statement is read only by a single
+/// stencil application such that it can be recomputed within the tiles of its
+/// consumer
+bool PrintC::check_fusible_producer(const stmt_node* curr_stmt) const
+{
+  if( curr_stmt->get_type() != VEC_STMT || curr_stmt->get_scale_domain() ||
+      curr_stmt->get_sub_domain() || curr_stmt->get_rhs()->get_type() != VEC_FN )
+    return false;
+  const fnid_expr_node* producer =
+    static_cast<const fnid_expr_node*>(curr_stmt->get_rhs());
+  if( !check_fusible_stencil(producer) )
+    return false;
+
+  /// The only use has to be a plain reference passed to a stencil
+  const deque<vector_expr_node*>& stmt_uses = curr_stmt->get_usage();
+  if( stmt_uses.size() != 1 || stmt_uses.front()->get_type() != VEC_ID )
+    return false;
+  const vec_id_expr_node* curr_use =
+    static_cast<const vec_id_expr_node*>(stmt_uses.front());
+  if( curr_use->get_sub_domain() || curr_use->get_access_field() != -1 ||
+      curr_use->get_access_iterator() ||
+      curr_use->get_usage().size() != 1 ||
+      curr_use->get_usage().front()->get_type() != VEC_FN )
+    return false;
+  const fnid_expr_node* consumer =
+    static_cast<const fnid_expr_node*>(curr_use->get_usage().front());
+  if( !check_fusible_stencil(consumer) ||
+      consumer->get_dim() != producer->get_dim() )
+    return false;
+
+  /// The consumer must write its output directly to a statement
+  const deque<vector_expr_node*>& consumer_uses = consumer->get_usage();
+  if( consumer_uses.size() != 1 ||
+      consumer_uses.front()->get_type() != VEC_STMT )
+    return false;
+  const stmt_node* consumer_stmt =
+    static_cast<const stmt_node*>(consumer_uses.front());
+  if( consumer_stmt->get_scale_domain() || consumer_stmt->get_sub_domain() )
+    return false;
+
+  /// Find the parameter bound to the use. Points read along the outermost
+  /// dimension have to lie within the halo of the tile, which rules out
+  /// sampled accesses and wrap-around boundaries
+  const deque<vector_defn_node*>& fn_params = consumer->get_defn()->get_args();
+  deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+  const deque<arg_info>& consumer_args = consumer->get_args();
+  for( deque<arg_info>::const_iterator it = consumer_args.begin() ;
+       it != consumer_args.end() ; it++, param_iter++ ){
+    if( it->arg_expr != curr_use )
+      continue;
+    if( it->bdy_condn && it->bdy_condn->type == B_WRAP )
+      return false;
+    const deque<offset_hull>& access_info = (*param_iter)->get_access_info();
+    if( access_info.empty() || access_info.front().scale != 1 )
+      return false;
+    return true;
+  }
+  return false;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Count the stencil applications computed within a tile for the statement,
+/// used to limit the depth of time tiles of iterated stencils
+int PrintC::get_fused_steps(const stmt_node* curr_stmt) const
+{
+  int num_steps = 0;
+  const deque<arg_info>& curr_args =
+    static_cast<const fnid_expr_node*>(curr_stmt->get_rhs())->get_args();
+  for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+       it != curr_args.end() ; it++ ){
+    if( it->arg_expr->get_type() != VEC_ID )
+      continue;
+    const set<vector_expr_node*>& curr_defn_set =
+      static_cast<const vec_id_expr_node*>(it->arg_expr)->get_defn();
+    const stmt_node* curr_producer =
+      dynamic_cast<const stmt_node*>(*curr_defn_set.begin());
+    if( curr_defn_set.size() == 1 && fused_producers.count(curr_producer) )
+      num_steps = MAX(num_steps,get_fused_steps(curr_producer));
+  }
+  return num_steps + 1;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Collect the producers fused into a stencil application, in the order they
+/// have to be computed within a tile
+void PrintC::collect_fused_stages
+(const fnid_expr_node* curr_fn, const offset_hull& halo,
+ deque<const stmt_node*>& stages, deque<offset_hull>& stage_halos)
+{
+  const deque<vector_defn_node*>& fn_params = curr_fn->get_defn()->get_args();
+  deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+  const deque<arg_info>& curr_args = curr_fn->get_args();
+  for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+       it != curr_args.end() ; it++, param_iter++ ){
+    if( it->arg_expr->get_type() != VEC_ID )
+      continue;
+    const set<vector_expr_node*>& curr_defn_set =
+      static_cast<const vec_id_expr_node*>(it->arg_expr)->get_defn();
+    const stmt_node* curr_producer =
+      dynamic_cast<const stmt_node*>(*curr_defn_set.begin());
+    if( curr_defn_set.size() != 1 || !fused_producers.count(curr_producer) )
+      continue;
+
+    /// The producer has to cover the points of the tile, extended by the
+    /// offsets used to access it
+    const offset_hull& access_hull = (*param_iter)->get_access_info().front();
+    offset_hull producer_halo
+      (halo.max_negetive + access_hull.max_negetive,
+       halo.max_positive + access_hull.max_positive);
+    collect_fused_stages
+      (static_cast<const fnid_expr_node*>(curr_producer->get_rhs()),
+       producer_halo, stages, stage_halos);
+    stages.push_back(curr_producer);
+    stage_halos.push_back(producer_halo);
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Generate a loop over tiles of the outermost dimension of a stencil
+/// application. Within each tile the fused producers are computed over the
+/// tile and its halo into buffers private to each thread, and then the
+/// stencil itself is computed over the tile
+void PrintC::print_fused_stencils
+(const fnid_expr_node* curr_fn, c_symbol_table& fn_bindings)
+{
+  deque<const stmt_node*> stages;
+  deque<offset_hull> stage_halos;
+  collect_fused_stages(curr_fn,offset_hull(0,0),stages,stage_halos);
+
+  /// Find the stage that reads each producer, the stencil being generated
+  /// reads the producers that are not read by any other stage
+  int num_stages = stages.size();
+  deque<int> stage_consumers(num_stages, num_stages);
+  for( int i = 0 ; i < num_stages ; i++ ){
+    for( int j = i + 1 ; j < num_stages && stage_consumers[i] == num_stages ;
+         j++ ){
+      const deque<arg_info>& consumer_args =
+        static_cast<const fnid_expr_node*>(stages[j]->get_rhs())->get_args();
+      for( deque<arg_info>::const_iterator it = consumer_args.begin() ;
+           it != consumer_args.end() ; it++ ){
+        if( it->arg_expr->get_type() == VEC_ID &&
+            static_cast<const vec_id_expr_node*>(it->arg_expr)->get_defn().
+            count(const_cast<stmt_node*>(stages[i])) ){
+          stage_consumers[i] = j;
+          break;
+        }
+      }
+    }
+  }
+
+  /// Assign a window buffer to each producer. A buffer is reused once the
+  /// stage that reads its previous contents has been computed, which for
+  /// iterated stencils alternates between two buffers
+  deque<int> slot_rows, slot_free_after, slot_stage;
+  deque<int> stage_slots;
+  for( int i = 0 ; i < num_stages ; i++ ){
+    int curr_rows =
+      fusion_tile_size + stage_halos[i].max_positive -
+      stage_halos[i].max_negetive;
+    const domain_node* curr_domain = stages[i]->get_expr_domain();
+    int curr_slot = 0;
+    for( ; curr_slot < (int)slot_rows.size() ; curr_slot++ ){
+      if( slot_free_after[curr_slot] >= i )
+        continue;
+      const stmt_node* slot_defn = stages[slot_stage[curr_slot]];
+      const domain_node* slot_domain = slot_defn->get_expr_domain();
+      if( get_string(slot_defn->get_data_type()).compare
+          (get_string(stages[i]->get_data_type())) != 0 ||
+          slot_domain->get_dim() != curr_domain->get_dim() )
+        continue;
+      bool same_size = true;
+      for( int d = 1 ; d < curr_domain->get_dim() && same_size ; d++ ){
+        same_size =
+          parametric_exp::is_equal
+          (slot_domain->range_list[d].lb,curr_domain->range_list[d].lb) &&
+          parametric_exp::is_equal
+          (slot_domain->range_list[d].ub,curr_domain->range_list[d].ub);
+      }
+      if( same_size )
+        break;
+    }
+    if( curr_slot == (int)slot_rows.size() ){
+      slot_rows.push_back(curr_rows);
+      slot_free_after.push_back(stage_consumers[i]);
+      slot_stage.push_back(i);
+    }
+    else{
+      slot_rows[curr_slot] = MAX(slot_rows[curr_slot],curr_rows);
+      slot_free_after[curr_slot] = stage_consumers[i];
+    }
+    stage_slots.push_back(curr_slot);
+  }
+
+  /// Allocate the buffers, one window per thread. Tiles computed by tasks
+  /// are not bound to a thread, each of them allocates its own windows
+  deque<string> slot_names, slot_sizes, slot_mallocs;
+  for( int curr_slot = 0 ; curr_slot < (int)slot_rows.size() ; curr_slot++ ){
+    const stmt_node* slot_defn = stages[slot_stage[curr_slot]];
+    string elem_type_string = get_string(slot_defn->get_data_type());
+    domain_node* window_domain = new domain_node(slot_defn->get_expr_domain());
+    range_coeffs& outer_range = window_domain->range_list.front();
+    delete outer_range.lb;
+    delete outer_range.ub;
+    outer_range.lb = new int_expr(0);
+    outer_range.ub = new int_expr(slot_rows[curr_slot] - 1);
+    stringstream size_stream;
+    size_stream << "sizeof(" << elem_type_string << ")*";
+    PrintCDomainSize(window_domain,size_stream);
+    delete window_domain;
+
+    string slot_name = get_new_var();
+    stringstream malloc_stream;
+    malloc_stream << elem_type_string << " * " << slot_name << " = (" <<
+      elem_type_string << "*)malloc(" << size_stream.str() << ");";
+    slot_names.push_back(slot_name);
+    slot_sizes.push_back(size_stream.str());
+    slot_mallocs.push_back(malloc_stream.str());
+  }
+  if( !use_omp_tasks )
+    print_window_buffers(slot_names,slot_mallocs,true);
+
+  deque<c_var_info*> stage_vars;
+  deque<string> stage_sizes;
+  for( int i = 0 ; i < num_stages ; i++ ){
+    c_var_info* new_var =
+      new c_var_info
+      (slot_names[stage_slots[i]],stages[i]->get_expr_domain(),
+       stages[i]->get_data_type());
+    def_vars.push_back(new_var);
+    stage_vars.push_back(new_var);
+    stage_sizes.push_back(slot_sizes[stage_slots[i]]);
+  }
+
+  /// Loop over the tiles
+  const range_coeffs& tile_range = curr_fn->get_expr_domain()->range_list[0];
+  string tile_var =
+    printTileHeader(tile_range.lb,tile_range.ub,fusion_tile_size);
+  if( use_omp_tasks )
+    print_window_buffers(slot_names,slot_mallocs,true);
+  parameter_defn tile_param(tile_var.c_str());
+  bool orig_omp_pragmas = generate_omp_pragmas;
+  generate_omp_pragmas = false;
+
+  /// Compute the producers over the tile and its halo
+  deque<offset_hull>::iterator halo_iter = stage_halos.begin();
+  deque<c_var_info*>::iterator var_iter = stage_vars.begin();
+  deque<string>::iterator size_iter = stage_sizes.begin();
+  for( deque<const stmt_node*>::iterator it = stages.begin() ;
+       it != stages.end() ; it++, halo_iter++, var_iter++, size_iter++ ){
+    tile_window_lb = new param_expr(&tile_param);
+    tile_window_lb = tile_window_lb->add(halo_iter->max_negetive);
+    tile_window_ub = new param_expr(&tile_param);
+    tile_window_ub =
+      tile_window_ub->add(fusion_tile_size - 1 + halo_iter->max_positive);
+
+    stringstream offset_stream;
+    PrintCParametricExpr(tile_window_lb,offset_stream);
+    (*var_iter)->window_offset = offset_stream.str();
+
+    if( init_zero ){
+      output_buffer->indent();
+      output_buffer->buffer << "memset(" << (*var_iter)->symbol_name <<
+        ",0," << (*size_iter) << ");";
+      output_buffer->newline();
+    }
+
+    const vector_expr_node* producer_rhs = (*it)->get_rhs();
+    fn_bindings.AddSymbol(producer_rhs,*var_iter,NULL,NULL,"");
+    print_fnid_expr
+      (static_cast<const fnid_expr_node*>(producer_rhs),fn_bindings);
+    fn_bindings.RemoveSymbol(producer_rhs);
+    fn_bindings.AddSymbol(*it,*var_iter,NULL,NULL,"");
+
+    delete tile_window_lb;
+    delete tile_window_ub;
+  }
+
+  /// Compute the consumer over the tile
+  tile_window_lb = new param_expr(&tile_param);
+  tile_window_ub = new param_expr(&tile_param);
+  tile_window_ub = tile_window_ub->add(fusion_tile_size - 1);
+  print_fnid_expr(curr_fn,fn_bindings);
+  delete tile_window_lb;
+  delete tile_window_ub;
+  tile_window_lb = NULL;
+  tile_window_ub = NULL;
+
+  generate_omp_pragmas = orig_omp_pragmas;
+  if( use_omp_tasks )
+    print_window_buffers(slot_names,slot_mallocs,false);
+  output_buffer->decreaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << "}";
+  output_buffer->newline();
+
+  /// The producers are not used outside the fused loop nest
+  for( deque<const stmt_node*>::iterator it = stages.begin() ;
+       it != stages.end() ; it++ ){
+    fn_bindings.RemoveSymbol(*it);
+  }
+  if( !use_omp_tasks )
+    print_window_buffers(slot_names,slot_mallocs,false);
+}
+
+
+///-----------------------------------------------------------------------------
+/// Print the allocation, or the release, of the windows of fused producers
+void PrintC::print_window_buffers
+(const deque<string>& slot_names, const deque<string>& slot_mallocs,
+ bool allocate)
+{
+  for( int i = 0 ; i < (int)slot_names.size() ; i++ ){
+    output_buffer->indent();
+    if( allocate )
+      output_buffer->buffer << slot_mallocs[i];
+    else
+      output_buffer->buffer << "free(" << slot_names[i] << ");";
+    output_buffer->newline();
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_domainfn_expr
+(const vec_domainfn_node* curr_domainfn, c_symbol_table& fn_bindings)
+{
+  ///Get the output symbol to be used for the RHS
+  const c_symbol_info* curr_output_symbol =
+    fn_bindings.GetSymbolInfo(curr_domainfn);
+  const domain_node* expr_domain = curr_output_symbol->var->expr_domain;
+
+  ///Precompute the base expression
+  const vector_expr_node* base_expr = curr_domainfn->get_base_expr();
+  init_rhs
+    (base_expr,curr_domainfn->get_expr_domain(),
+     output_buffer->buffer,fn_bindings);
+  c_symbol_info* base_symbol = FindDefnSymbol(base_expr,fn_bindings);
+  assert(base_symbol != NULL &&
+         "Couldnt find symbol for base of domainfn expr");
+
+  const domainfn_node* scale_domain = curr_domainfn->get_scale_fn();
+
+  //Compute the loop domain
+  domain_node* loop_domain = new domain_node(curr_domainfn->get_expr_domain());
+  // printf("Loop Domain Before : ");
+  // loop_domain->print_node(stdout);
+  // printf("\n");
+  // printf("Scale Domain : ");
+  // scale_domain->print_node(stdout);
+  // printf("\n");
+  // printf("Expr Domain : ");
+  // curr_domainfn->get_expr_domain()->print_node(stdout);
+  // printf("\n");
+  deque<range_coeffs>::iterator it = loop_domain->range_list.begin();
+  deque<scale_coeffs>::const_iterator jt = scale_domain->scale_fn.begin();
+  for( ; it != loop_domain->range_list.end() ; it++,jt++ ){
+    it->lb = it->lb->add(-MIN(0,FLOOR(jt->offset,jt->scale)));
+    it->ub = it->ub->subtract(MAX(0,FLOOR(jt->offset,jt->scale)));
+  }
+  ///Only the window needed for the region of interest is computed
+  map<const vector_expr_node*,domain_node*>::const_iterator curr_window =
+    roi_windows.find(curr_domainfn);
+  if( curr_window != roi_windows.end() ){
+    deque<range_coeffs>::const_iterator window_range =
+      curr_window->second->range_list.begin();
+    for( it = loop_domain->range_list.begin() ;
+         it != loop_domain->range_list.end() ; it++, window_range++ ){
+      it->lb = it->lb->max(window_range->lb);
+      it->ub = it->ub->min(window_range->ub);
+    }
+  }
+  // printf("Loop Domain : ");
+  // loop_domain->print_node(stdout);
+  // printf("\n");
+
+  ///Print the surrounding loops, iterate through points of the result domain in
+  ///this case
+  deque<c_symbol_info*> input_exprs;
+  input_exprs.push_back(base_symbol);
+  deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
+  print_domain_loops_header
+    (loop_domain, input_exprs, curr_output_symbol->var,
+     curr_output_symbol->scale_domain, curr_unroll_factors);
+
+  ///Print the LHS reference
+  output_buffer->indent();
+  stringstream rhs_stream;
+  print_rhs_var
+    (base_expr,rhs_stream,fn_bindings,curr_domainfn->get_sub_domain(),
+     scale_domain);
+  string rhs_string = rhs_stream.str();
+  print_assignment_stmt(curr_output_symbol,rhs_string,output_buffer->buffer);
+  output_buffer->newline();
+
+  ///Finish the loop
+  print_domain_loops_footer(loop_domain, curr_unroll_factors);
+
+  delete loop_domain;
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_make_struct
+(const make_struct_node* curr_struct_node, c_symbol_table& fn_bindings)
+{
+  const c_symbol_info* curr_output_symbol =
+    fn_bindings.GetSymbolInfo(curr_struct_node);
+  const deque<vector_expr_node*>& field_inputs =
+    curr_struct_node->get_field_inputs();
+
+  int field_num = 0;
+  for( deque<vector_expr_node*>::const_iterator it = field_inputs.begin() ;
+       it != field_inputs.end() ; it++, field_num++ ){
+    assert(curr_output_symbol->field_name.compare("") == 0 &&
+           curr_struct_node->get_base_type().type == T_STRUCT &&
+           curr_struct_node->get_base_type().struct_info);
+
+    ///Set the output variable of the RHS variable, with the same information as
+    ///the LHS, but updated field_num
+    fn_bindings.AddSymbol
+      (*it,curr_output_symbol->var, curr_output_symbol->scale_domain,
+       curr_output_symbol->offset_domain,
+       curr_struct_node->get_base_type().
+       struct_info->fields[field_num].field_name);
+    print_vector_expr(*it,fn_bindings);
+    fn_bindings.RemoveSymbol(*it);
+  }
+
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_compose_expr
+(const compose_expr_node* curr_compose_expr, c_symbol_table& fn_bindings)
+{
+  const c_symbol_info* curr_output_symbol =
+    fn_bindings.GetSymbolInfo(curr_compose_expr);
+  const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
+    curr_compose_expr->get_expr_list();
+
+  for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
+         expr_list.begin() ; it != expr_list.end() ; it++ ){
+    const vector_expr_node* curr_expr = it->second;
+    ///if the rhs expression is a scalar, craete a loop to iterate throught the
+    ///specified domain
+    if( curr_expr->get_dim() == 0 ){
+      const domain_node* curr_domain =
+        dynamic_cast<const domain_node*>(it->first);
+      assert(curr_domain);
+      c_symbol_info* curr_expr_symbol = FindDefnSymbol(curr_expr,fn_bindings);
+
+      deque<c_symbol_info*> input_exprs;
+      input_exprs.push_back(curr_expr_symbol);
+      deque<int> curr_unroll_factors(curr_domain->get_dim(), 1);
+      print_domain_loops_header
+        (curr_domain, input_exprs, curr_output_symbol->var,
+         curr_output_symbol->scale_domain, curr_unroll_factors);
+
+      output_buffer->indent();
+      string rhs_string;
+      if( it->second->get_type() == VEC_SCALAR )
+        rhs_string =
+          print_value_expr(static_cast<const expr_node*>(it->second));
+      else{
+        assert
+          (it->second->get_type() == VEC_ID &&
+           "Scalar expression is not a number or an ID");
+        rhs_string = curr_expr_symbol->var->symbol_name;
+      }
+      print_assignment_stmt
+        (curr_output_symbol,rhs_string,output_buffer->buffer);
+      output_buffer->newline();
+      print_domain_loops_footer(curr_domain, curr_unroll_factors);
+    }
+    else{
+      ///The the output symbol already has a scale domain, cant carry forward
+      ///the symbol, compute the expression here
+      if( curr_output_symbol->scale_domain ){
+
+        ///Precompute the RHS expression and set the scale or offset domain
+        ///appropriately
+        if( dynamic_cast<const domainfn_node*>(it->first))
+          init_rhs
+            (it->second,it->second->get_expr_domain(),output_buffer->buffer,
+             fn_bindings,static_cast<const domainfn_node*>(it->first),NULL);
+        else
+          init_rhs
+            (it->second,it->second->get_expr_domain(),output_buffer->buffer,
+             fn_bindings,NULL,static_cast<const domain_node*>(it->first));
+
+        ///The loop domain is the domain of the RHS
         domain_node* loop_domain = new domain_node();
         loop_domain->init_domain(it->second->get_expr_domain());
         if( it->second->get_sub_domain())
           loop_domain->compute_intersection(it->second->get_sub_domain());
         loop_domain->realign_domain();
 
-        ///Now read the value from just computed expression and place it in the
-        ///appropriate location on the LHS
-        c_symbol_info* curr_expr_symbol = FindDefnSymbol(curr_expr,fn_bindings);
+        ///Now read the value from just computed expression and place it in the
+        ///appropriate location on the LHS
+        c_symbol_info* curr_expr_symbol = FindDefnSymbol(curr_expr,fn_bindings);
+
+        deque<c_symbol_info*> input_exprs;
+        input_exprs.push_back(curr_expr_symbol);
+        deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
+        print_domain_loops_header
+          (loop_domain, input_exprs, curr_output_symbol->var,
+           curr_output_symbol->scale_domain, curr_unroll_factors);
+
+        output_buffer->indent();
+        stringstream rhs_stream;
+        print_rhs_var
+          (it->second,rhs_stream,fn_bindings,it->second->get_sub_domain(),NULL);
+        string rhs_string = rhs_stream.str();
+        print_assignment_stmt
+          (curr_output_symbol,rhs_string,output_buffer->buffer);
+        output_buffer->newline();
+
+        print_domain_loops_footer(loop_domain, curr_unroll_factors);
+        delete loop_domain;
+      }
+      else{
+        ///If there is no scale function on the output side, and the current
+        ///expression is scaled, move the output variable along
+        if( dynamic_cast<const domainfn_node*>(it->first) ){
+          fn_bindings.AddSymbol
+            (it->second, curr_output_symbol->var,
+             static_cast<const domainfn_node*>(it->first),
+             curr_output_symbol->offset_domain, curr_output_symbol->field_name);
+          ///Compute the vector expression
+          print_vector_expr(it->second,fn_bindings);
+          ///Remove the current rhs from the fn symbol table
+          fn_bindings.RemoveSymbol(it->second);
+        }
+        else{
+          ///When the current function is an offset function, compute the offset
+          ///to be used in the RHS
+          domain_node* curr_offset =
+            new domain_node(static_cast<const domain_node*>(it->first));
+
+          /// if the output symbol already has an offset, compute a new offset
+          /// domain
+          if( curr_output_symbol->offset_domain ){
+            assert(curr_output_symbol->offset_domain->get_dim() >=
+                   curr_offset->get_dim());
+            domain_node* new_offset = new domain_node();
+            deque<range_coeffs>::const_reverse_iterator kt =
+              curr_output_symbol->offset_domain->range_list.rbegin();
+            for( deque<range_coeffs>::const_reverse_iterator jt =
+                   curr_offset->range_list.rbegin() ;
+                 jt != curr_offset->range_list.rend() ; jt++, kt++ ){
+              if( jt->lb->is_default() ){
+                new_offset->range_list.insert
+                  (new_offset->range_list.begin(),
+                   range_coeffs
+                   (parametric_exp::copy(kt->lb),new default_expr()));
+              }
+              else{
+                parametric_exp* curr_offset = parametric_exp::copy(jt->lb);
+                if( !kt->lb->is_default() ){
+                  curr_offset = curr_offset->add(parametric_exp::copy(kt->lb));
+                }
+                new_offset->range_list.insert
+                  (new_offset->range_list.begin(),
+                   range_coeffs(curr_offset,new default_expr()));
+              }
+            }
+            for( ; kt != curr_output_symbol->offset_domain->range_list.rend() ;
+                 kt++ ){
+              new_offset->range_list.insert
+                (new_offset->range_list.begin(),
+                 range_coeffs(parametric_exp::copy(kt->lb),new default_expr()));
+            }
+            fn_bindings.AddSymbol
+              (it->second,curr_output_symbol->var, NULL,
+               new_offset, curr_output_symbol->field_name);
+            print_vector_expr(it->second,fn_bindings);
+            fn_bindings.RemoveSymbol(it->second);
+            delete new_offset;
+          }
+          else{
+            fn_bindings.AddSymbol
+              (it->second,curr_output_symbol->var, NULL, curr_offset,
+               curr_output_symbol->field_name);
+            print_vector_expr(it->second,fn_bindings);
+            fn_bindings.RemoveSymbol(it->second);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_vec_id_expr
+(const vec_id_expr_node* curr_expr, c_symbol_table& fn_bindings)
+{
+  ///When a vec_id_expr is reached, cant propagate the symbol more, need to copy
+  ///the value to the output variable
+  const c_symbol_info* curr_output_symbol =fn_bindings.GetSymbolInfo(curr_expr);
+  const set<vector_expr_node*>& curr_defn_set = curr_expr->get_defn();
+  assert(curr_defn_set.size() == 1 );
+  const vector_expr_node* curr_defn = *(curr_defn_set.begin());
+  c_symbol_info* curr_defn_symbol = fn_bindings.GetSymbolInfo(curr_defn);
+
+  deque<c_symbol_info*>input_exprs;
+  input_exprs.push_back(curr_defn_symbol);
+
+  domain_node* loop_domain = new domain_node();
+  domain_node* sub_domain = NULL;
+  loop_domain->init_domain(curr_expr->get_expr_domain());
+
+  if( curr_defn_symbol->offset_domain ){
+    sub_domain = new domain_node(curr_defn_symbol->var->expr_domain);
+    sub_domain->compute_intersection(curr_defn_symbol->offset_domain);
+  }
+  if( curr_expr->get_sub_domain() ){
+    if( sub_domain == NULL ){
+      sub_domain = new domain_node(curr_defn_symbol->var->expr_domain);
+    }
+    sub_domain->compute_intersection(curr_expr->get_sub_domain());
+    loop_domain->compute_intersection(curr_expr->get_sub_domain());
+    loop_domain->realign_domain();
+  }
+  ///Only the window needed for the region of interest is copied
+  map<const vector_expr_node*,domain_node*>::const_iterator curr_window =
+    roi_windows.find(curr_expr);
+  if( curr_window != roi_windows.end() ){
+    deque<range_coeffs>::const_iterator window_range =
+      curr_window->second->range_list.begin();
+    for( deque<range_coeffs>::iterator it = loop_domain->range_list.begin() ;
+         it != loop_domain->range_list.end() ; it++, window_range++ ){
+      it->lb = it->lb->max(window_range->lb);
+      it->ub = it->ub->min(window_range->ub);
+    }
+  }
+
+  deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
+  print_domain_loops_header
+    (loop_domain, input_exprs, curr_output_symbol->var,
+     curr_output_symbol->scale_domain, curr_unroll_factors);
+
+  output_buffer->indent();
+  stringstream rhs_stream;
+
+  string field_name = "";
+  if( curr_expr->get_base_type().type == T_STRUCT ){
+    int field_num = curr_expr->get_access_field();
+    if( field_num != -1 ){
+      assert(curr_expr->get_base_type().struct_info != NULL &&
+             field_num <
+             (int)(curr_expr->get_base_type().struct_info->fields.size()) );
+      field_name =
+        curr_expr->get_base_type().struct_info->fields[field_num].field_name;
+    }
+  }
+  print_vector_point
+    (curr_defn_symbol->var,field_name,NULL,sub_domain,rhs_stream);
+  string rhs_string = rhs_stream.str();
+  print_assignment_stmt(curr_output_symbol,rhs_string,output_buffer->buffer);
+  output_buffer->newline();
+
+  print_domain_loops_footer(loop_domain, curr_unroll_factors);
+  if( sub_domain )
+    delete sub_domain;
+  delete loop_domain;
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_vector_expr
+(const vector_expr_node* curr_expr, c_symbol_table& fn_bindings)
+{
+  ///Redirecting based on the type of the vector expression
+  assert(curr_expr != NULL );
+  switch(curr_expr->get_type()){
+  case VEC_ID: {
+    print_vec_id_expr
+      (static_cast<const vec_id_expr_node*>(curr_expr),fn_bindings);
+    break;
+  }
+  case VEC_SCALE: {
+    print_domainfn_expr
+      (static_cast<const vec_domainfn_node*>(curr_expr),fn_bindings);
+    break;
+  }
+  case VEC_FN: {
+    print_fnid_expr(static_cast<const fnid_expr_node*>(curr_expr),fn_bindings);
+    break;
+  }
+  case VEC_COMPOSE:{
+    print_compose_expr
+      (static_cast<const compose_expr_node*>(curr_expr),fn_bindings);
+    break;
+  }
+  case VEC_MAKESTRUCT: {
+    print_make_struct
+      (static_cast<const make_struct_node*>(curr_expr),fn_bindings);
+    break;
+  }
+  case VEC_SCALAR: {
+    assert
+      ((static_cast<const expr_node*>(curr_expr)->get_s_type() == S_VALUE) &&
+       "[ME] : CodegenError : Currently rhs of compose expressions"
+       "can either be vector expression or values\n");
+    assert(0); ///TO BE COMPLETED
+    break;
+  }
+  default:
+    assert(0);
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_vector_defn
+(const vector_defn_node* curr_defn, c_symbol_table& fn_bindings)
+{
+  ///Add the vector defn to the symbol table
+  c_var_info* new_var =
+    new c_var_info
+    (curr_defn->get_name(),curr_defn->get_expr_domain(),
+     curr_defn->get_data_type());
+  domain_node* sub_domain = NULL;
+  if( curr_defn->get_sub_domain() )
+    sub_domain = new domain_node(curr_defn->get_sub_domain());
+  fn_bindings.AddSymbol(curr_defn,new_var,NULL,sub_domain,"");
+  def_vars.push_back(new_var);
+  if( soa_args.count(curr_defn->get_name()) )
+    add_field_vars(new_var);
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_stmt
+(const stmt_node* curr_stmt, c_symbol_table& fn_bindings, bool use_new_names)
+{
+  ///Create a new variable for holding the value of the stmt lhs
+  map<const vector_expr_node*,deque<int> >::const_iterator ghost_iter =
+    ghost_halos.find(curr_stmt);
+  if( ghost_iter != ghost_halos.end() )
+    curr_ghost_zone = &ghost_iter->second;
+  init_rhs
+    (curr_stmt->get_rhs(),curr_stmt->get_expr_domain(),output_buffer->buffer,
+     fn_bindings,curr_stmt->get_scale_domain(),curr_stmt->get_sub_domain());
+  curr_ghost_zone = NULL;
+  domain_node* sub_domain = NULL;
+  if( !fn_bindings.IsPresent(curr_stmt->get_rhs()) ){
+    ///The rhs was a vec_id expressions, so just propogate the symbol used for
+    ///the rhs
+    const vec_id_expr_node* curr_vec_id =
+      dynamic_cast<const vec_id_expr_node*>(curr_stmt->get_rhs());
+    assert(curr_vec_id);
+    const set<vector_expr_node*> curr_defn_set = curr_vec_id->get_defn();
+    assert(curr_defn_set.size() == 1);
+    const vector_expr_node* curr_defn = *(curr_defn_set.begin());
+    const c_symbol_info* defn_symbol = fn_bindings.GetSymbolInfo(curr_defn);
+    if( curr_defn->get_dim() != 0){
+      if( defn_symbol->offset_domain ||curr_stmt->get_rhs()->get_sub_domain() ){
+        sub_domain = new domain_node(curr_defn->get_expr_domain());
+        if( defn_symbol->offset_domain ){
+          sub_domain->compute_intersection(defn_symbol->offset_domain);
+        }
+        if( curr_stmt->get_rhs()->get_sub_domain() ){
+          sub_domain->compute_intersection
+            (curr_stmt->get_rhs()->get_sub_domain());
+        }
+      }
+    }
+    fn_bindings.AddSymbol(curr_stmt, defn_symbol->var, NULL,sub_domain,"");
+  }
+  else{
+    const c_symbol_info* curr_rhs_symbol =
+      fn_bindings.GetSymbolInfo(curr_stmt->get_rhs());
+    if( curr_stmt->get_rhs()->get_sub_domain() ){
+      sub_domain = new domain_node(curr_rhs_symbol->var->expr_domain);
+      sub_domain->compute_intersection(curr_stmt->get_rhs()->get_sub_domain());
+    }
+    fn_bindings.AddSymbol(curr_stmt, curr_rhs_symbol->var,NULL,sub_domain,"");
+    fn_bindings.RemoveSymbol(curr_stmt->get_rhs());
+  }
+  if( ghost_iter != ghost_halos.end() )
+    print_ghost_zone_fill
+      (fn_bindings.GetSymbolInfo(curr_stmt)->var,ghost_bdys[curr_stmt]);
+}
+
+
+///-----------------------------------------------------------------------------
+/// Generate a for-loop that was not unrolled. A variable defined in the loop
+/// rotates between a buffer for the current iteration and one for each
+/// previous iteration that is read. Instances before the first iteration are
+/// read from the initial statements
+void PrintC::print_rolled_loop
+(const for_stmt_node* curr_loop, const deque<stmt_node*>& fn_body,
+ c_symbol_table& fn_bindings)
+{
+  const for_iterator* curr_iterator = curr_loop->get_iterator();
+  const range_coeffs& loop_range =
+    curr_iterator->iter_domain->range_list.front();
+  assert(loop_range.lb->type == P_INT);
+  int lb = static_cast<const int_expr*>(loop_range.lb)->value;
+  const deque<stmt_node*>& loop_body = curr_loop->get_body()->stmt_list;
+
+  ///Find the instances of previous iterations read by the loop body, they
+  ///are referred to through the initial statement of the first iteration
+  map<string,int> num_lags;
+  set<const vector_expr_node*> defns;
+  for( deque<stmt_node*>::const_iterator it = loop_body.begin() ;
+       it != loop_body.end() ; it++ ){
+    num_lags[(*it)->get_name_string()] = 0;
+    collect_vec_id_defns((*it)->get_rhs(),defns);
+  }
+  deque<const stmt_node*> lag_stmts;
+  for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+       it != defns.end() ; it++ ){
+    const stmt_node* curr_defn = dynamic_cast<const stmt_node*>(*it);
+    if( curr_defn && curr_defn->get_access_iterator() == NULL &&
+        num_lags.count(curr_defn->get_name_string()) ){
+      lag_stmts.push_back(curr_defn);
+      num_lags[curr_defn->get_name_string()] =
+        MAX(num_lags[curr_defn->get_name_string()],
+            lb - curr_defn->get_offset());
+    }
+  }
+
+  ///The buffers of a variable are allocated once, the initial values have
+  ///to be of the same size as the instances computed by the loop
+  map<string,string> slot_arrays;
+  map<string,map<int,string> > initial_values;
+  map<string,map<int,const c_var_info*> > initial_vars;
+  map<string,const c_var_info*> slot_vars;
+  for( deque<stmt_node*>::const_iterator it = loop_body.begin() ;
+       it != loop_body.end() ; it++ ){
+    const string& curr_name = (*it)->get_name_string();
+    const domain_node* curr_domain = (*it)->get_expr_domain();
+    for( deque<stmt_node*>::const_iterator jt = fn_body.begin() ;
+         jt != fn_body.end() ; jt++ ){
+      if( (*jt)->get_type() != VEC_STMT ||
+          curr_name.compare((*jt)->get_name()) != 0 ||
+          (*jt)->get_offset() < lb - num_lags[curr_name] ||
+          (*jt)->get_offset() >= lb )
+        continue;
+      const c_symbol_info* initial_symbol = fn_bindings.GetSymbolInfo(*jt);
+      bool same_domain =
+        initial_symbol->offset_domain == NULL &&
+        initial_symbol->scale_domain == NULL &&
+        initial_symbol->var->window_offset.empty() &&
+        initial_symbol->var->expr_domain->get_dim() == curr_domain->get_dim();
+      for( int i = 0 ; i < curr_domain->get_dim() && same_domain ; i++ ){
+        const range_coeffs& initial_range =
+          initial_symbol->var->expr_domain->range_list[i];
+        const range_coeffs& curr_range = curr_domain->range_list[i];
+        same_domain =
+          parametric_exp::is_equal(initial_range.lb,curr_range.lb) &&
+          parametric_exp::is_equal(initial_range.ub,curr_range.ub);
+      }
+      if( !same_domain ){
+        fprintf(stderr,"[ME] : Error! : Domain of %s<%d> differs from the "
+                "domain of %s<%s>, the loop over %s cannot be kept rolled\n",
+                curr_name.c_str(),(*jt)->get_offset(),curr_name.c_str(),
+                curr_iterator->name.c_str(),curr_iterator->name.c_str());
+        exit(1);
+      }
+      if( !initial_symbol->var->field_vars.empty() ){
+        fprintf(stderr,"[ME] : Error! : %s<%d> is stored as an array per "
+                "field, the loop over %s cannot be kept rolled\n",
+                curr_name.c_str(),(*jt)->get_offset(),
+                curr_iterator->name.c_str());
+        exit(1);
+      }
+      initial_values[curr_name][lb - (*jt)->get_offset()] =
+        initial_symbol->var->symbol_name;
+      initial_vars[curr_name][lb - (*jt)->get_offset()] = initial_symbol->var;
+    }
+    assert((int)initial_values[curr_name].size() == num_lags[curr_name]);
+
+    string elem_type_string = get_string((*it)->get_data_type());
+    int num_slots = num_lags[curr_name] + 1;
+    string slot_array = get_new_var();
+    stringstream slot_list;
+    for( int i = 0 ; i < num_slots ; i++ ){
+      c_var_info* slot_var =
+        printMalloc(get_new_var(),(*it)->get_data_type(),curr_domain);
+      slot_list << ( i == 0 ? "" : "," ) << slot_var->symbol_name;
+      slot_vars[curr_name] = slot_var;
+    }
+    output_buffer->indent();
+    output_buffer->buffer << elem_type_string << " * " << slot_array << "[" <<
+      num_slots << "] = {" << slot_list.str() << "};";
+    output_buffer->newline();
+    slot_arrays[curr_name] = slot_array;
+  }
+
+  string iter_var = get_new_iterator(output_buffer);
+  output_buffer->indent();
+  output_buffer->buffer << "for (" << iter_var << " = " << lb << "; " <<
+    iter_var << " <= ";
+  PrintCParametricExpr(loop_range.ub,output_buffer->buffer);
+  output_buffer->buffer << "; " << iter_var << "++){";
+  output_buffer->newline();
+  output_buffer->increaseIndent();
+
+  ///Point the initial statements to the instances read by this iteration
+  deque<c_var_info*> saved_vars;
+  for( deque<const stmt_node*>::iterator it = lag_stmts.begin() ;
+       it != lag_stmts.end() ; it++ ){
+    const string& curr_name = (*it)->get_name_string();
+    int num_slots = num_lags[curr_name] + 1;
+    int curr_lag = lb - (*it)->get_offset();
+    string lag_var = get_new_var();
+    output_buffer->indent();
+    output_buffer->buffer << get_string((*it)->get_data_type()) << " * " <<
+      lag_var << " = ( " << iter_var << " >= " << lb + curr_lag << " ? " <<
+      slot_arrays[curr_name] << "[(" << iter_var << " - " << lb + curr_lag <<
+      ") % " << num_slots << "] : ";
+    for( int i = curr_lag ; i > 1 ; i-- ){
+      output_buffer->buffer << "( " << iter_var << " == " << lb + curr_lag - i <<
+        " ? " << initial_values[curr_name][i] << " : ";
+    }
+    output_buffer->buffer << initial_values[curr_name][1];
+    for( int i = curr_lag ; i > 1 ; i-- )
+      output_buffer->buffer << " )";
+    output_buffer->buffer << " );";
+    output_buffer->newline();
+
+    ///With padded rows, the pitch is selected along with the buffer since the
+    ///initial instances can be dense parameters
+    string lag_pitch = "";
+    bool is_pitched = ( slot_vars[curr_name]->row_pitch.compare("") != 0 );
+    for( int i = curr_lag ; i > 0 ; i-- )
+      is_pitched =
+        is_pitched || initial_vars[curr_name][i]->row_pitch.compare("") != 0;
+    if( is_pitched ){
+      lag_pitch = lag_var + "pitch__";
+      output_buffer->indent();
+      output_buffer->buffer << "int " << lag_pitch << " = ( " << iter_var <<
+        " >= " << lb + curr_lag << " ? ";
+      print_row_pitch(slot_vars[curr_name],output_buffer->buffer);
+      output_buffer->buffer << " : ";
+      for( int i = curr_lag ; i > 1 ; i-- ){
+        output_buffer->buffer << "( " << iter_var << " == " <<
+          lb + curr_lag - i << " ? ";
+        print_row_pitch(initial_vars[curr_name][i],output_buffer->buffer);
+        output_buffer->buffer << " : ";
+      }
+      print_row_pitch(initial_vars[curr_name][1],output_buffer->buffer);
+      for( int i = curr_lag ; i > 1 ; i-- )
+        output_buffer->buffer << " )";
+      output_buffer->buffer << " );";
+      output_buffer->newline();
+    }
+
+    c_symbol_info* initial_symbol = fn_bindings.GetSymbolInfo(*it);
+    saved_vars.push_back(initial_symbol->var);
+    c_var_info* new_var =
+      new c_var_info
+      (lag_var,initial_symbol->var->expr_domain,(*it)->get_data_type());
+    new_var->row_pitch = lag_pitch;
+    def_vars.push_back(new_var);
+    fn_bindings.RemoveSymbol(*it);
+    fn_bindings.AddSymbol(*it,new_var,NULL,NULL,"");
+  }
+
+  ///Each statement writes to the buffer of the current iteration
+  for( deque<stmt_node*>::const_iterator it = loop_body.begin() ;
+       it != loop_body.end() ; it++ ){
+    const string& curr_name = (*it)->get_name_string();
+    string curr_var_name = get_new_var();
+    output_buffer->indent();
+    output_buffer->buffer << get_string((*it)->get_data_type()) << " * " <<
+      curr_var_name << " = " << slot_arrays[curr_name] << "[(" << iter_var <<
+      " - " << lb << ") % " << num_lags[curr_name] + 1 << "];";
+    output_buffer->newline();
+    c_var_info* curr_var =
+      new c_var_info
+      (curr_var_name,(*it)->get_expr_domain(),(*it)->get_data_type());
+    curr_var->row_pitch = slot_vars[curr_name]->row_pitch;
+    def_vars.push_back(curr_var);
+    fn_bindings.AddSymbol((*it)->get_rhs(),curr_var,NULL,NULL,"");
+    print_vector_expr((*it)->get_rhs(),fn_bindings);
+    fn_bindings.RemoveSymbol((*it)->get_rhs());
+    fn_bindings.AddSymbol(*it,curr_var,NULL,NULL,"");
+  }
+
+  ///The next iteration overwrites buffers read by this one, loops without a
+  ///worksharing construct dont end with a barrier
+  print_barrier();
+  output_buffer->decreaseIndent();
+  output_buffer->indent();
+  output_buffer->buffer << "}";
+  output_buffer->newline();
+
+  deque<c_var_info*>::iterator saved_iter = saved_vars.begin();
+  for( deque<const stmt_node*>::iterator it = lag_stmts.begin() ;
+       it != lag_stmts.end() ; it++, saved_iter++ ){
+    fn_bindings.RemoveSymbol(*it);
+    fn_bindings.AddSymbol(*it,*saved_iter,NULL,NULL,"");
+  }
+
+  ///After the loop, the statements refer to the last instance. Without any
+  ///iteration that is the instance before the loop, if there is none the
+  ///kernel only accepts parameters for which the loop is not empty
+  stringstream empty_loop;
+  PrintCParametricExpr(loop_range.ub,empty_loop);
+  empty_loop << " < " << lb;
+  for( deque<stmt_node*>::const_iterator it = loop_body.begin() ;
+       it != loop_body.end() ; it++ ){
+    const string& curr_name = (*it)->get_name_string();
+    string last_var_name = get_new_var();
+    output_buffer->indent();
+    output_buffer->buffer << get_string((*it)->get_data_type()) << " * " <<
+      last_var_name << " = ";
+    if( num_lags[curr_name] > 0 )
+      output_buffer->buffer << "( " << empty_loop.str() << " ? " <<
+        initial_values[curr_name][1] << " : ";
+    else if( find(empty_loop_checks.begin(),empty_loop_checks.end(),
+                  empty_loop.str()) == empty_loop_checks.end() )
+      empty_loop_checks.push_back(empty_loop.str());
+    output_buffer->buffer << slot_arrays[curr_name] << "[(";
+    PrintCParametricExpr(loop_range.ub,output_buffer->buffer);
+    output_buffer->buffer << " - " << lb << ") % " <<
+      num_lags[curr_name] + 1 << "]" <<
+      ( num_lags[curr_name] > 0 ? " )" : "" ) << ";";
+    output_buffer->newline();
+    string last_pitch = slot_vars[curr_name]->row_pitch;
+    if( num_lags[curr_name] > 0 &&
+        ( last_pitch.compare("") != 0 ||
+          initial_vars[curr_name][1]->row_pitch.compare("") != 0 ) ){
+      last_pitch = last_var_name + "pitch__";
+      output_buffer->indent();
+      output_buffer->buffer << "int " << last_pitch << " = ( " <<
+        empty_loop.str() << " ? ";
+      print_row_pitch(initial_vars[curr_name][1],output_buffer->buffer);
+      output_buffer->buffer << " : ";
+      print_row_pitch(slot_vars[curr_name],output_buffer->buffer);
+      output_buffer->buffer << " );";
+      output_buffer->newline();
+    }
+    c_var_info* last_var =
+      new c_var_info
+      (last_var_name,(*it)->get_expr_domain(),(*it)->get_data_type());
+    last_var->row_pitch = last_pitch;
+    def_vars.push_back(last_var);
+    fn_bindings.RemoveSymbol(*it);
+    fn_bindings.AddSymbol(*it,last_var,NULL,NULL,"");
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+void PrintC::print_vectorfn_body_helper
+(const vectorfn_defn_node* curr_fn, c_symbol_table& fn_bindings,bool is_inlined)
+{
+  const deque<stmt_node*> fn_body = curr_fn->get_body();
+  const vector_expr_node* return_expr = curr_fn->get_return_expr();
+
+  ///Producers that are fused into their consumer are computed later. The
+  ///schedule only applies to the statements of the program
+  if( fuse_stencils ){
+    for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+         it != fn_body.end() ; it++ ){
+      if( is_inlined ? !fuse_all_stages : !is_fused_stage(*it) )
+        continue;
+      if( !check_fusible_producer(*it) ){
+        if( !is_inlined && !fuse_all_stages )
+          fprintf
+            (stderr,"[MW] : Warning : Stage %s cannot be computed within the "
+             "tiles of its consumer, it is computed into a buffer\n",
+             (*it)->get_name());
+        continue;
+      }
+      if( time_tile_steps == 0 || get_fused_steps(*it) < time_tile_steps )
+        fused_producers.insert(*it);
+    }
+  }
+
+  ///Statements read with a boundary condition are padded with a ghost zone
+  if( ghost_zones && !is_inlined )
+    compute_ghost_zones(fn_body,return_expr);
+
+  ///Find the last use of each statement, buffers allocated within this
+  ///function are released after their last use
+  map<const stmt_node*,int> last_use;
+  bool reuse_body_buffers =
+    reuse_buffers && compute_last_uses(fn_body,return_expr,last_use);
+  int first_body_var = def_vars.size();
+  map<c_var_info*,int> live_stmts;
+
+  ///The statements of the program whose values are not read by the next
+  ///statement are written with non-temporal stores, as is the output
+  set<const stmt_node*> streamed_stmts;
+  bool stream_return = stream_curr_stmt;
+  if( streaming_stores && !is_inlined ){
+    compute_streamed_stmts(fn_body,return_expr,streamed_stmts);
+    stream_return = true;
+  }
+
+  ///Pages of the statements of the program that are read with a different
+  ///partition than the one they are computed with are interleaved
+  set<const stmt_node*> interleaved_stmts;
+  bool interleave_return = interleave_curr_stmt;
+  if( numa_interleave && !is_inlined )
+    compute_interleaved_stmts(fn_body,return_expr,interleaved_stmts);
+
+  ///Every stage of the program is a task that waits only for the stages it
+  ///reads, independent stages run concurrently
+  bool use_stage_tasks = use_omp_tasks && !is_inlined;
+  map<const stmt_node*,c_var_info*> task_vars;
+
+  ///Precompute the expression for statements and the return expression
+  int stmt_num = 0;
+  for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++, stmt_num++ ){
+    if( fused_producers.count(*it) )
+      continue;
+    if( (*it)->get_type() == VEC_FORSTMT ){
+      ///The stages of a rolled loop are run after all earlier tasks, and
+      ///before later ones are generated
+      if( use_stage_tasks ){
+        output_buffer->buffer << "#pragma omp taskwait";
+        output_buffer->newline();
+      }
+      print_rolled_loop
+        (static_cast<const for_stmt_node*>(*it),fn_body,fn_bindings);
+      continue;
+    }
+    stream_curr_stmt = ( streamed_stmts.count(*it) != 0 );
+    interleave_curr_stmt = ( interleaved_stmts.count(*it) != 0 );
+    stringBuffer* orig_buffer = output_buffer;
+    if( use_stage_tasks )
+      output_buffer = new stringBuffer(orig_buffer->getIndent() + 2);
+    if( !is_inlined )
+      set_stage_schedule((*it)->get_name_string());
+    emitted_stream_stores = false;
+    print_stmt(*it,fn_bindings,is_inlined);
+    if( !is_inlined )
+      set_stage_schedule("");
+    ///The non-temporal stores of every thread are made visible before the
+    ///stages that read them start
+    if( emitted_stream_stores && !is_inlined ){
+      print_stream_fence();
+      print_barrier();
+    }
+    if( use_stage_tasks ){
+      stringBuffer* stage_buffer = output_buffer;
+      output_buffer = orig_buffer;
+      c_var_info* stage_var = fn_bindings.GetSymbolInfo(*it)->var;
+      print_stage_task
+        ((*it)->get_rhs(),stage_var,task_vars,stage_buffer);
+      task_vars[*it] = stage_var;
+      delete stage_buffer;
+    }
+    stream_curr_stmt = false;
+    interleave_curr_stmt = false;
+    if( !reuse_body_buffers )
+      continue;
+
+    live_stmts[fn_bindings.GetSymbolInfo(*it)->var]++;
+    for( deque<stmt_node*>::const_iterator jt = fn_body.begin() ; jt <= it ;
+         jt++ ){
+      if( last_use[*jt] != stmt_num || fused_producers.count(*jt) )
+        continue;
+      c_var_info* dead_var = fn_bindings.GetSymbolInfo(*jt)->var;
+      if( --live_stmts[dead_var] != 0 ||
+          find(def_vars.begin()+first_body_var,def_vars.end(),dead_var) ==
+          def_vars.end() )
+        continue;
+      if( reusable_vars.count(dead_var) )
+        free_vars.push_back(dead_var);
+      for( deque<c_var_info*>::iterator kt = dead_var->field_vars.begin() ;
+           kt != dead_var->field_vars.end() ; kt++ )
+        if( reusable_vars.count(*kt) )
+          free_vars.push_back(*kt);
+    }
+  }
+
+  stream_curr_stmt = stream_return;
+  interleave_curr_stmt = interleave_return;
+  stringBuffer* orig_buffer = output_buffer;
+  if( use_stage_tasks )
+    output_buffer = new stringBuffer(orig_buffer->getIndent() + 2);
+  if( !is_inlined )
+    set_stage_schedule("return");
+  emitted_stream_stores = false;
+  print_vector_expr(return_expr,fn_bindings);
+  if( !is_inlined )
+    set_stage_schedule("");
+  ///The output is read after the parallel region, that ends with a barrier
+  if( emitted_stream_stores && !is_inlined )
+    print_stream_fence();
+  if( use_stage_tasks ){
+    stringBuffer* stage_buffer = output_buffer;
+    output_buffer = orig_buffer;
+    print_stage_task
+      (return_expr,fn_bindings.GetSymbolInfo(return_expr)->var,task_vars,
+       stage_buffer);
+    delete stage_buffer;
+  }
+  stream_curr_stmt = false;
+  interleave_curr_stmt = false;
+}
 
-        deque<c_symbol_info*> input_exprs;
-        input_exprs.push_back(curr_expr_symbol);
-        deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
-        print_domain_loops_header
-          (loop_domain, input_exprs, curr_output_symbol->var,
-           curr_output_symbol->scale_domain, curr_unroll_factors);
 
-        output_buffer->indent();
-        stringstream rhs_stream;
-        print_rhs_var
-          (it->second,rhs_stream,fn_bindings,it->second->get_sub_domain(),NULL);
-        string rhs_string = rhs_stream.str();
-        print_assignment_stmt
-          (curr_output_symbol,rhs_string,output_buffer->buffer);
-        output_buffer->newline();
+///-----------------------------------------------------------------------------
+/// Add the buffers of the statements computed by tasks that are read by an
+/// expression to the dependences of a task. Producers fused into the expression
+/// are computed by the task, it depends on the statements they read
+void PrintC::collect_task_inputs
+(const vector_expr_node* curr_expr,
+ const map<const stmt_node*,c_var_info*>& task_vars,
+ set<c_var_info*>& task_inputs) const
+{
+  set<const vector_expr_node*> defns;
+  collect_vec_id_defns(curr_expr,defns);
+  for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+       it != defns.end() ; it++ ){
+    const stmt_node* curr_defn = dynamic_cast<const stmt_node*>(*it);
+    if( !curr_defn )
+      continue;
+    if( fused_producers.count(curr_defn) )
+      collect_task_inputs(curr_defn->get_rhs(),task_vars,task_inputs);
+    else if( task_vars.count(curr_defn) )
+      task_inputs.insert(task_vars.find(curr_defn)->second);
+  }
+}
 
-        print_domain_loops_footer(loop_domain, curr_unroll_factors);
-        delete loop_domain;
-      }
-      else{
-        ///If there is no scale function on the output side, and the current
-        ///expression is scaled, move the output variable along
-        if( dynamic_cast<const domainfn_node*>(it->first) ){
-          fn_bindings.AddSymbol
-            (it->second, curr_output_symbol->var,
-             static_cast<const domainfn_node*>(it->first),
-             curr_output_symbol->offset_domain, curr_output_symbol->field_name);
-          ///Compute the vector expression
-          print_vector_expr(it->second,fn_bindings);
-          ///Remove the current rhs from the fn symbol table
-          fn_bindings.RemoveSymbol(it->second);
-        }
-        else{
-          ///When the current function is an offset function, compute the offset
-          ///to be used in the RHS
-          domain_node* curr_offset =
-            new domain_node(static_cast<const domain_node*>(it->first));
 
-          /// if the output symbol already has an offset, compute a new offset
-          /// domain
-          if( curr_output_symbol->offset_domain ){
-            assert(curr_output_symbol->offset_domain->get_dim() >=
-                   curr_offset->get_dim());
-            domain_node* new_offset = new domain_node();
-            deque<range_coeffs>::const_reverse_iterator kt =
-              curr_output_symbol->offset_domain->range_list.rbegin();
-            for( deque<range_coeffs>::const_reverse_iterator jt =
-                   curr_offset->range_list.rbegin() ;
-                 jt != curr_offset->range_list.rend() ; jt++, kt++ ){
-              if( jt->lb->is_default() ){
-                new_offset->range_list.insert
-                  (new_offset->range_list.begin(),
-                   range_coeffs
-                   (parametric_exp::copy(kt->lb),new default_expr()));
-              }
-              else{
-                parametric_exp* curr_offset = parametric_exp::copy(jt->lb);
-                if( !kt->lb->is_default() ){
-                  curr_offset = curr_offset->add(parametric_exp::copy(kt->lb));
-                }
-                new_offset->range_list.insert
-                  (new_offset->range_list.begin(),
-                   range_coeffs(curr_offset,new default_expr()));
-              }
-            }
-            for( ; kt != curr_output_symbol->offset_domain->range_list.rend() ;
-                 kt++ ){
-              new_offset->range_list.insert
-                (new_offset->range_list.begin(),
-                 range_coeffs(parametric_exp::copy(kt->lb),new default_expr()));
-            }
-            fn_bindings.AddSymbol
-              (it->second,curr_output_symbol->var, NULL,
-               new_offset, curr_output_symbol->field_name);
-            print_vector_expr(it->second,fn_bindings);
-            fn_bindings.RemoveSymbol(it->second);
-            delete new_offset;
-          }
-          else{
-            fn_bindings.AddSymbol
-              (it->second,curr_output_symbol->var, NULL, curr_offset,
-               curr_output_symbol->field_name);
-            print_vector_expr(it->second,fn_bindings);
-            fn_bindings.RemoveSymbol(it->second);
-          }
-        }
-      }
+///-----------------------------------------------------------------------------
+/// Print the dependences of a variable in a depend clause. Buffers are
+/// identified by their first element, variables that share a reused buffer
+/// refer to the same storage
+void PrintC::print_task_depend_item
+(const c_var_info* curr_var, bool& first, stringstream& curr_stream) const
+{
+  if( !curr_var->field_vars.empty() ){
+    for( deque<c_var_info*>::const_iterator it = curr_var->field_vars.begin() ;
+         it != curr_var->field_vars.end() ; it++ )
+      print_task_depend_item(*it,first,curr_stream);
+    return;
+  }
+  curr_stream << ( first ? "" : "," ) << curr_var->symbol_name;
+  if( curr_var->expr_domain->get_dim() != 0 )
+    curr_stream << "[0]";
+  first = false;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Print the code of a stage as a task that depends on the tasks computing
+/// the statements it reads, and on earlier tasks using its buffer
+void PrintC::print_stage_task
+(const vector_expr_node* stage_expr, const c_var_info* stage_var,
+ const map<const stmt_node*,c_var_info*>& task_vars,
+ stringBuffer* stage_buffer)
+{
+  set<c_var_info*> task_inputs;
+  collect_task_inputs(stage_expr,task_vars,task_inputs);
+
+  output_buffer->buffer << "#pragma omp task";
+  if( !task_inputs.empty() ){
+    stringstream input_stream;
+    bool first = true;
+    for( set<c_var_info*>::iterator it = task_inputs.begin() ;
+         it != task_inputs.end() ; it++ )
+      print_task_depend_item(*it,first,input_stream);
+    output_buffer->buffer << " depend(in:" << input_stream.str() << ")";
+  }
+  stringstream output_stream;
+  bool first = true;
+  print_task_depend_item(stage_var,first,output_stream);
+  output_buffer->buffer << " depend(out:" << output_stream.str() << ")";
+  output_buffer->newline();
+  output_buffer->indent();
+  output_buffer->buffer << "{";
+  output_buffer->newline();
+  output_buffer->buffer << stage_buffer->buffer.str();
+  output_buffer->indent();
+  output_buffer->buffer << "}";
+  output_buffer->newline();
+}
+
+
+///-----------------------------------------------------------------------------
+/// Find the definitions of the vectors read by an expression
+void PrintC::collect_vec_id_defns
+(const vector_expr_node* curr_expr, set<const vector_expr_node*>& defns) const
+{
+  switch(curr_expr->get_type()){
+  case VEC_ID: {
+    const set<vector_expr_node*>& curr_defns =
+      static_cast<const vec_id_expr_node*>(curr_expr)->get_defn();
+    defns.insert(curr_defns.begin(),curr_defns.end());
+    break;
+  }
+  case VEC_SCALE: {
+    collect_vec_id_defns
+      (static_cast<const vec_domainfn_node*>(curr_expr)->get_base_expr(),
+       defns);
+    break;
+  }
+  case VEC_FN: {
+    const deque<arg_info>& curr_args =
+      static_cast<const fnid_expr_node*>(curr_expr)->get_args();
+    for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+         it != curr_args.end() ; it++ )
+      collect_vec_id_defns(it->arg_expr,defns);
+    break;
+  }
+  case VEC_COMPOSE: {
+    const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
+      static_cast<const compose_expr_node*>(curr_expr)->get_expr_list();
+    for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
+           expr_list.begin() ; it != expr_list.end() ; it++ )
+      collect_vec_id_defns(it->second,defns);
+    break;
+  }
+  case VEC_MAKESTRUCT: {
+    const deque<vector_expr_node*>& field_inputs =
+      static_cast<const make_struct_node*>(curr_expr)->get_field_inputs();
+    for( deque<vector_expr_node*>::const_iterator it = field_inputs.begin() ;
+         it != field_inputs.end() ; it++ )
+      collect_vec_id_defns(*it,defns);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Liveness analysis over the statements of a function body. A statement is
+/// live from its computation to the computation of the last statement that
+/// reads it. Statements fused into a consumer are computed with the consumer
+bool PrintC::compute_last_uses
+(const deque<stmt_node*>& fn_body, const vector_expr_node* return_expr,
+ map<const stmt_node*,int>& last_use) const
+{
+  int num_stmts = fn_body.size();
+  map<const stmt_node*,int> computed_at;
+  for( int i = num_stmts - 1 ; i >= 0 ; i-- ){
+    const stmt_node* curr_stmt = fn_body[i];
+    if( curr_stmt->get_type() != VEC_STMT )
+      return false;
+    computed_at[curr_stmt] = i;
+    if( fused_producers.count(curr_stmt) ){
+      const vector_expr_node* curr_use = curr_stmt->get_usage().front();
+      const vector_expr_node* consumer = curr_use->get_usage().front();
+      const stmt_node* consumer_stmt =
+        static_cast<const stmt_node*>(consumer->get_usage().front());
+      if( computed_at.count(consumer_stmt) )
+        computed_at[curr_stmt] = computed_at[consumer_stmt];
+    }
+    last_use[curr_stmt] = computed_at[curr_stmt];
+  }
+
+  for( int i = 0 ; i <= num_stmts ; i++ ){
+    set<const vector_expr_node*> defns;
+    int curr_use;
+    if( i < num_stmts ){
+      collect_vec_id_defns(fn_body[i]->get_rhs(),defns);
+      curr_use = computed_at[fn_body[i]];
+    }
+    else{
+      collect_vec_id_defns(return_expr,defns);
+      curr_use = num_stmts;
+    }
+    for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+         it != defns.end() ; it++ ){
+      const stmt_node* curr_defn = dynamic_cast<const stmt_node*>(*it);
+      if( curr_defn && last_use.count(curr_defn) )
+        last_use[curr_defn] = MAX(last_use[curr_defn],curr_use);
     }
   }
+  return true;
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_vec_id_expr
-(const vec_id_expr_node* curr_expr, c_symbol_table& fn_bindings)
+/// Reuse analysis over the statements of a function body. The values of a
+/// statement that is not read by the statement computed right after it are
+/// likely evicted from the caches before they are read
+void PrintC::compute_streamed_stmts
+(const deque<stmt_node*>& fn_body, const vector_expr_node* return_expr,
+ set<const stmt_node*>& streamed_stmts) const
 {
-  ///When a vec_id_expr is reached, cant propagate the symbol more, need to copy
-  ///the value to the output variable
-  const c_symbol_info* curr_output_symbol =fn_bindings.GetSymbolInfo(curr_expr);
-  const set<vector_expr_node*>& curr_defn_set = curr_expr->get_defn();
-  assert(curr_defn_set.size() == 1 );
-  const vector_expr_node* curr_defn = *(curr_defn_set.begin());
-  c_symbol_info* curr_defn_symbol = fn_bindings.GetSymbolInfo(curr_defn);
+  int num_stmts = fn_body.size();
+  map<const stmt_node*,int> computed_at;
+  for( int i = 0 ; i < num_stmts ; i++ ){
+    if( fn_body[i]->get_type() != VEC_STMT )
+      return;
+    computed_at[fn_body[i]] = i;
+  }
 
-  deque<c_symbol_info*>input_exprs;
-  input_exprs.push_back(curr_defn_symbol);
+  map<const stmt_node*,int> first_use;
+  for( int i = 0 ; i <= num_stmts ; i++ ){
+    set<const vector_expr_node*> defns;
+    collect_vec_id_defns
+      ( i < num_stmts ? fn_body[i]->get_rhs() : return_expr, defns);
+    for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+         it != defns.end() ; it++ ){
+      const stmt_node* curr_defn = dynamic_cast<const stmt_node*>(*it);
+      if( curr_defn && computed_at.count(curr_defn) &&
+          !first_use.count(curr_defn) )
+        first_use[curr_defn] = i;
+    }
+  }
 
-  domain_node* loop_domain = new domain_node();
-  domain_node* sub_domain = NULL;
-  loop_domain->init_domain(curr_expr->get_expr_domain());
+  ///Producers fused into their consumer are computed within its tiles
+  for( int i = 0 ; i < num_stmts ; i++ ){
+    if( fused_producers.count(fn_body[i]) )
+      continue;
+    if( !first_use.count(fn_body[i]) || first_use[fn_body[i]] > i + 1 )
+      streamed_stmts.insert(fn_body[i]);
+  }
+}
 
-  if( curr_defn_symbol->offset_domain ){
-    sub_domain = new domain_node(curr_defn_symbol->var->expr_domain);
-    sub_domain->compute_intersection(curr_defn_symbol->offset_domain);
+
+///-----------------------------------------------------------------------------
+/// Strip the integer terms added to a parametric expression
+static const parametric_exp* strip_constant_terms
+(const parametric_exp* curr_exp)
+{
+  while( curr_exp->type == P_ADD || curr_exp->type == P_SUBTRACT ){
+    const binary_expr* curr_binary = static_cast<const binary_expr*>(curr_exp);
+    if( curr_binary->rhs_expr->type == P_INT )
+      curr_exp = curr_binary->lhs_expr;
+    else if( curr_exp->type == P_ADD && curr_binary->lhs_expr->type == P_INT )
+      curr_exp = curr_binary->rhs_expr;
+    else
+      break;
   }
-  if( curr_expr->get_sub_domain() ){
-    if( sub_domain == NULL ){
-      sub_domain = new domain_node(curr_defn_symbol->var->expr_domain);
+  return curr_exp;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Check if a static schedule splits two ranges into chunks that are shifts of
+/// each other. Ranges of constant size are split alike if their sizes are
+/// within an eighth of each other
+static bool is_shifted_range(const range_coeffs& lhs, const range_coeffs& rhs)
+{
+  if( lhs.lb->type == P_INT && lhs.ub->type == P_INT &&
+      rhs.lb->type == P_INT && rhs.ub->type == P_INT ){
+    int lhs_size =
+      static_cast<const int_expr*>(lhs.ub)->value -
+      static_cast<const int_expr*>(lhs.lb)->value + 1;
+    int rhs_size =
+      static_cast<const int_expr*>(rhs.ub)->value -
+      static_cast<const int_expr*>(rhs.lb)->value + 1;
+    return abs(lhs_size - rhs_size) * 8 <= MAX(lhs_size,rhs_size);
+  }
+  const parametric_exp* lhs_bounds[2] =
+    { strip_constant_terms(lhs.lb), strip_constant_terms(lhs.ub) };
+  const parametric_exp* rhs_bounds[2] =
+    { strip_constant_terms(rhs.lb), strip_constant_terms(rhs.ub) };
+  for( int i = 0 ; i < 2 ; i++ )
+    if( ( lhs_bounds[i]->type != P_INT || rhs_bounds[i]->type != P_INT ) &&
+        !parametric_exp::is_equal(lhs_bounds[i],rhs_bounds[i]) )
+      return false;
+  return true;
+}
+
+
+///-----------------------------------------------------------------------------
+/// The outermost loop of a statement is split across threads, a statement
+/// that reads another over a range of the outermost dimension that is not a
+/// shift of the range it is computed over reads rows computed by other threads
+void PrintC::compute_interleaved_stmts
+(const deque<stmt_node*>& fn_body, const vector_expr_node* return_expr,
+ set<const stmt_node*>& interleaved_stmts) const
+{
+  int num_stmts = fn_body.size();
+  for( int i = 0 ; i <= num_stmts ; i++ ){
+    if( i < num_stmts && fn_body[i]->get_type() != VEC_STMT )
+      continue;
+    const domain_node* use_domain =
+      ( i < num_stmts ? fn_body[i]->get_expr_domain() :
+        return_expr->get_expr_domain() );
+    if( use_domain->get_dim() == 0 )
+      continue;
+    set<const vector_expr_node*> defns;
+    collect_vec_id_defns
+      ( i < num_stmts ? fn_body[i]->get_rhs() : return_expr, defns);
+    for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+         it != defns.end() ; it++ ){
+      const stmt_node* curr_defn = dynamic_cast<const stmt_node*>(*it);
+      if( !curr_defn || curr_defn->get_expr_domain()->get_dim() == 0 )
+        continue;
+      if( !is_shifted_range
+          (curr_defn->get_expr_domain()->range_list.front(),
+           use_domain->range_list.front()) )
+        interleaved_stmts.insert(curr_defn);
     }
-    sub_domain->compute_intersection(curr_expr->get_sub_domain());
-    loop_domain->compute_intersection(curr_expr->get_sub_domain());
-    loop_domain->realign_domain();
   }
+}
 
-  deque<int> curr_unroll_factors(loop_domain->get_dim(), 1);
-  print_domain_loops_header
-    (loop_domain, input_exprs, curr_output_symbol->var,
-     curr_output_symbol->scale_domain, curr_unroll_factors);
 
-  output_buffer->indent();
-  stringstream rhs_stream;
+///-----------------------------------------------------------------------------
+/// Points of the statements read by an expression that are needed to compute
+/// a window of it. A stencil over the window [lb,ub] reads the points
+/// lb*scale+max_negetive to ub*scale+max_positive of an argument. Indices
+/// clamped to the domain of the argument stay within these points, mirrored
+/// ones within the largest offset on either side of the window. Wrapped
+/// indices can be anywhere in the argument. A scaled expression over the
+/// window reads the points lb*scale+offset to ub*scale+offset of its base. A
+/// vector function called once computes its body over the window, the points
+/// needed of its parameters are those needed of the arguments
+void PrintC::add_roi_demands
+(const vector_expr_node* curr_expr, domain_node* curr_window,
+ map<const vector_expr_node*,domain_node*>& demands)
+{
+  deque<pair<const vector_expr_node*,domain_node*> > defn_demands;
+  const fnid_expr_node* curr_fn =
+    dynamic_cast<const fnid_expr_node*>(curr_expr);
+  if( curr_window && curr_expr->get_sub_domain() ){
+    delete curr_window;
+    curr_window = NULL;
+  }
 
-  if( sub_domain )
-    print_domain_point(curr_defn_symbol->var,rhs_stream,sub_domain);
-  else
-    print_domain_point(curr_defn_symbol->var,rhs_stream);
-  if( curr_expr->get_base_type().type == T_STRUCT ){
-    int field_num = curr_expr->get_access_field();
-    if( field_num != -1 ){
-      assert(curr_expr->get_base_type().struct_info != NULL &&
-             field_num <
-             (int)(curr_expr->get_base_type().struct_info->fields.size()) );
-      rhs_stream << "." <<
-        curr_expr->get_base_type().struct_info->fields[field_num].field_name;
+  if( curr_window && curr_expr->get_type() == VEC_ID &&
+      static_cast<const vec_id_expr_node*>(curr_expr)->get_defn().size() == 1 ){
+    ///A reference that is copied only copies the window
+    roi_windows[curr_expr] = new domain_node(curr_window);
+    defn_demands.push_back
+      (make_pair
+       (*static_cast<const vec_id_expr_node*>(curr_expr)->get_defn().begin(),
+        curr_window));
+  }
+  else if( curr_window && curr_expr->get_type() == VEC_FN &&
+           dynamic_cast<const stencilfn_defn_node*>(curr_fn->get_defn()) ){
+    roi_windows[curr_expr] = curr_window;
+    const deque<vector_defn_node*>& fn_params = curr_fn->get_defn()->get_args();
+    deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+    const deque<arg_info>& curr_args = curr_fn->get_args();
+    for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+         it != curr_args.end() ; it++, param_iter++ ){
+      if( it->arg_expr->get_dim() == 0 )
+        continue;
+      domain_node* arg_window = NULL;
+      if( !(*param_iter)->get_direct_access() &&
+          (*param_iter)->get_dim() == curr_window->get_dim() &&
+          it->bdy_condn->type != B_WRAP ){
+        arg_window = new domain_node();
+        const deque<offset_hull>& access_info =
+          (*param_iter)->get_access_info();
+        deque<range_coeffs>::const_iterator window_range =
+          curr_window->range_list.begin();
+        for( deque<offset_hull>::const_iterator jt = access_info.begin() ;
+             jt != access_info.end() ; jt++, window_range++ ){
+          int lb_offset = jt->max_negetive;
+          int ub_offset = jt->max_positive;
+          if( it->bdy_condn->type == B_MIRROR ){
+            ub_offset = MAX(-lb_offset,ub_offset);
+            lb_offset = -ub_offset;
+          }
+          arg_window->add_range
+            (parametric_exp::copy(window_range->lb)->
+             multiply(jt->scale)->add(lb_offset),
+             parametric_exp::copy(window_range->ub)->
+             multiply(jt->scale)->add(ub_offset));
+        }
+      }
+      add_roi_demands(it->arg_expr,arg_window,demands);
+    }
+    return;
+  }
+  else if( curr_window && curr_expr->get_type() == VEC_FN &&
+           dynamic_cast<const vectorfn_defn_node*>(curr_fn->get_defn()) &&
+           roi_vectorfn_calls[static_cast<const vectorfn_defn_node*>
+                              (curr_fn->get_defn())] == 1 ){
+    const vectorfn_defn_node* curr_defn =
+      static_cast<const vectorfn_defn_node*>(curr_fn->get_defn());
+    const deque<stmt_node*>& fn_body = curr_defn->get_body();
+    bool has_loops = false;
+    for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+         it != fn_body.end() ; it++ )
+      has_loops = has_loops || (*it)->get_type() != VEC_STMT;
+    if( !has_loops ){
+      add_roi_demands(curr_defn->get_return_expr(),curr_window,demands);
+      add_body_roi_demands(fn_body,demands);
+      const deque<vector_defn_node*>& fn_params = curr_defn->get_args();
+      deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+      const deque<arg_info>& curr_args = curr_fn->get_args();
+      for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+           it != curr_args.end() ; it++, param_iter++ ){
+        if( it->arg_expr->get_dim() == 0 )
+          continue;
+        ///A parameter that is not read needs none of the argument, it is
+        ///still computed whole
+        domain_node* arg_window = NULL;
+        map<const vector_expr_node*,domain_node*>::iterator param_demand =
+          demands.find(*param_iter);
+        if( param_demand != demands.end() ){
+          arg_window = param_demand->second;
+          demands.erase(param_demand);
+        }
+        add_roi_demands(it->arg_expr,arg_window,demands);
+      }
+      return;
+    }
+    ///The statements of loops are computed whole, so are their parameters
+    delete curr_window;
+    set<const vector_expr_node*> defns;
+    collect_vec_id_defns(curr_expr,defns);
+    for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+         it != defns.end() ; it++ )
+      defn_demands.push_back
+        (make_pair(*it,static_cast<domain_node*>(NULL)));
+  }
+  else if( curr_window && curr_expr->get_type() == VEC_COMPOSE ){
+    ///A patch scaled by (offset,scale) writes point p of its expression to
+    ///p*scale+offset, the points of the window are those of the expression
+    ///between ceil((lb-offset)/scale) and floor((ub-offset)/scale). With
+    ///0 <= offset < scale the numerators below are not negative, so the
+    ///truncating division is the floor. Other patches, and patches over a
+    ///sub-domain, are computed whole
+    const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
+      static_cast<const compose_expr_node*>(curr_expr)->get_expr_list();
+    for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
+           expr_list.begin() ; it != expr_list.end() ; it++ ){
+      const domainfn_node* patch_fn =
+        dynamic_cast<const domainfn_node*>(it->first);
+      bool is_aligned = patch_fn &&
+        it->second->get_dim() == curr_window->get_dim();
+      if( is_aligned )
+        for( deque<scale_coeffs>::const_iterator jt =
+               patch_fn->scale_fn.begin() ; jt != patch_fn->scale_fn.end() ;
+             jt++ )
+          is_aligned = is_aligned && jt->offset >= 0 &&
+            jt->offset < jt->scale;
+      domain_node* patch_window = NULL;
+      if( is_aligned ){
+        patch_window = new domain_node();
+        deque<scale_coeffs>::const_iterator jt = patch_fn->scale_fn.begin();
+        for( deque<range_coeffs>::const_iterator kt =
+               curr_window->range_list.begin() ;
+             kt != curr_window->range_list.end() ; kt++, jt++ )
+          patch_window->add_range
+            (parametric_exp::copy(kt->lb)->subtract(jt->offset)->
+             add(jt->scale-1)->divide(jt->scale),
+             parametric_exp::copy(kt->ub)->subtract(jt->offset)->
+             add(jt->scale)->divide(jt->scale)->subtract(1));
+      }
+      add_roi_demands(it->second,patch_window,demands);
+    }
+    delete curr_window;
+    return;
+  }
+  else if( curr_window && curr_expr->get_type() == VEC_SCALE ){
+    roi_windows[curr_expr] = curr_window;
+    const vec_domainfn_node* curr_domainfn =
+      static_cast<const vec_domainfn_node*>(curr_expr);
+    domain_node* base_window = new domain_node();
+    deque<scale_coeffs>::const_iterator jt =
+      curr_domainfn->get_scale_fn()->scale_fn.begin();
+    for( deque<range_coeffs>::const_iterator it =
+           curr_window->range_list.begin() ;
+         it != curr_window->range_list.end() ; it++, jt++ )
+      base_window->add_range
+        (parametric_exp::copy(it->lb)->multiply(jt->scale)->add(jt->offset),
+         parametric_exp::copy(it->ub)->multiply(jt->scale)->add(jt->offset));
+    add_roi_demands(curr_domainfn->get_base_expr(),base_window,demands);
+    return;
+  }
+  else{
+    ///All of the statements read are needed
+    delete curr_window;
+    set<const vector_expr_node*> defns;
+    collect_vec_id_defns(curr_expr,defns);
+    for( set<const vector_expr_node*>::iterator it = defns.begin() ;
+         it != defns.end() ; it++ )
+      defn_demands.push_back
+        (make_pair(*it,static_cast<domain_node*>(NULL)));
+  }
+
+  ///The points needed of a statement are the hull of those needed by each of
+  ///its uses
+  for( deque<pair<const vector_expr_node*,domain_node*> >::iterator it =
+         defn_demands.begin() ; it != defn_demands.end() ; it++ ){
+    map<const vector_expr_node*,domain_node*>::iterator curr_demand =
+      demands.find(it->first);
+    if( curr_demand == demands.end() ){
+      demands[it->first] = it->second;
+    }
+    else if( curr_demand->second == NULL || it->second == NULL ){
+      delete curr_demand->second;
+      delete it->second;
+      curr_demand->second = NULL;
+    }
+    else{
+      deque<range_coeffs>::iterator jt =
+        curr_demand->second->range_list.begin();
+      for( deque<range_coeffs>::iterator kt = it->second->range_list.begin() ;
+           kt != it->second->range_list.end() ; kt++, jt++ ){
+        jt->lb = jt->lb->min(kt->lb);
+        jt->ub = jt->ub->max(kt->ub);
+      }
+      delete it->second;
+    }
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// The window of the return expression is the region of interest, the window
+/// of a statement is the hull of the points needed by its consumers. The
+/// bounds of the window of every statement are computed once at the start of
+/// the kernel
+void PrintC::compute_roi_windows(const vectorfn_defn_node* program_fn)
+{
+  const deque<stmt_node*>& fn_body = program_fn->get_body();
+  const vector_expr_node* return_expr = program_fn->get_return_expr();
+
+  for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ )
+    count_vectorfn_calls(*it,roi_vectorfn_calls);
+  count_vectorfn_calls(return_expr,roi_vectorfn_calls);
+
+  map<const vector_expr_node*,domain_node*> demands;
+  domain_node* return_window = new domain_node();
+  for( int i = 0 ; i < return_expr->get_dim() ; i++ ){
+    stringstream lb_name, ub_name;
+    lb_name << "roi_lb_" << i;
+    ub_name << "roi_ub_" << i;
+    roi_bounds.push_back(new parameter_defn(lb_name.str().c_str()));
+    roi_bounds.push_back(new parameter_defn(ub_name.str().c_str()));
+    add_region_capture("int",lb_name.str(),false,false,false);
+    add_region_capture("int",ub_name.str(),false,false,false);
+    return_window->add_range
+      (new param_expr(roi_bounds[roi_bounds.size()-2]),
+       new param_expr(roi_bounds.back()));
+  }
+  add_roi_demands(return_expr,return_window,demands);
+  add_body_roi_demands(fn_body,demands);
+
+  for( map<const vector_expr_node*,domain_node*>::iterator it =
+         demands.begin() ; it != demands.end() ; it++ )
+    delete it->second;
+}
+
+
+///-----------------------------------------------------------------------------
+/// The window of a statement is the hull of the points needed by its
+/// consumers, which follow it in the body. The bounds of the window are
+/// computed once at the start of the kernel
+void PrintC::add_body_roi_demands
+(const deque<stmt_node*>& fn_body,
+ map<const vector_expr_node*,domain_node*>& demands)
+{
+  for( int i = fn_body.size() - 1 ; i >= 0 ; i-- ){
+    const stmt_node* curr_stmt = fn_body[i];
+    ///The statements of loops are computed over their whole domain, as are
+    ///all the statements before them
+    if( curr_stmt->get_type() != VEC_STMT )
+      break;
+    map<const vector_expr_node*,domain_node*>::iterator curr_demand =
+      demands.find(curr_stmt);
+    domain_node* stmt_window = NULL;
+    if( curr_demand != demands.end() && curr_demand->second &&
+        !curr_stmt->get_scale_domain() && !curr_stmt->get_sub_domain() ){
+      stmt_window = new domain_node();
+      int window_num = roi_bounds.size();
+      int dim = 0;
+      for( deque<range_coeffs>::iterator it =
+             curr_demand->second->range_list.begin() ;
+           it != curr_demand->second->range_list.end() ; it++, dim++ ){
+        stringstream lb_name, ub_name;
+        lb_name << "__roi_" << window_num << "_lb_" << dim << "__";
+        ub_name << "__roi_" << window_num << "_ub_" << dim << "__";
+        output_buffer->buffer << "int " << lb_name.str() << " = ";
+        PrintCParametricExpr(it->lb,output_buffer->buffer);
+        output_buffer->buffer << ";";
+        output_buffer->newline();
+        output_buffer->indent();
+        output_buffer->buffer << "int " << ub_name.str() << " = ";
+        PrintCParametricExpr(it->ub,output_buffer->buffer);
+        output_buffer->buffer << ";";
+        output_buffer->newline();
+        output_buffer->indent();
+        roi_bounds.push_back(new parameter_defn(lb_name.str().c_str()));
+        roi_bounds.push_back(new parameter_defn(ub_name.str().c_str()));
+        add_region_capture("int",lb_name.str(),false,false,false);
+        add_region_capture("int",ub_name.str(),false,false,false);
+        stmt_window->add_range
+          (new param_expr(roi_bounds[roi_bounds.size()-2]),
+           new param_expr(roi_bounds.back()));
+      }
     }
+    add_roi_demands(curr_stmt->get_rhs(),stmt_window,demands);
   }
-  string rhs_string = rhs_stream.str();
-  print_assignment_stmt(curr_output_symbol,rhs_string,output_buffer->buffer);
-  output_buffer->newline();
-
-  print_domain_loops_footer(loop_domain, curr_unroll_factors);
-  if( sub_domain )
-    delete sub_domain;
-  delete loop_domain;
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_vector_expr
-(const vector_expr_node* curr_expr, c_symbol_table& fn_bindings)
+/// Calls of vector functions. The calls within the body of a function are
+/// counted once however many times it is called, a function called from it is
+/// only windowed through the calls of the function itself
+void PrintC::count_vectorfn_calls
+(const vector_expr_node* curr_expr,
+ map<const vectorfn_defn_node*,int>& num_calls) const
 {
-  ///Redirecting based on the type of the vector expression
-  assert(curr_expr != NULL );
   switch(curr_expr->get_type()){
-  case VEC_ID: {
-    print_vec_id_expr
-      (static_cast<const vec_id_expr_node*>(curr_expr),fn_bindings);
+  case VEC_STMT: {
+    count_vectorfn_calls
+      (static_cast<const stmt_node*>(curr_expr)->get_rhs(),num_calls);
+    break;
+  }
+  case VEC_FORSTMT:
+  case VEC_DOSTMT: {
+    const deque<stmt_node*>& loop_body =
+      static_cast<const stmt_node*>(curr_expr)->get_body()->stmt_list;
+    for( deque<stmt_node*>::const_iterator it = loop_body.begin() ;
+         it != loop_body.end() ; it++ )
+      count_vectorfn_calls(*it,num_calls);
     break;
   }
   case VEC_SCALE: {
-    print_domainfn_expr
-      (static_cast<const vec_domainfn_node*>(curr_expr),fn_bindings);
+    count_vectorfn_calls
+      (static_cast<const vec_domainfn_node*>(curr_expr)->get_base_expr(),
+       num_calls);
     break;
   }
   case VEC_FN: {
-    print_fnid_expr(static_cast<const fnid_expr_node*>(curr_expr),fn_bindings);
+    const fnid_expr_node* curr_fn =
+      static_cast<const fnid_expr_node*>(curr_expr);
+    const deque<arg_info>& curr_args = curr_fn->get_args();
+    for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+         it != curr_args.end() ; it++ )
+      count_vectorfn_calls(it->arg_expr,num_calls);
+    const vectorfn_defn_node* curr_defn =
+      dynamic_cast<const vectorfn_defn_node*>(curr_fn->get_defn());
+    if( curr_defn && num_calls[curr_defn]++ == 0 ){
+      for( deque<stmt_node*>::const_iterator it =
+             curr_defn->get_body().begin() ;
+           it != curr_defn->get_body().end() ; it++ )
+        count_vectorfn_calls(*it,num_calls);
+      count_vectorfn_calls(curr_defn->get_return_expr(),num_calls);
+    }
     break;
   }
-  case VEC_COMPOSE:{
-    print_compose_expr
-      (static_cast<const compose_expr_node*>(curr_expr),fn_bindings);
+  case VEC_COMPOSE: {
+    const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
+      static_cast<const compose_expr_node*>(curr_expr)->get_expr_list();
+    for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
+           expr_list.begin() ; it != expr_list.end() ; it++ )
+      count_vectorfn_calls(it->second,num_calls);
     break;
   }
   case VEC_MAKESTRUCT: {
-    print_make_struct
-      (static_cast<const make_struct_node*>(curr_expr),fn_bindings);
+    const deque<vector_expr_node*>& field_inputs =
+      static_cast<const make_struct_node*>(curr_expr)->get_field_inputs();
+    for( deque<vector_expr_node*>::const_iterator it = field_inputs.begin() ;
+         it != field_inputs.end() ; it++ )
+      count_vectorfn_calls(*it,num_calls);
     break;
   }
-  case VEC_SCALAR: {
-    assert
-      ((static_cast<const expr_node*>(curr_expr)->get_s_type() == S_VALUE) &&
-       "[ME] : CodegenError : Currently rhs of compose expressions"
-       "can either be vector expression or values\n");
-    assert(0); ///TO BE COMPLETED
+  default:
+    break;
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Arguments of stencils that read a statement or an expression with a
+/// boundary condition. The points along each dimension are read at the same
+/// offsets from the domain as the stencil accesses, unless the argument is a
+/// sub-domain
+void PrintC::collect_ghost_uses
+(const vector_expr_node* curr_expr,
+ map<const vector_expr_node*,
+ deque<pair<const arg_info*,const vector_defn_node*> > >& ghost_uses) const
+{
+  switch(curr_expr->get_type()){
+  case VEC_SCALE: {
+    collect_ghost_uses
+      (static_cast<const vec_domainfn_node*>(curr_expr)->get_base_expr(),
+       ghost_uses);
+    break;
+  }
+  case VEC_FN: {
+    const fnid_expr_node* curr_fn =
+      static_cast<const fnid_expr_node*>(curr_expr);
+    bool is_stencil =
+      dynamic_cast<const stencilfn_defn_node*>(curr_fn->get_defn()) != NULL;
+    const deque<vector_defn_node*>& fn_params = curr_fn->get_defn()->get_args();
+    deque<vector_defn_node*>::const_iterator param_iter = fn_params.begin();
+    const deque<arg_info>& curr_args = curr_fn->get_args();
+    for( deque<arg_info>::const_iterator it = curr_args.begin() ;
+         it != curr_args.end() ; it++, param_iter++ ){
+      collect_ghost_uses(it->arg_expr,ghost_uses);
+      if( !is_stencil || it->arg_expr->get_dim() == 0 ||
+          it->arg_expr->get_sub_domain() || it->bdy_condn->type == B_NONE ||
+          (*param_iter)->get_direct_access() ||
+          (*param_iter)->get_dim() != it->arg_expr->get_dim() )
+        continue;
+      ///Arguments that are not vec_ids are computed into a buffer of their own
+      const vector_expr_node* curr_defn = it->arg_expr;
+      if( it->arg_expr->get_type() == VEC_ID ){
+        const set<vector_expr_node*>& curr_defns =
+          static_cast<const vec_id_expr_node*>(it->arg_expr)->get_defn();
+        curr_defn =
+          ( curr_defns.size() == 1 ?
+            dynamic_cast<const stmt_node*>(*curr_defns.begin()) : NULL );
+      }
+      if( curr_defn )
+        ghost_uses[curr_defn].push_back(make_pair(&(*it),*param_iter));
+    }
+    break;
+  }
+  case VEC_COMPOSE: {
+    const deque<pair<domain_desc_node*,vector_expr_node*> >& expr_list =
+      static_cast<const compose_expr_node*>(curr_expr)->get_expr_list();
+    for( deque<pair<domain_desc_node*,vector_expr_node*> >::const_iterator it =
+           expr_list.begin() ; it != expr_list.end() ; it++ )
+      collect_ghost_uses(it->second,ghost_uses);
+    break;
+  }
+  case VEC_MAKESTRUCT: {
+    const deque<vector_expr_node*>& field_inputs =
+      static_cast<const make_struct_node*>(curr_expr)->get_field_inputs();
+    for( deque<vector_expr_node*>::const_iterator it = field_inputs.begin() ;
+         it != field_inputs.end() ; it++ )
+      collect_ghost_uses(*it,ghost_uses);
     break;
   }
   default:
-    assert(0);
+    break;
   }
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_vector_defn
-(const vector_defn_node* curr_defn, c_symbol_table& fn_bindings)
+/// A statement computed over its whole domain into a buffer of its own is
+/// padded with a ghost zone, as are arguments computed into a temporary
+/// buffer. The zone is filled with the boundary condition of the first
+/// stencil that reads it. Stencils that read it with the same condition read
+/// the ghost zone instead of checking their indices. The zone covers the
+/// offsets of their accesses, and the points past the domain read by sampled
+/// accesses
+void PrintC::compute_ghost_zones
+(const deque<stmt_node*>& fn_body, const vector_expr_node* return_expr)
 {
-  ///Add the vector defn to the symbol table
-  c_var_info* new_var =
-    new c_var_info
-    (curr_defn->get_name(),curr_defn->get_expr_domain(),
-     curr_defn->get_data_type());
-  domain_node* sub_domain = NULL;
-  if( curr_defn->get_sub_domain() )
-    sub_domain = new domain_node(curr_defn->get_sub_domain());
-  fn_bindings.AddSymbol(curr_defn,new_var,NULL,sub_domain,"");
-  def_vars.push_back(new_var);
+  map<const vector_expr_node*,
+    deque<pair<const arg_info*,const vector_defn_node*> > > ghost_uses;
+  set<const vector_expr_node*> excluded;
+  collect_ghost_uses(return_expr,ghost_uses);
+  for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
+       it != fn_body.end() ; it++ ){
+    ///Buffers of the statements read by a rolled loop are rotated with the
+    ///buffers of the loop
+    if( (*it)->get_type() == VEC_FORSTMT ){
+      const deque<stmt_node*>& loop_body =
+        static_cast<const for_stmt_node*>(*it)->get_body()->stmt_list;
+      for( deque<stmt_node*>::const_iterator jt = loop_body.begin() ;
+           jt != loop_body.end() ; jt++ )
+        collect_vec_id_defns((*jt)->get_rhs(),excluded);
+      continue;
+    }
+    collect_ghost_uses((*it)->get_rhs(),ghost_uses);
+  }
+
+  for( map<const vector_expr_node*,
+         deque<pair<const arg_info*,const vector_defn_node*> > >::iterator it =
+         ghost_uses.begin() ; it != ghost_uses.end() ; it++ ){
+    const vector_expr_node* curr_defn = it->first;
+    const stmt_node* curr_stmt = dynamic_cast<const stmt_node*>(curr_defn);
+    if( curr_defn->get_data_type().type == T_STRUCT ||
+        curr_defn->get_access_field() != -1 )
+      continue;
+    if( curr_stmt &&
+        ( curr_stmt->get_type() != VEC_STMT || excluded.count(curr_stmt) ||
+          fused_producers.count(curr_stmt) ||
+          find(fn_body.begin(),fn_body.end(),curr_stmt) == fn_body.end() ||
+          curr_stmt->get_scale_domain() || curr_stmt->get_sub_domain() ||
+          curr_stmt->get_rhs()->get_type() == VEC_ID ||
+          curr_stmt->get_rhs()->get_sub_domain() ) )
+      continue;
+    ///Arguments of stencils computed a tile at a time are computed over
+    ///the tile
+    if( !curr_stmt && fuse_stencils )
+      continue;
+    const bdy_info* curr_bdy = it->second.front().first->bdy_condn;
+    deque<int> curr_halo(curr_defn->get_dim(),0);
+    deque<const vector_expr_node*> curr_args;
+    for( deque<pair<const arg_info*,const vector_defn_node*> >::iterator jt =
+           it->second.begin() ; jt != it->second.end() ; jt++ ){
+      const bdy_info* use_bdy = jt->first->bdy_condn;
+      if( use_bdy->type != curr_bdy->type ||
+          ( use_bdy->type == B_CONSTANT && use_bdy->value != curr_bdy->value ) )
+        continue;
+      const deque<offset_hull>& access_info = jt->second->get_access_info();
+      bool is_valid = ( (int)access_info.size() == curr_defn->get_dim() );
+      for( int i = 0 ; i < (int)access_info.size() && is_valid ; i++ )
+        is_valid = access_info[i].scale >= 1;
+      if( !is_valid )
+        continue;
+      for( int i = 0 ; i < (int)access_info.size() ; i++ ){
+        curr_halo[i] = MAX(curr_halo[i],-access_info[i].max_negetive);
+        curr_halo[i] =
+          MAX(curr_halo[i],
+              access_info[i].max_positive + access_info[i].scale - 1);
+      }
+      curr_args.push_back(jt->first->arg_expr);
+    }
+    if( curr_args.empty() ||
+        *max_element(curr_halo.begin(),curr_halo.end()) == 0 )
+      continue;
+    ghost_halos[curr_defn] = curr_halo;
+    ghost_bdys[curr_defn] = curr_bdy;
+    ghost_args.insert(curr_args.begin(),curr_args.end());
+  }
 }
 
 
 ///-----------------------------------------------------------------------------
-void PrintC::print_stmt
-(const stmt_node* curr_stmt, c_symbol_table& fn_bindings, bool use_new_names)
+/// The ghost zone is filled one dimension at a time, from the innermost. The
+/// zone along a dimension spans the zone of the inner dimensions, its corners
+/// are copied from points filled earlier, as the checks would remap every
+/// index outside the domain
+void PrintC::print_ghost_zone_fill
+(const c_var_info* curr_var, const bdy_info* curr_bdy)
 {
-  ///Create a new variable for holding the value of the stmt lhs
-  init_rhs
-    (curr_stmt->get_rhs(),curr_stmt->get_expr_domain(),output_buffer->buffer,
-     fn_bindings,curr_stmt->get_scale_domain(),curr_stmt->get_sub_domain());
-  domain_node* sub_domain = NULL;
-  if( !fn_bindings.IsPresent(curr_stmt->get_rhs()) ){
-    ///The rhs was a vec_id expressions, so just propogate the symbol used for
-    ///the rhs
-    const vec_id_expr_node* curr_vec_id =
-      dynamic_cast<const vec_id_expr_node*>(curr_stmt->get_rhs());
-    assert(curr_vec_id);
-    const set<vector_expr_node*> curr_defn_set = curr_vec_id->get_defn();
-    assert(curr_defn_set.size() == 1);
-    const vector_expr_node* curr_defn = *(curr_defn_set.begin());
-    const c_symbol_info* defn_symbol = fn_bindings.GetSymbolInfo(curr_defn);
-    if( curr_defn->get_dim() != 0){
-      if( defn_symbol->offset_domain ||curr_stmt->get_rhs()->get_sub_domain() ){
-        sub_domain = new domain_node(curr_defn->get_expr_domain());
-        if( defn_symbol->offset_domain ){
-          sub_domain->compute_intersection(defn_symbol->offset_domain);
+  const domain_node* interior_domain = curr_var->interior_domain;
+  int ndims = interior_domain->get_dim();
+  int first_iter = iters.size();
+  for( int fill_dim = ndims - 1 ; fill_dim >= 0 ; fill_dim-- ){
+    int width = curr_var->ghost_zone[fill_dim];
+    if( width == 0 )
+      continue;
+    const range_coeffs& fill_range = interior_domain->range_list[fill_dim];
+    stringstream lb_stream, ub_stream;
+    PrintCParametricExpr(fill_range.lb,lb_stream);
+    PrintCParametricExpr(fill_range.ub,ub_stream);
+    for( int is_upper = 0 ; is_upper < 2 ; is_upper++ ){
+      for( int i = 0 ; i < ndims ; i++ ){
+        const range_coeffs& curr_range =
+          ( i > fill_dim ? curr_var->expr_domain : interior_domain )->
+          range_list[i];
+        parametric_exp* curr_lb = parametric_exp::copy(curr_range.lb);
+        parametric_exp* curr_ub = parametric_exp::copy(curr_range.ub);
+        if( i == fill_dim && !is_upper ){
+          delete curr_ub;
+          curr_ub = parametric_exp::copy(curr_range.lb)->add(-1);
+          curr_lb = curr_lb->add(-width);
         }
-        if( curr_stmt->get_rhs()->get_sub_domain() ){
-          sub_domain->compute_intersection
-            (curr_stmt->get_rhs()->get_sub_domain());
+        else if( i == fill_dim ){
+          delete curr_lb;
+          curr_lb = parametric_exp::copy(curr_range.ub)->add(1);
+          curr_ub = curr_ub->add(width);
+        }
+        iters.push_back(printForHeader(curr_lb,curr_ub,1,i == ndims-1));
+        delete curr_lb;
+        delete curr_ub;
+      }
+
+      deque<string> access_exp;
+      for( int i = 0 ; i < ndims ; i++ )
+        access_exp.push_back(iters[first_iter+i]->name);
+      const string& fill_iter = access_exp[fill_dim];
+      stringstream value_stream;
+      if( curr_bdy->type == B_CONSTANT )
+        value_stream << curr_bdy->value;
+      else{
+        deque<string> src_exp = access_exp;
+        stringstream src_stream;
+        switch(curr_bdy->type){
+        case B_WRAP:
+          src_stream << fill_iter << ( is_upper ? " - (" : " + (" ) <<
+            ub_stream.str() << " - " << lb_stream.str() << " + 1)";
+          break;
+        case B_MIRROR:
+          src_stream << "2*(" << ( is_upper ? ub_stream : lb_stream ).str() <<
+            ") - " << fill_iter;
+          break;
+        default:
+          src_stream << ( is_upper ? ub_stream : lb_stream ).str();
+          break;
         }
+        src_exp[fill_dim] = src_stream.str();
+        value_stream << curr_var->symbol_name;
+        print_array_access(curr_var,src_exp,value_stream);
       }
+      output_buffer->indent();
+      output_buffer->buffer << curr_var->symbol_name;
+      print_array_access(curr_var,access_exp,output_buffer->buffer);
+      output_buffer->buffer << " = " << value_stream.str() << ";";
+      output_buffer->newline();
+
+      for( int i = 0 ; i < ndims ; i++ )
+        printForFooter();
     }
-    fn_bindings.AddSymbol(curr_stmt, defn_symbol->var, NULL,sub_domain,"");
   }
-  else{
-    const c_symbol_info* curr_rhs_symbol =
-      fn_bindings.GetSymbolInfo(curr_stmt->get_rhs());
-    if( curr_stmt->get_rhs()->get_sub_domain() ){
-      sub_domain = new domain_node(curr_rhs_symbol->var->expr_domain);
-      sub_domain->compute_intersection(curr_stmt->get_rhs()->get_sub_domain());
+}
+
+
+///-----------------------------------------------------------------------------
+bool PrintC::readsGhostZone(const vector_expr_node* arg) const
+{
+  return ghost_args.count(arg) != 0;
+}
+
+
+///-----------------------------------------------------------------------------
+/// The arguments, parameters and outputs of the kernel are used by the region
+void PrintC::add_kernel_captures
+(const program_node* curr_program, const string& output_var)
+{
+#ifndef _WINDOWS_
+  bool is_restrict = true;
+#else
+  bool is_restrict = false;
+#endif
+  const vectorfn_defn_node* program_fn = curr_program->get_body();
+  const deque<vector_defn_node*>& curr_args = program_fn->get_args();
+  for( deque<vector_defn_node*>::const_iterator it = curr_args.begin() ;
+       it != curr_args.end() ; it++ ){
+    bool is_array = (*it)->get_dim() != 0;
+    if( soa_args.count((*it)->get_name()) ){
+      const deque<defined_fields>& fields =
+        (*it)->get_data_type().struct_info->fields;
+      for( deque<defined_fields>::const_iterator jt = fields.begin() ;
+           jt != fields.end() ; jt++ ){
+        data_types field_type;
+        field_type.assign(jt->field_type);
+        add_region_capture
+          (get_string(field_type),(*it)->get_name() + "_" + jt->field_name,
+           is_array,is_restrict,false);
+      }
+    }
+    else
+      add_region_capture
+        (get_string((*it)->get_data_type()),(*it)->get_name(),is_array,
+         is_restrict && is_array,false);
+  }
+  for( deque<pair<string,parameter_defn*> >::const_iterator it =
+         global_params->begin() ; it != global_params->end() ; it++ )
+    add_region_capture("int",it->first,false,false,false);
+
+  const vector_expr_node* return_expr = program_fn->get_return_expr();
+  if( soa_args.count("return") ){
+    const deque<defined_fields>& fields =
+      return_expr->get_data_type().struct_info->fields;
+    for( deque<defined_fields>::const_iterator it = fields.begin() ;
+         it != fields.end() ; it++ ){
+      data_types field_type;
+      field_type.assign(it->field_type);
+      add_region_capture
+        (get_string(field_type),output_var + "_" + it->field_name,true,
+         is_restrict,false);
     }
-    fn_bindings.AddSymbol(curr_stmt, curr_rhs_symbol->var,NULL,sub_domain,"");
-    fn_bindings.RemoveSymbol(curr_stmt->get_rhs());
   }
+  else
+    add_region_capture
+      (get_string(return_expr->get_data_type()),output_var,true,is_restrict,
+       false);
 }
 
 
-void PrintC::print_vectorfn_body_helper
-(const vectorfn_defn_node* curr_fn, c_symbol_table& fn_bindings,bool is_inlined)
+///-----------------------------------------------------------------------------
+/// Pass the address of the variables used by the region to the team of the
+/// runtime
+void PrintC::print_region_call()
 {
-  ///Precompute the expression for statements and the return expression
-  const deque<stmt_node*> fn_body = curr_fn->get_body();
-  for( deque<stmt_node*>::const_iterator it = fn_body.begin() ;
-       it != fn_body.end() ; it++ ){
-    print_stmt(*it,fn_bindings,is_inlined);
-  }
+  output_buffer->buffer << "void* forma_region_args__[" <<
+    region_captures.size() << "] = {";
+  for( deque<c_region_capture>::iterator it = region_captures.begin() ;
+       it != region_captures.end() ; it++ )
+    output_buffer->buffer << ( it == region_captures.begin() ? "" : "," ) <<
+      "(void*)&" << it->name;
+  output_buffer->buffer << "};";
+  output_buffer->newline();
+  output_buffer->indent();
+  output_buffer->buffer << "forma_parallel_region(" << kernel_name <<
+    "_region__,forma_region_args__);";
+  output_buffer->newline();
+}
 
-  const vector_expr_node* return_expr = curr_fn->get_return_expr();
-  print_vector_expr(return_expr,fn_bindings);
+
+///-----------------------------------------------------------------------------
+/// The function run by each thread of the team, that gets the variables of
+/// the kernel from the region arguments
+void PrintC::print_region_function(FILE* outfile)
+{
+  fprintf(outfile,"static void %s_region__(void* forma_region_data__){\n",
+          kernel_name.c_str());
+  fprintf(outfile,"  void** forma_region_args__ = "
+          "(void**)forma_region_data__;\n");
+  int arg_num = 0;
+  for( deque<c_region_capture>::iterator it = region_captures.begin() ;
+       it != region_captures.end() ; it++, arg_num++ ){
+    if( it->by_reference )
+      fprintf(outfile,"#define %s (*(%s*)forma_region_args__[%d])\n",
+              it->name.c_str(),it->elem_type.c_str(),arg_num);
+    else
+      fprintf(outfile,"  %s %s%s = *(%s%s*)forma_region_args__[%d];\n",
+              it->elem_type.c_str(),
+              ( !it->is_array ? "" :
+                ( it->is_restrict ? "* restrict " : "* " ) ),
+              it->name.c_str(),it->elem_type.c_str(),
+              ( it->is_array ? "*" : "" ),arg_num);
+  }
+  fprintf(outfile,"%s",region_code.c_str());
+  for( deque<c_region_capture>::iterator it = region_captures.begin() ;
+       it != region_captures.end() ; it++ )
+    if( it->by_reference )
+      fprintf(outfile,"#undef %s\n",it->name.c_str());
+  fprintf(outfile,"}\n");
 }
 
 
@@ -2400,12 +6487,30 @@ void PrintC::print_program_body
   output_buffer->newline();
   output_buffer->indent();
 
-  if( generate_omp_pragmas ){
-    output_buffer->buffer << "#pragma omp parallel ";
-    output_buffer->newline();
-    output_buffer->buffer << "{";
+  ///The windows of the statements needed for the region of interest are
+  ///computed before the region
+  if( roi_api )
+    compute_roi_windows(curr_program->get_body());
 
-    output_buffer->newline();
+  ///With the forma runtime, the region is generated separately and outlined
+  ///into a function run by each thread of the team
+  stringBuffer* kernel_buffer = output_buffer;
+  if( use_forma_runtime ){
+    output_buffer = new stringBuffer();
+    output_buffer->increaseIndent();
+    add_kernel_captures(curr_program,output_var);
+  }
+
+  if( generate_omp_pragmas ){
+    if( !use_forma_runtime ){
+      output_buffer->buffer << "#pragma omp parallel ";
+      ///Images of a batch computed in parallel use one thread each
+      if( batch_api )
+        output_buffer->buffer << "if(!omp_in_parallel())";
+      output_buffer->newline();
+      output_buffer->buffer << "{";
+      output_buffer->newline();
+    }
     output_buffer->buffer << "#ifdef _LIKWID_";
     output_buffer->newline();
     output_buffer->indent();
@@ -2420,6 +6525,17 @@ void PrintC::print_program_body
 
 
     output_buffer->newline();
+
+    ///With tasks, one thread generates the tasks of all the stages, the
+    ///others run them
+    if( use_omp_tasks ){
+      output_buffer->buffer << "#pragma omp single";
+      output_buffer->newline();
+      output_buffer->indent();
+      output_buffer->buffer << "{";
+      output_buffer->newline();
+      output_buffer->increaseIndent();
+    }
   }
   if( generate_affine ){
     output_buffer->buffer << "#pragma scop";
@@ -2441,12 +6557,21 @@ void PrintC::print_program_body
   c_var_info* return_var =
     new c_var_info(output_var,return_expr_domain,return_expr->get_data_type());
   def_vars.push_back(return_var);
+  if( soa_args.count("return") )
+    add_field_vars(return_var);
   fn_bindings.AddSymbol(program_fn->get_return_expr(),return_var,NULL,NULL,"");
   print_vectorfn_body_helper(curr_program->get_body(),fn_bindings,false);
 
   fn_bindings.RemoveSymbol(return_expr);
   delete return_expr_domain;
 
+  if( use_omp_tasks ){
+    output_buffer->decreaseIndent();
+    output_buffer->indent();
+    output_buffer->buffer << "}";
+    output_buffer->newline();
+  }
+
   if( generate_omp_pragmas ){
     output_buffer->buffer << "#ifdef _LIKWID_";
     output_buffer->newline();
@@ -2457,9 +6582,17 @@ void PrintC::print_program_body
     output_buffer->newline();
     output_buffer->indent();
 
-    output_buffer->indent();
-    output_buffer->buffer <<"}";
-    output_buffer->newline();
+    if( !use_forma_runtime ){
+      output_buffer->indent();
+      output_buffer->buffer <<"}";
+      output_buffer->newline();
+    }
+  }
+  if( use_forma_runtime ){
+    region_code = output_buffer->buffer.str();
+    delete output_buffer;
+    output_buffer = kernel_buffer;
+    print_region_call();
   }
   if( generate_affine ){
     output_buffer->buffer << "#pragma endscop";
@@ -2490,12 +6623,70 @@ void PrintC::GenerateCode
   if( command_opts.use_icc_pragmas )
     generate_icc_pragmas = true;
   init_zero = command_opts.init_zero;
+  ///Stages scheduled within the tiles of their consumer are fused even if the
+  ///other stages are not
+  if( ( command_opts.fuse_stencils ||
+        command_opts.has_compute_level(COMPUTE_TILE) ) && !generate_affine ){
+    fuse_stencils = true;
+    fuse_all_stages = command_opts.fuse_stencils;
+    fusion_tile_size = command_opts.fusion_tile_size;
+    time_tile_steps = command_opts.time_tile_steps;
+  }
+  if( command_opts.reuse_buffers && !generate_affine )
+    reuse_buffers = true;
+  if( command_opts.sliding_window && !generate_affine )
+    use_sliding_window = true;
+  if( !generate_affine )
+    simd_isa = command_opts.simd_isa;
+  value_ranges.set_saturate(command_opts.saturate_int_casts);
+  soa_structs = command_opts.soa_structs;
+  aligned_buffers = command_opts.aligned_buffers;
+  streaming_stores = command_opts.streaming_stores;
+  numa_first_touch = command_opts.numa_first_touch && generate_omp_pragmas;
+  numa_interleave = command_opts.numa_interleave && numa_first_touch;
+  use_omp_tasks = command_opts.omp_tasks && generate_omp_pragmas;
+  use_forma_runtime =
+    command_opts.runtime.compare("forma") == 0 && generate_omp_pragmas;
+  kernel_name = command_opts.kernel_name;
+  plan_api = command_opts.plan_api && !generate_affine;
+  batch_api = command_opts.batch_api && !generate_affine;
+  roi_api = command_opts.roi_api && !generate_affine;
+  ghost_zones = command_opts.ghost_zones && !generate_affine;
+  specialize_bdys = command_opts.specialize_bdys;
+  buffer_alignment = command_opts.buffer_alignment;
+  soa_args.insert(command_opts.soa_args.begin(),command_opts.soa_args.end());
+  for( set<string>::iterator it = soa_args.begin() ; it != soa_args.end() ;
+       it++ ){
+    const vectorfn_defn_node* program_fn = curr_program->get_body();
+    const vector_expr_node* soa_arg = NULL;
+    if( it->compare("return") == 0 )
+      soa_arg = program_fn->get_return_expr();
+    for( deque<vector_defn_node*>::const_iterator jt =
+           program_fn->get_args().begin() ;
+         jt != program_fn->get_args().end() ; jt++ )
+      if( (*jt)->get_name().compare(*it) == 0 )
+        soa_arg = *jt;
+    if( soa_arg == NULL || soa_arg->get_data_type().type != T_STRUCT ||
+        soa_arg->get_dim() == 0 ){
+      fprintf(stderr,"[ME] : Error! : %s is not a struct vector argument of "
+              "the program, cannot pass it as an array per field\n",
+              it->c_str());
+      exit(1);
+    }
+  }
+  if( command_opts.generate_tiled_code ){
+    generate_tiled_code = true;
+    tile_sizes.insert
+      (tile_sizes.begin(), command_opts.tile_sizes.begin(),
+       command_opts.tile_sizes.end());
+  }
   if (command_opts.generate_unroll_code) {
     generate_unroll_code = true;
     unroll_factors.insert
       (unroll_factors.begin(), command_opts.unroll_factors.begin(),
        command_opts.unroll_factors.end());
   }
+  init_stage_schedules(command_opts);
 
   output_buffer->increaseIndent();
   deallocate_buffer->increaseIndent();
@@ -2549,8 +6740,9 @@ void PrintC::GenerateCode
   output_buffer->decreaseIndent();
 
   if( use_single_malloc ){
+    workspace_size_code = host_allocate_size->buffer.str();
     host_allocate_size->indent();
-    host_allocate_size->buffer << "char* " << globalMemVar << ";";
+    host_allocate_size->buffer << "char* " << globalMemVar << " = NULL;";
     host_allocate_size->newline();
 
     host_allocate_size->indent();
@@ -2559,11 +6751,16 @@ void PrintC::GenerateCode
     host_allocate_size->increaseIndent();
 
     host_allocate_size->indent();
-    host_allocate_size->buffer << globalMemVar << " = (char*)malloc( " <<
-      globalMemOffset << ");";
+    if( aligned_buffers )
+      host_allocate_size->buffer << globalMemVar <<
+        " = (char*)forma_aligned_malloc( " << globalMemOffset << "," <<
+        buffer_alignment << ");";
+    else
+      host_allocate_size->buffer << globalMemVar << " = (char*)malloc( " <<
+        globalMemOffset << ");";
     host_allocate_size->newline();
 
-    if( init_zero ){
+    if( init_zero && !numa_first_touch ){
       host_allocate_size->indent();
       host_allocate_size->buffer << "memset(" << globalMemVar << ",0," <<
         globalMemOffset << ");";
@@ -2581,12 +6778,16 @@ void PrintC::GenerateCode
     deallocate_buffer->increaseIndent();
 
     deallocate_buffer->indent();
-    deallocate_buffer->buffer << "free(" << globalMemVar << ");";
+    deallocate_buffer->buffer <<
+      ( aligned_buffers ? "forma_aligned_free(" : "free(" ) << globalMemVar <<
+      ");";
     deallocate_buffer->newline();
     deallocate_buffer->decreaseIndent();
   }
 
-  output_buffer->buffer << deallocate_buffer->buffer.str();
+  ///With the plan API the workspace is released by <kernel>_destroy
+  if( !plan_api )
+    output_buffer->buffer << deallocate_buffer->buffer.str();
   deallocate_buffer->decreaseIndent();
   if( use_single_malloc )
     host_allocate_size->decreaseIndent();
@@ -2611,59 +6812,382 @@ void PrintC::print_string
   PrintCParametricDefines(temp_buffer);
   PrintCStructDefinition(temp_buffer);
   fprintf(CodeGenFile,"%s",temp_buffer.buffer.str().c_str());
-  fprintf(CodeGenFile,"void %s(",command_opts.kernel_name.c_str());
-
+  if( use_forma_runtime )
+    fprintf(CodeGenFile,"static void %s_region__(void* forma_region_data__);\n",
+            kernel_name.c_str());
+  stringstream input_args, param_args, output_args;
+  stringstream input_names, param_names, output_names;
+  ///Arguments of the batched kernel, arrays are passed as one pointer per
+  ///image
+  deque<pair<string,string> > batch_args;
+  stringstream image_inputs, image_outputs;
+  batch_args.push_back(make_pair(string("int"),string("num_images")));
   for( deque<vector_defn_node*>::const_iterator it = curr_args.begin() ;
        it != curr_args.end() ; it++ ){
-    fprintf(CodeGenFile,"%s ",get_string((*it)->get_data_type()).c_str());
-    if( generate_affine && (*it)->get_dim() > 1 &&
-        (*it)->get_dim() <= supported_affine_dim ){
-      stringstream temp_stream;
-      print_pointer((*it)->get_dim(),temp_stream);
-      fprintf(CodeGenFile,"%s",temp_stream.str().c_str());
+    ///Struct arguments passed per field are split into one argument per field
+    deque<pair<data_types,string> > arg_buffers;
+    if( soa_args.count((*it)->get_name()) ){
+      const deque<defined_fields>& fields =
+        (*it)->get_data_type().struct_info->fields;
+      for( deque<defined_fields>::const_iterator jt = fields.begin() ;
+           jt != fields.end() ; jt++ ){
+        data_types field_type;
+        field_type.assign(jt->field_type);
+        arg_buffers.push_back
+          (make_pair(field_type,(*it)->get_name() + "_" + jt->field_name));
+      }
     }
-    else{
+    else
+      arg_buffers.push_back(make_pair((*it)->get_data_type(),(*it)->get_name()));
+
+    for( deque<pair<data_types,string> >::iterator jt = arg_buffers.begin() ;
+         jt != arg_buffers.end() ; jt++ ){
+      input_args << get_string(jt->first) << " ";
+      if( generate_affine && (*it)->get_dim() > 1 &&
+          (*it)->get_dim() <= supported_affine_dim ){
+        print_pointer((*it)->get_dim(),input_args);
+      }
+      else{
 #ifndef _WINDOWS_
-      fprintf(CodeGenFile,"%s",((*it)->get_dim() == 0 ? "" : "* restrict "));
+        input_args << ((*it)->get_dim() == 0 ? "" : "* restrict ");
 #else
-      fprintf(CodeGenFile,"%s",((*it)->get_dim() == 0 ? "" : "* "));
+        input_args << ((*it)->get_dim() == 0 ? "" : "* ");
 #endif
+      }
+      input_args << jt->second << ", ";
+      input_names << jt->second << ", ";
+      batch_args.push_back
+        (make_pair(get_string(jt->first) +
+                   ( (*it)->get_dim() == 0 ? "" : "**" ),jt->second));
+      image_inputs << jt->second <<
+        ( (*it)->get_dim() == 0 ? "" : "[__image__]" ) << ", ";
     }
-    fprintf(CodeGenFile,"%s, ",(*it)->get_name().c_str());
   }
   ///Add parameters as arguments
   for( deque<pair<string,parameter_defn*> >::const_iterator it =
          global_params->begin() ; it != global_params->end() ; it++ ){
-    fprintf(CodeGenFile,"int %s, ",it->first.c_str());
+    param_args << "int " << it->first << ", ";
+    param_names << it->first << ", ";
+    batch_args.push_back(make_pair(string("int"),it->first));
   }
 
-  fprintf(CodeGenFile,"%s",
-          get_string(program_fn->get_return_expr()->get_data_type()).c_str());
-  if( generate_affine && program_fn->get_return_expr()->get_dim() > 1 &&
-      program_fn->get_return_expr()->get_dim() <= supported_affine_dim){
-    stringstream temp_stream;
-    print_pointer(program_fn->get_return_expr()->get_dim(),temp_stream);
-    fprintf(CodeGenFile,"%s",temp_stream.str().c_str());
+  const vector_expr_node* return_expr = program_fn->get_return_expr();
+  deque<pair<data_types,string> > output_buffers;
+  if( soa_args.count("return") ){
+    const deque<defined_fields>& fields =
+      return_expr->get_data_type().struct_info->fields;
+    for( deque<defined_fields>::const_iterator it = fields.begin() ;
+         it != fields.end() ; it++ ){
+      data_types field_type;
+      field_type.assign(it->field_type);
+      output_buffers.push_back
+        (make_pair(field_type,output_var + "_" + it->field_name));
+    }
   }
-  else{
+  else
+    output_buffers.push_back(make_pair(return_expr->get_data_type(),output_var));
+
+  for( deque<pair<data_types,string> >::iterator it = output_buffers.begin() ;
+       it != output_buffers.end() ; it++ ){
+    if( it != output_buffers.begin() ){
+      output_args << ", ";
+      output_names << ", ";
+    }
+    output_args << get_string(it->first);
+    if( generate_affine && return_expr->get_dim() > 1 &&
+        return_expr->get_dim() <= supported_affine_dim){
+      print_pointer(return_expr->get_dim(),output_args);
+    }
+    else{
 #ifndef _WINDOWS_
-    fprintf(CodeGenFile,"* restrict ");
+      output_args << "* restrict ";
 #else
-    fprintf(CodeGenFile,"* ");
+      output_args << "* ";
 #endif
+    }
+    output_args << " " << it->second;
+    output_names << it->second;
+    batch_args.push_back(make_pair(get_string(it->first) + "**",it->second));
+    image_outputs << ( it == output_buffers.begin() ? "" : ", " ) <<
+      it->second << "[__image__]";
   }
-  fprintf(CodeGenFile," %s){\n",output_var.c_str());
-  if( use_single_malloc ){
-    fprintf(CodeGenFile,"%s",host_allocate_size->buffer.str().c_str());
+  ///The code is only valid for parameter values satisfying the constraints it
+  ///was specialized for
+  stringstream param_checks;
+  for( deque<pair<string,parameter_defn*> >::const_iterator it =
+         global_params->begin() ; it != global_params->end() ; it++ ){
+    const parameter_defn* curr_param = it->second;
+    if( curr_param->value != DEFAULT_RANGE )
+      param_checks << " || " << it->first << " != " << curr_param->value;
+    if( curr_param->multiple_of != 1 )
+      param_checks << " || " << it->first << " % " << curr_param->multiple_of
+                   << " != 0";
+    if( curr_param->has_lower_bound )
+      param_checks << " || " << it->first << " < "
+                   << curr_param->lower_bound;
+  }
+  stringstream param_check_code;
+  if( !param_checks.str().empty() ){
+    param_check_code << "  if( " << param_checks.str().substr(4) << " ){\n";
+    param_check_code << "    fprintf(stderr,\"[FORMA] : Error! Parameter "
+      "values do not satisfy the constraints the kernel was specialized "
+      "for\\n\");\n";
+    param_check_code << "    exit(1);\n";
+    param_check_code << "  }\n";
+  }
+  for( deque<string>::const_iterator it = empty_loop_checks.begin() ;
+       it != empty_loop_checks.end() ; it++ ){
+    param_check_code << "  if( " << *it << " ){\n";
+    param_check_code << "    fprintf(stderr,\"[FORMA] : Error! Parameter "
+      "values give an empty loop whose result is read\\n\");\n";
+    param_check_code << "    exit(1);\n";
+    param_check_code << "  }\n";
+  }
+
+  if( plan_api ){
+    print_plan_functions
+      (CodeGenFile,input_args.str(),param_args.str(),output_args.str(),
+       param_check_code.str());
+    ///The kernel runs the plan once
+    string context_type = "struct " + kernel_name + "_context";
+    string create_names = param_names.str();
+    if( !create_names.empty() )
+      create_names.erase(create_names.size()-2);
+    fprintf(CodeGenFile,"void %s(%s%s%s){\n",kernel_name.c_str(),
+            input_args.str().c_str(),param_args.str().c_str(),
+            output_args.str().c_str());
+    fprintf(CodeGenFile,"  %s* ctx = %s_create(%s);\n",context_type.c_str(),
+            kernel_name.c_str(),create_names.c_str());
+    fprintf(CodeGenFile,"  %s_run(ctx, %s%s);\n",kernel_name.c_str(),
+            input_names.str().c_str(),output_names.str().c_str());
+    fprintf(CodeGenFile,"  %s_destroy(ctx);\n",kernel_name.c_str());
+    fprintf(CodeGenFile,"}\n");
+  }
+  else if( roi_api ){
+    ///The kernel computes the whole output as its region of interest
+    const domain_node* output_domain = return_expr->get_expr_domain();
+    stringstream roi_args, roi_names;
+    int dim = 0;
+    for( deque<range_coeffs>::const_iterator it =
+           output_domain->range_list.begin() ;
+         it != output_domain->range_list.end() ; it++, dim++ ){
+      roi_args << "int roi_lb_" << dim << ", int roi_ub_" << dim << ", ";
+      PrintCParametricExpr(it->lb,roi_names);
+      roi_names << ", ";
+      PrintCParametricExpr(it->ub,roi_names);
+      roi_names << ", ";
+    }
+    fprintf(CodeGenFile,"void %s_roi(%s%s%s%s){\n",kernel_name.c_str(),
+            input_args.str().c_str(),param_args.str().c_str(),
+            roi_args.str().c_str(),output_args.str().c_str());
+    fprintf(CodeGenFile,"%s",param_check_code.str().c_str());
+    if( use_single_malloc ){
+      fprintf(CodeGenFile,"%s",host_allocate_size->buffer.str().c_str());
+    }
+    fprintf(CodeGenFile,"%s",host_allocate->buffer.str().c_str());
+    fprintf(CodeGenFile,"%s",output_buffer->buffer.str().c_str());
+    fprintf(CodeGenFile,"}\n");
+    fprintf(CodeGenFile,"void %s(%s%s%s){\n",kernel_name.c_str(),
+            input_args.str().c_str(),param_args.str().c_str(),
+            output_args.str().c_str());
+    fprintf(CodeGenFile,"  %s_roi(%s%s%s%s);\n",kernel_name.c_str(),
+            input_names.str().c_str(),param_names.str().c_str(),
+            roi_names.str().c_str(),output_names.str().c_str());
+    fprintf(CodeGenFile,"}\n");
+  }
+  else{
+    fprintf(CodeGenFile,"void %s(%s%s%s){\n",kernel_name.c_str(),
+            input_args.str().c_str(),param_args.str().c_str(),
+            output_args.str().c_str());
+    fprintf(CodeGenFile,"%s",param_check_code.str().c_str());
+    if( use_single_malloc ){
+      fprintf(CodeGenFile,"%s",host_allocate_size->buffer.str().c_str());
+    }
+    fprintf(CodeGenFile,"%s",host_allocate->buffer.str().c_str());
+    fprintf(CodeGenFile,"%s",output_buffer->buffer.str().c_str());
+    fprintf(CodeGenFile,"}\n");
+  }
+  if( use_forma_runtime )
+    print_region_function(CodeGenFile);
+  if( batch_api ){
+    stringstream image_call;
+    if( plan_api )
+      image_call << kernel_name << "_run(ctx, " << image_inputs.str() <<
+        image_outputs.str() << ");";
+    else
+      image_call << kernel_name << "(" << image_inputs.str() <<
+        param_names.str() << image_outputs.str() << ");";
+    stringstream image_size;
+    PrintCDomainSize(program_fn->get_expr_domain(),image_size);
+    print_batch_function
+      (CodeGenFile,batch_args,image_call.str(),param_names.str(),
+       image_size.str());
   }
-  fprintf(CodeGenFile,"%s",host_allocate->buffer.str().c_str());
-  fprintf(CodeGenFile,"%s",output_buffer->buffer.str().c_str());
-  fprintf(CodeGenFile,"}\n");
   fflush(CodeGenFile);
   fclose(CodeGenFile);
 }
 
 
+///-----------------------------------------------------------------------------
+/// The context holds the parameters and the workspace from which all the
+/// intermediates are carved. <kernel>_create computes the size of the
+/// workspace and allocates it, <kernel>_run recomputes the offsets of the
+/// intermediates in the workspace and runs the program
+void PrintC::print_plan_functions
+(FILE* outfile, const string& input_args, const string& param_args,
+ const string& output_args, const string& param_check_code)
+{
+  string context_type = "struct " + kernel_name + "_context";
+  const char* context_str = context_type.c_str();
+  const char* mem_var = globalMemVar.c_str();
+  const char* mem_size = globalMemOffset.c_str();
+
+  fprintf(outfile,"%s{\n",context_str);
+  for( deque<pair<string,parameter_defn*> >::const_iterator it =
+         global_params->begin() ; it != global_params->end() ; it++ )
+    fprintf(outfile,"  int %s;\n",it->first.c_str());
+  fprintf(outfile,"  char* %s;\n",mem_var);
+  fprintf(outfile,"  int %s;\n",mem_size);
+  fprintf(outfile,"};\n");
+
+  string create_args = param_args;
+  if( create_args.empty() )
+    create_args = "void";
+  else
+    create_args.erase(create_args.size()-2);
+  fprintf(outfile,"%s* %s_create(%s){\n",context_str,kernel_name.c_str(),
+          create_args.c_str());
+  fprintf(outfile,"%s",param_check_code.c_str());
+  fprintf(outfile,"%s",host_allocate_size->buffer.str().c_str());
+  fprintf(outfile,"  %s* ctx = (%s*)malloc(sizeof(%s));\n",context_str,
+          context_str,context_str);
+  for( deque<pair<string,parameter_defn*> >::const_iterator it =
+         global_params->begin() ; it != global_params->end() ; it++ )
+    fprintf(outfile,"  ctx->%s = %s;\n",it->first.c_str(),it->first.c_str());
+  fprintf(outfile,"  ctx->%s = %s;\n",mem_var,mem_var);
+  fprintf(outfile,"  ctx->%s = %s;\n",mem_size,mem_size);
+  fprintf(outfile,"  return ctx;\n");
+  fprintf(outfile,"}\n");
+
+  fprintf(outfile,"void %s_run(%s* ctx, %s%s){\n",kernel_name.c_str(),
+          context_str,input_args.c_str(),output_args.c_str());
+  for( deque<pair<string,parameter_defn*> >::const_iterator it =
+         global_params->begin() ; it != global_params->end() ; it++ )
+    fprintf(outfile,"  int %s = ctx->%s;\n",it->first.c_str(),
+            it->first.c_str());
+  fprintf(outfile,"%s",workspace_size_code.c_str());
+  fprintf(outfile,"  char* %s = ctx->%s;\n",mem_var,mem_var);
+  fprintf(outfile,"%s",host_allocate->buffer.str().c_str());
+  fprintf(outfile,"%s",output_buffer->buffer.str().c_str());
+  fprintf(outfile,"}\n");
+
+  fprintf(outfile,"void %s_destroy(%s* ctx){\n",kernel_name.c_str(),
+          context_str);
+  fprintf(outfile,"  char* %s = ctx->%s;\n",mem_var,mem_var);
+  fprintf(outfile,"  int %s = ctx->%s;\n",mem_size,mem_size);
+  fprintf(outfile,"%s",deallocate_buffer->buffer.str().c_str());
+  fprintf(outfile,"  free(ctx);\n");
+  fprintf(outfile,"}\n");
+}
+
+
+///-----------------------------------------------------------------------------
+/// <kernel>_batch computes the program on each image of a batch. Batches of
+/// small images are parallelized across images, each image computed by one
+/// thread, otherwise the images are computed one after the other by all the
+/// threads
+void PrintC::print_batch_function
+(FILE* outfile, const deque<pair<string,string> >& batch_args,
+ const string& image_call, const string& param_names,
+ const string& image_size)
+{
+  string context_type = "struct " + kernel_name + "_context";
+  string create_names = param_names;
+  if( !create_names.empty() )
+    create_names.erase(create_names.size()-2);
+  stringstream create_ctx, destroy_ctx;
+  if( plan_api ){
+    create_ctx << context_type << "* ctx = " << kernel_name << "_create(" <<
+      create_names << ");";
+    destroy_ctx << kernel_name << "_destroy(ctx);";
+  }
+
+  fprintf(outfile,"#ifndef FORMA_BATCH_IMAGE_POINTS\n");
+  fprintf(outfile,"#define FORMA_BATCH_IMAGE_POINTS 262144\n");
+  fprintf(outfile,"#endif\n");
+
+  ///With the forma runtime, the loop over images is the parallel region
+  if( use_forma_runtime && generate_omp_pragmas ){
+    fprintf(outfile,"static void %s_batch_region__(void* forma_region_data__){"
+            "\n",kernel_name.c_str());
+    fprintf(outfile,"  void** forma_region_args__ = "
+            "(void**)forma_region_data__;\n");
+    int arg_num = 0;
+    for( deque<pair<string,string> >::const_iterator it = batch_args.begin() ;
+         it != batch_args.end() ; it++, arg_num++ )
+      fprintf(outfile,"  %s %s = *(%s*)forma_region_args__[%d];\n",
+              it->first.c_str(),it->second.c_str(),it->first.c_str(),arg_num);
+    fprintf(outfile,"  int __image__;\n");
+    if( plan_api )
+      fprintf(outfile,"  %s\n",create_ctx.str().c_str());
+    fprintf(outfile,"  forma_loop __image__loop__;\n");
+    fprintf(outfile,"  for (__image__ = forma_loop_begin(&__image__loop__,0,"
+            "num_images-1,1); __image__ <= num_images-1; __image__ = "
+            "forma_loop_next(&__image__loop__,__image__))\n");
+    fprintf(outfile,"    %s\n",image_call.c_str());
+    if( plan_api )
+      fprintf(outfile,"  %s\n",destroy_ctx.str().c_str());
+    fprintf(outfile,"}\n");
+  }
+
+  fprintf(outfile,"void %s_batch(",kernel_name.c_str());
+  for( deque<pair<string,string> >::const_iterator it = batch_args.begin() ;
+       it != batch_args.end() ; it++ )
+    fprintf(outfile,"%s%s %s",( it == batch_args.begin() ? "" : ", " ),
+            it->first.c_str(),it->second.c_str());
+  fprintf(outfile,"){\n");
+  fprintf(outfile,"  int __image__;\n");
+  if( generate_omp_pragmas ){
+    fprintf(outfile,"  if( num_images > 1 && (long)(%s) < "
+            "FORMA_BATCH_IMAGE_POINTS ){\n",image_size.c_str());
+    if( use_forma_runtime ){
+      fprintf(outfile,"    void* forma_region_args__[%d] = {",
+              (int)batch_args.size());
+      for( deque<pair<string,string> >::const_iterator it =
+             batch_args.begin() ; it != batch_args.end() ; it++ )
+        fprintf(outfile,"%s(void*)&%s",( it == batch_args.begin() ? "" : "," ),
+                it->second.c_str());
+      fprintf(outfile,"};\n");
+      fprintf(outfile,"    forma_parallel_region(%s_batch_region__,"
+              "forma_region_args__);\n",kernel_name.c_str());
+    }
+    else{
+      fprintf(outfile,"#pragma omp parallel private(__image__)\n");
+      fprintf(outfile,"    {\n");
+      if( plan_api )
+        fprintf(outfile,"      %s\n",create_ctx.str().c_str());
+      fprintf(outfile,"#pragma omp for schedule(dynamic)\n");
+      fprintf(outfile,"      for (__image__ = 0; __image__ < num_images; "
+              "__image__++)\n");
+      fprintf(outfile,"        %s\n",image_call.c_str());
+      if( plan_api )
+        fprintf(outfile,"      %s\n",destroy_ctx.str().c_str());
+      fprintf(outfile,"    }\n");
+    }
+    fprintf(outfile,"    return;\n");
+    fprintf(outfile,"  }\n");
+  }
+  if( plan_api )
+    fprintf(outfile,"  %s\n",create_ctx.str().c_str());
+  fprintf(outfile,"  for (__image__ = 0; __image__ < num_images; "
+          "__image__++)\n");
+  fprintf(outfile,"    %s\n",image_call.c_str());
+  if( plan_api )
+    fprintf(outfile,"  %s\n",destroy_ctx.str().c_str());
+  fprintf(outfile,"}\n");
+}
+
+
 ///-----------------------------------------------------------------------------
 void PrintC::print_header_info(FILE * outfile)
 {
@@ -2685,4 +7209,61 @@ void PrintC::print_header_info(FILE * outfile)
      "void initialize_short_array"
      "(short * array, int size, short val);\n"
      "void initialize_float_array(float * array, int size, float val);\n\n");
+  if( aligned_buffers )
+    fprintf
+      (outfile,
+       "void* forma_aligned_malloc(size_t size, int alignment);\n"
+       "void forma_aligned_free(void* aligned_array);\n"
+       "int forma_row_pitch(int width, int elem_size, int alignment);\n"
+       "void** forma_malloc_2d_pitched_array"
+       "(int outer_dim, int inner_dim, int elem_size, int alignment);\n"
+       "void forma_free_2d_pitched_array(void** curr_array);\n\n");
+  if( numa_interleave )
+    fprintf
+      (outfile,"void forma_numa_interleave(void* buffer, size_t size);\n\n");
+  if( use_forma_runtime )
+    fprintf
+      (outfile,
+       "typedef struct {\n"
+       "  int lb, ub, step;\n"
+       "  int loop_id;\n"
+       "  int grain;\n"
+       "  int chunk_last;\n"
+       "} forma_loop;\n"
+       "void forma_parallel_region"
+       "(void (*region_fn)(void*), void* region_data);\n"
+       "int forma_loop_begin(forma_loop* loop, int lb, int ub, int step);\n"
+       "int forma_loop_next(forma_loop* loop, int iter);\n"
+       "int forma_thread_num();\n"
+       "int forma_num_threads();\n"
+       "void forma_barrier();\n\n");
+  ///The widest instruction set used by any stage is required
+  const char* isa_order[] = { "sse4", "avx2", "avx512" };
+  string header_isa = "";
+  for( int i = 0 ; i < 3 ; i++ ){
+    bool is_used = ( default_simd_isa.compare(isa_order[i]) == 0 );
+    for( map<string,stage_schedule>::const_iterator it =
+           stage_schedules.begin() ; it != stage_schedules.end() ; it++ )
+      is_used = is_used || ( it->second.simd_isa.compare(isa_order[i]) == 0 );
+    if( is_used && !generate_affine )
+      header_isa = isa_order[i];
+  }
+  if( header_isa.compare("") != 0 ){
+    string isa_macro = "__SSE4_1__", isa_flags = "-msse4.1";
+    if( header_isa.compare("avx2") == 0 ){
+      isa_macro = "__AVX2__";
+      isa_flags = "-mavx2";
+    }
+    else if( header_isa.compare("avx512") == 0 ){
+      isa_macro = "__AVX512BW__";
+      isa_flags = "-mavx512f -mavx512bw";
+    }
+    fprintf
+      (outfile,
+       "#include \"immintrin.h\"\n"
+       "#ifndef %s\n"
+       "#error \"Generated for --simd=%s, compile with %s\"\n"
+       "#endif\n\n", isa_macro.c_str(), header_isa.c_str(),
+       isa_flags.c_str());
+  }
 }
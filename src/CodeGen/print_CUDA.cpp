@@ -1834,6 +1834,25 @@ void PrintCUDA::GenerateCode
       (unroll_factors.begin(), command_opts.unroll_factors.begin(),
        command_opts.unroll_factors.end());
   }
+  ///Only the unroll factors of the schedule of a stage apply to its kernels,
+  ///stages computed inline are already inlined
+  init_stage_schedules(command_opts);
+  for( map<string,stage_schedule>::iterator it = stage_schedules.begin() ;
+       it != stage_schedules.end() ; it++ ){
+    if( !it->second.tile_sizes.empty() || it->second.parallel_dim != -1 ||
+        it->second.simd_isa.compare("") != 0 )
+      fprintf
+        (stderr,"[MW] : Warning : The tile, parallel and vectorize directives "
+         "of stage %s are ignored by the CUDA backend\n",it->first.c_str());
+    if( it->second.compute_level == COMPUTE_TILE )
+      fprintf
+        (stderr,"[MW] : Warning : Stage %s cannot be computed within the "
+         "tiles of its consumer, it is computed into a buffer\n",
+         it->first.c_str());
+    it->second.tile_sizes.clear();
+    it->second.simd_isa = "";
+    it->second.parallel_dim = -1;
+  }
 
   PrintCStructDefinition(*output_buffer, false);
   //init_parameters();
@@ -26,6 +26,7 @@
 //* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.     *//
 //****************************************************************************//
 #include <cstdio>
+#include <cstdlib>
 #include "AST/parser.hpp"
 #include "CodeGen/print_C.hpp"
 #include "CodeGen/print_dot.hpp"
@@ -35,6 +36,10 @@
 #include "ASTVisitor/unroll.hpp"
 #include "ASTVisitor/forward_expr.hpp"
 #include "ASTVisitor/inline_vectorfn.hpp"
+#include "ASTVisitor/stencil_cse.hpp"
+#include "ASTVisitor/separable_stencils.hpp"
+#include "ASTVisitor/inline_pointwise.hpp"
+#include "ASTVisitor/stencil_simplify.hpp"
 
 using namespace std;
 
@@ -42,19 +47,45 @@ program_node* parser::root_node = NULL;
 
 void print_header(const program_node* curr_program);
 
+///The stages named in the schedule have to be statements of the program, or
+///its return expression
+static void check_schedule
+(const program_node* curr_program, const program_options& mode)
+{
+  const deque<stmt_node*>& program_body = curr_program->get_body()->get_body();
+  for( map<string,stage_schedule>::const_iterator it =
+         mode.stage_schedules.begin() ; it != mode.stage_schedules.end() ;
+       it++ ){
+    bool is_stage = ( it->first.compare("return") == 0 );
+    for( deque<stmt_node*>::const_iterator jt = program_body.begin() ;
+         jt != program_body.end() && !is_stage ; jt++ )
+      is_stage =
+        ( (*jt)->get_type() == VEC_STMT &&
+          it->first.compare((*jt)->get_name()) == 0 );
+    if( !is_stage ){
+      fprintf
+        (stderr,"[ME] : Error! : %s in the schedule is not a statement of the "
+         "program\n", it->first.c_str());
+      exit(1);
+    }
+  }
+}
+
 int main(int argc, char ** argv)
 {
   program_options mode;
   mode.parse_options(argc,argv);
 
   parser::set_input_file(mode.inp_file);
+  parser::set_param_constraints(mode.param_constraints);
   parser::parse_input();
 
   if( parser::root_node ){
+    check_schedule(parser::root_node,mode);
 
     ///Optimization passes. They are ordered here
     if( mode.unroll_loops ){
-      LoopUnroll unroll_for_loops;
+      LoopUnroll unroll_for_loops(mode.roll_loops);
       printf("Loop Unroll ...");
       unroll_for_loops.visit(parser::root_node,0);
       printf(" done\n");
@@ -71,6 +102,31 @@ int main(int argc, char ** argv)
       inline_vectorfns.visit(parser::root_node,NULL);
       printf(" done\n");
     }
+    if( mode.separable_stencils ){
+      SeparableStencils separate_stencils;
+      printf("Separable Stencils ...");
+      separate_stencils.visit(parser::root_node);
+      printf(" done\n");
+    }
+    if( mode.inline_pointwise || mode.has_compute_level(COMPUTE_INLINE) ){
+      InlinePointwise inline_pointwise_fns
+        (mode.inline_pointwise,mode.stage_schedules);
+      printf("Inline Pointwise Stencils ...");
+      inline_pointwise_fns.visit(parser::root_node,NULL);
+      printf(" done\n");
+    }
+    if( mode.simplify_stencils ){
+      StencilSimplify simplify_exprs;
+      printf("Simplify Stencils ...");
+      simplify_exprs.visit(parser::root_node);
+      printf(" done\n");
+    }
+    if( mode.stencil_cse ){
+      StencilCSE eliminate_subexprs;
+      printf("Stencil CSE ...");
+      eliminate_subexprs.visit(parser::root_node);
+      printf(" done\n");
+    }
 
     ///Codegen Passes
     if( mode.pretty_print ){
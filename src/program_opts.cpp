@@ -27,6 +27,9 @@
 //****************************************************************************//
 #include "program_opts.hpp"
 #include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
 
 using namespace std;
 
@@ -37,6 +40,10 @@ void program_options::parse_options(int argc, char** argv)
   string enable_unroll("--unroll-loops");
   string enable_forwarding("--forward-exprs");
   string enable_inline_vectorfn("--inline-vector-functions");
+  string enable_stencil_cse("--stencil-cse");
+  string enable_separable_stencils("--separable-stencils");
+  string enable_inline_pointwise("--inline-pointwise");
+  string enable_simplify_stencils("--simplify-stencils");
 
   string enable_pretty_print("--pretty-print");
 
@@ -45,6 +52,8 @@ void program_options::parse_options(int argc, char** argv)
   string enable_init_zero("--init-zero");
   string enable_single_malloc("--use-single-malloc");
   string set_unroll_factors("--unroll-factors");
+  string set_param_constraints("--param-constraints");
+  string set_schedule_file("--schedule");
 
   string enable_dot("--print-dot");
   string set_dot_output_file("--dot-output");
@@ -53,6 +62,29 @@ void program_options::parse_options(int argc, char** argv)
   string enable_affine("--generate-affine");
   string enable_sequential("--disable-openmp");
   string enable_icc_vecflags("--enable-icc-pragmas");
+  string enable_fusion("--fuse-stencils");
+  string set_fusion_tile_size("--fusion-tile-size");
+  string set_time_tile_steps("--time-tile-steps");
+  string set_tile_sizes("--tile-sizes");
+  string enable_buffer_reuse("--reuse-buffers");
+  string enable_loop_rolling("--roll-loops");
+  string enable_sliding_window("--sliding-window");
+  string set_simd_isa("--simd=");
+  string enable_soa_structs("--soa-structs");
+  string set_soa_args("--soa-args");
+  string enable_saturate_int_casts("--saturate-int-casts");
+  string enable_aligned_buffers("--aligned-buffers");
+  string set_buffer_alignment("--buffer-alignment");
+  string enable_streaming_stores("--streaming-stores");
+  string enable_numa_first_touch("--numa-first-touch");
+  string enable_numa_interleave("--numa-interleave");
+  string enable_omp_tasks("--omp-tasks");
+  string set_runtime("--runtime=");
+  string enable_plan_api("--plan-api");
+  string enable_batch_api("--batch-api");
+  string enable_roi_api("--roi-api");
+  string enable_ghost_zones("--ghost-zones");
+  string enable_specialize_bdys("--specialize-boundaries");
   string set_c_output_file("--c-output");
 
   string enable_cuda("--print-cuda");
@@ -79,6 +111,22 @@ void program_options::parse_options(int argc, char** argv)
       inline_vectorfn = true;
       continue;
     }
+    else if( enable_stencil_cse.compare(argv[i]) == 0 ){
+      stencil_cse = true;
+      continue;
+    }
+    else if( enable_separable_stencils.compare(argv[i]) == 0 ){
+      separable_stencils = true;
+      continue;
+    }
+    else if( enable_inline_pointwise.compare(argv[i]) == 0 ){
+      inline_pointwise = true;
+      continue;
+    }
+    else if( enable_simplify_stencils.compare(argv[i]) == 0 ){
+      simplify_stencils = true;
+      continue;
+    }
 
     /// generic code-gen options
     else if( set_kernel_name.compare(argv[i]) == 0 ){
@@ -148,10 +196,203 @@ void program_options::parse_options(int argc, char** argv)
       use_icc_pragmas = true;
       continue;
     }
+    else if( enable_fusion.compare(argv[i]) == 0 ){
+      fuse_stencils = true;
+      continue;
+    }
+    else if( set_fusion_tile_size.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing tile size after %s, using default : %d\n",
+           set_fusion_tile_size.c_str(), fusion_tile_size);
+      }
+      else {
+        int tile_size = atoi(argv[++i]);
+        if( tile_size <= 0 ){
+          fprintf
+            (stderr,"[ME] : Error! Invalid tile size %s specified with %s\n",
+             argv[i], set_fusion_tile_size.c_str());
+          exit(1);
+        }
+        fusion_tile_size = tile_size;
+      }
+      continue;
+    }
+    else if( enable_buffer_reuse.compare(argv[i]) == 0 ){
+      reuse_buffers = true;
+      continue;
+    }
+    else if( enable_loop_rolling.compare(argv[i]) == 0 ){
+      roll_loops = true;
+      continue;
+    }
+    else if( enable_sliding_window.compare(argv[i]) == 0 ){
+      sliding_window = true;
+      continue;
+    }
+    else if( string(argv[i]).compare(0,set_simd_isa.size(),set_simd_isa) == 0 ){
+      simd_isa = string(argv[i]).substr(set_simd_isa.size());
+      if( simd_isa.compare("sse4") != 0 && simd_isa.compare("avx2") != 0 &&
+          simd_isa.compare("avx512") != 0 ){
+        fprintf
+          (stderr,"[ME] : Error! Unsupported instruction set %s specified with "
+           "%s, expected sse4, avx2 or avx512\n", simd_isa.c_str(),
+           set_simd_isa.c_str());
+        exit(1);
+      }
+      continue;
+    }
+    else if( enable_soa_structs.compare(argv[i]) == 0 ){
+      soa_structs = true;
+      continue;
+    }
+    else if( set_soa_args.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing argument names after %s, using arrays of structs for all "
+           "arguments\n", set_soa_args.c_str());
+      }
+      else {
+        std::string arg_list = argv[++i];
+        size_t start = 0;
+        while (start < arg_list.size()) {
+          size_t end = arg_list.find_first_of(",", start);
+          int substr_len =
+            (end == string::npos ? arg_list.size() : end) - start;
+          if( substr_len > 0 )
+            soa_args.push_back(arg_list.substr(start, substr_len));
+          start += substr_len+1;
+        }
+      }
+      continue;
+    }
+    else if( enable_saturate_int_casts.compare(argv[i]) == 0 ){
+      saturate_int_casts = true;
+      continue;
+    }
+    else if( enable_streaming_stores.compare(argv[i]) == 0 ){
+      streaming_stores = true;
+      continue;
+    }
+    else if( enable_omp_tasks.compare(argv[i]) == 0 ){
+      omp_tasks = true;
+      continue;
+    }
+    else if( string(argv[i]).compare(0,set_runtime.size(),set_runtime) == 0 ){
+      runtime = string(argv[i]).substr(set_runtime.size());
+      if( runtime.compare("openmp") != 0 && runtime.compare("forma") != 0 ){
+        fprintf
+          (stderr,"[ME] : Error! Unsupported runtime %s specified with %s, "
+           "expected openmp or forma\n", runtime.c_str(), set_runtime.c_str());
+        exit(1);
+      }
+      continue;
+    }
+    else if( enable_numa_first_touch.compare(argv[i]) == 0 ){
+      numa_first_touch = true;
+      continue;
+    }
+    else if( enable_numa_interleave.compare(argv[i]) == 0 ){
+      numa_first_touch = true;
+      numa_interleave = true;
+      continue;
+    }
+    else if( enable_aligned_buffers.compare(argv[i]) == 0 ){
+      aligned_buffers = true;
+      continue;
+    }
+    else if( set_buffer_alignment.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing alignment after %s, using %d bytes\n",
+           set_buffer_alignment.c_str(), buffer_alignment);
+      }
+      else {
+        int alignment = atoi(argv[++i]);
+        if( alignment < (int)sizeof(void*) ||
+            ( alignment & ( alignment - 1 ) ) != 0 ){
+          fprintf
+            (stderr,"[ME] : Error! Invalid alignment %s specified with %s, "
+             "has to be a power of two no less than %d\n", argv[i],
+             set_buffer_alignment.c_str(), (int)sizeof(void*));
+          exit(1);
+        }
+        buffer_alignment = alignment;
+      }
+      aligned_buffers = true;
+      continue;
+    }
+    else if( set_time_tile_steps.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing number of steps after %s, disabling temporal blocking\n",
+           set_time_tile_steps.c_str());
+      }
+      else {
+        int num_steps = atoi(argv[++i]);
+        if( num_steps <= 0 ){
+          fprintf
+            (stderr,"[ME] : Error! Invalid number of steps %s specified with "
+             "%s\n", argv[i], set_time_tile_steps.c_str());
+          exit(1);
+        }
+        fuse_stencils = true;
+        time_tile_steps = num_steps;
+      }
+      continue;
+    }
+    else if( set_tile_sizes.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing tile sizes after %s, disabling tiling\n",
+           set_tile_sizes.c_str());
+      }
+      else {
+        generate_tiled_code = true;
+        std::string size_list = argv[++i];
+        size_t start = 0;
+        while (start < size_list.size()) {
+          size_t end = size_list.find_first_of(",", start);
+          int substr_len =
+            (end == string::npos ? size_list.size() : end) - start;
+          int tile_size = atoi(size_list.substr(start, substr_len).c_str());
+          if( tile_size < 0 ){
+            fprintf
+              (stderr,"[ME] : Error! Invalid tile size %d specified with %s\n",
+               tile_size, set_tile_sizes.c_str());
+            exit(1);
+          }
+          tile_sizes.push_back(tile_size);
+          start += substr_len+1;
+        }
+      }
+      continue;
+    }
     else if ( enable_single_malloc.compare(argv[i]) == 0 ){
       use_single_malloc = true;
       continue;
     }
+    else if( enable_plan_api.compare(argv[i]) == 0 ){
+      plan_api = true;
+      use_single_malloc = true;
+      continue;
+    }
+    else if( enable_batch_api.compare(argv[i]) == 0 ){
+      batch_api = true;
+      continue;
+    }
+    else if( enable_roi_api.compare(argv[i]) == 0 ){
+      roi_api = true;
+      continue;
+    }
+    else if( enable_ghost_zones.compare(argv[i]) == 0 ){
+      ghost_zones = true;
+      continue;
+    }
+    else if( enable_specialize_bdys.compare(argv[i]) == 0 ){
+      specialize_bdys = true;
+      continue;
+    }
     else if ( set_unroll_factors.compare(argv[i]) == 0 ){
       if (i == argc - 1) {
         printf
@@ -173,6 +414,37 @@ void program_options::parse_options(int argc, char** argv)
       }
       continue;
     }
+    else if ( set_param_constraints.compare(argv[i]) == 0 ){
+      if (i == argc - 1) {
+        printf
+          ("Missing constraints after %s, parameters are runtime values\n",
+           set_param_constraints.c_str());
+      }
+      else {
+        std::string constraint_list = argv[++i];
+        size_t start = 0;
+        while (start < constraint_list.size()) {
+          size_t end = constraint_list.find_first_of(",", start);
+          int substr_len =
+            (end == string::npos ? constraint_list.size() : end) - start;
+          if( substr_len > 0 )
+            param_constraints.push_back
+              (constraint_list.substr(start, substr_len));
+          start += substr_len+1;
+        }
+      }
+      continue;
+    }
+    else if( set_schedule_file.compare(argv[i]) == 0 ){
+      if( i == argc - 1 ) {
+        printf
+          ("Missing schedule file after %s, all stages use the global "
+           "options\n", set_schedule_file.c_str());
+      }
+      else
+        parse_schedule(argv[++i]);
+      continue;
+    }
     else if( set_c_output_file.compare(argv[i]) == 0 ){
       if( i == argc - 1 ) {
         printf
@@ -234,6 +506,20 @@ void program_options::parse_options(int argc, char** argv)
       printf
         ("%s <name> : Specify output file name for generated dot output code, "
          "valid only with %s\n",set_dot_output_file.c_str(),enable_dot.c_str());
+      printf
+        ("%s : Eliminate common subexpressions within stencil functions\n",
+         enable_stencil_cse.c_str());
+      printf
+        ("%s : Split stencil functions whose weights form a rank-1 matrix "
+         "into a sequence of lower-dimensional stencils\n",
+         enable_separable_stencils.c_str());
+      printf
+        ("%s : Inline stencil functions that only read the current point "
+         "into the stencil functions using their result\n",
+         enable_inline_pointwise.c_str());
+      printf
+        ("%s : Fold constants and simplify arithmetic identities within "
+         "stencil functions\n",enable_simplify_stencils.c_str());
       printf("\n");
 
       printf("Generic code-generation options :\n");
@@ -248,11 +534,61 @@ void program_options::parse_options(int argc, char** argv)
       printf
         ("%s : Use a single malloc to allocate all required memory\n",
          enable_single_malloc.c_str());
+      printf
+        ("%s : Also generate <kernel>_create, <kernel>_run and "
+         "<kernel>_destroy, so that the memory for the intermediates is "
+         "allocated once and reused by every run. Implies %s, and cannot "
+         "be used with %s [default:disabled]\n", enable_plan_api.c_str(),
+         enable_single_malloc.c_str(), enable_fusion.c_str());
+      printf
+        ("%s : Also generate <kernel>_batch, that takes the number of images "
+         "and an array of pointers for every input and output. Batches of "
+         "images with fewer points than FORMA_BATCH_IMAGE_POINTS are computed "
+         "in parallel across images, others one image at a time "
+         "[default:disabled]\n", enable_batch_api.c_str());
+      printf
+        ("%s : Also generate <kernel>_roi, that takes the bounds of a region "
+         "of the output after the parameters and computes only that region, "
+         "and every intermediate only over the points the region needs "
+         "[default:disabled]\n", enable_roi_api.c_str());
+      printf
+        ("%s : Pad the intermediates read with a boundary condition with a "
+         "ghost zone as wide as the stencils reading them, filled after the "
+         "intermediate is computed. Stencils read them without checking "
+         "their indices [default:disabled]\n", enable_ghost_zones.c_str());
+      printf
+        ("%s : Generate the loop nests of the edges and corners of a stencil "
+         "with only the index checks of their side. Images smaller than the "
+         "stencils use the fully checked loop nests [default:disabled]\n",
+         enable_specialize_bdys.c_str());
       printf
         ("%s <integer_list> : Specify a list of unroll factors to use for the "
          "different loop nests. <integer_list> is a comma-separated list of "
          "integers with the unroll factor specified from innermost dimension to"
          " outermost dimension\n", set_unroll_factors.c_str());
+      printf
+        ("%s <constraint_list> : Specialize the generated code for parameter "
+         "values satisfying the constraints. <constraint_list> is a "
+         "comma-separated list of constraints of the form <param>=<integer>, "
+         "<param>%%<integer>==0 or <param>>=<integer>. The kernel still takes "
+         "the parameters as arguments and checks them at runtime\n",
+         set_param_constraints.c_str());
+      printf
+        ("%s <file> : Read the schedule of the stages of the program from "
+         "<file>. Every line is \"<stage> : <directive> ...\", where <stage> "
+         "is the name of a statement of the program, or return for its "
+         "output. The directives are tile=<integer_list>, "
+         "unroll=<integer_list>, parallel=<integer> (number of outer loops "
+         "run by every thread before the distributed loop), "
+         "vectorize=none|sse4|avx2|avx512 and compute=root|inline|tile "
+         "(within the tiles of its consumer), the output is computed at "
+         "the root. A directive is given once per stage. They override the "
+         "global options for that stage. Text after a # is a comment. The C "
+         "backend honours every directive. The CUDA backend only honours "
+         "unroll and compute=root|inline, the other directives are ignored "
+         "with a warning. Stages computed inline are inlined before code "
+         "generation, which is all the LLVM backend honours of the schedule\n",
+         set_schedule_file.c_str());
       printf("\n");
 
       printf("C code-generation options :\n");
@@ -265,6 +601,94 @@ void program_options::parse_options(int argc, char** argv)
       printf
         ("%s : Generate ICC pragmas for vectorization\n",
          enable_icc_vecflags.c_str());
+      printf
+        ("%s : Fuse chains of stencil applications into a single tiled loop "
+         "nest, recomputing producers over the halo of each tile "
+         "[default:disabled]\n", enable_fusion.c_str());
+      printf
+        ("%s <integer> : Number of points along the outermost dimension "
+         "computed per tile of fused stencils [default:32]\n",
+         set_fusion_tile_size.c_str());
+      printf
+        ("%s : Reuse the buffers of intermediates that are no longer live for "
+         "later intermediates of the same size and type [default:disabled]\n",
+         enable_buffer_reuse.c_str());
+      printf
+        ("%s : Generate for-loops whose iterations only read values of "
+         "previous iterations as loops that rotate between buffers, instead "
+         "of unrolling them. Required for loops with a parametric upper bound "
+         "[default:disabled]\n",
+         enable_loop_rolling.c_str());
+      printf
+        ("%s : When the innermost loop is unrolled using %s, load the "
+         "values of stencil inputs read by the unrolled iterations once per "
+         "block into registers shared by the iterations [default:disabled]\n",
+         enable_sliding_window.c_str(), set_unroll_factors.c_str());
+      printf
+        ("%s <integer> : Limit the number of successive stencil applications "
+         "computed within each tile of fused stencils, to block iterated "
+         "stencils in time. Implies %s [default:no limit]\n",
+         set_time_tile_steps.c_str(), enable_fusion.c_str());
+      printf
+        ("%s <integer_list> : Specify a list of tile sizes used to block the "
+         "loop nests of stencil applications. <integer_list> is a "
+         "comma-separated list of integers with the tile size specified from "
+         "innermost dimension to outermost dimension, dimensions with a tile "
+         "size of 0 or 1 are not tiled\n", set_tile_sizes.c_str());
+      printf
+        ("%s<isa> : Generate the innermost loops of stencil applications over "
+         "the interior of the domain using vector intrinsics. <isa> is one of "
+         "sse4, avx2 or avx512, the generated code has to be compiled for the "
+         "same instruction set. Boundaries and remainder iterations use scalar "
+         "code [default:disabled]\n", set_simd_isa.c_str());
+      printf
+        ("%s : Store intermediates of struct type as one array per field "
+         "instead of an array of structs [default:disabled]\n",
+         enable_soa_structs.c_str());
+      printf
+        ("%s <name_list> : Pass the struct arguments in <name_list> to the "
+         "kernel as one array per field, named <name>_<field>. <name_list> is "
+         "a comma-separated list of argument names, use return to select the "
+         "output [default:arrays of structs]\n", set_soa_args.c_str());
+      printf
+        ("%s : Conversions of integer values to int8 and int16, by casts and "
+         "by stores, saturate to the range of the type instead of wrapping "
+         "around [default:disabled]\n", enable_saturate_int_casts.c_str());
+      printf
+        ("%s : Allocate intermediates on aligned addresses, with every row of "
+         "the innermost dimension padded to start on an aligned address. The "
+         "row pitch avoids multiples of 1024 bytes that cause cache conflicts "
+         "between successive rows [default:disabled]\n",
+         enable_aligned_buffers.c_str());
+      printf
+        ("%s <integer> : Alignment in bytes of the buffers and rows allocated "
+         "with %s. Implies %s [default:64]\n", set_buffer_alignment.c_str(),
+         enable_aligned_buffers.c_str(), enable_aligned_buffers.c_str());
+      printf
+        ("%s : With %s, write the output and the intermediates that are not "
+         "read by the next stencil application using non-temporal stores "
+         "[default:disabled]\n", enable_streaming_stores.c_str(),
+         set_simd_isa.c_str());
+      printf
+        ("%s : Run every stencil stage as an OpenMP task that depends on the "
+         "stages it reads, so that independent stages run concurrently, with "
+         "its loops split into tasks by taskloop constructs "
+         "[default:disabled]\n", enable_omp_tasks.c_str());
+      printf
+        ("%s<openmp|forma> : Runtime that runs the parallel region. With "
+         "forma, the region is run by a persistent pool of threads of the "
+         "forma runtime, that balances the iterations of the distributed "
+         "loops by work stealing [default:openmp]\n", set_runtime.c_str());
+      printf
+        ("%s : Intermediates are zero-initialized by all threads, each thread "
+         "touching the rows it computes first, so that pages are allocated on "
+         "the NUMA node of the thread that uses them [default:disabled]\n",
+         enable_numa_first_touch.c_str());
+      printf
+        ("%s : Interleave the pages of intermediates that are read with a "
+         "different partition of the rows than the one they are computed "
+         "with across NUMA nodes. Implies %s [default:disabled]\n",
+         enable_numa_interleave.c_str(), enable_numa_first_touch.c_str());
       printf
         ("%s <name> : Specify output file name for generated C code\n",
          set_c_output_file.c_str());
@@ -341,6 +765,295 @@ void program_options::parse_options(int argc, char** argv)
     }
   }
 
+  ///Loops are kept rolled only by the C backend, and only with passes that
+  ///can handle them
+  if( roll_loops &&
+      ( !print_c || print_cuda || print_llvm || generate_affine ||
+        forward_exprs || inline_vectorfn ) ){
+    printf
+      ("%s is supported only for C code generation without %s, %s or %s, "
+       "unrolling loops\n",enable_loop_rolling.c_str(),
+       enable_affine.c_str(),enable_forwarding.c_str(),
+       enable_inline_vectorfn.c_str());
+    roll_loops = false;
+  }
+
+  ///The header with the kernel signature is shared by all backends, only the C
+  ///backend can split struct arguments into arrays
+  if( !soa_args.empty() && ( !print_c || print_cuda || print_llvm ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation\n",
+       set_soa_args.c_str());
+    exit(1);
+  }
+
+  ///The other backends wrap around, their results would differ
+  if( saturate_int_casts && ( !print_c || print_cuda || print_llvm ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation\n",
+       enable_saturate_int_casts.c_str());
+    exit(1);
+  }
+
+  if( streaming_stores && simd_isa.compare("") == 0 ){
+    fprintf
+      (stderr,"[ME] : Error! %s requires %s\n",
+       enable_streaming_stores.c_str(), set_simd_isa.c_str());
+    exit(1);
+  }
+
+  ///Every stage fences the non-temporal stores of its threads before the
+  ///stages that read it, the chunks of a taskloop run on any thread
+  if( streaming_stores && omp_tasks ){
+    fprintf
+      (stderr,"[ME] : Error! %s cannot be used with %s\n",
+       enable_streaming_stores.c_str(), enable_omp_tasks.c_str());
+    exit(1);
+  }
+
+  ///Placement follows the static partition of the OpenMP loops
+  if( numa_first_touch &&
+      ( !print_c || print_cuda || print_llvm || !use_openmp ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s or %s\n", enable_numa_first_touch.c_str(),
+       enable_sequential.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( omp_tasks &&
+      ( !print_c || print_cuda || print_llvm || !use_openmp ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s or %s\n", enable_omp_tasks.c_str(),
+       enable_sequential.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( runtime.compare("forma") == 0 &&
+      ( !print_c || print_cuda || print_llvm || !use_openmp ) ){
+    fprintf
+      (stderr,"[ME] : Error! %sforma is supported only for C code generation "
+       "without %s or %s\n", set_runtime.c_str(), enable_sequential.c_str(),
+       enable_affine.c_str());
+    exit(1);
+  }
+
+  if( plan_api && ( !print_c || print_cuda || print_llvm || generate_affine ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s\n", enable_plan_api.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( batch_api && ( !print_c || print_cuda || print_llvm || generate_affine ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s\n", enable_batch_api.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( roi_api && ( !print_c || print_cuda || print_llvm || generate_affine ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s\n", enable_roi_api.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( ghost_zones &&
+      ( !print_c || print_cuda || print_llvm || generate_affine ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s\n", enable_ghost_zones.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  if( specialize_bdys &&
+      ( !print_c || print_cuda || print_llvm || generate_affine ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation "
+       "without %s\n", enable_specialize_bdys.c_str(), enable_affine.c_str());
+    exit(1);
+  }
+
+  ///The region needed of a fused producer depends on the tile of its
+  ///consumer, and the plan and batch entry points compute whole images
+  if( roi_api && ( fuse_stencils || plan_api || batch_api ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s cannot be used with %s, %s or %s\n",
+       enable_roi_api.c_str(), enable_fusion.c_str(), enable_plan_api.c_str(),
+       enable_batch_api.c_str());
+    exit(1);
+  }
+
+  ///The windows of fused producers are allocated by every thread in the
+  ///parallel region, they are not part of the workspace of the plan
+  if( plan_api && ( fuse_stencils || has_compute_level(COMPUTE_TILE) ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s cannot be used with %s, or with stages "
+       "computed within the tiles of their consumer\n",
+       enable_plan_api.c_str(), enable_fusion.c_str());
+    exit(1);
+  }
+
+  if( roi_api && has_compute_level(COMPUTE_TILE) ){
+    fprintf
+      (stderr,"[ME] : Error! %s cannot be used with stages computed within "
+       "the tiles of their consumer\n", enable_roi_api.c_str());
+    exit(1);
+  }
+
+  if( runtime.compare("forma") == 0 && omp_tasks ){
+    fprintf
+      (stderr,"[ME] : Error! %sforma cannot be used with %s\n",
+       set_runtime.c_str(), enable_omp_tasks.c_str());
+    exit(1);
+  }
+
+  ///Tasks are not bound to the threads that own the rows of a buffer
+  if( omp_tasks && numa_first_touch ){
+    fprintf
+      (stderr,"[ME] : Error! %s cannot be used with %s\n",
+       enable_omp_tasks.c_str(), enable_numa_first_touch.c_str());
+    exit(1);
+  }
+
+  if( aligned_buffers && ( !print_c || print_cuda || print_llvm ) ){
+    fprintf
+      (stderr,"[ME] : Error! %s is supported only for C code generation\n",
+       enable_aligned_buffers.c_str());
+    exit(1);
+  }
 }
 
 
+///-----------------------------------------------------------------------------
+/// Parse a comma-separated list of integers no smaller than min_value
+static bool parse_int_list
+(const string& int_list, int min_value, deque<int>& values)
+{
+  values.clear();
+  size_t start = 0;
+  while( start <= int_list.size() ){
+    size_t end = int_list.find_first_of(",", start);
+    if( end == string::npos )
+      end = int_list.size();
+    string curr_value = int_list.substr(start, end - start);
+    char* value_end = NULL;
+    long value = strtol(curr_value.c_str(), &value_end, 10);
+    if( curr_value.empty() || *value_end != '\0' || value < min_value )
+      return false;
+    values.push_back(value);
+    start = end + 1;
+  }
+  return true;
+}
+
+
+///-----------------------------------------------------------------------------
+/// Read the schedule of the stages of the program. Every line is
+/// "<stage> : <directive> ...", a stage can be named on multiple lines but
+/// every directive is given once per stage
+void program_options::parse_schedule(const char* file_name)
+{
+  map<string,set<string> > stage_directives;
+  ifstream schedule_file(file_name);
+  if( !schedule_file ){
+    fprintf
+      (stderr,"[ME] : Error! Cannot open schedule file %s\n", file_name);
+    exit(1);
+  }
+  string line;
+  for( int line_num = 1 ; getline(schedule_file,line) ; line_num++ ){
+    size_t comment = line.find('#');
+    if( comment != string::npos )
+      line.erase(comment);
+    if( line.find_first_not_of(" \t\r") == string::npos )
+      continue;
+
+    size_t separator = line.find(':');
+    stringstream stage_stream(line.substr(0,separator));
+    string stage_name, extra;
+    stage_stream >> stage_name;
+    if( separator == string::npos || stage_name.empty() ||
+        stage_stream >> extra ){
+      fprintf
+        (stderr,"[ME] : Error! %s:%d : Expected \"<stage> : <directive> "
+         "...\"\n", file_name, line_num);
+      exit(1);
+    }
+
+    stage_schedule& curr_schedule = stage_schedules[stage_name];
+    stringstream directive_stream(line.substr(separator+1));
+    string directive;
+    while( directive_stream >> directive ){
+      size_t equals = directive.find('=');
+      string key = directive.substr(0,equals);
+      string value =
+        ( equals == string::npos ? "" : directive.substr(equals+1) );
+      if( !stage_directives[stage_name].insert(key).second ){
+        fprintf
+          (stderr,"[ME] : Error! %s:%d : Directive %s is given more than once "
+           "for stage %s\n", file_name, line_num, key.c_str(),
+           stage_name.c_str());
+        exit(1);
+      }
+      bool is_valid = false;
+      if( key.compare("tile") == 0 )
+        is_valid = parse_int_list(value, 0, curr_schedule.tile_sizes);
+      else if( key.compare("unroll") == 0 )
+        is_valid = parse_int_list(value, 1, curr_schedule.unroll_factors);
+      else if( key.compare("parallel") == 0 ){
+        deque<int> parallel_dim;
+        is_valid =
+          parse_int_list(value, 0, parallel_dim) && parallel_dim.size() == 1;
+        if( is_valid )
+          curr_schedule.parallel_dim = parallel_dim.front();
+      }
+      else if( key.compare("vectorize") == 0 ){
+        is_valid =
+          ( value.compare("none") == 0 || value.compare("sse4") == 0 ||
+            value.compare("avx2") == 0 || value.compare("avx512") == 0 );
+        curr_schedule.simd_isa = value;
+      }
+      else if( key.compare("compute") == 0 ){
+        is_valid = true;
+        if( value.compare("root") == 0 )
+          curr_schedule.compute_level = COMPUTE_ROOT;
+        else if( value.compare("inline") == 0 )
+          curr_schedule.compute_level = COMPUTE_INLINE;
+        else if( value.compare("tile") == 0 )
+          curr_schedule.compute_level = COMPUTE_TILE;
+        else
+          is_valid = false;
+        ///The return expression has no consumer to be computed within
+        if( is_valid && stage_name.compare("return") == 0 &&
+            curr_schedule.compute_level != COMPUTE_ROOT ){
+          fprintf
+            (stderr,"[ME] : Error! %s:%d : The return expression is always "
+             "computed at the root, invalid directive %s\n", file_name,
+             line_num, directive.c_str());
+          exit(1);
+        }
+      }
+      if( !is_valid ){
+        fprintf
+          (stderr,"[ME] : Error! %s:%d : Invalid directive %s for stage %s\n",
+           file_name, line_num, directive.c_str(), stage_name.c_str());
+        exit(1);
+      }
+    }
+  }
+}
+
+
+///-----------------------------------------------------------------------------
+/// Check if any stage of the schedule is computed at the given level
+bool program_options::has_compute_level(stage_compute_level level) const
+{
+  for( map<string,stage_schedule>::const_iterator it = stage_schedules.begin();
+       it != stage_schedules.end() ; it++ )
+    if( it->second.compute_level == level )
+      return true;
+  return false;
+}